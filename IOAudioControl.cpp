@@ -23,6 +23,7 @@
 #include "IOAudioDebug.h"
 #include "IOAudioControl.h"
 #include "IOAudioControlUserClient.h"
+#include "IOAudioStream.h"
 #include "IOAudioTypes.h"
 #include "IOAudioDefines.h"
 
@@ -535,6 +536,13 @@ IOReturn IOAudioControl::updateValue(OSObject *newValue)
     
     result = _setValue(newValue);
     if (result == kIOReturnSuccess) {
+        IOAudioStream *audioStream = OSDynamicCast(IOAudioStream, getProvider());
+        
+        // A default control attached to a stream may be applied by the stream itself
+        if (audioStream) {
+            audioStream->defaultAudioControlChanged(this);
+        }
+        
         sendValueChangeNotification();
     }
     
@@ -206,6 +206,14 @@
 #define kIOAudioStreamStartingChannelNumberKey	"IOAudioStreamStartingChannelNumber"
 #define kIOAudioStreamAvailableKey				"IOAudioStreamAvailable"
 
+/*!
+ * @defined kIOAudioStreamInputSampleBufferSharedKey
+ * @abstract The key in the IORegistry for an input stream whose sample buffer clients may map.
+ * @discussion The value is a boolean.  While it is true and the stream's format is native Float32, a client can
+ *  map the sample buffer with kIOAudioInputSampleBuffer and read the samples from it directly.
+ */
+#define kIOAudioStreamInputSampleBufferSharedKey	"IOAudioStreamInputSampleBufferShared"
+
 #define kIOAudioStreamFormatKey					"IOAudioStreamFormat"
 #define kIOAudioStreamAvailableFormatsKey		"IOAudioStreamAvailableFormats"
 
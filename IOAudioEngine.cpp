@@ -28,6 +28,9 @@
 #include "IOAudioTypes.h"
 #include "IOAudioDefines.h"
 #include "IOAudioControl.h"
+
+#include "PCMBlitterLib/IOAudioBlitterLibDispatch.h"
+
 #include <IOKit/IOLib.h>
 #include <IOKit/IOWorkLoop.h>
 #include <IOKit/IOCommandGate.h>
@@ -41,6 +44,8 @@
 
 #define WATCHDOG_THREAD_LATENCY_PADDING_NS	(125000)	// 125us
 #define DEFAULT_MIX_CLIP_OVERHEAD			10			// <rdar://12188841>
+#define MIX_BUFFER_POOL_SIZE				64			// Enough to hold a buffer for every stream of a large engine
+#define MIX_BUFFER_ALIGNMENT				64			// One cache line
 
 // <rdar://8518215>
 enum
@@ -69,11 +74,11 @@ OSMetaClassDefineReservedUsed(IOAudioEngine, 11);
 OSMetaClassDefineReservedUsed(IOAudioEngine, 12);
 OSMetaClassDefineReservedUsed(IOAudioEngine, 13);
 OSMetaClassDefineReservedUsed(IOAudioEngine, 14);
+OSMetaClassDefineReservedUsed(IOAudioEngine, 15);
+OSMetaClassDefineReservedUsed(IOAudioEngine, 16);
 
-OSMetaClassDefineReservedUnused(IOAudioEngine, 15);
-OSMetaClassDefineReservedUnused(IOAudioEngine, 16);
-OSMetaClassDefineReservedUnused(IOAudioEngine, 17);
-OSMetaClassDefineReservedUnused(IOAudioEngine, 18);
+OSMetaClassDefineReservedUsed(IOAudioEngine, 17);
+OSMetaClassDefineReservedUsed(IOAudioEngine, 18);
 OSMetaClassDefineReservedUnused(IOAudioEngine, 19);
 OSMetaClassDefineReservedUnused(IOAudioEngine, 20);
 OSMetaClassDefineReservedUnused(IOAudioEngine, 21);
@@ -210,6 +215,108 @@ UInt32 IOAudioEngine::getNextStreamID(IOAudioStream * newStream) {
 	return reserved->streams->getCount() - 1;
 }
 
+// Makes sure every mixable output stream without a mix buffer will find one in the pool, so that a
+// client attaching to it once the engine is running doesn't allocate
+void IOAudioEngine::reserveMixBuffers()
+{
+	OSCollectionIterator	*streamIterator;
+	IOAudioStream			*audioStream;
+	MixBufferPoolEntry		*reservedBuffers;
+	UInt32					numStreams;
+	UInt32					numReserved = 0;
+	
+	if (!outputStreams || (numSampleFramesPerBuffer == 0)) {
+		return;
+	}
+	
+	numStreams = outputStreams->getCount();
+	if (numStreams == 0) {
+		return;
+	}
+	
+	reservedBuffers = (MixBufferPoolEntry *)IOMalloc(numStreams * sizeof(MixBufferPoolEntry));
+	if (!reservedBuffers) {
+		return;
+	}
+	
+	streamIterator = OSCollectionIterator::withCollection(outputStreams);
+	if (streamIterator) {
+		while ( (audioStream = OSDynamicCast(IOAudioStream, streamIterator->getNextObject())) && (numReserved < numStreams) ) {
+			UInt32 mixBufSize = 0;
+			
+			lockStreamForIO(audioStream);
+			if (!audioStream->mixBuffer && audioStream->format.fIsMixable && audioStream->sampleBuffer && (audioStream->sampleBufferSize > 0)) {
+				mixBufSize = audioStream->format.fNumChannels * kIOAudioEngineDefaultMixBufferSampleSize * numSampleFramesPerBuffer;
+			}
+			unlockStreamForIO(audioStream);
+			
+			if (mixBufSize > 0) {
+				// Held until every stream has been looked at so that streams of the same size get one each
+				reservedBuffers[numReserved].buffer = checkOutMixBuffer(mixBufSize);
+				if (reservedBuffers[numReserved].buffer) {
+					reservedBuffers[numReserved].size = mixBufSize;
+					numReserved++;
+				}
+			}
+		}
+		streamIterator->release();
+	}
+	
+	while (numReserved > 0) {
+		numReserved--;
+		checkInMixBuffer(reservedBuffers[numReserved].buffer, reservedBuffers[numReserved].size);
+	}
+	
+	IOFree(reservedBuffers, numStreams * sizeof(MixBufferPoolEntry));
+}
+
+// True if some mixable output stream takes mix buffers of this size with its current format. The
+// formats are read without the streams' IO locks: at worst a buffer is pooled or freed needlessly.
+bool IOAudioEngine::isMixBufferSizeInUse(UInt32 size)
+{
+	IOAudioStream	*audioStream;
+	UInt32			i, numStreams;
+	
+	if (!outputStreams) {
+		return false;
+	}
+	
+	numStreams = outputStreams->getCount();
+	for (i = 0; i < numStreams; i++) {
+		audioStream = OSDynamicCast(IOAudioStream, outputStreams->getObject(i));
+		if (audioStream && audioStream->format.fIsMixable &&
+			(audioStream->format.fNumChannels * kIOAudioEngineDefaultMixBufferSampleSize * numSampleFramesPerBuffer == size)) {
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+// Frees the pooled mix buffers that no output stream would check out any more, after a format or
+// buffer size change
+void IOAudioEngine::pruneMixBufferPool()
+{
+	UInt32	i = 0;
+	
+	assert(reserved);
+	if (!reserved->mixBufferPoolLock || !reserved->mixBufferPool) {
+		return;
+	}
+	
+	IOLockLock(reserved->mixBufferPoolLock);
+	while (i < reserved->mixBufferPoolCount) {
+		if (isMixBufferSizeInUse(reserved->mixBufferPool[i].size)) {
+			i++;
+		} else {
+			IOFreeAligned(reserved->mixBufferPool[i].buffer, reserved->mixBufferPool[i].size);
+			reserved->mixBufferPoolCount--;
+			reserved->mixBufferPool[i] = reserved->mixBufferPool[reserved->mixBufferPoolCount];
+		}
+	}
+	IOLockUnlock(reserved->mixBufferPoolLock);
+}
+
 // OSMetaClassDefineReservedUsed(IOAudioEngine, 4);
 void IOAudioEngine::lockStreamForIO(IOAudioStream *stream) {
 	stream->lockStreamForIO();
@@ -410,6 +517,12 @@ bool IOAudioEngine::init(OSDictionary *properties)
 			reserved->streams = NULL;
 			reserved->commandGateStatus = kCommandGateStatus_Normal;	// <rdar://8518215>
 			reserved->commandGateUsage = 0;								// <rdar://8518215>
+			reserved->mixBufferPoolLock = IOLockAlloc();
+			reserved->mixBufferPool = (MixBufferPoolEntry *)IOMalloc(MIX_BUFFER_POOL_SIZE * sizeof(MixBufferPoolEntry));
+			reserved->mixBufferPoolCount = 0;
+			reserved->clipJobs = NULL;
+			reserved->clipJobCapacity = 0;
+			reserved->numClipJobs = 0;
 
 			reserved->statusDescriptor = IOBufferMemoryDescriptor::withOptions(kIODirectionOutIn | kIOMemoryKernelUserShared, round_page_32(sizeof(IOAudioEngineStatus)), page_size);
 
@@ -485,6 +598,25 @@ void IOAudioEngine::free()
 			reserved->streams = NULL;
 		}
 		
+		if (reserved->mixBufferPool) {
+			while (reserved->mixBufferPoolCount > 0) {
+				reserved->mixBufferPoolCount--;
+				IOFreeAligned(reserved->mixBufferPool[reserved->mixBufferPoolCount].buffer, reserved->mixBufferPool[reserved->mixBufferPoolCount].size);
+			}
+			IOFree(reserved->mixBufferPool, MIX_BUFFER_POOL_SIZE * sizeof(MixBufferPoolEntry));
+			reserved->mixBufferPool = NULL;
+		}
+		
+		if (reserved->mixBufferPoolLock) {
+			IOLockFree(reserved->mixBufferPoolLock);
+			reserved->mixBufferPoolLock = NULL;
+		}
+		
+		if (reserved->clipJobs) {
+			IOFree(reserved->clipJobs, reserved->clipJobCapacity * sizeof(IOAF_ConversionJob));
+			reserved->clipJobs = NULL;
+		}
+		
 		IOFree (reserved, sizeof(struct ExpansionData));
 	}
 
@@ -1307,6 +1439,9 @@ IOReturn IOAudioEngine::addAudioStream(IOAudioStream *stream)
 			}
 			else
 			{
+				IOAF_ConversionJob	*clipJobs, *oldClipJobs;
+				UInt32				oldClipJobCapacity;
+				
 				switch ( stream->getDirection () )
 				{
 					case kIOAudioStreamDirectionOutput:
@@ -1320,6 +1455,21 @@ IOReturn IOAudioEngine::addAudioStream(IOAudioStream *stream)
 							setRunEraseHead(true);
 						}
 
+						// clipOutputStreams() collects up to two clips per stream, for a clip that wraps
+						clipJobs = (IOAF_ConversionJob *)IOMalloc(2 * outputStreams->getCount() * sizeof(IOAF_ConversionJob));
+						if (clipJobs) {
+							lockAllStreams();
+							oldClipJobs = reserved->clipJobs;
+							oldClipJobCapacity = reserved->clipJobCapacity;
+							reserved->clipJobs = clipJobs;
+							reserved->clipJobCapacity = 2 * outputStreams->getCount();
+							unlockAllStreams();
+							
+							if (oldClipJobs) {
+								IOFree(oldClipJobs, oldClipJobCapacity * sizeof(IOAF_ConversionJob));
+							}
+						}
+
 						if (reserved->bytesInOutputBufferArrayDescriptor) {
 							reserved->bytesInOutputBufferArrayDescriptor->release();
 						}
@@ -1370,6 +1520,7 @@ void IOAudioEngine::detachAudioStreams()
             iterator->release();
         }
         outputStreams->flushCollection();
+		pruneMixBufferPool();		// no stream is left to take the pooled buffers
 		if (reserved->bytesInOutputBufferArrayDescriptor) {
 			reserved->bytesInOutputBufferArrayDescriptor->release();
 			reserved->bytesInOutputBufferArrayDescriptor = NULL;
@@ -1401,60 +1552,51 @@ void IOAudioEngine::detachAudioStreams()
 	return;
 }
 
+// Indexed rather than iterated, as clipOutputStreams() locks all streams on every IO cycle
 void IOAudioEngine::lockAllStreams()
 {
-    OSCollectionIterator *streamIterator;
+    IOAudioStream *stream;
+    UInt32 streamIndex;
     
     if (outputStreams) {
-        streamIterator = OSCollectionIterator::withCollection(outputStreams);
-        if (streamIterator) {
-            IOAudioStream *stream;
-            
-            while ( (stream = (IOAudioStream *)streamIterator->getNextObject()) ) {
+        for (streamIndex = 0; streamIndex < outputStreams->getCount(); streamIndex++) {
+            stream = (IOAudioStream *)outputStreams->getObject(streamIndex);
+            if (stream) {
                 stream->lockStreamForIO();
             }
-            streamIterator->release();
         }
     }
 
     if (inputStreams) {
-        streamIterator = OSCollectionIterator::withCollection(inputStreams);
-        if (streamIterator) {
-            IOAudioStream *stream;
-            
-            while ( (stream = (IOAudioStream *)streamIterator->getNextObject()) ) {
+        for (streamIndex = 0; streamIndex < inputStreams->getCount(); streamIndex++) {
+            stream = (IOAudioStream *)inputStreams->getObject(streamIndex);
+            if (stream) {
                 stream->lockStreamForIO();
             }
-            streamIterator->release();
         }
     }
 }
 
 void IOAudioEngine::unlockAllStreams()
 {
-    OSCollectionIterator *streamIterator;
+    IOAudioStream *stream;
+    UInt32 streamIndex;
     
     if (outputStreams) {
-        streamIterator = OSCollectionIterator::withCollection(outputStreams);
-        if (streamIterator) {
-            IOAudioStream *stream;
-            
-            while ( (stream = (IOAudioStream *)streamIterator->getNextObject()) ) {
+        for (streamIndex = 0; streamIndex < outputStreams->getCount(); streamIndex++) {
+            stream = (IOAudioStream *)outputStreams->getObject(streamIndex);
+            if (stream) {
                 stream->unlockStreamForIO();
             }
-            streamIterator->release();
         }
     }
 
     if (inputStreams) {
-        streamIterator = OSCollectionIterator::withCollection(inputStreams);
-        if (streamIterator) {
-            IOAudioStream *stream;
-            
-            while ( (stream = (IOAudioStream *)streamIterator->getNextObject()) ) {
+        for (streamIndex = 0; streamIndex < inputStreams->getCount(); streamIndex++) {
+            stream = (IOAudioStream *)inputStreams->getObject(streamIndex);
+            if (stream) {
                 stream->unlockStreamForIO();
             }
-            streamIterator->release();
         }
     }
 }
@@ -1712,6 +1854,7 @@ IOReturn IOAudioEngine::startAudioEngine()
             audioDevice->audioEngineStarting();
         case kIOAudioEngineResumed:
             resetStatusBuffer();
+            reserveMixBuffers();
             
 			reserved->pauseCount = 0;
             result = performAudioEngineStart();
@@ -1851,6 +1994,9 @@ void IOAudioEngine::setNumSampleFramesPerBuffer(UInt32 numSampleFrames)
                 streamIterator->release();
             }
         }
+        
+        // The pooled mix buffers were sized for the old buffer
+        pruneMixBufferPool();
     }
     DbgLog("- IOAudioEngine[%p]::setNumSampleFramesPerBuffer(0x%lx)\n", this, (long unsigned int)numSampleFrames);
 	return;
@@ -2201,6 +2347,106 @@ IOReturn IOAudioEngine::clipOutputSamples(const void *mixBuf, void *sampleBuf, U
     return kIOReturnUnsupported;
 }
 
+// OSMetaClassDefineReservedUsed(IOAudioEngine, 16);
+void *IOAudioEngine::checkOutMixBuffer(UInt32 size)
+{
+	void	*buffer = NULL;
+	UInt32	i;
+	
+	if (size == 0) {
+		return NULL;
+	}
+	
+	assert(reserved);
+	if (reserved->mixBufferPoolLock && reserved->mixBufferPool) {
+		IOLockLock(reserved->mixBufferPoolLock);
+		for (i = 0; i < reserved->mixBufferPoolCount; i++) {
+			if (reserved->mixBufferPool[i].size == size) {
+				buffer = reserved->mixBufferPool[i].buffer;
+				reserved->mixBufferPoolCount--;
+				reserved->mixBufferPool[i] = reserved->mixBufferPool[reserved->mixBufferPoolCount];
+				break;
+			}
+		}
+		IOLockUnlock(reserved->mixBufferPoolLock);
+	}
+	
+	if (!buffer) {
+		buffer = IOMallocAligned(size, MIX_BUFFER_ALIGNMENT);
+	}
+	
+	return buffer;
+}
+
+// OSMetaClassDefineReservedUsed(IOAudioEngine, 17);
+void IOAudioEngine::checkInMixBuffer(void *buffer, UInt32 size)
+{
+	bool	pooled = false;
+	
+	if (!buffer) {
+		return;
+	}
+	
+	assert(reserved);
+	if (reserved->mixBufferPoolLock && reserved->mixBufferPool) {
+		pruneMixBufferPool();
+		
+		IOLockLock(reserved->mixBufferPoolLock);
+		if ((reserved->mixBufferPoolCount < MIX_BUFFER_POOL_SIZE) && isMixBufferSizeInUse(size)) {
+			reserved->mixBufferPool[reserved->mixBufferPoolCount].buffer = buffer;
+			reserved->mixBufferPool[reserved->mixBufferPoolCount].size = size;
+			reserved->mixBufferPoolCount++;
+			pooled = true;
+		}
+		IOLockUnlock(reserved->mixBufferPoolLock);
+	}
+	
+	if (!pooled) {
+		IOFreeAligned(buffer, size);
+	}
+}
+
+// OSMetaClassDefineReservedUsed(IOAudioEngine, 18);
+IOReturn IOAudioEngine::clipOutputStreams()
+{
+	IOReturn		result = kIOReturnSuccess;
+	IOAudioStream	*outputStream;
+	UInt32			streamIndex;
+	
+	assert(reserved);
+	if (!outputStreams) {
+		return kIOReturnSuccess;
+	}
+	
+	lockAllStreams();
+	
+	// Each stream's clipOutputSamples() adds a plain conversion to clipJobs rather than converting it
+	reserved->numClipJobs = 0;
+	for (streamIndex = 0; streamIndex < outputStreams->getCount(); streamIndex++) {
+		outputStream = (IOAudioStream *)outputStreams->getObject(streamIndex);
+		if (outputStream && outputStream->reserved && outputStream->reserved->mClipDeferred) {
+			outputStream->reserved->mClipDeferred = false;
+			outputStream->reserved->mClipOutputStatus = kIOReturnSuccess;
+			outputStream->reserved->mClipBatched = (reserved->clipJobs != NULL);
+			outputStream->clipIfNecessary();
+			outputStream->reserved->mClipBatched = false;
+			
+			if ((outputStream->reserved->mClipOutputStatus != kIOReturnSuccess) && (result == kIOReturnSuccess)) {
+				result = outputStream->reserved->mClipOutputStatus;
+			}
+		}
+	}
+	
+	if (reserved->numClipJobs > 0) {
+		IOAF_Float32ToIntBatch(reserved->clipJobs, reserved->numClipJobs);
+		reserved->numClipJobs = 0;
+	}
+	
+	unlockAllStreams();
+	
+	return result;
+}
+
 void IOAudioEngine::resetClipPosition(IOAudioStream *audioStream, UInt32 clipSampleFrame)
 {
     DbgLog("+-IOAudioEngine[%p]::resetClipPosition(%p, 0x%lx)\n", this, audioStream, (long unsigned int)clipSampleFrame);
@@ -45,6 +45,8 @@ class IOAudioStream;
 class IOAudioControl;
 class IOCommandGate;
 
+struct IOAF_ConversionJob;
+
 #define IOAUDIOENGINE_DEFAULT_NUM_ERASES_PER_BUFFER	4
 
 /*!
@@ -68,6 +70,19 @@ typedef struct {
             
 #define IOAUDIOENGINEPOSITION_IS_ZERO(p1) (((p1)->fLoopCount == 0) && ((p1)->fSampleFrame == 0))
 
+/*!
+ * @typedef IOAudioMixSource
+ * @abstract One client buffer to be mixed by IOAudioEngine::mixOutputSamplesFromSources().
+ * @field fSourceBuf The Float32 samples to mix in.  The first sample belongs at fFirstSampleFrame.
+ * @field fFirstSampleFrame The first sample frame of the mix buffer covered by this source.
+ * @field fNumSampleFrames The number of sample frames in this source.  The range must not wrap around the end of the mix buffer.
+ */
+typedef struct {
+    const void *	fSourceBuf;
+    UInt32			fFirstSampleFrame;
+    UInt32			fNumSampleFrames;
+} IOAudioMixSource;
+
 
 #define CMP_ABSOLUTETIME(t1, t2)            \
 (AbsoluteTime_to_scalar(t1) >               \
@@ -255,6 +270,11 @@ protected:
     bool			deviceStartedAudioEngine;
     
 protected:
+	struct MixBufferPoolEntry {
+		void								*buffer;
+		UInt32								size;
+	};
+
     struct ExpansionData {
 		UInt32								pauseCount;
 		IOBufferMemoryDescriptor			*statusDescriptor;
@@ -265,6 +285,12 @@ protected:
 	    UInt32								inputSampleOffset;
 		UInt32								commandGateStatus;			// <rdar://8518215>
 		SInt32								commandGateUsage;			// <rdar://8518215>
+		IOLock								*mixBufferPoolLock;
+		MixBufferPoolEntry					*mixBufferPool;
+		UInt32								mixBufferPoolCount;
+		IOAF_ConversionJob					*clipJobs;					// collected by clipOutputStreams(), two per output stream
+		UInt32								clipJobCapacity;
+		UInt32								numClipJobs;
 	};
     
     ExpansionData   *reserved;
@@ -388,6 +414,61 @@ public:
 	
     virtual IOReturn getAttributeForConnection( SInt32 connectIndex, UInt32 attribute, uintptr_t * value );
 
+	// OSMetaClassDeclareReservedUsed(IOAudioEngine, 15);
+	/*!
+	 * @function mixOutputSamplesFromSources
+	 * @abstract Mixes several client buffers into the mix buffer in one pass.
+	 * @discussion Equivalent to calling mixOutputSamples() once for each source in array order, but the mix buffer
+	 *  is read and written only once for the frames the sources have in common.  Sources may cover different
+	 *  ranges of the mix buffer.  A subclass that overrides mixOutputSamples() should override this as well.
+	 * @param sources Array of sources to mix.
+	 * @param numSources The number of entries in sources.
+	 * @param mixBuf The mix buffer to mix into.
+	 * @param streamFormat The format of the stream.
+	 * @param audioStream The stream the mix buffer belongs to.
+	 * @result an IOReturn code.
+	 */
+	virtual IOReturn mixOutputSamplesFromSources(const IOAudioMixSource *sources, UInt32 numSources, void *mixBuf, const IOAudioStreamFormat *streamFormat, IOAudioStream *audioStream);
+
+	// OSMetaClassDeclareReservedUsed(IOAudioEngine, 16);
+	/*!
+	 * @function checkOutMixBuffer
+	 * @abstract Takes a mix buffer of the given size from the engine's pool.
+	 * @discussion The engine keeps the mix buffers its output streams give back so that a stream that is
+	 *  recreated, or changes format, or gets its first client while the engine is running doesn't have to go to
+	 *  the allocator.  A new buffer is allocated only if the pool has none of the requested size.  Buffers are
+	 *  aligned to a cache line.  The contents of the buffer are undefined.
+	 * @param size The size of the buffer in bytes.
+	 * @result The buffer, or NULL if none could be allocated.
+	 */
+	virtual void *checkOutMixBuffer(UInt32 size);
+
+	// OSMetaClassDeclareReservedUsed(IOAudioEngine, 17);
+	/*!
+	 * @function checkInMixBuffer
+	 * @abstract Returns a mix buffer obtained from checkOutMixBuffer() to the engine's pool.
+	 * @discussion The buffer is freed instead if the pool is full, or if no mixable output stream uses buffers of
+	 *  its size with its current format.  Pooled buffers of other sizes are freed at the same time.
+	 * @param buffer The buffer.
+	 * @param size The size the buffer was checked out with.
+	 */
+	virtual void checkInMixBuffer(void *buffer, UInt32 size);
+
+	// OSMetaClassDeclareReservedUsed(IOAudioEngine, 18);
+	/*!
+	 * @function clipOutputStreams
+	 * @abstract Clips all output streams in one call.
+	 * @discussion When the engine has more than one output stream, a stream that lets the family convert for it
+	 *  (see IOAudioStream::setFusedOutputConversion()) leaves its clip to this call, which IOAudioEngineUserClient
+	 *  makes once a client has mixed into all of its output streams.  The default implementation locks the streams
+	 *  with lockAllStreams(), collects each stream's clip and converts them with a single IOAF_Float32ToIntBatch()
+	 *  call.  A clip that is not a plain conversion, such as one with a gain, dither or a write-combined sample
+	 *  buffer, goes through clipOutputSamples() as before.
+	 * @result kIOReturnSuccess, or the error from the first stream whose clip failed.  The remaining streams are
+	 *  still clipped.
+	 */
+	virtual IOReturn clipOutputStreams();
+
 private:
 	OSMetaClassDeclareReservedUsed(IOAudioEngine, 0);
 	OSMetaClassDeclareReservedUsed(IOAudioEngine, 1);
@@ -404,11 +485,11 @@ private:
 	OSMetaClassDeclareReservedUsed(IOAudioEngine, 12);
 	OSMetaClassDeclareReservedUsed(IOAudioEngine, 13);
 	OSMetaClassDeclareReservedUsed(IOAudioEngine, 14);
+	OSMetaClassDeclareReservedUsed(IOAudioEngine, 15);
+	OSMetaClassDeclareReservedUsed(IOAudioEngine, 16);
+	OSMetaClassDeclareReservedUsed(IOAudioEngine, 17);
+	OSMetaClassDeclareReservedUsed(IOAudioEngine, 18);
 
-	OSMetaClassDeclareReservedUnused(IOAudioEngine, 15);
-	OSMetaClassDeclareReservedUnused(IOAudioEngine, 16);
-	OSMetaClassDeclareReservedUnused(IOAudioEngine, 17);
-	OSMetaClassDeclareReservedUnused(IOAudioEngine, 18);
 	OSMetaClassDeclareReservedUnused(IOAudioEngine, 19);
 	OSMetaClassDeclareReservedUnused(IOAudioEngine, 20);
 	OSMetaClassDeclareReservedUnused(IOAudioEngine, 21);
@@ -884,6 +965,9 @@ protected:
 	// These aren't virtual by design
 	UInt32 getNextStreamID(IOAudioStream * newStream);
 	IOAudioStream * getStreamForID(UInt32 streamID);
+	void reserveMixBuffers();
+	bool isMixBufferSizeInUse(UInt32 size);
+	void pruneMixBufferPool();
 
 	static void setCommandGateUsage(IOAudioEngine *engine, bool increment);		// <rdar://8518215>
 
@@ -23,11 +23,11 @@
 #include "IOAudioDebug.h"
 #include "IOAudioEngine.h"
 #include "IOAudioStream.h"
+#include "IOAudioLevelControl.h"
 #include "IOAudioTypes.h"
+#include "IOAudioDefines.h"
 
-//#include <AppleDSP/OSvKernDSPLib.h>
-
-extern "C" void vDSP_vadd( const float input1[], __darwin_ptrdiff_t stride1, const float input2[], __darwin_ptrdiff_t stride2, float res[], __darwin_ptrdiff_t strideres, __darwin_size_t size);
+#include "PCMBlitterLib/IOAudioBlitterLibDispatch.h"
 
 IOReturn IOAudioEngine::mixOutputSamples(const void *sourceBuf, void *mixBuf, UInt32 firstSampleFrame, UInt32 numSampleFrames, const IOAudioStreamFormat *streamFormat, IOAudioStream *audioStream)
 {
@@ -35,24 +35,261 @@ IOReturn IOAudioEngine::mixOutputSamples(const void *sourceBuf, void *mixBuf, UI
 	
     if (sourceBuf && mixBuf) 
 	{
-		const float * floatSource1Buf;
-		const float * floatSource2Buf;
+		const float * floatSourceBuf;
 		float * floatMixBuf;
 		
         UInt32 numSamplesLeft = numSampleFrames * streamFormat->fNumChannels;
-		
-		__darwin_size_t numSamps = numSamplesLeft;
  		
 		floatMixBuf = &(((float *)mixBuf)[firstSampleFrame * streamFormat->fNumChannels]);
-		floatSource2Buf = floatMixBuf;
-		floatSource1Buf = (const float *)sourceBuf;
-		
-		__darwin_ptrdiff_t strideOne=1, strideTwo=1, resultStride=1;
+		floatSourceBuf = (const float *)sourceBuf;
 		
-		vDSP_vadd(floatSource1Buf, strideOne, floatSource2Buf, strideTwo, floatMixBuf, resultStride, numSamps);
+		IOAF_MixFloat32(floatSourceBuf, floatMixBuf, numSamplesLeft);
 		
         result = kIOReturnSuccess;
     }
     
     return result;
 }
+
+// OSMetaClassDefineReservedUsed(IOAudioEngine, 15);
+//
+// The mix buffer is split at every point where a source starts or ends. Within each piece the same
+// set of sources is active, and they are all added in one pass with IOAF_MixFloat32Multi. The pieces
+// are walked in mix buffer order and each keeps the sources in array order, so the result matches
+// one mixOutputSamples() call per source.
+#define kMaxSourcesPerPass	32
+
+IOReturn IOAudioEngine::mixOutputSamplesFromSources(const IOAudioMixSource *sources, UInt32 numSources, void *mixBuf, const IOAudioStreamFormat *streamFormat, IOAudioStream *audioStream)
+{
+	IOReturn result = kIOReturnBadArgument;
+	
+	if (sources && mixBuf && streamFormat)
+	{
+		const float *	srcBufs[kMaxSourcesPerPass];
+		UInt32			numChannels = streamFormat->fNumChannels;
+		UInt32			frame = 0xFFFFFFFF;
+		UInt32			i;
+		
+		for (i = 0; i < numSources; i++) {
+			if (!sources[i].fSourceBuf) {
+				return kIOReturnBadArgument;
+			}
+			if ((sources[i].fNumSampleFrames > 0) && (sources[i].fFirstSampleFrame < frame)) {
+				frame = sources[i].fFirstSampleFrame;
+			}
+		}
+		
+		while (frame != 0xFFFFFFFF) {
+			UInt32	nextFrame = 0xFFFFFFFF;
+			UInt32	numActive = 0;
+			
+			// The piece ends at the next place any source starts or ends
+			for (i = 0; i < numSources; i++) {
+				UInt32 firstFrame = sources[i].fFirstSampleFrame;
+				UInt32 endFrame = firstFrame + sources[i].fNumSampleFrames;
+				
+				if ((firstFrame > frame) && (firstFrame < nextFrame)) {
+					nextFrame = firstFrame;
+				}
+				if ((endFrame > frame) && (endFrame < nextFrame)) {
+					nextFrame = endFrame;
+				}
+			}
+			
+			if (nextFrame == 0xFFFFFFFF) {
+				break;
+			}
+			
+			for (i = 0; i < numSources; i++) {
+				UInt32 firstFrame = sources[i].fFirstSampleFrame;
+				
+				if ((firstFrame <= frame) && (frame < firstFrame + sources[i].fNumSampleFrames)) {
+					srcBufs[numActive++] = (const float *)sources[i].fSourceBuf + ((frame - firstFrame) * numChannels);
+					if (numActive == kMaxSourcesPerPass) {
+						IOAF_MixFloat32Multi(srcBufs, numActive, (float *)mixBuf + (frame * numChannels), (nextFrame - frame) * numChannels);
+						numActive = 0;
+					}
+				}
+			}
+			
+			if (numActive > 0) {
+				IOAF_MixFloat32Multi(srcBufs, numActive, (float *)mixBuf + (frame * numChannels), (nextFrame - frame) * numChannels);
+			}
+			
+			frame = nextFrame;
+		}
+		
+		result = kIOReturnSuccess;
+	}
+	
+	return result;
+}
+
+// ____________________________________________________________________________________
+// IOAudioStream default control gain.  These work in floating point, so they live here rather
+// than in IOAudioStream.cpp.  All are called with the stream locked for IO.
+
+// Maps a volume control's value to dB, linearly across the range it falls in.  Returns false for
+// a value that means negative infinity.
+static bool levelControlValueToDB(IOAudioLevelControl *control, SInt32 value, IOFixed *dB)
+{
+	OSArray *	ranges = OSDynamicCast(OSArray, control->getProperty(kIOAudioLevelControlRangesKey));
+	SInt32		minValue = control->getMinValue();
+	SInt32		maxValue = control->getMaxValue();
+	IOFixed		minDB = control->getMinDB();
+	IOFixed		maxDB = control->getMaxDB();
+	
+	if (ranges) {
+		UInt32 i;
+		
+		for (i = 0; i < ranges->getCount(); i++) {
+			OSDictionary *	range = OSDynamicCast(OSDictionary, ranges->getObject(i));
+			OSNumber *		rangeMinValue;
+			OSNumber *		rangeMaxValue;
+			OSNumber *		rangeMinDB;
+			OSNumber *		rangeMaxDB;
+			
+			if (!range) {
+				continue;
+			}
+			
+			rangeMinValue = OSDynamicCast(OSNumber, range->getObject(kIOAudioLevelControlMinValueKey));
+			rangeMaxValue = OSDynamicCast(OSNumber, range->getObject(kIOAudioLevelControlMaxValueKey));
+			rangeMinDB = OSDynamicCast(OSNumber, range->getObject(kIOAudioLevelControlMinDBKey));
+			rangeMaxDB = OSDynamicCast(OSNumber, range->getObject(kIOAudioLevelControlMaxDBKey));
+			
+			if (rangeMinValue && rangeMaxValue && rangeMinDB && rangeMaxDB &&
+				(value >= (SInt32)rangeMinValue->unsigned32BitValue()) && (value <= (SInt32)rangeMaxValue->unsigned32BitValue())) {
+				minValue = (SInt32)rangeMinValue->unsigned32BitValue();
+				maxValue = (SInt32)rangeMaxValue->unsigned32BitValue();
+				minDB = (IOFixed)rangeMinDB->unsigned32BitValue();
+				maxDB = (IOFixed)rangeMaxDB->unsigned32BitValue();
+				break;
+			}
+		}
+	}
+	
+	if ((UInt32)minDB == kIOAudioLevelControlNegativeInfinity) {
+		return false;
+	}
+	
+	if (maxValue > minValue) {
+		*dB = minDB + (IOFixed)(((SInt64)(value - minValue) * (SInt64)(maxDB - minDB)) / (SInt64)(maxValue - minValue));
+	} else {
+		*dB = maxDB;
+	}
+	
+	return true;
+}
+
+void IOAudioStream::resetDefaultControlGain()
+{
+	reserved->mGainMuted = false;
+	reserved->mGainUnity = true;
+	reserved->mGainStepExponential = false;
+	reserved->mGainRampFramesLeft = 0;
+	reserved->mGain = 1.0f;
+	reserved->mGainTarget = 1.0f;
+	reserved->mGainStep = 0.0f;
+	reserved->mGainLevel = 1.0f;
+}
+
+void IOAudioStream::updateDefaultControlGain(IOAudioControl *control, UInt32 numRampFrames)
+{
+	IOAudioLevelControl *	levelControl;
+	float					target;
+	
+	if ((control->getType() == kIOAudioControlTypeLevel) && (control->getSubType() == kIOAudioLevelControlSubTypeVolume) &&
+		(levelControl = OSDynamicCast(IOAudioLevelControl, control))) {
+		IOFixed dB;
+		
+		reserved->mGainLevel = levelControlValueToDB(levelControl, levelControl->getIntValue(), &dB) ? IOAF_DecibelsToGain(dB) : 0.0f;
+	} else if ((control->getType() == kIOAudioControlTypeToggle) && (control->getSubType() == kIOAudioToggleControlSubTypeMute)) {
+		reserved->mGainMuted = (control->getIntValue() != 0);
+	} else {
+		return;
+	}
+	
+	target = reserved->mGainMuted ? 0.0f : reserved->mGainLevel;
+	reserved->mGainTarget = target;
+	
+	if ((numRampFrames == 0) || (target == reserved->mGain)) {
+		reserved->mGain = target;
+		reserved->mGainStep = 0.0f;
+		reserved->mGainStepExponential = false;
+		reserved->mGainRampFramesLeft = 0;
+		reserved->mGainUnity = (target == 1.0f);
+	} else {
+		// The ramp starts from wherever the last one got to
+		reserved->mGainStepExponential = reserved->mGainRampExponential && (reserved->mGain > 0.0f) && (target > 0.0f);
+		reserved->mGainStep = IOAF_GainRampStep(reserved->mGain, target, numRampFrames, reserved->mGainStepExponential);
+		reserved->mGainRampFramesLeft = numRampFrames;
+		reserved->mGainUnity = false;
+	}
+}
+
+// Scales frames by a ramp, converting them into the sample buffer on the way when there is one and
+// in place otherwise.  Returns the gain for the frame after the last.
+static float gainRampFrames(float *src, void *sampleBuf, UInt32 firstSampleFrame, UInt32 numSampleFrames, const IOAudioStreamFormat *streamFormat, float gain, float step, bool exponential)
+{
+	UInt8 *	dest;
+	bool	bigEndian = (streamFormat->fByteOrder == kIOAudioStreamByteOrderBigEndian);
+	
+	if (!sampleBuf) {
+		return IOAF_GainRampFloat32(src, src, streamFormat->fNumChannels, numSampleFrames, gain, step, exponential);
+	}
+	
+	dest = (UInt8 *)sampleBuf + (firstSampleFrame * streamFormat->fNumChannels * (streamFormat->fBitWidth / 8));
+	switch (streamFormat->fBitWidth) {
+		case 16:
+			if (bigEndian) {
+				return IOAF_Float32ToBEInt16WithGainRamp(src, (SInt16 *)dest, streamFormat->fNumChannels, numSampleFrames, gain, step, exponential);
+			}
+			return IOAF_Float32ToLEInt16WithGainRamp(src, (SInt16 *)dest, streamFormat->fNumChannels, numSampleFrames, gain, step, exponential);
+		case 24:
+			if (bigEndian) {
+				return IOAF_Float32ToBEInt24WithGainRamp(src, dest, streamFormat->fNumChannels, numSampleFrames, gain, step, exponential);
+			}
+			return IOAF_Float32ToLEInt24WithGainRamp(src, dest, streamFormat->fNumChannels, numSampleFrames, gain, step, exponential);
+		case 32:
+			if (bigEndian) {
+				return IOAF_Float32ToBEInt32WithGainRamp(src, (SInt32 *)dest, streamFormat->fNumChannels, numSampleFrames, gain, step, exponential);
+			}
+			return IOAF_Float32ToLEInt32WithGainRamp(src, (SInt32 *)dest, streamFormat->fNumChannels, numSampleFrames, gain, step, exponential);
+	}
+	
+	return gain;
+}
+
+// Applies the current gain to the frames about to be played, either as src is converted into the
+// sample buffer or, with no sample buffer, to src in place.  The caller checks the format.
+void IOAudioStream::applyDefaultControlGain(float *src, void *sampleBuf, UInt32 firstSampleFrame, UInt32 numSampleFrames)
+{
+	UInt32 numRampFrames;
+	
+	if (reserved->mGainUnity || !format.fIsMixable || !src) {
+		return;
+	}
+	
+	numRampFrames = (numSampleFrames < reserved->mGainRampFramesLeft) ? numSampleFrames : reserved->mGainRampFramesLeft;
+	if (numRampFrames > 0) {
+		reserved->mGain = gainRampFrames(src, sampleBuf, firstSampleFrame, numRampFrames, &format, reserved->mGain, reserved->mGainStep, reserved->mGainStepExponential);
+		reserved->mGainRampFramesLeft -= numRampFrames;
+		if (reserved->mGainRampFramesLeft == 0) {
+			reserved->mGain = reserved->mGainTarget;
+			reserved->mGainStep = 0.0f;
+			reserved->mGainStepExponential = false;
+		}
+		src += numRampFrames * format.fNumChannels;
+		firstSampleFrame += numRampFrames;
+	}
+	
+	if (numSampleFrames > numRampFrames) {
+		gainRampFrames(src, sampleBuf, firstSampleFrame, numSampleFrames - numRampFrames, &format, reserved->mGain, 0.0f, false);
+	}
+	
+	// Back at unity: later frames are converted or clipped as they are
+	if ((reserved->mGainRampFramesLeft == 0) && (reserved->mGain == 1.0f)) {
+		reserved->mGainUnity = true;
+	}
+}
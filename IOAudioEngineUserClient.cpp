@@ -400,6 +400,7 @@ bool IOAudioEngineUserClient::initWithAudioEngine(IOAudioEngine *engine, task_t
 							reserved->classicMode = 0;
 							reserved->commandGateStatus = kCommandGateStatus_Normal;	// <rdar://8518215>
 							reserved->commandGateUsage = 0;								// <rdar://8518215>
+							reserved->mappedInputStreams = 0;
 
 							workLoop->addEventSource(commandGate);
 							
@@ -774,6 +775,7 @@ bool IOAudioEngineUserClient::initWithAudioEngine(IOAudioEngine *engine, task_t
 							reserved->classicMode = 0;
 							reserved->commandGateStatus = kCommandGateStatus_Normal;	// <rdar://8518215>
 							reserved->commandGateUsage = 0;								// <rdar://8518215>
+							reserved->mappedInputStreams = 0;
 
 							workLoop->addEventSource(commandGate);
 							
@@ -1102,7 +1104,7 @@ void IOAudioEngineUserClient::unlockBuffers()
 IOReturn IOAudioEngineUserClient::clientMemoryForType(UInt32 type, UInt32 *flags, IOMemoryDescriptor **memory)
 {
     IOReturn						result = kIOReturnSuccess;
-	IOBufferMemoryDescriptor		*theMemoryDescriptor = NULL;
+	IOMemoryDescriptor				*theMemoryDescriptor = NULL;
 
     DbgLog("+ IOAudioEngineUserClient[%p]::clientMemoryForType(0x%lx, 0x%lx, %p)\n", this, (long unsigned int)type, (long unsigned int)*flags, memory);
 
@@ -1119,6 +1121,24 @@ IOReturn IOAudioEngineUserClient::clientMemoryForType(UInt32 type, UInt32 *flags
 			theMemoryDescriptor = audioEngine->getBytesInOutputBufferArrayDescriptor();
 			break;
         default:
+			if ((type & kIOAudioMemoryTypeMask) == kIOAudioInputSampleBuffer) {
+				UInt32			streamID = type >> kIOAudioMemoryStreamIDShift;
+				IOAudioStream	*audioStream = audioEngine->getStreamForID(streamID);
+				
+				// From now on this client reads the stream's samples from the mapping
+				if (audioStream && (audioStream->getDirection() == kIOAudioStreamDirectionInput) && (streamID < 64)) {
+					audioStream->lockStreamForIO();
+					theMemoryDescriptor = audioStream->getSharedInputSampleBuffer();
+					if (theMemoryDescriptor) {
+						reserved->mappedInputStreams |= (1ULL << streamID);
+					}
+					audioStream->unlockStreamForIO();
+				}
+				if (!theMemoryDescriptor) {
+					result = kIOReturnUnsupported;
+				}
+				break;
+			}
             result = kIOReturnUnsupported;
             break;
     }
@@ -1971,6 +1991,7 @@ static inline IOAudioBufferDataDescriptor * FlipBufferDataDescriptor(IOAudioBuff
 IOReturn IOAudioEngineUserClient::performClientOutput(UInt32 firstSampleFrame, UInt32 loopCount, IOAudioClientBufferSet *bufferSet, UInt32 sampleIntervalHi, UInt32 sampleIntervalLo)
 {
     IOReturn tmpResult, result = kIOReturnSuccess;
+    bool clipDeferred = false;
 
 	// <rdar://9725460>
 	DbgLog("+ IOAudioEngineUserClient[%p]::performClientOutput ( firstSampleFrame %ld, loopCount %ld,  bufferSet %p, sampleIntervalHi %ld, sampleIntervalLo %ld )\n",
@@ -2050,13 +2071,13 @@ IOReturn IOAudioEngineUserClient::performClientOutput(UInt32 firstSampleFrame, U
                     assert(audioStream->getDirection() == kIOAudioStreamDirectionOutput);
                     assert(clientBuf->mAudioClientBuffer32.sourceBuffer != NULL);
                     
-                    audioStream->lockStreamForIO();
+                    audioStream->lockStreamForOutputMix();
                     
                     maxNumSampleFrames = clientBuf->mAudioClientBuffer32.numSampleFrames;
                     // <rdar://6865619>, <rdar://6917678> Validate the parameters passed in IOAudioBufferDataDescriptor vs the maximum buffer size.
                     if ( numSampleFrames > maxNumSampleFrames ) {
                         DbgLog("  **** VBR OUTPUT ERROR! - actual sample frames (%ld) is larger than max sample frames (%ld)\n", (long int)numSampleFrames, (long int)maxNumSampleFrames);
-                        audioStream->unlockStreamForIO();
+                        audioStream->unlockStreamForOutputMix();
                         result = kIOReturnBadArgument;
                         goto Exit;
                     }
@@ -2082,7 +2103,7 @@ IOReturn IOAudioEngineUserClient::performClientOutput(UInt32 firstSampleFrame, U
                                                 (long unsigned int)localBufferDataDescriptorPtr->fNominalDataByteSize, 
                                                 (long unsigned int)localBufferDataDescriptorPtr->fTotalDataByteSize, 
                                                 (long unsigned int)clientBuf->mAudioClientBuffer32.sourceBufferDescriptor->getLength () - offsetof(IOAudioBufferDataDescriptor, fData ) );
-                            audioStream->unlockStreamForIO();
+                            audioStream->unlockStreamForOutputMix();
                             result = kIOReturnBadArgument;
                             goto Exit;
                         }	
@@ -2106,9 +2127,12 @@ IOReturn IOAudioEngineUserClient::performClientOutput(UInt32 firstSampleFrame, U
 
                     tmpResult = audioStream->processOutputSamples( &( clientBuf->mAudioClientBuffer32 ), firstSampleFrame, loopCount, true);
 
+                    // The stream may have left its clip to the engine, to be done with its other output streams below
+                    clipDeferred = clipDeferred || audioStream->reserved->mClipDeferred;
+                    
                     clientBuf->mAudioClientBuffer32.numSampleFrames = maxNumSampleFrames;
                     
-                    audioStream->unlockStreamForIO();
+                    audioStream->unlockStreamForOutputMix();
                     
                     if (tmpResult != kIOReturnSuccess) {
                         DbgLog("  processOutputSamples failed - result 0x%x\n", tmpResult );
@@ -2162,6 +2186,15 @@ IOReturn IOAudioEngineUserClient::performClientOutput(UInt32 firstSampleFrame, U
 	}
 
 Exit:
+	// Clip all the output streams that left their clip to the engine in one call, even after an error on a later buffer
+	if (clipDeferred) {
+		tmpResult = audioEngine->clipOutputStreams();
+		if ((tmpResult != kIOReturnSuccess) && (result == kIOReturnSuccess)) {
+			DbgLog("  clipOutputStreams failed - result 0x%x\n", tmpResult );
+			result = tmpResult;
+		}
+	}
+	
 	// <rdar://9725460>
 	DbgLog("- IOAudioEngineUserClient[%p]::performClientOutput ( firstSampleFrame %ld, loopCount %ld,  bufferSet %p, sampleIntervalHi %ld, sampleIntervalLo %ld ) returns 0x%lX\n", 
 					this,
@@ -2261,17 +2294,22 @@ IOReturn IOAudioEngineUserClient::performClientInput(UInt32 firstSampleFrame, IO
 		// set the default number of frames read.  This allows drivers to override readInputSamples and still work in the VBR world
 		audioStream->setDefaultNumSampleFramesRead(numSampleFrames);
         
-        tmpResult = audioStream->readInputSamples( &( clientBuf->mAudioClientBuffer32 ), firstSampleFrame);
+		// A client that mapped the sample buffer reads the samples from it; only the frames read are reported
+		if ((audioStream->reserved->mStreamID < 64) && (reserved->mappedInputStreams & (1ULL << audioStream->reserved->mStreamID)) && audioStream->getSharedInputSampleBuffer()) {
+			tmpResult = kIOReturnSuccess;
+		} else {
+			tmpResult = audioStream->readInputSamples( &( clientBuf->mAudioClientBuffer32 ), firstSampleFrame);
         
 #if __i386__ || __x86_64__	// <rdar://6612182>
-		if (reserved->classicMode && clientBuf->mAudioClientBuffer32.sourceBuffer != NULL) {
-			const IOAudioStreamFormat *fmt = audioStream->getFormat();
-			if (fmt->fIsMixable && fmt->fSampleFormat == kIOAudioStreamSampleFormatLinearPCM)
-			{
-				FlipFloats(clientBuf->mAudioClientBuffer32.sourceBuffer, clientBuf->mAudioClientBuffer32.numSampleFrames * clientBuf->mAudioClientBuffer32.numChannels);
+			if (reserved->classicMode && clientBuf->mAudioClientBuffer32.sourceBuffer != NULL) {
+				const IOAudioStreamFormat *fmt = audioStream->getFormat();
+				if (fmt->fIsMixable && fmt->fSampleFormat == kIOAudioStreamSampleFormatLinearPCM)
+				{
+					FlipFloats(clientBuf->mAudioClientBuffer32.sourceBuffer, clientBuf->mAudioClientBuffer32.numSampleFrames * clientBuf->mAudioClientBuffer32.numChannels);
+				}
 			}
-		}
 #endif        
+		}
 
 		// get how many samples the driver actually read & update the rest of the structures
 		numSampleFramesRead = audioStream->getNumSampleFramesRead();
@@ -2364,7 +2402,7 @@ void IOAudioEngineUserClient::performWatchdogOutput(IOAudioClientBufferSet *clie
 						numSampleFrames = clientBuffer->mAudioClientBuffer32.numSampleFrames;
 					}
 
-                    audioStream->lockStreamForIO();
+                    audioStream->lockStreamForOutputMix();
                     
 					// <rdar://8500809> Make sure that the number of sample frames to process is less than the total number of sample frames
 					// in the buffer.
@@ -2382,7 +2420,7 @@ void IOAudioEngineUserClient::performWatchdogOutput(IOAudioClientBufferSet *clie
 						clientBuffer->mAudioClientBuffer32.numSampleFrames = maxNumSampleFrames;
 					}
 
-                    audioStream->unlockStreamForIO();
+                    audioStream->unlockStreamForOutputMix();
                     
                     clientBuffer = clientBuffer->mNextBuffer64;
                 }
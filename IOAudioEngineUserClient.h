@@ -55,8 +55,8 @@ typedef struct IOAudioClientBuffer
     UInt32						numChannels;
     IOAudioEnginePosition		mixedPosition;
     struct IOAudioClientBuffer	*mNextBuffer32;
-    struct IOAudioClientBuffer	*nextClip;
-    struct IOAudioClientBuffer	*previousClip;
+    struct IOAudioClientBuffer	*nextClip;				// unused; output clients are ordered by IOAudioStream's clip queue
+    struct IOAudioClientBuffer	*previousClip;			// unused
     struct IOAudioClientBuffer	*nextClient;
 	IOAudioBufferDataDescriptor *bufferDataDescriptor;
 } IOAudioClientBuffer;
@@ -123,6 +123,7 @@ protected:
 		UInt32								classicMode;
 		UInt32								commandGateStatus;						// <rdar://8518215>
 		SInt32								commandGateUsage;						// <rdar://8518215>
+		UInt64								mappedInputStreams;						// a bit per stream ID whose sample buffer the client reads itself
 	};
 
 // <rdar://101000004> START
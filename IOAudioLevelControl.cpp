@@ -217,6 +217,7 @@ IOFixed IOAudioLevelControl::getMinDB()
     
 void IOAudioLevelControl::setMaxDB(IOFixed newMaxDB)
 {
+    maxDB = newMaxDB;
     setProperty(kIOAudioLevelControlMaxDBKey, newMaxDB, sizeof(IOFixed)*8);
 	sendChangeNotification(kIOAudioControlRangeChangeNotification);
 }
@@ -28,6 +28,8 @@
 #include "IOAudioTypes.h"
 #include "IOAudioDefines.h"
 
+#include "PCMBlitterLib/IOAudioBlitterLibDispatch.h"
+
 #include <IOKit/IOLib.h>
 #include <IOKit/IOWorkLoop.h>
 #include <IOKit/IOCommandGate.h>
@@ -53,6 +55,21 @@ typedef struct IOAudioStreamFormatDesc {
     IOAudioStreamFormatExtensionDesc	formatExtension;
 } IOAudioStreamFormatDesc;
 
+// Disables denormals for the lifetime of the object, for a whole IO cycle rather than per conversion.
+// Must be destroyed on the thread that created it, without blocking in between. Nesting is cheap: an
+// inner scope finds denormals already disabled and leaves the state alone.
+class IOAF_FlushDenormals {
+public:
+	IOAF_FlushDenormals() : savedState( IOAF_DisableDenormals() ) {}
+	~IOAF_FlushDenormals() { IOAF_RestoreDenormals( savedState ); }
+
+private:
+	IOAF_FlushDenormals( const IOAF_FlushDenormals & );
+	IOAF_FlushDenormals &operator=( const IOAF_FlushDenormals & );
+
+	UInt32	savedState;
+};
+
 #define super IOService
 OSDefineMetaClassAndStructors(IOAudioStream, IOService)
 
@@ -68,21 +85,21 @@ OSMetaClassDefineReservedUsed(IOAudioStream, 8);
 OSMetaClassDefineReservedUsed(IOAudioStream, 9);
 OSMetaClassDefineReservedUsed(IOAudioStream, 10);
 OSMetaClassDefineReservedUsed(IOAudioStream, 11);
+OSMetaClassDefineReservedUsed(IOAudioStream, 12);
+OSMetaClassDefineReservedUsed(IOAudioStream, 13);
+OSMetaClassDefineReservedUsed(IOAudioStream, 14);
+OSMetaClassDefineReservedUsed(IOAudioStream, 15);
+OSMetaClassDefineReservedUsed(IOAudioStream, 16);
+OSMetaClassDefineReservedUsed(IOAudioStream, 17);
+OSMetaClassDefineReservedUsed(IOAudioStream, 18);
+OSMetaClassDefineReservedUsed(IOAudioStream, 19);
+OSMetaClassDefineReservedUsed(IOAudioStream, 20);
+OSMetaClassDefineReservedUsed(IOAudioStream, 21);
+OSMetaClassDefineReservedUsed(IOAudioStream, 22);
+OSMetaClassDefineReservedUsed(IOAudioStream, 23);
+OSMetaClassDefineReservedUsed(IOAudioStream, 24);
+OSMetaClassDefineReservedUsed(IOAudioStream, 25);
 
-OSMetaClassDefineReservedUnused(IOAudioStream, 12);
-OSMetaClassDefineReservedUnused(IOAudioStream, 13);
-OSMetaClassDefineReservedUnused(IOAudioStream, 14);
-OSMetaClassDefineReservedUnused(IOAudioStream, 15);
-OSMetaClassDefineReservedUnused(IOAudioStream, 16);
-OSMetaClassDefineReservedUnused(IOAudioStream, 17);
-OSMetaClassDefineReservedUnused(IOAudioStream, 18);
-OSMetaClassDefineReservedUnused(IOAudioStream, 19);
-OSMetaClassDefineReservedUnused(IOAudioStream, 20);
-OSMetaClassDefineReservedUnused(IOAudioStream, 21);
-OSMetaClassDefineReservedUnused(IOAudioStream, 22);
-OSMetaClassDefineReservedUnused(IOAudioStream, 23);
-OSMetaClassDefineReservedUnused(IOAudioStream, 24);
-OSMetaClassDefineReservedUnused(IOAudioStream, 25);
 OSMetaClassDefineReservedUnused(IOAudioStream, 26);
 OSMetaClassDefineReservedUnused(IOAudioStream, 27);
 OSMetaClassDefineReservedUnused(IOAudioStream, 28);
@@ -117,6 +134,11 @@ OSMetaClassDefineReservedUnused(IOAudioStream, 47);
 
 #define kMixBufferMaxSize ( 2043 ) //  Limit to 2 pages but there is 16 bytes taken out of the sample buffer for VBR stuff
 
+// Clients mixing concurrently lock the mix buffer a tile of frames at a time.  A tile of Float32 frames is
+// a multiple of the cache line size, and the locks are striped over the tiles rather than one per tile.
+#define kConcurrentMixTileFrames	256
+#define kConcurrentMixTileLocks		16
+
 bool IOAudioStream::validateFormat(IOAudioStreamFormat *streamFormat, IOAudioStreamFormatExtension *formatExtension, IOAudioStreamFormatDesc *formatDesc, const IOAudioSampleRate *sampleRate)
 {
     bool foundFormat = false;
@@ -335,7 +357,7 @@ IOReturn IOAudioStream::setFormat(const IOAudioStreamFormat *streamFormat, const
 								newMixBufSize = validFormat.fNumChannels * kIOAudioEngineDefaultMixBufferSampleSize * audioEngine->numSampleFramesPerBuffer;
 			
 								if (newMixBufSize > 0) {
-									void *newMixBuf = IOMallocAligned(newMixBufSize, 32);
+									void *newMixBuf = audioEngine->checkOutMixBuffer(newMixBufSize);
 									if (newMixBuf) {
 										setMixBuffer(newMixBuf, newMixBufSize);
 										streamAllocatedMixBuffer = true;
@@ -349,6 +371,21 @@ IOReturn IOAudioStream::setFormat(const IOAudioStreamFormat *streamFormat, const
 						format = validFormat;
 						setProperty(kIOAudioStreamFormatKey, newFormatDict);
 						newFormatDict->release();
+						
+						// A mix buffer the old format gave back may fit no stream now
+						audioEngine->pruneMixBufferPool();
+						
+						// The noise shaping history, the active channels and the cached input belong to the old format
+						if (reserved->mDitherState) {
+							bzero(reserved->mDitherState->error, sizeof(reserved->mDitherState->error));
+						}
+						reserved->mActiveFirstChannel = 0;
+						reserved->mActiveNumChannels = 0;
+						reserved->mInputCacheStart = 0;
+						reserved->mInputCacheEnd = 0;
+						if (reserved->mInputCacheEnabled && (numClients > 1)) {
+							reallocateInputCache();
+						}
 		
 						if (format.fNumChannels != oldNumChannels) {
 							audioEngine->updateChannelNumbers();
@@ -527,6 +564,696 @@ void IOAudioStream::setDefaultNumSampleFramesRead(UInt32 inDefaultNumFramesRead)
 	reserved->mSampleFramesReadByEngine = inDefaultNumFramesRead;
 }
 
+// The fused output path only handles the formats the family converters can produce directly,
+// including samples narrower than their container (20 bits in 24, 24 in 32)
+static bool fusedOutputFormatSupported(const IOAudioStreamFormat *streamFormat)
+{
+	if ((streamFormat->fSampleFormat != kIOAudioStreamSampleFormatLinearPCM) ||
+		(streamFormat->fNumericRepresentation != kIOAudioStreamNumericRepresentationSignedInt) ||
+		(streamFormat->fBitDepth < 8) || (streamFormat->fBitDepth > streamFormat->fBitWidth)) {
+		return false;
+	}
+	
+	return (streamFormat->fBitWidth == 16) || (streamFormat->fBitWidth == 24) || (streamFormat->fBitWidth == 32);
+}
+
+// The default control gain can go into the conversion when it would be a plain one
+static bool gainConversionSupported(const IOAudioStreamFormat *streamFormat, bool writeCombined, IOAF_DitherState *ditherState)
+{
+	return fusedOutputFormatSupported(streamFormat) && (streamFormat->fBitDepth == streamFormat->fBitWidth) && !writeCombined && !ditherState;
+}
+
+// Dither, when there is a state for it, takes precedence over the non-temporal stores; 32-bit output is never dithered.
+// Both convert whole frames; otherwise only the active channels are converted. A sample narrower than its container
+// is rounded to its own depth and placed as fAlignment says, with plain stores and no dither.
+static void convertFloat32ToSampleBuffer(const float *src, void *sampleBuf, UInt32 firstSampleFrame, UInt32 numSampleFrames, const IOAudioStreamFormat *streamFormat, bool writeCombined, IOAF_DitherState *ditherState, bool noiseShaping, UInt32 firstActiveChannel, UInt32 numActiveChannels)
+{
+	UInt8			*dest = (UInt8 *)sampleBuf + (firstSampleFrame * streamFormat->fNumChannels * (streamFormat->fBitWidth / 8));
+	unsigned int	numSamples = numSampleFrames * streamFormat->fNumChannels;
+	bool			bigEndian = (streamFormat->fByteOrder == kIOAudioStreamByteOrderBigEndian);
+	
+	if (streamFormat->fBitDepth < streamFormat->fBitWidth) {
+		bool highAligned = (streamFormat->fAlignment == kIOAudioStreamAlignmentHighByte);
+		
+		if (bigEndian) {
+			IOAF_Float32ToBEIntJustified(src, dest, numSamples, streamFormat->fBitDepth, streamFormat->fBitWidth, highAligned);
+		} else {
+			IOAF_Float32ToLEIntJustified(src, dest, numSamples, streamFormat->fBitDepth, streamFormat->fBitWidth, highAligned);
+		}
+		return;
+	}
+	
+	if ((numActiveChannels < streamFormat->fNumChannels) && !ditherState && !writeCombined) {
+		switch (streamFormat->fBitWidth) {
+			case 16:
+				if (bigEndian) {
+					IOAF_Float32ToBEInt16Channels(src, (SInt16 *)dest, numSampleFrames, streamFormat->fNumChannels, firstActiveChannel, numActiveChannels);
+				} else {
+					IOAF_Float32ToLEInt16Channels(src, (SInt16 *)dest, numSampleFrames, streamFormat->fNumChannels, firstActiveChannel, numActiveChannels);
+				}
+				break;
+			case 24:
+				if (bigEndian) {
+					IOAF_Float32ToBEInt24Channels(src, dest, numSampleFrames, streamFormat->fNumChannels, firstActiveChannel, numActiveChannels);
+				} else {
+					IOAF_Float32ToLEInt24Channels(src, dest, numSampleFrames, streamFormat->fNumChannels, firstActiveChannel, numActiveChannels);
+				}
+				break;
+			case 32:
+				if (bigEndian) {
+					IOAF_Float32ToBEInt32Channels(src, (SInt32 *)dest, numSampleFrames, streamFormat->fNumChannels, firstActiveChannel, numActiveChannels);
+				} else {
+					IOAF_Float32ToLEInt32Channels(src, (SInt32 *)dest, numSampleFrames, streamFormat->fNumChannels, firstActiveChannel, numActiveChannels);
+				}
+				break;
+		}
+		return;
+	}
+	
+	switch (streamFormat->fBitWidth) {
+		case 16:
+			if (ditherState) {
+				if (bigEndian) {
+					IOAF_Float32ToBEInt16Dithered(src, (SInt16 *)dest, numSamples, streamFormat->fNumChannels, noiseShaping, ditherState);
+				} else {
+					IOAF_Float32ToLEInt16Dithered(src, (SInt16 *)dest, numSamples, streamFormat->fNumChannels, noiseShaping, ditherState);
+				}
+			} else if (writeCombined) {
+				if (bigEndian) {
+					IOAF_Float32ToBEInt16_ToWriteCombine(src, (SInt16 *)dest, numSamples);
+				} else {
+					IOAF_Float32ToLEInt16_ToWriteCombine(src, (SInt16 *)dest, numSamples);
+				}
+			} else if (bigEndian) {
+				IOAF_Float32ToBEInt16(src, (SInt16 *)dest, numSamples);
+			} else {
+				IOAF_Float32ToLEInt16(src, (SInt16 *)dest, numSamples);
+			}
+			break;
+		case 24:
+			if (ditherState) {
+				if (bigEndian) {
+					IOAF_Float32ToBEInt24Dithered(src, dest, numSamples, streamFormat->fNumChannels, noiseShaping, ditherState);
+				} else {
+					IOAF_Float32ToLEInt24Dithered(src, dest, numSamples, streamFormat->fNumChannels, noiseShaping, ditherState);
+				}
+			} else if (writeCombined) {
+				if (bigEndian) {
+					IOAF_Float32ToBEInt24_ToWriteCombine(src, dest, numSamples);
+				} else {
+					IOAF_Float32ToLEInt24_ToWriteCombine(src, dest, numSamples);
+				}
+			} else if (bigEndian) {
+				IOAF_Float32ToBEInt24(src, dest, numSamples);
+			} else {
+				IOAF_Float32ToLEInt24(src, dest, numSamples);
+			}
+			break;
+		case 32:
+			if (writeCombined) {
+				if (bigEndian) {
+					IOAF_Float32ToBEInt32_ToWriteCombine(src, (SInt32 *)dest, numSamples);
+				} else {
+					IOAF_Float32ToLEInt32_ToWriteCombine(src, (SInt32 *)dest, numSamples);
+				}
+			} else if (bigEndian) {
+				IOAF_Float32ToBEInt32(src, (SInt32 *)dest, numSamples);
+			} else {
+				IOAF_Float32ToLEInt32(src, (SInt32 *)dest, numSamples);
+			}
+			break;
+	}
+}
+
+static void convertSampleBufferToFloat32(const void *sampleBuf, float *dest, UInt32 numSampleFrames, const IOAudioStreamFormat *streamFormat)
+{
+	const UInt8		*src = (const UInt8 *)sampleBuf;
+	unsigned int	numSamples = numSampleFrames * streamFormat->fNumChannels;
+	bool			bigEndian = (streamFormat->fByteOrder == kIOAudioStreamByteOrderBigEndian);
+	
+	if (streamFormat->fBitDepth < streamFormat->fBitWidth) {
+		bool highAligned = (streamFormat->fAlignment == kIOAudioStreamAlignmentHighByte);
+		
+		if (bigEndian) {
+			IOAF_BEIntJustifiedToFloat32(src, dest, numSamples, streamFormat->fBitDepth, streamFormat->fBitWidth, highAligned);
+		} else {
+			IOAF_LEIntJustifiedToFloat32(src, dest, numSamples, streamFormat->fBitDepth, streamFormat->fBitWidth, highAligned);
+		}
+		return;
+	}
+	
+	switch (streamFormat->fBitWidth) {
+		case 16:
+			if (bigEndian) {
+				IOAF_BEInt16ToFloat32((const SInt16 *)src, dest, numSamples);
+			} else {
+				IOAF_LEInt16ToFloat32((const SInt16 *)src, dest, numSamples);
+			}
+			break;
+		case 24:
+			if (bigEndian) {
+				IOAF_BEInt24ToFloat32(src, dest, numSamples);
+			} else {
+				IOAF_LEInt24ToFloat32(src, dest, numSamples);
+			}
+			break;
+		case 32:
+			if (bigEndian) {
+				IOAF_BEInt32ToFloat32((const SInt32 *)src, dest, numSamples);
+			} else {
+				IOAF_LEInt32ToFloat32((const SInt32 *)src, dest, numSamples);
+			}
+			break;
+	}
+}
+
+void IOAudioStream::setFusedOutputConversion(bool enable)
+{
+	assert(reserved);
+    DbgLog("+-IOAudioStream[%p]::setFusedOutputConversion(%d)\n", this, enable);
+	
+	lockStreamForIO();
+	reserved->mFusedOutputEnabled = enable;
+	unlockStreamForIO();
+}
+
+void IOAudioStream::setSampleBufferWriteCombined(bool writeCombined)
+{
+	assert(reserved);
+    DbgLog("+-IOAudioStream[%p]::setSampleBufferWriteCombined(%d)\n", this, writeCombined);
+	
+	lockStreamForIO();
+	reserved->mSampleBufferWriteCombined = writeCombined;
+	unlockStreamForIO();
+}
+
+bool IOAudioStream::isSampleBufferWriteCombined()
+{
+	assert(reserved);
+	return reserved->mSampleBufferWriteCombined;
+}
+
+IOReturn IOAudioStream::setDefaultControlGainRamp(bool enable, UInt32 numSampleFrames, bool exponential)
+{
+	assert(reserved);
+    DbgLog("+-IOAudioStream[%p]::setDefaultControlGainRamp(%d, %ld, %d)\n", this, enable, (long int)numSampleFrames, exponential);
+	
+	if (getDirection() != kIOAudioStreamDirectionOutput) {
+		return kIOReturnUnsupported;
+	}
+	
+	lockStreamForIO();
+	
+	reserved->mGainRampFrames = numSampleFrames;
+	reserved->mGainRampExponential = exponential;
+	
+	if (enable != reserved->mGainRampEnabled) {
+		reserved->mGainRampEnabled = enable;
+		resetDefaultControlGain();
+		
+		if (enable && defaultAudioControls) {
+			OSCollectionIterator *controlIterator = OSCollectionIterator::withCollection(defaultAudioControls);
+			
+			// Start from the controls' current values
+			if (controlIterator) {
+				IOAudioControl *control;
+				
+				while ( (control = (IOAudioControl *)controlIterator->getNextObject()) ) {
+					updateDefaultControlGain(control, 0);
+				}
+				
+				controlIterator->release();
+			}
+		}
+	}
+	
+	unlockStreamForIO();
+	
+	return kIOReturnSuccess;
+}
+
+void IOAudioStream::defaultAudioControlChanged(IOAudioControl *control)
+{
+	assert(reserved);
+	
+	// Most drivers never enable the gain, so don't take the IO lock just to find that out
+	if (control && reserved->mGainRampEnabled) {
+		lockStreamForIO();
+		if (reserved->mGainRampEnabled) {
+			updateDefaultControlGain(control, reserved->mGainRampFrames);
+		}
+		unlockStreamForIO();
+	}
+}
+
+IOReturn IOAudioStream::setOutputDither(bool enable, bool noiseShaping)
+{
+	IOAF_DitherState *ditherState = NULL;
+	
+	assert(reserved);
+    DbgLog("+-IOAudioStream[%p]::setOutputDither(%d, %d)\n", this, enable, noiseShaping);
+	
+	if (getDirection() != kIOAudioStreamDirectionOutput) {
+		return kIOReturnUnsupported;
+	}
+	
+	// Allocated outside the lock; each stream gets its own noise
+	if (enable && !reserved->mDitherState) {
+		ditherState = (IOAF_DitherState *)IOMallocAligned(sizeof(IOAF_DitherState), 16);
+		if (!ditherState) {
+			return kIOReturnNoMemory;
+		}
+		IOAF_DitherStateInit(ditherState, (UInt32)(uintptr_t)this);
+	}
+	
+	lockStreamForIO();
+	
+	reserved->mOutputNoiseShaping = noiseShaping;
+	if (enable && !reserved->mDitherState) {
+		reserved->mDitherState = ditherState;
+		ditherState = NULL;
+	} else if (!enable) {
+		ditherState = reserved->mDitherState;
+		reserved->mDitherState = NULL;
+	}
+	
+	unlockStreamForIO();
+	
+	if (ditherState) {
+		IOFreeAligned(ditherState, sizeof(IOAF_DitherState));
+	}
+	
+	return kIOReturnSuccess;
+}
+
+IOAF_DitherState *IOAudioStream::getOutputDitherState(bool *noiseShaping)
+{
+	assert(reserved);
+	
+	if (noiseShaping) {
+		*noiseShaping = reserved->mOutputNoiseShaping;
+	}
+	
+	return reserved->mDitherState;
+}
+
+void IOAudioStream::setActiveChannelTracking(bool enable)
+{
+	assert(reserved);
+    DbgLog("+-IOAudioStream[%p]::setActiveChannelTracking(%d)\n", this, enable);
+	
+	lockStreamForIO();
+	reserved->mActiveChannelTracking = enable;
+	reserved->mActiveFirstChannel = 0;
+	reserved->mActiveNumChannels = 0;
+	unlockStreamForIO();
+}
+
+void IOAudioStream::getActiveChannels(UInt32 *firstChannel, UInt32 *numChannels)
+{
+	assert(reserved);
+	
+	if (reserved->mActiveChannelTracking) {
+		*firstChannel = reserved->mActiveFirstChannel;
+		*numChannels = reserved->mActiveNumChannels;
+	} else {
+		*firstChannel = 0;
+		*numChannels = format.fNumChannels;
+	}
+}
+
+IOReturn IOAudioStream::setConcurrentOutputMixing(bool enable)
+{
+	IOReturn result = kIOReturnSuccess;
+	
+	assert(reserved);
+    DbgLog("+-IOAudioStream[%p]::setConcurrentOutputMixing(%d)\n", this, enable);
+	
+	if (getDirection() != kIOAudioStreamDirectionOutput) {
+		return kIOReturnUnsupported;
+	}
+	
+	lockStreamForIO();
+	
+	// The locks are kept until the stream is freed, including any allocated by an earlier call that failed
+	if (enable && !reserved->mOutputMixLock) {
+		UInt32 tile;
+		
+		if (!reserved->mClipStateLock) {
+			reserved->mClipStateLock = IOLockAlloc();
+		}
+		if (!reserved->mMixTileLocks) {
+			reserved->mMixTileLocks = (IOLock **)IOMalloc(kConcurrentMixTileLocks * sizeof(IOLock *));
+			if (reserved->mMixTileLocks) {
+				bzero(reserved->mMixTileLocks, kConcurrentMixTileLocks * sizeof(IOLock *));
+			}
+		}
+		if (reserved->mMixTileLocks) {
+			for (tile = 0; tile < kConcurrentMixTileLocks; tile++) {
+				if (!reserved->mMixTileLocks[tile]) {
+					reserved->mMixTileLocks[tile] = IOLockAlloc();
+				}
+				if (!reserved->mMixTileLocks[tile]) {
+					result = kIOReturnNoMemory;
+				}
+			}
+		}
+		if (!reserved->mClipStateLock || !reserved->mMixTileLocks) {
+			result = kIOReturnNoMemory;
+		}
+		
+		// Only a stream with all of its locks is ever mixed concurrently
+		if (result == kIOReturnSuccess) {
+			reserved->mOutputMixLock = IORWLockAlloc();
+			if (!reserved->mOutputMixLock) {
+				result = kIOReturnNoMemory;
+			}
+		}
+	}
+	
+	// The output mix lock is held exclusively while the stream is locked for IO and clients mix concurrently,
+	// so take or drop it here as lockStreamForIO() would have
+	if ((result == kIOReturnSuccess) && (enable != reserved->mConcurrentMixing)) {
+		if (enable) {
+			IORWLockWrite(reserved->mOutputMixLock);
+			reserved->mConcurrentMixing = true;
+		} else {
+			reserved->mConcurrentMixing = false;
+			IORWLockUnlock(reserved->mOutputMixLock);
+		}
+	}
+	
+	unlockStreamForIO();
+	
+	return result;
+}
+
+// Only changed with the stream locked for IO, so it holds for as long as a client has the stream locked either way
+bool IOAudioStream::outputMixesConcurrently()
+{
+	return reserved && reserved->mConcurrentMixing && format.fIsMixable && mixBuffer && !(audioIOFunctions && (numIOFunctions != 0));
+}
+
+void IOAudioStream::lockStreamForOutputMix()
+{
+	// Check again once locked, as the stream may have changed while waiting
+	while (true) {
+		if (outputMixesConcurrently()) {
+			IORWLockRead(reserved->mOutputMixLock);
+			if (outputMixesConcurrently()) {
+				break;
+			}
+			IORWLockUnlock(reserved->mOutputMixLock);
+		} else {
+			lockStreamForIO();
+			if (!outputMixesConcurrently()) {
+				break;
+			}
+			unlockStreamForIO();
+		}
+	}
+}
+
+void IOAudioStream::unlockStreamForOutputMix()
+{
+	if (outputMixesConcurrently()) {
+		IORWLockUnlock(reserved->mOutputMixLock);
+	} else {
+		unlockStreamForIO();
+	}
+}
+
+// Mixes the active channels of a client's samples.  A lone client's samples are copied, as
+// IOAudioStream::mixOutputSamples() does, and the other channels are left alone.  The caller reads the
+// active channels once they include this client's, as they may be widened while it mixes.
+IOReturn IOAudioStream::mixActiveChannels(const float *sourceBuf, UInt32 firstSampleFrame, UInt32 numSampleFrames, UInt32 firstChannel, UInt32 numActive)
+{
+	UInt32	numChannels = format.fNumChannels;
+	float *	mixBuf = (float *)mixBuffer + (firstSampleFrame * numChannels);
+	
+	if (!sourceBuf || !mixBuffer) {
+		return kIOReturnBadArgument;
+	}
+	
+	if (numClients > 1) {
+		IOAF_MixFloat32Channels(sourceBuf, mixBuf, numSampleFrames, numChannels, firstChannel, numActive);
+	} else if (numActive == numChannels) {
+		bcopy(sourceBuf, mixBuf, numSampleFrames * numChannels * sizeof(float));
+	} else if (numActive > 0) {
+		UInt32 frame;
+		
+		for (frame = 0; frame < numSampleFrames; frame++) {
+			bcopy(sourceBuf + firstChannel, mixBuf + firstChannel, numActive * sizeof(float));
+			sourceBuf += numChannels;
+			mixBuf += numChannels;
+		}
+	}
+	
+	return kIOReturnSuccess;
+}
+
+IOReturn IOAudioStream::setInputConversionCache(bool enable)
+{
+	IOReturn result = kIOReturnSuccess;
+	
+	assert(reserved);
+    DbgLog("+-IOAudioStream[%p]::setInputConversionCache(%d)\n", this, enable);
+	
+	if (getDirection() != kIOAudioStreamDirectionInput) {
+		return kIOReturnUnsupported;
+	}
+	
+	lockStreamForIO();
+	reserved->mInputCacheEnabled = enable;
+	reserved->mInputCacheStart = 0;
+	reserved->mInputCacheEnd = 0;
+	if (!enable || (numClients > 1)) {
+		result = reallocateInputCache();
+	}
+	unlockStreamForIO();
+	
+	return result;
+}
+
+// The input cache holds a whole sample buffer of Float32 frames in the current format.  Called with the stream locked.
+IOReturn IOAudioStream::reallocateInputCache()
+{
+	UInt32 numSampleFramesPerBuffer = audioEngine->getNumSampleFramesPerBuffer();
+	UInt32 size = numSampleFramesPerBuffer * format.fNumChannels * sizeof(float);
+	
+	if (reserved->mInputCacheEnabled && format.fIsMixable && (reserved->mInputCacheSize == size) && (reserved->mInputCacheFrames == numSampleFramesPerBuffer)) {
+		return kIOReturnSuccess;
+	}
+	
+	if (reserved->mInputCache) {
+		IOFreeAligned(reserved->mInputCache, reserved->mInputCacheSize);
+		reserved->mInputCache = NULL;
+		reserved->mInputCacheSize = 0;
+	}
+	reserved->mInputCacheFrames = 0;
+	reserved->mInputCacheStart = 0;
+	reserved->mInputCacheEnd = 0;
+	
+	if (reserved->mInputCacheEnabled && format.fIsMixable && (size > 0)) {
+		reserved->mInputCache = (float *)IOMallocAligned(size, 32);
+		if (!reserved->mInputCache) {
+			return kIOReturnNoMemory;
+		}
+		reserved->mInputCacheSize = size;
+		reserved->mInputCacheFrames = numSampleFramesPerBuffer;
+	}
+	
+	return kIOReturnSuccess;
+}
+
+// Works out where the frames a client reads are in the engine's input since it started, which tells the same
+// frames apart from the ones the engine writes over them a loop later.  Returns false if the cache can't be used.
+bool IOAudioStream::findInputCachePosition(UInt32 firstSampleFrame, UInt32 numSampleFrames, UInt64 *position)
+{
+	UInt32 numSampleFramesPerBuffer = audioEngine->getNumSampleFramesPerBuffer();
+	UInt32 currentSampleFrame;
+	UInt32 loopCount;
+	AbsoluteTime loopTime;
+	
+	if (!reserved->mInputCacheEnabled || (numClients < 2) || !format.fIsMixable || !reserved->mInputCache ||
+		(reserved->mInputCacheFrames != numSampleFramesPerBuffer) ||
+		(reserved->mInputCacheSize != numSampleFramesPerBuffer * format.fNumChannels * sizeof(float)) ||
+		(numSampleFrames == 0) || (numSampleFrames > numSampleFramesPerBuffer)) {
+		return false;
+	}
+	
+	if (audioEngine->getLoopCountAndTimeStamp(&loopCount, &loopTime) != kIOReturnSuccess) {
+		return false;
+	}
+	
+	// The engine has restarted if its loop count went back or the same loop has a new time
+	if ((loopCount < reserved->mInputCacheLoopCount) ||
+		((loopCount == reserved->mInputCacheLoopCount) && (CMP_ABSOLUTETIME(&loopTime, &reserved->mInputCacheLoopTime) != 0))) {
+		reserved->mInputCacheStart = 0;
+		reserved->mInputCacheEnd = 0;
+	}
+	reserved->mInputCacheLoopCount = loopCount;
+	reserved->mInputCacheLoopTime = loopTime;
+	
+	// Frames at or after the current position were written in the previous loop.  Just after the
+	// position wraps the loop count may not have been taken yet, so don't trust it then.
+	currentSampleFrame = audioEngine->getCurrentSampleFrame();
+	if ((currentSampleFrame < numSampleFrames) || (currentSampleFrame >= numSampleFramesPerBuffer)) {
+		return false;
+	}
+	if (firstSampleFrame >= currentSampleFrame) {
+		if (loopCount == 0) {
+			return false;
+		}
+		loopCount--;
+	}
+	
+	*position = ((UInt64)loopCount * numSampleFramesPerBuffer) + firstSampleFrame;
+	
+	return true;
+}
+
+// Converts frames that don't wrap into the same place in the input cache
+IOReturn IOAudioStream::convertInputSamplesToCache(UInt32 firstSampleFrame, UInt32 numSampleFrames)
+{
+	IOReturn result = kIOReturnError;
+	float *dest = reserved->mInputCache + (firstSampleFrame * format.fNumChannels);
+	
+	if (audioIOFunctions && (numIOFunctions != 0)) {
+		UInt32 functionNum;
+		
+		for (functionNum = 0; functionNum < numIOFunctions; functionNum++) {
+			if (audioIOFunctions[functionNum]) {
+				result = audioIOFunctions[functionNum](sampleBuffer, dest, firstSampleFrame, numSampleFrames, &format, this);
+				if (result != kIOReturnSuccess) {
+					break;
+				}
+			}
+		}
+	} else {
+		UInt32 numReadFrames = numSampleFrames;
+		
+		result = audioEngine->convertInputSamplesVBR(sampleBuffer, dest, firstSampleFrame, numReadFrames, &format, this);
+	}
+	
+	return result;
+}
+
+// readInputSamples() for a client of a stream with the input cache.  The frames are only converted if the
+// cache doesn't already hold them; either way the client gets a copy from the cache.
+IOReturn IOAudioStream::readCachedInputSamples(IOAudioClientBuffer *clientBuffer, UInt32 firstSampleFrame, UInt64 position)
+{
+	IOReturn result = kIOReturnSuccess;
+	UInt32 numSampleFramesPerBuffer = reserved->mInputCacheFrames;
+	UInt32 numSampleFrames = clientBuffer->numSampleFrames;
+	UInt32 numChannels = format.fNumChannels;
+	UInt32 numFirstFrames = numSampleFrames;
+	UInt64 endPosition = position + numSampleFrames;
+	
+	if ((firstSampleFrame + numSampleFrames) > numSampleFramesPerBuffer) {
+		numFirstFrames = numSampleFramesPerBuffer - firstSampleFrame;
+	}
+	
+	if ((position < reserved->mInputCacheStart) || (endPosition > reserved->mInputCacheEnd)) {
+		result = convertInputSamplesToCache(firstSampleFrame, numFirstFrames);
+		if ((result == kIOReturnSuccess) && (numFirstFrames < numSampleFrames)) {
+			result = convertInputSamplesToCache(0, numSampleFrames - numFirstFrames);
+		}
+		
+		if (result != kIOReturnSuccess) {
+			// Some of the cached frames may have been written over
+			reserved->mInputCacheStart = 0;
+			reserved->mInputCacheEnd = 0;
+			return result;
+		}
+		
+		// Add the frames to the ones held if they touch, keeping the ones this conversion didn't write over
+		if ((reserved->mInputCacheStart == reserved->mInputCacheEnd) || (position > reserved->mInputCacheEnd) || (endPosition < reserved->mInputCacheStart)) {
+			reserved->mInputCacheStart = position;
+			reserved->mInputCacheEnd = endPosition;
+		} else {
+			if (endPosition >= reserved->mInputCacheEnd) {
+				reserved->mInputCacheEnd = endPosition;
+				if (position < reserved->mInputCacheStart) {
+					reserved->mInputCacheStart = position;
+				}
+				if ((reserved->mInputCacheEnd - reserved->mInputCacheStart) > numSampleFramesPerBuffer) {
+					reserved->mInputCacheStart = reserved->mInputCacheEnd - numSampleFramesPerBuffer;
+				}
+			} else {
+				reserved->mInputCacheStart = position;
+				if ((reserved->mInputCacheEnd - reserved->mInputCacheStart) > numSampleFramesPerBuffer) {
+					reserved->mInputCacheEnd = reserved->mInputCacheStart + numSampleFramesPerBuffer;
+				}
+			}
+		}
+	}
+	
+	bcopy(reserved->mInputCache + (firstSampleFrame * numChannels), clientBuffer->sourceBuffer, numFirstFrames * numChannels * sizeof(float));
+	if (numFirstFrames < numSampleFrames) {
+		bcopy(reserved->mInputCache, ((float *)clientBuffer->sourceBuffer) + (numFirstFrames * numChannels), (numSampleFrames - numFirstFrames) * numChannels * sizeof(float));
+	}
+	reserved->mSampleFramesReadByEngine = numSampleFrames;
+	
+	return result;
+}
+
+// The samples a client can read out of the sample buffer just as they would arrive in its own buffer
+static bool sharedInputFormatSupported(const IOAudioStreamFormat *streamFormat)
+{
+#if __BIG_ENDIAN__
+	UInt8 nativeByteOrder = kIOAudioStreamByteOrderBigEndian;
+#else
+	UInt8 nativeByteOrder = kIOAudioStreamByteOrderLittleEndian;
+#endif
+
+	return (streamFormat->fSampleFormat == kIOAudioStreamSampleFormatLinearPCM) &&
+		   (streamFormat->fNumericRepresentation == kIOAudioStreamNumericRepresentationIEEE754Float) &&
+		   (streamFormat->fBitWidth == 32) && (streamFormat->fBitDepth == 32) &&
+		   (streamFormat->fByteOrder == nativeByteOrder) && streamFormat->fIsMixable;
+}
+
+IOReturn IOAudioStream::setSharedInputSampleBuffer(IOMemoryDescriptor *sampleBufferDescriptor)
+{
+	IOReturn result = kIOReturnSuccess;
+	
+	assert(reserved);
+    DbgLog("+-IOAudioStream[%p]::setSharedInputSampleBuffer(%p)\n", this, sampleBufferDescriptor);
+	
+	if (getDirection() != kIOAudioStreamDirectionInput) {
+		return kIOReturnUnsupported;
+	}
+	
+	lockStreamForIO();
+	
+	if (sampleBufferDescriptor && (sampleBufferDescriptor->getLength() < sampleBufferSize)) {
+		result = kIOReturnBadArgument;
+	} else {
+		if (sampleBufferDescriptor) {
+			sampleBufferDescriptor->retain();
+		}
+		if (reserved->mSharedInputSampleBuffer) {
+			reserved->mSharedInputSampleBuffer->release();
+		}
+		reserved->mSharedInputSampleBuffer = sampleBufferDescriptor;
+		setProperty(kIOAudioStreamInputSampleBufferSharedKey, (sampleBufferDescriptor != NULL));
+	}
+	
+	unlockStreamForIO();
+	
+	return result;
+}
+
+// Returns the sample buffer for a client to map, or NULL if the current format can't be read from it directly
+IOMemoryDescriptor *IOAudioStream::getSharedInputSampleBuffer()
+{
+	if (!reserved || !reserved->mSharedInputSampleBuffer || !sampleBuffer || !sharedInputFormatSupported(&format)) {
+		return NULL;
+	}
+	
+	return reserved->mSharedInputSampleBuffer;
+}
+
 // Original code from here on:
 const OSSymbol *IOAudioStream::gDirectionKey = NULL;
 const OSSymbol *IOAudioStream::gNumChannelsKey = NULL;
@@ -749,6 +1476,50 @@ bool IOAudioStream::initWithAudioEngine(IOAudioEngine *engine, IOAudioStreamDire
 	if (!reserved) {
 		return false;
 	}
+	
+	reserved->mFusedOutputEnabled = false;
+	reserved->mFusedOutputClipped = false;
+	reserved->mClipDeferred = false;
+	reserved->mClipBatched = false;
+	reserved->mMixBufferStale = false;
+	reserved->mSampleBufferWriteCombined = false;
+	reserved->mGainRampEnabled = false;
+	reserved->mGainRampExponential = false;
+	reserved->mGainRampFrames = 0;
+	resetDefaultControlGain();
+	reserved->mOutputNoiseShaping = false;
+	reserved->mDitherState = NULL;
+	reserved->mActiveChannelTracking = false;
+	reserved->mActiveFirstChannel = 0;
+	reserved->mActiveNumChannels = 0;
+	reserved->mClipQueue = NULL;
+	reserved->mClipQueueCount = 0;
+	reserved->mClipQueueCapacity = 0;
+	reserved->mClipSlots = NULL;
+	reserved->mClipSlotsMask = 0;
+	reserved->mConcurrentMixing = false;
+	reserved->mStreamIODepth = 0;
+	reserved->mOutputMixLock = NULL;
+	reserved->mClipStateLock = NULL;
+	reserved->mMixTileLocks = NULL;
+	reserved->mMixBatches = NULL;
+	reserved->mMixBatchCount[0] = 0;
+	reserved->mMixBatchCount[1] = 0;
+	reserved->mMixBatchResult[0] = kIOReturnSuccess;
+	reserved->mMixBatchResult[1] = kIOReturnSuccess;
+	reserved->mMixBatchOpen = 1;
+	reserved->mMixBatchDone = 0;
+	reserved->mMixBatchMixing = false;
+	reserved->mInputCacheEnabled = false;
+	reserved->mInputCache = NULL;
+	reserved->mInputCacheSize = 0;
+	reserved->mInputCacheFrames = 0;
+	reserved->mInputCacheStart = 0;
+	reserved->mInputCacheEnd = 0;
+	reserved->mInputCacheLoopCount = 0;
+	AbsoluteTime_to_scalar(&reserved->mInputCacheLoopTime) = 0;
+	reserved->mStreamID = 0;
+	reserved->mSharedInputSampleBuffer = NULL;
 
     workLoop = audioEngine->getWorkLoop();
     if (!workLoop) {
@@ -787,6 +1558,7 @@ bool IOAudioStream::initWithAudioEngine(IOAudioEngine *engine, IOAudioStreamDire
 	// This needs to change to passing up a token rather than the "this" pointer.
 	streamID = engine->getNextStreamID (this);
     setProperty(kIOAudioStreamIDKey, streamID, sizeof(UInt32)*8);
+    reserved->mStreamID = streamID;
 //    setProperty(kIOAudioStreamIDKey, (UInt32)this, sizeof(UInt32)*8);
     
     streamAvailable = true;
@@ -830,6 +1602,65 @@ void IOAudioStream::free()
         defaultAudioControls->release();
         defaultAudioControls = NULL;
     }
+    
+    if (reserved && reserved->mDitherState) {
+        IOFreeAligned(reserved->mDitherState, sizeof(IOAF_DitherState));
+        reserved->mDitherState = NULL;
+    }
+    
+    if (reserved && reserved->mMixBatches) {
+        IOFree(reserved->mMixBatches, 4 * reserved->mClipQueueCapacity * sizeof(IOAudioMixSource));
+        reserved->mMixBatches = NULL;
+    }
+    
+    if (reserved && reserved->mClipQueue) {
+        IOFree(reserved->mClipQueue, reserved->mClipQueueCapacity * sizeof(IOAudioClientBuffer *));
+        reserved->mClipQueue = NULL;
+        reserved->mClipQueueCapacity = 0;
+    }
+    
+    if (reserved && reserved->mClipSlots) {
+        IOFree(reserved->mClipSlots, (reserved->mClipSlotsMask + 1) * sizeof(IOAudioClipSlot));
+        reserved->mClipSlots = NULL;
+        reserved->mClipSlotsMask = 0;
+    }
+    
+    if (reserved && reserved->mSharedInputSampleBuffer) {
+        reserved->mSharedInputSampleBuffer->release();
+        reserved->mSharedInputSampleBuffer = NULL;
+    }
+    
+    if (reserved && reserved->mInputCache) {
+        IOFreeAligned(reserved->mInputCache, reserved->mInputCacheSize);
+        reserved->mInputCache = NULL;
+        reserved->mInputCacheSize = 0;
+    }
+    
+    if (reserved) {
+        reserved->mConcurrentMixing = false;
+    }
+    
+    if (reserved && reserved->mMixTileLocks) {
+        UInt32 tile;
+        
+        for (tile = 0; tile < kConcurrentMixTileLocks; tile++) {
+            if (reserved->mMixTileLocks[tile]) {
+                IOLockFree(reserved->mMixTileLocks[tile]);
+            }
+        }
+        IOFree(reserved->mMixTileLocks, kConcurrentMixTileLocks * sizeof(IOLock *));
+        reserved->mMixTileLocks = NULL;
+    }
+    
+    if (reserved && reserved->mClipStateLock) {
+        IOLockFree(reserved->mClipStateLock);
+        reserved->mClipStateLock = NULL;
+    }
+    
+    if (reserved && reserved->mOutputMixLock) {
+        IORWLockFree(reserved->mOutputMixLock);
+        reserved->mOutputMixLock = NULL;
+    }
 
     if (commandGate) {
         if (workLoop) {
@@ -879,6 +1710,11 @@ void IOAudioStream::free()
 
 void IOAudioStream::stop(IOService *provider)
 {
+    // Give the mix buffer back to the engine while it's still around
+    if (mixBuffer && streamAllocatedMixBuffer) {
+        setMixBuffer(NULL, 0);
+    }
+    
     if (commandGate) {
         if (workLoop) {
             workLoop->removeEventSource(commandGate);
@@ -957,6 +1793,13 @@ void IOAudioStream::setSampleBuffer(void *buffer, UInt32 size)
         sampleBufferSize = 0;
     }
     
+    // Clients may no longer map the old buffer; they keep any mapping they have
+    if (reserved && reserved->mSharedInputSampleBuffer) {
+        reserved->mSharedInputSampleBuffer->release();
+        reserved->mSharedInputSampleBuffer = NULL;
+        setProperty(kIOAudioStreamInputSampleBufferSharedKey, false);
+    }
+    
     unlockStreamForIO();
 }
 
@@ -975,7 +1818,8 @@ void IOAudioStream::setMixBuffer(void *buffer, UInt32 size)
     lockStreamForIO();
       
     if (mixBuffer && streamAllocatedMixBuffer) {
-        IOFreeAligned(mixBuffer, mixBufferSize);
+        assert(audioEngine);
+        audioEngine->checkInMixBuffer(mixBuffer, mixBufferSize);
         mixBuffer = NULL;
         mixBufferSize = 0;
         streamAllocatedMixBuffer = false;
@@ -1116,69 +1960,252 @@ IOReturn IOAudioStream::setFormat(const IOAudioStreamFormat *streamFormat, OSDic
 
 IOReturn IOAudioStream::hardwareFormatChanged(const IOAudioStreamFormat *streamFormat)
 {
-	assert(reserved);
-    return setFormat(streamFormat, &reserved->streamFormatExtension, false);
+	assert(reserved);
+    return setFormat(streamFormat, &reserved->streamFormatExtension, false);
+}
+
+void IOAudioStream::addAvailableFormat(const IOAudioStreamFormat *streamFormat, const IOAudioSampleRate *minRate, const IOAudioSampleRate *maxRate, AudioIOFunction ioFunction)
+{
+    addAvailableFormat(streamFormat, NULL, minRate, maxRate, &ioFunction, 1);
+}
+
+void IOAudioStream::addAvailableFormat(const IOAudioStreamFormat *streamFormat, const IOAudioSampleRate *minRate, const IOAudioSampleRate *maxRate, const AudioIOFunction *ioFunctionList, UInt32 numFunctions)
+{
+    addAvailableFormat(streamFormat, NULL, minRate, maxRate, ioFunctionList, numFunctions);
+}
+
+void IOAudioStream::clearAvailableFormats()
+{
+	OSArray*	oldAvailableFormats;
+	OSArray*	clearedAvailableFormats;
+	
+    assert(availableFormatDictionaries);
+	
+	oldAvailableFormats = availableFormatDictionaries;
+	
+    clearedAvailableFormats = OSArray::withCapacity(1);
+    if (!clearedAvailableFormats) {
+        return;
+    }
+	availableFormatDictionaries = clearedAvailableFormats;
+    setProperty(kIOAudioStreamAvailableFormatsKey, availableFormatDictionaries);
+	
+    oldAvailableFormats->release();
+
+	//	<rdar://9059646> Clean up the available formats array.
+	if (availableFormats && (numAvailableFormats > 0)) {
+		IOFreeAligned(availableFormats, numAvailableFormats * sizeof(IOAudioStreamFormatDesc));
+	}
+	availableFormats = NULL;
+	numAvailableFormats = 0;
+}
+
+bool IOAudioStream::validateFormat(IOAudioStreamFormat *streamFormat, IOAudioStreamFormatDesc *formatDesc)
+{
+	return validateFormat(streamFormat, NULL, formatDesc);
+}
+
+UInt32 IOAudioStream::getStartingChannelID()
+{
+    return startingChannelID;
+}
+
+UInt32 IOAudioStream::getMaxNumChannels()
+{
+    return maxNumChannels;
+}
+
+void IOAudioStream::setStartingChannelNumber(UInt32 channelNumber)
+{
+    setProperty(kIOAudioStreamStartingChannelNumberKey, channelNumber, sizeof(UInt32)*8);
+}
+
+void IOAudioStream::updateNumClients()
+{
+    setProperty(kIOAudioStreamNumClientsKey, numClients, sizeof(UInt32)*8);
+}
+
+// The clip queue holds the output clients that have mixed, as a binary min-heap on mixedPosition:
+// the earliest, which clipIfNecessary() clips up to, is always on top, and a client that mixes
+// moves to its new place in O(log n). The stream finds a client's slot in mClipSlots, an open
+// addressed table from the client buffer to its slot + 1 that is never more than half full.
+
+struct IOAudioClipSlot {
+    IOAudioClientBuffer		*clientBuffer;		// NULL for an empty entry
+    UInt32					index;				// slot in the clip queue + 1
+};
+
+// Where the client's entry goes if the table has room there
+static inline UInt32 clipSlotHome(UInt32 slotsMask, IOAudioClientBuffer *clientBuffer)
+{
+    return (UInt32)(((uintptr_t)clientBuffer >> 4) ^ ((uintptr_t)clientBuffer >> 12)) & slotsMask;
+}
+
+// The client's entry, or the empty one where it would go
+static inline IOAudioClipSlot *clipSlotFind(IOAudioClipSlot *slots, UInt32 slotsMask, IOAudioClientBuffer *clientBuffer)
+{
+    UInt32 i = clipSlotHome(slotsMask, clientBuffer);
+    
+    while (slots[i].clientBuffer && (slots[i].clientBuffer != clientBuffer)) {
+        i = (i + 1) & slotsMask;
+    }
+    
+    return &slots[i];
+}
+
+// The client's slot in the clip queue + 1, or 0 when it is not queued
+static inline UInt32 clipQueueIndex(IOAudioClipSlot *slots, UInt32 slotsMask, IOAudioClientBuffer *clientBuffer)
+{
+    return slots ? clipSlotFind(slots, slotsMask, clientBuffer)->index : 0;
+}
+
+// Takes the client out of the table, moving back the entries after it that could no longer be found
+static void clipSlotRemove(IOAudioClipSlot *slots, UInt32 slotsMask, IOAudioClientBuffer *clientBuffer)
+{
+    IOAudioClipSlot *entry = clipSlotFind(slots, slotsMask, clientBuffer);
+    UInt32 hole = (UInt32)(entry - slots);
+    UInt32 i;
+    
+    if (!entry->clientBuffer) {
+        return;
+    }
+    
+    // An entry can fill the hole unless its home lies after the hole, up to where the entry is
+    for (i = (hole + 1) & slotsMask; slots[i].clientBuffer; i = (i + 1) & slotsMask) {
+        UInt32 home = clipSlotHome(slotsMask, slots[i].clientBuffer);
+        
+        if (((i - home) & slotsMask) >= ((i - hole) & slotsMask)) {
+            slots[hole] = slots[i];
+            hole = i;
+        }
+    }
+    
+    slots[hole].clientBuffer = NULL;
+    slots[hole].index = 0;
 }
 
-void IOAudioStream::addAvailableFormat(const IOAudioStreamFormat *streamFormat, const IOAudioSampleRate *minRate, const IOAudioSampleRate *maxRate, AudioIOFunction ioFunction)
+static inline bool clipQueueBefore(IOAudioClientBuffer *a, IOAudioClientBuffer *b)
 {
-    addAvailableFormat(streamFormat, NULL, minRate, maxRate, &ioFunction, 1);
+    return CMP_IOAUDIOENGINEPOSITION(&a->mixedPosition, &b->mixedPosition) < 0;
 }
 
-void IOAudioStream::addAvailableFormat(const IOAudioStreamFormat *streamFormat, const IOAudioSampleRate *minRate, const IOAudioSampleRate *maxRate, const AudioIOFunction *ioFunctionList, UInt32 numFunctions)
+static inline void clipQueueSet(IOAudioClientBuffer **queue, IOAudioClipSlot *slots, UInt32 slotsMask, UInt32 slot, IOAudioClientBuffer *clientBuffer)
 {
-    addAvailableFormat(streamFormat, NULL, minRate, maxRate, ioFunctionList, numFunctions);
+    IOAudioClipSlot *entry = clipSlotFind(slots, slotsMask, clientBuffer);
+    
+    queue[slot] = clientBuffer;
+    entry->clientBuffer = clientBuffer;
+    entry->index = slot + 1;
 }
 
-void IOAudioStream::clearAvailableFormats()
+// Moves the client in slot up or down until the heap is in order again
+static void clipQueueSift(IOAudioClientBuffer **queue, IOAudioClipSlot *slots, UInt32 slotsMask, UInt32 count, UInt32 slot)
 {
-	OSArray*	oldAvailableFormats;
-	OSArray*	clearedAvailableFormats;
-	
-    assert(availableFormatDictionaries);
-	
-	oldAvailableFormats = availableFormatDictionaries;
-	
-    clearedAvailableFormats = OSArray::withCapacity(1);
-    if (!clearedAvailableFormats) {
-        return;
+    IOAudioClientBuffer *clientBuffer = queue[slot];
+    
+    while ((slot > 0) && clipQueueBefore(clientBuffer, queue[(slot - 1) / 2])) {
+        clipQueueSet(queue, slots, slotsMask, slot, queue[(slot - 1) / 2]);
+        slot = (slot - 1) / 2;
     }
-	availableFormatDictionaries = clearedAvailableFormats;
-    setProperty(kIOAudioStreamAvailableFormatsKey, availableFormatDictionaries);
-	
-    oldAvailableFormats->release();
-
-	//	<rdar://9059646> Clean up the available formats array.
-	if (availableFormats && (numAvailableFormats > 0)) {
-		IOFreeAligned(availableFormats, numAvailableFormats * sizeof(IOAudioStreamFormatDesc));
-	}
-	availableFormats = NULL;
-	numAvailableFormats = 0;
+    
+    while ((2 * slot + 1) < count) {
+        UInt32 child = 2 * slot + 1;
+        
+        if (((child + 1) < count) && clipQueueBefore(queue[child + 1], queue[child])) {
+            child++;
+        }
+        if (!clipQueueBefore(queue[child], clientBuffer)) {
+            break;
+        }
+        clipQueueSet(queue, slots, slotsMask, slot, queue[child]);
+        slot = child;
+    }
+    
+    clipQueueSet(queue, slots, slotsMask, slot, clientBuffer);
 }
 
-bool IOAudioStream::validateFormat(IOAudioStreamFormat *streamFormat, IOAudioStreamFormatDesc *formatDesc)
+static IOAudioClientBuffer *clipQueueLatest(IOAudioClientBuffer **queue, UInt32 count)
 {
-	return validateFormat(streamFormat, NULL, formatDesc);
+    IOAudioClientBuffer *latest = NULL;
+    UInt32 slot;
+    
+    for (slot = 0; slot < count; slot++) {
+        if (!latest || clipQueueBefore(latest, queue[slot])) {
+            latest = queue[slot];
+        }
+    }
+    
+    return latest;
 }
 
-UInt32 IOAudioStream::getStartingChannelID()
+// Queues a client after its first mix, or puts it back in order after it mixed again.
+// Only a client that moved back can have been the latest and no longer be.
+static void clipQueueUpdate(IOAudioClientBuffer **queue, IOAudioClipSlot *slots, UInt32 slotsMask, UInt32 &count, IOAudioClientBuffer *&earliest, IOAudioClientBuffer *&latest, IOAudioClientBuffer *clientBuffer, bool movedBack)
 {
-    return startingChannelID;
+    UInt32 index = clipQueueIndex(slots, slotsMask, clientBuffer);
+    
+    if (index == 0) {
+        clipQueueSet(queue, slots, slotsMask, count, clientBuffer);
+        count++;
+        index = count;
+    }
+    clipQueueSift(queue, slots, slotsMask, count, index - 1);
+    
+    earliest = queue[0];
+    if (latest == clientBuffer) {
+        if (movedBack) {
+            latest = clipQueueLatest(queue, count);
+        }
+    } else if (!latest || clipQueueBefore(latest, clientBuffer)) {
+        latest = clientBuffer;
+    }
 }
 
-UInt32 IOAudioStream::getMaxNumChannels()
+static void clipQueueRemove(IOAudioClientBuffer **queue, IOAudioClipSlot *slots, UInt32 slotsMask, UInt32 &count, IOAudioClientBuffer *&earliest, IOAudioClientBuffer *&latest, IOAudioClientBuffer *clientBuffer)
 {
-    return maxNumChannels;
+    UInt32 slot = clipQueueIndex(slots, slotsMask, clientBuffer) - 1;
+    
+    clipSlotRemove(slots, slotsMask, clientBuffer);
+    count--;
+    if (slot < count) {
+        clipQueueSet(queue, slots, slotsMask, slot, queue[count]);
+        clipQueueSift(queue, slots, slotsMask, count, slot);
+    }
+    
+    earliest = (count > 0) ? queue[0] : NULL;
+    if (latest == clientBuffer) {
+        latest = clipQueueLatest(queue, count);
+    }
 }
 
-void IOAudioStream::setStartingChannelNumber(UInt32 channelNumber)
+void dumpClipQueue(IOAudioClientBuffer **queue, UInt32 count)
 {
-    setProperty(kIOAudioStreamStartingChannelNumberKey, channelNumber, sizeof(UInt32)*8);
+    UInt32 slot;
+    
+    for (slot = 0; slot < count; slot++) {
+        DbgLog("  %lu: (%lx,%lx)\n", (long unsigned int)slot, (long unsigned int)queue[slot]->mixedPosition.fLoopCount, (long unsigned int)queue[slot]->mixedPosition.fSampleFrame);
+    }
 }
 
-void IOAudioStream::updateNumClients()
+// Debug check of the clip queue's invariants
+void validateClipQueue(IOAudioClientBuffer **queue, IOAudioClipSlot *slots, UInt32 slotsMask, UInt32 count, IOAudioClientBuffer *earliest, IOAudioClientBuffer *latest)
 {
-    setProperty(kIOAudioStreamNumClientsKey, numClients, sizeof(UInt32)*8);
+    UInt32 slot;
+    
+    for (slot = 0; slot < count; slot++) {
+        if ((clipQueueIndex(slots, slotsMask, queue[slot]) != slot + 1) ||
+            ((slot > 0) && clipQueueBefore(queue[slot], queue[(slot - 1) / 2])) ||
+            clipQueueBefore(latest, queue[slot])) {
+            DbgLog("+-IOAudioStream: ERROR - clip queue out of order at %lu!\n", (long unsigned int)slot);
+            dumpClipQueue(queue, count);
+            return;
+        }
+    }
+    
+    if ((earliest != ((count > 0) ? queue[0] : NULL)) || ((latest != NULL) != (count > 0)) || (latest && (clipQueueIndex(slots, slotsMask, latest) == 0))) {
+        DbgLog("+-IOAudioStream: ERROR - clip queue ends are wrong!\n");
+        dumpClipQueue(queue, count);
+    }
 }
 
 IOReturn IOAudioStream::addClient(IOAudioClientBuffer *clientBuffer)
@@ -1194,7 +2221,7 @@ IOReturn IOAudioStream::addClient(IOAudioClientBuffer *clientBuffer)
         
         // <rdar://11731381> Make sure this buffer is not in the list
 		bool bufferInList = false;
-        if ((clientBuffer->nextClip == NULL) && (clientBuffer->previousClip == NULL) && (clientBuffer != clientBufferListStart) && (clientBuffer->nextClient == NULL) && (clientBuffer != userClientList)) {
+        if ((clipQueueIndex(reserved->mClipSlots, reserved->mClipSlotsMask, clientBuffer) == 0) && (clientBuffer->nextClient == NULL) && (clientBuffer != userClientList)) {
             
 			// <rdar://11731381> Make sure that the clientBuffer is not at the end of the list.
 			IOAudioClientBuffer *tmpClientBuffer = userClientList;
@@ -1215,7 +2242,52 @@ IOReturn IOAudioStream::addClient(IOAudioClientBuffer *clientBuffer)
             // It's OK to allow a new client if this is a mixable format
             // or if its not mixable but we don't have any clients
             // or if we are an input stream
-            if (format.fIsMixable || (numClients == 0) || (getDirection() == kIOAudioStreamDirectionInput)) {
+            // Every output client needs a place in the clip queue before it mixes
+            if ((getDirection() == kIOAudioStreamDirectionOutput) && (numClients >= reserved->mClipQueueCapacity)) {
+                UInt32 capacity = (reserved->mClipQueueCapacity > 0) ? (2 * reserved->mClipQueueCapacity) : 8;
+                IOAudioClientBuffer **queue = (IOAudioClientBuffer **)IOMalloc(capacity * sizeof(IOAudioClientBuffer *));
+                IOAudioClipSlot *slots = (IOAudioClipSlot *)IOMalloc(2 * capacity * sizeof(IOAudioClipSlot));
+                IOAudioMixSource *mixBatches = (IOAudioMixSource *)IOMalloc(4 * capacity * sizeof(IOAudioMixSource));
+                
+                if (queue && slots && mixBatches) {
+                    UInt32 slot;
+                    
+                    bzero(slots, 2 * capacity * sizeof(IOAudioClipSlot));
+                    if (reserved->mClipQueue) {
+                        bcopy(reserved->mClipQueue, queue, reserved->mClipQueueCount * sizeof(IOAudioClientBuffer *));
+                        IOFree(reserved->mClipQueue, reserved->mClipQueueCapacity * sizeof(IOAudioClientBuffer *));
+                    }
+                    if (reserved->mClipSlots) {
+                        IOFree(reserved->mClipSlots, (reserved->mClipSlotsMask + 1) * sizeof(IOAudioClipSlot));
+                    }
+                    // No client is mixing, so no batch is in use
+                    if (reserved->mMixBatches) {
+                        IOFree(reserved->mMixBatches, 4 * reserved->mClipQueueCapacity * sizeof(IOAudioMixSource));
+                    }
+                    reserved->mMixBatches = mixBatches;
+                    reserved->mClipQueue = queue;
+                    reserved->mClipQueueCapacity = capacity;
+                    reserved->mClipSlots = slots;
+                    reserved->mClipSlotsMask = 2 * capacity - 1;
+                    for (slot = 0; slot < reserved->mClipQueueCount; slot++) {
+                        clipQueueSet(queue, slots, reserved->mClipSlotsMask, slot, queue[slot]);
+                    }
+                } else {
+                    if (queue) {
+                        IOFree(queue, capacity * sizeof(IOAudioClientBuffer *));
+                    }
+                    if (slots) {
+                        IOFree(slots, 2 * capacity * sizeof(IOAudioClipSlot));
+                    }
+                    if (mixBatches) {
+                        IOFree(mixBatches, 4 * capacity * sizeof(IOAudioMixSource));
+                    }
+                }
+            }
+            
+            if ((getDirection() == kIOAudioStreamDirectionOutput) && (numClients >= reserved->mClipQueueCapacity)) {
+                result = kIOReturnNoMemory;
+            } else if (format.fIsMixable || (numClients == 0) || (getDirection() == kIOAudioStreamDirectionInput)) {
                 numClients++;
                 updateNumClients();
                 
@@ -1227,22 +2299,22 @@ IOReturn IOAudioStream::addClient(IOAudioClientBuffer *clientBuffer)
                     clientBuffer->mixedPosition.fLoopCount = 0;
                     clientBuffer->mixedPosition.fSampleFrame = 0;
                     
-                    clientBuffer->previousClip = NULL;
-                    clientBuffer->nextClip = NULL;
-                    
                     if (!mixBuffer && format.fIsMixable && sampleBuffer && (sampleBufferSize > 0)) {
                         assert(audioEngine);
                         
                         UInt32 mixBufSize = format.fNumChannels * kIOAudioEngineDefaultMixBufferSampleSize * audioEngine->numSampleFramesPerBuffer;
                         
                         if (mixBufSize > 0) {
-                            void *mixBuf = IOMallocAligned(mixBufSize, 32);
+                            void *mixBuf = audioEngine->checkOutMixBuffer(mixBufSize);
                             if (mixBuf) {
                                 setMixBuffer(mixBuf, mixBufSize);
                                 streamAllocatedMixBuffer = true;
                             }
                         }
                     }
+                } else if ((numClients > 1) && reserved->mInputCacheEnabled) {
+                    // Without it the clients just convert their own input
+                    reallocateInputCache();
                 }
                 
                 result = kIOReturnSuccess;
@@ -1289,39 +2361,27 @@ void IOAudioStream::removeClient(IOAudioClientBuffer *clientBuffer)
             updateNumClients();
         }
         
-        // Make sure the buffer is in the list
-        if ((clientBuffer->nextClip != NULL) || (clientBuffer->previousClip != NULL) || (clientBuffer == clientBufferListStart)) {
+        // Make sure the buffer is in the clip queue
+        if (clipQueueIndex(reserved->mClipSlots, reserved->mClipSlotsMask, clientBuffer) != 0) {
             if (getDirection() == kIOAudioStreamDirectionOutput) {
+                bool wasEarliest = (clientBufferListStart == clientBuffer);
+                
                 if (numClients == 0) {
                     resetClipInfo();
                 }
                 
-                if (clientBuffer->previousClip != NULL) {
-                    clientBuffer->previousClip->nextClip = clientBuffer->nextClip;
-                }
-                
-                if (clientBuffer->nextClip != NULL) {
-                    clientBuffer->nextClip->previousClip = clientBuffer->previousClip;
-                }
-                
-                if (clientBufferListEnd == clientBuffer) {
-                    assert(clientBuffer->nextClip == NULL);
-                    clientBufferListEnd = clientBuffer->previousClip;
-                }
+                clipQueueRemove(reserved->mClipQueue, reserved->mClipSlots, reserved->mClipSlotsMask, reserved->mClipQueueCount, clientBufferListStart, clientBufferListEnd, clientBuffer);
+#ifdef DEBUG
+                validateClipQueue(reserved->mClipQueue, reserved->mClipSlots, reserved->mClipSlotsMask, reserved->mClipQueueCount, clientBufferListStart, clientBufferListEnd);
+#endif
                 
-                if (clientBufferListStart == clientBuffer) {
-                    assert(clientBuffer->previousClip == NULL);
-                    clientBufferListStart = clientBuffer->nextClip;
-                    if (clientBufferListStart != NULL) {
-                        clipIfNecessary();
-                    }
+                if (wasEarliest && (clientBufferListStart != NULL)) {
+                    clipIfNecessary();
                 }
             }
         }
         
 		// clear these values for bug 2851917
-		clientBuffer->previousClip = NULL;
-		clientBuffer->nextClip = NULL;
 		clientBuffer->nextClient = NULL;
 		unlockStreamForIO();
     }
@@ -1335,32 +2395,6 @@ UInt32 IOAudioStream::getNumClients()
     return numClients;
 }
 
-void dumpList(IOAudioClientBuffer *start)
-{
-    IOAudioClientBuffer *tmp;
-    
-    tmp = start;
-    while (tmp) {
-        DbgLog("  (%lx,%lx)\n", (long unsigned int)tmp->mixedPosition.fLoopCount, (long unsigned int)tmp->mixedPosition.fSampleFrame);
-        tmp = tmp->nextClip;
-    }
-}
-
-void validateList(IOAudioClientBuffer *start)
-{
-    IOAudioClientBuffer *tmp;
-    
-    tmp = start;
-    while (tmp) {
-        if (tmp->nextClip && (CMP_IOAUDIOENGINEPOSITION(&tmp->mixedPosition, &tmp->nextClip->mixedPosition) > 0)) {
-            DbgLog("+-IOAudioStream: ERROR - client buffer list not sorted!\n");
-            dumpList(start);
-            break;
-        }
-        tmp = tmp->nextClip;
-    }
-}
-
 IOReturn IOAudioStream::readInputSamples(IOAudioClientBuffer *clientBuffer, UInt32 firstSampleFrame)
 {
     IOReturn result = kIOReturnError;
@@ -1373,7 +2407,13 @@ IOReturn IOAudioStream::readInputSamples(IOAudioClientBuffer *clientBuffer, UInt
         UInt32 numWrappedFrames = 0;
         UInt32 numReadFrames = 0;
         UInt32 numSampleFramesPerBuffer;
+        UInt64 inputPosition;
 		
+        // Clients recording the same frames share one conversion of them
+        if (findInputCachePosition(firstSampleFrame, clientBuffer->numSampleFrames, &inputPosition)) {
+            return readCachedInputSamples(clientBuffer, firstSampleFrame, inputPosition);
+        }
+        
         numSampleFramesPerBuffer = audioEngine->getNumSampleFramesPerBuffer();
         
         if ((firstSampleFrame + clientBuffer->numSampleFrames) > numSampleFramesPerBuffer) {
@@ -1436,14 +2476,24 @@ IOReturn IOAudioStream::processOutputSamples(IOAudioClientBuffer *clientBuffer,
     //DbgLog("m(%lx,%lx,%lx)\n", loopCount, firstSampleFrame, clientBuffer->numSampleFrames);
 
     assert(direction == kIOAudioStreamDirectionOutput);
+    
+    // Other clients may be mixing into the same mix buffer at the same time
+    if (outputMixesConcurrently()) {
+        return processOutputSamplesConcurrently(clientBuffer, firstSampleFrame, loopCount, samplesAvailable);
+    }
+    
     if (clientBuffer) {
         // We can go ahead if we have a mix buffer or if the format is not mixable
         if (mixBuffer || !format.fIsMixable) {
+            IOAF_FlushDenormals flushDenormals;	// once for the whole mix and clip
             UInt32 numSampleFramesPerBuffer = audioEngine->getNumSampleFramesPerBuffer();
             UInt32 nextSampleFrame = 0;
             UInt32 mixBufferWrapped = false;
             UInt32 numSamplesToMix = 0;
-            IOAudioClientBuffer *tmpBuf = NULL;
+            bool fuseOutput = false;
+            UInt32 firstActiveChannel = 0;
+            UInt32 numActiveChannels = format.fNumChannels;
+            IOAudioEnginePosition queuedPosition = clientBuffer->mixedPosition;	// where the clip queue has it
                     
             assert(audioEngine);
         
@@ -1492,7 +2542,7 @@ IOReturn IOAudioStream::processOutputSamples(IOAudioClientBuffer *clientBuffer,
 										(long unsigned int)clientBufferListEnd->mixedPosition.fSampleFrame, 
 										(long unsigned int)clientBuffer->mixedPosition.fLoopCount, 
 										(long unsigned int)firstSampleFrame);
-					//dumpList(clientBufferListStart);
+					//dumpClipQueue(reserved->mClipQueue, reserved->mClipQueueCount);
                 }
             }
             
@@ -1565,10 +2615,43 @@ IOReturn IOAudioStream::processOutputSamples(IOAudioClientBuffer *clientBuffer,
 #endif
 */
 
+				// Widen the active channels to cover this buffer before any of it is mixed
+				if (reserved->mActiveChannelTracking && format.fIsMixable) {
+					IOAF_Float32FindActiveChannels((const float *)clientBuffer->sourceBuffer, numSamplesToMix, format.fNumChannels, (unsigned int *)&reserved->mActiveFirstChannel, (unsigned int *)&reserved->mActiveNumChannels);
+					firstActiveChannel = reserved->mActiveFirstChannel;
+					numActiveChannels = reserved->mActiveNumChannels;
+				}
+				
+				// A lone client whose samples would only be copied into the mix buffer and then converted by
+				// the clip can be converted straight into the sample buffer, provided the clip covers exactly these frames
+				fuseOutput = (numClients == 1) && reserved->mFusedOutputEnabled && format.fIsMixable && sampleBuffer &&
+							 (reserved->mGainUnity || gainConversionSupported(&format, reserved->mSampleBufferWriteCombined, reserved->mDitherState)) &&
+							 !(audioIOFunctions && (numIOFunctions != 0)) && fusedOutputFormatSupported(&format) &&
+							 (IOAUDIOENGINEPOSITION_IS_ZERO(&clippedPosition) || (CMP_IOAUDIOENGINEPOSITION(&clippedPosition, &clientBuffer->mixedPosition) == 0));
+
+				// Earlier buffers may have been converted straight into the sample buffer, so bring the mix
+				// buffer back in sync before anything mixes into it again (a second client, a gain the conversion
+				// can't apply, an I/O function or a clip that fell behind all leave the fused path)
+				if (!fuseOutput && reserved->mMixBufferStale) {
+					if (mixBuffer && sampleBuffer && format.fIsMixable) {
+						convertSampleBufferToFloat32(sampleBuffer, (float *)mixBuffer, numSampleFramesPerBuffer, &format);
+					}
+					reserved->mMixBufferStale = false;
+				}
+
 				// Check if the buffer wraps
 				if (numSampleFramesPerBuffer > (firstSampleFrame + numSamplesToMix)) {	// No wrap
 					if (format.fIsMixable) {
-						if (numClients == 1) {
+						if (fuseOutput) {
+							if (reserved->mGainUnity) {
+								convertFloat32ToSampleBuffer((float *)clientBuffer->sourceBuffer, sampleBuffer, firstSampleFrame, numSamplesToMix, &format, reserved->mSampleBufferWriteCombined, reserved->mDitherState, reserved->mOutputNoiseShaping, firstActiveChannel, numActiveChannels);
+							} else {
+								applyDefaultControlGain((float *)clientBuffer->sourceBuffer, sampleBuffer, firstSampleFrame, numSamplesToMix);
+							}
+							result = kIOReturnSuccess;
+						} else if (reserved->mActiveChannelTracking) {
+							result = mixActiveChannels((float *)clientBuffer->sourceBuffer, firstSampleFrame, numSamplesToMix, firstActiveChannel, numActiveChannels);
+						} else if (numClients == 1) {
 							result = mixOutputSamples (clientBuffer->sourceBuffer, mixBuffer, firstSampleFrame, numSamplesToMix, &format, this);
 						} else {
 							result = audioEngine->mixOutputSamples(clientBuffer->sourceBuffer, mixBuffer, firstSampleFrame, numSamplesToMix, &format, this);
@@ -1580,7 +2663,16 @@ IOReturn IOAudioStream::processOutputSamples(IOAudioClientBuffer *clientBuffer,
 				} else {	// Buffer wraps around
 					mixBufferWrapped = true;
 					if (format.fIsMixable) {
-						if (numClients == 1) {
+						if (fuseOutput) {
+							if (reserved->mGainUnity) {
+								convertFloat32ToSampleBuffer((float *)clientBuffer->sourceBuffer, sampleBuffer, firstSampleFrame, numSampleFramesPerBuffer - firstSampleFrame, &format, reserved->mSampleBufferWriteCombined, reserved->mDitherState, reserved->mOutputNoiseShaping, firstActiveChannel, numActiveChannels);
+							} else {
+								applyDefaultControlGain((float *)clientBuffer->sourceBuffer, sampleBuffer, firstSampleFrame, numSampleFramesPerBuffer - firstSampleFrame);
+							}
+							result = kIOReturnSuccess;
+						} else if (reserved->mActiveChannelTracking) {
+							result = mixActiveChannels((float *)clientBuffer->sourceBuffer, firstSampleFrame, numSampleFramesPerBuffer - firstSampleFrame, firstActiveChannel, numActiveChannels);
+						} else if (numClients == 1) {
 							result = mixOutputSamples (clientBuffer->sourceBuffer, mixBuffer, firstSampleFrame, numSampleFramesPerBuffer - firstSampleFrame, &format, this);
 						} else {
 							result = audioEngine->mixOutputSamples(clientBuffer->sourceBuffer, mixBuffer, firstSampleFrame, numSampleFramesPerBuffer - firstSampleFrame, &format, this);
@@ -1593,7 +2685,16 @@ IOReturn IOAudioStream::processOutputSamples(IOAudioClientBuffer *clientBuffer,
 					}
 					nextSampleFrame = numSamplesToMix - (numSampleFramesPerBuffer - firstSampleFrame);
 					if (format.fIsMixable) {
-						if (numClients == 1) {
+						if (fuseOutput) {
+							if (reserved->mGainUnity) {
+								convertFloat32ToSampleBuffer(((float *)clientBuffer->sourceBuffer) + ((numSampleFramesPerBuffer - firstSampleFrame) * format.fNumChannels), sampleBuffer, 0, nextSampleFrame, &format, reserved->mSampleBufferWriteCombined, reserved->mDitherState, reserved->mOutputNoiseShaping, firstActiveChannel, numActiveChannels);
+							} else {
+								applyDefaultControlGain(((float *)clientBuffer->sourceBuffer) + ((numSampleFramesPerBuffer - firstSampleFrame) * format.fNumChannels), sampleBuffer, 0, nextSampleFrame);
+							}
+							result = kIOReturnSuccess;
+						} else if (reserved->mActiveChannelTracking) {
+							result = mixActiveChannels(((float *)clientBuffer->sourceBuffer) + ((numSampleFramesPerBuffer - firstSampleFrame) * format.fNumChannels), 0, nextSampleFrame, firstActiveChannel, numActiveChannels);
+						} else if (numClients == 1) {
 							result = mixOutputSamples (((float *)clientBuffer->sourceBuffer) + ((numSampleFramesPerBuffer - firstSampleFrame) * format.fNumChannels), mixBuffer, 0, nextSampleFrame, &format, this);
 						} else {
 							result = audioEngine->mixOutputSamples(((float *)clientBuffer->sourceBuffer) + ((numSampleFramesPerBuffer - firstSampleFrame) * format.fNumChannels), mixBuffer, 0, nextSampleFrame, &format, this);
@@ -1604,6 +2705,10 @@ IOReturn IOAudioStream::processOutputSamples(IOAudioClientBuffer *clientBuffer,
 				}
             
                 if (result == kIOReturnSuccess) {
+                    if (fuseOutput) {
+                        reserved->mMixBufferStale = true;
+                    }
+                    
                     // Reset startingSampleFrame and startingLoopCount if we haven't clipped
                     // anything yet and this buffer mixed samples before the previous
                     // starting frame
@@ -1633,69 +2738,13 @@ IOReturn IOAudioStream::processOutputSamples(IOAudioClientBuffer *clientBuffer,
                 }
             }
             
-            // If this buffer isn't in the list yet, then we look at the beginning of the list
-            if ((clientBuffer->nextClip == NULL) && (clientBuffer->previousClip == NULL) && (clientBuffer != clientBufferListStart)) {
-                // If the buffer has mixed past the first buffer in the list, then we can start at the beginning
-                // If not, then tmpBuf is just NULL and we insert at the beginning
-                if ((clientBufferListStart != NULL) && (CMP_IOAUDIOENGINEPOSITION(&clientBuffer->mixedPosition, &clientBufferListStart->mixedPosition) > 0)) {
-                    tmpBuf = clientBufferListStart;
-                }
-            } else { // Otherwise, we look forward from the current position
-                tmpBuf = clientBuffer;
-            }
-                
-            // Add it to the beginning if the buffer is new and has not mixed past any other buffers
-            if (tmpBuf == NULL) {
-                assert(clientBuffer->nextClip == NULL);
-                assert(clientBuffer->previousClip == NULL);
-                
-                clientBuffer->nextClip = clientBufferListStart;
-                clientBufferListStart = clientBuffer;
-                
-                if (clientBuffer->nextClip == NULL) {
-                    clientBufferListEnd = clientBuffer;
-                } else {
-                    clientBuffer->nextClip->previousClip = clientBuffer;
-                }
-            } else {
-                //Find the insertion point for the new location for this buffer
-                while ((tmpBuf->nextClip != NULL) && (CMP_IOAUDIOENGINEPOSITION(&clientBuffer->mixedPosition, &tmpBuf->nextClip->mixedPosition) > 0)) {
-                    tmpBuf = tmpBuf->nextClip;
-                }
-            
-                if (tmpBuf != clientBuffer) {
-                    // If the buffer is to change position, move updated client buffer to its new sorted position
-                    // First remove the client buffer from its current position
-                    if (clientBuffer->previousClip != NULL) {
-                        clientBuffer->previousClip->nextClip = clientBuffer->nextClip;
-                    } else if (clientBuffer == clientBufferListStart) {	// If we don't have a previous clip set, we may be the starting entry
-                        clientBufferListStart = clientBuffer->nextClip;
-                    } // If we have don't have a previousClip set and are not the start, then this is the first time this buffer is being mixed
-                    
-                    if (clientBuffer->nextClip != NULL) {
-                        clientBuffer->nextClip->previousClip = clientBuffer->previousClip;
-                    } else if (clientBuffer == clientBufferListEnd) {	// If we don't have a next clip set, we may be the last entry
-                        // We should never get here, because we only are moving this buffer forward
-                        // and that is impossible if it is the last one
-                        clientBufferListEnd = clientBuffer->previousClip;
-                    } // If we don't have a next clip and are not the end, then this is the first time this buffer is being mixed
-                    
-                    // Insert it after tmpBuf
-                    clientBuffer->nextClip = tmpBuf->nextClip;
-                    clientBuffer->previousClip= tmpBuf;
-                    tmpBuf->nextClip = clientBuffer;
-                    if (clientBuffer->nextClip) {
-                        clientBuffer->nextClip->previousClip = clientBuffer;
-                    }
-                    if (clientBuffer->nextClip == NULL) {
-                        assert(clientBufferListEnd == tmpBuf);
-                        clientBufferListEnd = clientBuffer;
-                    }
-                    
+            // Queue the buffer if this was its first mix, otherwise move it to its new place
+            if ((clipQueueIndex(reserved->mClipSlots, reserved->mClipSlotsMask, clientBuffer) != 0) || (reserved->mClipQueueCount < reserved->mClipQueueCapacity)) {
+                clipQueueUpdate(reserved->mClipQueue, reserved->mClipSlots, reserved->mClipSlotsMask, reserved->mClipQueueCount, clientBufferListStart, clientBufferListEnd, clientBuffer,
+                                (clipQueueIndex(reserved->mClipSlots, reserved->mClipSlotsMask, clientBuffer) != 0) && (CMP_IOAUDIOENGINEPOSITION(&clientBuffer->mixedPosition, &queuedPosition) < 0));
 #ifdef DEBUG
-                    validateList(clientBufferListStart);
+                validateClipQueue(reserved->mClipQueue, reserved->mClipSlots, reserved->mClipSlotsMask, reserved->mClipQueueCount, clientBufferListStart, clientBufferListEnd);
 #endif
-                }
             }
             
             // We should attempt to clip if we mixed some samples of if we
@@ -1707,8 +2756,12 @@ IOReturn IOAudioStream::processOutputSamples(IOAudioClientBuffer *clientBuffer,
 				}
 				
 				reserved->mClipOutputStatus = kIOReturnSuccess;
+				reserved->mFusedOutputClipped = fuseOutput && (result == kIOReturnSuccess);
                 
-				clipIfNecessary();
+				if (fuseOutput || !samplesAvailable || !deferClip()) {
+					clipIfNecessary();
+				}
+				reserved->mFusedOutputClipped = false;
 				if (!format.fIsMixable) {
 					mixBuffer = NULL;
 				}
@@ -1727,12 +2780,265 @@ IOReturn IOAudioStream::processOutputSamples(IOAudioClientBuffer *clientBuffer,
     return result;
 }
 
+// Adds a client's samples to the batch being filled and waits for the batch to be mixed, mixing it itself if no
+// other client is mixing one.  Only clients inside processOutputSamplesConcurrently() are batched, as a client's
+// samples can change once it returns; they are all queued at the frames they start from, so the clip stays clear of
+// the batch while it is mixed without the clip state lock.  Called, and returns, with the clip state lock held.
+IOReturn IOAudioStream::mixOutputBatch(const float *sourceBuf, UInt32 firstSampleFrame, UInt32 numSampleFrames, UInt32 numSampleFramesPerBuffer)
+{
+	UInt32				batch = reserved->mMixBatchOpen;
+	IOAudioMixSource *	sources = reserved->mMixBatches + ((batch & 1) * 2 * reserved->mClipQueueCapacity);
+	UInt32				numSources = reserved->mMixBatchCount[batch & 1];
+	
+	// The mix buffer wraps between the two halves of a buffer that runs past its end
+	sources[numSources].fSourceBuf = sourceBuf;
+	sources[numSources].fFirstSampleFrame = firstSampleFrame;
+	if (numSampleFramesPerBuffer > (firstSampleFrame + numSampleFrames)) {
+		sources[numSources++].fNumSampleFrames = numSampleFrames;
+	} else {
+		sources[numSources++].fNumSampleFrames = numSampleFramesPerBuffer - firstSampleFrame;
+		sources[numSources].fSourceBuf = sourceBuf + ((numSampleFramesPerBuffer - firstSampleFrame) * format.fNumChannels);
+		sources[numSources].fFirstSampleFrame = 0;
+		sources[numSources++].fNumSampleFrames = numSampleFrames - (numSampleFramesPerBuffer - firstSampleFrame);
+	}
+	reserved->mMixBatchCount[batch & 1] = numSources;
+	
+	while ((SInt32)(reserved->mMixBatchDone - batch) < 0) {
+		if (reserved->mMixBatchMixing) {
+			IOLockSleep(reserved->mClipStateLock, &reserved->mMixBatchDone, THREAD_UNINT);
+		} else {
+			UInt32		mixing = reserved->mMixBatchOpen++;
+			IOReturn	result;
+			
+			// The other batch was mixed before this one could start filling, so it's free for the next clients
+			reserved->mMixBatchCount[reserved->mMixBatchOpen & 1] = 0;
+			reserved->mMixBatchMixing = true;
+			sources = reserved->mMixBatches + ((mixing & 1) * 2 * reserved->mClipQueueCapacity);
+			numSources = reserved->mMixBatchCount[mixing & 1];
+			IOLockUnlock(reserved->mClipStateLock);
+			
+			result = audioEngine->mixOutputSamplesFromSources(sources, numSources, mixBuffer, &format, this);
+			
+			IOLockLock(reserved->mClipStateLock);
+			reserved->mMixBatchResult[mixing & 1] = result;
+			reserved->mMixBatchDone = mixing;
+			reserved->mMixBatchMixing = false;
+			IOLockWakeup(reserved->mClipStateLock, &reserved->mMixBatchDone, false);
+		}
+	}
+	
+	return reserved->mMixBatchResult[batch & 1];
+}
+
+// processOutputSamples() for a stream whose clients hold it shared with lockStreamForOutputMix().  The positions
+// and the clip queue are only touched with the clip state lock held, and the client stays queued at the frame it
+// starts mixing from until it has finished, so the clip never reaches frames still being mixed.  The samples are
+// mixed a tile at a time with only that tile's lock held.  The clip is done with the clip state lock held, which
+// keeps the gain ramp and dither in order.
+IOReturn IOAudioStream::processOutputSamplesConcurrently(IOAudioClientBuffer *clientBuffer, UInt32 firstSampleFrame, UInt32 loopCount, bool samplesAvailable)
+{
+    IOReturn result = kIOReturnSuccess;
+    IOAF_FlushDenormals flushDenormals;	// once for the whole mix and clip
+    UInt32 numSampleFramesPerBuffer;
+    UInt32 numSamplesToMix = 0;
+    UInt32 nextSampleFrame;
+    bool mixBufferWrapped = false;
+    UInt32 firstActiveChannel = 0;
+    UInt32 numActiveChannels = 0;
+    bool batchMix;
+    IOAudioEnginePosition queuedPosition;
+    
+    if (!clientBuffer) {
+        return kIOReturnBadArgument;
+    }
+    
+    assert(audioEngine);
+    numSampleFramesPerBuffer = audioEngine->getNumSampleFramesPerBuffer();
+    
+    IOLockLock(reserved->mClipStateLock);
+    
+    queuedPosition = clientBuffer->mixedPosition;
+    
+    // Find the loop these samples belong to, as processOutputSamples() does
+    if (IOAUDIOENGINEPOSITION_IS_ZERO(&clientBuffer->mixedPosition)) {
+        clientBuffer->mixedPosition.fSampleFrame = firstSampleFrame;
+        clientBuffer->mixedPosition.fLoopCount = loopCount;
+    } else {
+        if ((clientBuffer->mixedPosition.fSampleFrame != firstSampleFrame) || (clientBuffer->mixedPosition.fLoopCount != loopCount)) {
+            clientBuffer->mixedPosition.fLoopCount = loopCount;
+            clientBuffer->mixedPosition.fSampleFrame = firstSampleFrame;
+        }
+        
+        if ((clientBuffer != clientBufferListEnd) &&
+            (clientBufferListEnd != NULL) &&
+            ((clientBufferListEnd->mixedPosition.fLoopCount > (clientBuffer->mixedPosition.fLoopCount + 1)) ||
+             ((clientBufferListEnd->mixedPosition.fLoopCount == (clientBuffer->mixedPosition.fLoopCount + 1)) &&
+              (clientBufferListEnd->mixedPosition.fSampleFrame > clientBuffer->mixedPosition.fSampleFrame)))) {
+            if (clientBuffer->mixedPosition.fSampleFrame > clientBufferListEnd->mixedPosition.fSampleFrame) {
+                clientBuffer->mixedPosition.fLoopCount = clientBufferListEnd->mixedPosition.fLoopCount - 1;
+            } else {
+                clientBuffer->mixedPosition.fLoopCount = clientBufferListEnd->mixedPosition.fLoopCount;
+            }
+        }
+    }
+    
+    // Samples before the clipped position can't be played; clip again from them
+    if (!IOAUDIOENGINEPOSITION_IS_ZERO(&clippedPosition) && (CMP_IOAUDIOENGINEPOSITION(&clientBuffer->mixedPosition, &clippedPosition) < 0)) {
+        audioEngine->resetClipPosition(this, clientBuffer->mixedPosition.fSampleFrame);
+        clippedPosition = clientBuffer->mixedPosition;
+    }
+    
+    if (samplesAvailable) {
+        numSamplesToMix = clientBuffer->numSampleFrames;
+    }
+    
+    if ((numSamplesToMix > 0) && reserved->mActiveChannelTracking) {
+        IOAF_Float32FindActiveChannels((const float *)clientBuffer->sourceBuffer, numSamplesToMix, format.fNumChannels, (unsigned int *)&reserved->mActiveFirstChannel, (unsigned int *)&reserved->mActiveNumChannels);
+        firstActiveChannel = reserved->mActiveFirstChannel;
+        numActiveChannels = reserved->mActiveNumChannels;
+    }
+    
+    // Hold the clip back at the frame this client starts mixing from
+    if ((clipQueueIndex(reserved->mClipSlots, reserved->mClipSlotsMask, clientBuffer) != 0) || (reserved->mClipQueueCount < reserved->mClipQueueCapacity)) {
+        clipQueueUpdate(reserved->mClipQueue, reserved->mClipSlots, reserved->mClipSlotsMask, reserved->mClipQueueCount, clientBufferListStart, clientBufferListEnd, clientBuffer,
+                        (clipQueueIndex(reserved->mClipSlots, reserved->mClipSlotsMask, clientBuffer) != 0) && (CMP_IOAUDIOENGINEPOSITION(&clientBuffer->mixedPosition, &queuedPosition) < 0));
+    }
+    
+    if (numSamplesToMix > 0) {
+        if (numSampleFramesPerBuffer > (firstSampleFrame + numSamplesToMix)) {
+            nextSampleFrame = firstSampleFrame + numSamplesToMix;
+        } else {
+            mixBufferWrapped = true;
+            nextSampleFrame = numSamplesToMix - (numSampleFramesPerBuffer - firstSampleFrame);
+        }
+    }
+    
+    // A lone client copies rather than adds, and active channel tracking mixes a subset; everyone else is batched
+    batchMix = (numSamplesToMix > 0) && (numClients > 1) && !reserved->mActiveChannelTracking && reserved->mMixBatches;
+    if (batchMix) {
+        result = mixOutputBatch((const float *)clientBuffer->sourceBuffer, firstSampleFrame, numSamplesToMix, numSampleFramesPerBuffer);
+        if (result != kIOReturnSuccess) {
+            IOLog("IOAudioStream[%p]::processOutputSamplesConcurrently(%p) - Error: 0x%lx returned from mixOutputSamplesFromSources(%p, 0x%lx, 0x%lx)\n", this, clientBuffer, (long unsigned int)result, clientBuffer->sourceBuffer, (long unsigned int)firstSampleFrame, (long unsigned int)numSamplesToMix);
+        }
+    }
+    
+    IOLockUnlock(reserved->mClipStateLock);
+    
+    if ((numSamplesToMix > 0) && !batchMix) {
+        const float *sourceBuf = (const float *)clientBuffer->sourceBuffer;
+        UInt32 sampleFrame = firstSampleFrame;
+        UInt32 numSamplesLeft = numSamplesToMix;
+        
+        while ((numSamplesLeft > 0) && (result == kIOReturnSuccess)) {
+            UInt32 tile = sampleFrame / kConcurrentMixTileFrames;
+            UInt32 numTileSamples = ((tile + 1) * kConcurrentMixTileFrames) - sampleFrame;
+            IOLock *tileLock = reserved->mMixTileLocks[tile % kConcurrentMixTileLocks];
+            
+            if (numTileSamples > (numSampleFramesPerBuffer - sampleFrame)) {
+                numTileSamples = numSampleFramesPerBuffer - sampleFrame;
+            }
+            if (numTileSamples > numSamplesLeft) {
+                numTileSamples = numSamplesLeft;
+            }
+            
+            IOLockLock(tileLock);
+            if (reserved->mActiveChannelTracking) {
+                result = mixActiveChannels(sourceBuf, sampleFrame, numTileSamples, firstActiveChannel, numActiveChannels);
+            } else if (numClients == 1) {
+                result = mixOutputSamples(sourceBuf, mixBuffer, sampleFrame, numTileSamples, &format, this);
+            } else {
+                result = audioEngine->mixOutputSamples(sourceBuf, mixBuffer, sampleFrame, numTileSamples, &format, this);
+            }
+            IOLockUnlock(tileLock);
+            
+            sourceBuf += numTileSamples * format.fNumChannels;
+            numSamplesLeft -= numTileSamples;
+            sampleFrame += numTileSamples;
+            if (sampleFrame >= numSampleFramesPerBuffer) {
+                sampleFrame = 0;
+            }
+        }
+        
+        if (result != kIOReturnSuccess) {
+            IOLog("IOAudioStream[%p]::processOutputSamplesConcurrently(%p) - Error: 0x%lx returned from mixOutputSamples(%p, %p, 0x%lx, 0x%lx, %p, %p)\n", this, clientBuffer, (long unsigned int)result, clientBuffer->sourceBuffer, mixBuffer, (long unsigned int)firstSampleFrame, (long unsigned int)numSamplesToMix, &format, this);
+        }
+    }
+    
+    IOLockLock(reserved->mClipStateLock);
+    
+    queuedPosition = clientBuffer->mixedPosition;
+    
+    if (numSamplesToMix > 0) {
+        if ((result == kIOReturnSuccess) && IOAUDIOENGINEPOSITION_IS_ZERO(&clippedPosition)) {
+            if (IOAUDIOENGINEPOSITION_IS_ZERO(&startingPosition) ||
+                (clientBuffer->mixedPosition.fLoopCount < startingPosition.fLoopCount) ||
+                ((clientBuffer->mixedPosition.fLoopCount == startingPosition.fLoopCount) && (firstSampleFrame < startingPosition.fSampleFrame))) {
+                startingPosition.fLoopCount = clientBuffer->mixedPosition.fLoopCount;
+                startingPosition.fSampleFrame = firstSampleFrame;
+            }
+        }
+        
+        if (mixBufferWrapped) {
+            clientBuffer->mixedPosition.fLoopCount++;
+        }
+        clientBuffer->mixedPosition.fSampleFrame = nextSampleFrame;
+    } else {
+        clientBuffer->mixedPosition.fSampleFrame += clientBuffer->numSampleFrames;
+        if (clientBuffer->mixedPosition.fSampleFrame >= numSampleFramesPerBuffer) {
+            clientBuffer->mixedPosition.fSampleFrame -= numSampleFramesPerBuffer;
+            clientBuffer->mixedPosition.fLoopCount++;
+        }
+    }
+    
+    if (clipQueueIndex(reserved->mClipSlots, reserved->mClipSlotsMask, clientBuffer) != 0) {
+        clipQueueUpdate(reserved->mClipQueue, reserved->mClipSlots, reserved->mClipSlotsMask, reserved->mClipQueueCount, clientBufferListStart, clientBufferListEnd, clientBuffer,
+                        CMP_IOAUDIOENGINEPOSITION(&clientBuffer->mixedPosition, &queuedPosition) < 0);
+#ifdef DEBUG
+        validateClipQueue(reserved->mClipQueue, reserved->mClipSlots, reserved->mClipSlotsMask, reserved->mClipQueueCount, clientBufferListStart, clientBufferListEnd);
+#endif
+    }
+    
+    if ((numSamplesToMix > 0) || !samplesAvailable) {
+        reserved->mClipOutputStatus = kIOReturnSuccess;
+        if (!samplesAvailable || !deferClip()) {
+            clipIfNecessary();
+        }
+        result = reserved->mClipOutputStatus;
+    }
+    
+    IOLockUnlock(reserved->mClipStateLock);
+    
+    return result;
+}
+
 void IOAudioStream::resetClipInfo()
 {
     startingPosition.fLoopCount = 0;
     startingPosition.fSampleFrame = 0;
     clippedPosition.fLoopCount = 0;
     clippedPosition.fSampleFrame = 0;
+    
+    // Called when the last client goes, so the next ones start with no active channels
+    if (reserved) {
+        reserved->mActiveFirstChannel = 0;
+        reserved->mActiveNumChannels = 0;
+    }
+}
+
+// A clip that can be a plain conversion is left to IOAudioEngine::clipOutputStreams() when the engine has other output
+// streams to convert along with it; IOAudioEngineUserClient calls it once the client has mixed into all of them.
+// The watchdog clips at once, as nothing follows it.
+bool IOAudioStream::deferClip()
+{
+	assert(audioEngine);
+	
+	if (!format.fIsMixable || !reserved->mFusedOutputEnabled || (audioIOFunctions && (numIOFunctions != 0)) ||
+		reserved->mActiveChannelTracking || !audioEngine->outputStreams || (audioEngine->outputStreams->getCount() < 2)) {
+		return false;
+	}
+	
+	reserved->mClipDeferred = true;
+	return true;
 }
 
 void IOAudioStream::clipIfNecessary()
@@ -1740,6 +3046,8 @@ void IOAudioStream::clipIfNecessary()
     //DbgLog("IOAudioStream[%p]::clipIfNecessary()\n", this);
 
     if (clientBufferListStart != NULL) {
+        IOAF_FlushDenormals flushDenormals;	// a no-op when called from processOutputSamples()
+
         // Only try to clip if there is not an unmixed buffer
         if (!IOAUDIOENGINEPOSITION_IS_ZERO(&clientBufferListStart->mixedPosition)) {
         
@@ -1750,9 +3058,10 @@ void IOAudioStream::clipIfNecessary()
             
 #ifdef DEBUG
             IOAudioClientBuffer *tmp;
+            UInt32 slot;
             
-            tmp = clientBufferListStart->nextClip;
-            while (tmp) {
+            for (slot = 1; slot < reserved->mClipQueueCount; slot++) {
+                tmp = reserved->mClipQueue[slot];
                 if ((tmp->mixedPosition.fLoopCount > (clippedPosition.fLoopCount + 1)) ||
                     ((tmp->mixedPosition.fLoopCount == clippedPosition.fLoopCount) && 
                      (tmp->mixedPosition.fSampleFrame > clippedPosition.fSampleFrame))) {
@@ -1768,7 +3077,7 @@ void IOAudioStream::clipIfNecessary()
 											(long unsigned int)clientBufferListStart->mixedPosition.fSampleFrame, 
 											(long unsigned int)tmp->mixedPosition.fLoopCount, 
 											(long unsigned int)tmp->mixedPosition.fSampleFrame);
-                            dumpList(clientBufferListStart);
+                            dumpClipQueue(reserved->mClipQueue, reserved->mClipQueueCount);
                             break;
                         }
                     } else if (clippedPosition.fSampleFrame > clientBufferListStart->mixedPosition.fSampleFrame) {
@@ -1782,12 +3091,11 @@ void IOAudioStream::clipIfNecessary()
 											(long unsigned int)clientBufferListStart->mixedPosition.fSampleFrame, 
 											(long unsigned int)tmp->mixedPosition.fLoopCount, 
 											(long unsigned int)tmp->mixedPosition.fSampleFrame);
-                            dumpList(clientBufferListStart);
+                            dumpClipQueue(reserved->mClipQueue, reserved->mClipQueueCount);
                             break;
                         }
                     }
                 }
-                tmp = tmp->nextClip;
             }
 #endif
             
@@ -1807,8 +3115,10 @@ void IOAudioStream::clipIfNecessary()
             
 			// Add a test to see if we'd be clipping more samples than delivered because the HAL might skip some samples around a loop increment
 			// If the HAL skipped samples around a loop increment, then just start from where it wants to
+			bool requeueEarliest = false;
 			if (clientBufferListStart->mixedPosition.fLoopCount + 1 == clippedPosition.fLoopCount && (clientBufferListStart->numSampleFrames < audioEngine->getNumSampleFramesPerBuffer() - clippedPosition.fSampleFrame)) {
 				clientBufferListStart->mixedPosition.fLoopCount = clippedPosition.fLoopCount;
+				requeueEarliest = true;
 				IOLog ("clip position is off %ld < %ld - %ld \n",(long int) clientBufferListStart->numSampleFrames,(long int) audioEngine->getNumSampleFramesPerBuffer(),(long int) clippedPosition.fSampleFrame);
 			}
 /*
@@ -1892,6 +3202,11 @@ void IOAudioStream::clipIfNecessary()
 				}
                 clippedPosition = clientBufferListStart->mixedPosition;
             }
+            
+            // The buffer clipped to was moved a loop forward above; put it back in order
+            if (requeueEarliest) {
+                clipQueueUpdate(reserved->mClipQueue, reserved->mClipSlots, reserved->mClipSlotsMask, reserved->mClipQueueCount, clientBufferListStart, clientBufferListEnd, clientBufferListStart, false);
+            }
         }
     }
 }
@@ -1912,6 +3227,12 @@ void IOAudioStream::clipOutputSamples(UInt32 firstSampleFrame, UInt32 numSampleF
         return;
     }
     
+    // processOutputSamples() already converted these frames into the sample buffer
+    if (reserved->mFusedOutputClipped) {
+        reserved->mClipOutputStatus = kIOReturnSuccess;
+        return;
+    }
+    
 /*
 #ifdef DEBUG
     UInt32 currentSampleFrame = audioEngine->getCurrentSampleFrame();
@@ -1930,6 +3251,45 @@ void IOAudioStream::clipOutputSamples(UInt32 firstSampleFrame, UInt32 numSampleF
 #endif
 */
     
+    // The default controls' gain goes into the family's own conversion when the driver lets it convert,
+    // otherwise the frames are scaled in the mix buffer for the clip routine
+    if (!reserved->mGainUnity && format.fIsMixable) {
+        float *src = (float *)mixBuffer + (firstSampleFrame * format.fNumChannels);
+        
+        if (reserved->mFusedOutputEnabled && !(audioIOFunctions && (numIOFunctions != 0)) &&
+            gainConversionSupported(&format, reserved->mSampleBufferWriteCombined, reserved->mDitherState)) {
+            applyDefaultControlGain(src, sampleBuffer, firstSampleFrame, numSampleFrames);
+            reserved->mClipOutputStatus = kIOReturnSuccess;
+            return;
+        }
+        applyDefaultControlGain(src, NULL, firstSampleFrame, numSampleFrames);
+    }
+    
+    // IOAudioEngine::clipOutputStreams() converts a plain clip together with those of the engine's other output streams
+    if (reserved->mClipBatched && reserved->mGainUnity && reserved->mFusedOutputEnabled && !(audioIOFunctions && (numIOFunctions != 0)) &&
+        gainConversionSupported(&format, reserved->mSampleBufferWriteCombined, reserved->mDitherState) &&
+        (audioEngine->reserved->numClipJobs < audioEngine->reserved->clipJobCapacity)) {
+        IOAF_ConversionJob *job = &audioEngine->reserved->clipJobs[audioEngine->reserved->numClipJobs++];
+        bool bigEndian = (format.fByteOrder == kIOAudioStreamByteOrderBigEndian);
+        
+        job->src = (const float *)mixBuffer + (firstSampleFrame * format.fNumChannels);
+        job->dest = (UInt8 *)sampleBuffer + (firstSampleFrame * format.fNumChannels * (format.fBitWidth / 8));
+        job->count = numSampleFrames * format.fNumChannels;
+        switch (format.fBitWidth) {
+            case 16:
+                job->format = bigEndian ? kIOAF_BEInt16 : kIOAF_LEInt16;
+                break;
+            case 24:
+                job->format = bigEndian ? kIOAF_BEInt24 : kIOAF_LEInt24;
+                break;
+            default:
+                job->format = bigEndian ? kIOAF_BEInt32 : kIOAF_LEInt32;
+                break;
+        }
+        reserved->mClipOutputStatus = kIOReturnSuccess;
+        return;
+    }
+    
     if (audioIOFunctions && (numIOFunctions != 0)) {
         UInt32 functionNum;
         
@@ -1956,12 +3316,21 @@ void IOAudioStream::lockStreamForIO()
     assert(streamIOLock);
     
     IORecursiveLockLock(streamIOLock);
+    
+    // Clients mixing concurrently don't take the stream's IO lock, so keep them out as well
+    if (reserved && (reserved->mStreamIODepth++ == 0) && reserved->mConcurrentMixing) {
+        IORWLockWrite(reserved->mOutputMixLock);
+    }
 }
 
 void IOAudioStream::unlockStreamForIO()
 {
     assert(streamIOLock);
     
+    if (reserved && (--reserved->mStreamIODepth == 0) && reserved->mConcurrentMixing) {
+        IORWLockUnlock(reserved->mOutputMixLock);
+    }
+    
     IORecursiveLockUnlock(streamIOLock);
 }
 
@@ -2010,6 +3379,12 @@ IOReturn IOAudioStream::addDefaultAudioControl(IOAudioControl *defaultAudioContr
                 } else {
                     defaultAudioControls->setObject(defaultAudioControl);
                 }
+                
+                lockStreamForIO();
+                if (reserved->mGainRampEnabled) {
+                    updateDefaultControlGain(defaultAudioControl, 0);
+                }
+                unlockStreamForIO();
             } else {
                 result = kIOReturnError;
             }
@@ -2049,4 +3424,8 @@ void IOAudioStream::removeDefaultAudioControls()
         
         defaultAudioControls->flushCollection();
     }
+    
+    lockStreamForIO();
+    resetDefaultControlGain();
+    unlockStreamForIO();
 }
@@ -42,6 +42,7 @@ class IOAudioControl;
 
 struct IOAudioClientBuffer;
 struct IOAudioStreamFormatDesc;
+struct IOAF_DitherState;
 
 /*!
  * @class IOAudioStream
@@ -123,8 +124,8 @@ public:
     IOAudioEnginePosition		startingPosition;
     IOAudioEnginePosition		clippedPosition;
     
-    IOAudioClientBuffer			*clientBufferListStart;
-    IOAudioClientBuffer			*clientBufferListEnd;
+    IOAudioClientBuffer			*clientBufferListStart;		// earliest mixed output client, the top of the clip queue
+    IOAudioClientBuffer			*clientBufferListEnd;		// latest mixed output client
     
     IOAudioClientBuffer			*userClientList;
 	
@@ -134,6 +135,54 @@ protected:
 		IOAudioStreamFormatExtension	streamFormatExtension;
 		UInt32							mSampleFramesReadByEngine;
 		IOReturn						mClipOutputStatus;
+		bool							mFusedOutputEnabled;		// driver lets the family convert a lone client straight into the sample buffer
+		bool							mFusedOutputClipped;		// the frames being clipped were already converted by processOutputSamples
+		bool							mClipDeferred;				// the clip is left to IOAudioEngine::clipOutputStreams()
+		bool							mClipBatched;				// clipOutputStreams() is collecting this stream's clip
+		bool							mMixBufferStale;			// the sample buffer holds fused samples the mix buffer does not
+		bool							mSampleBufferWriteCombined;	// the sample buffer is uncached/write-combined; use non-temporal stores
+		bool							mGainRampEnabled;			// the family applies the default volume and mute controls
+		bool							mGainRampExponential;		// ramp control changes in dB rather than in linear gain
+		bool							mGainStepExponential;		// the ramp in progress is in dB
+		bool							mGainMuted;
+		bool							mGainUnity;					// gain is 1.0 and not ramping; nothing to apply
+		UInt32							mGainRampFrames;			// frames a control change is spread over
+		UInt32							mGainRampFramesLeft;
+		float							mGain;						// gain of the next frame clipped
+		float							mGainTarget;
+		float							mGainStep;
+		float							mGainLevel;					// gain of the volume control, used when not muted
+		bool							mOutputNoiseShaping;		// shape the dither noise as well
+		IOAF_DitherState *				mDitherState;				// only while output dither is enabled
+		bool							mActiveChannelTracking;		// mix and convert only the channels clients have played
+		UInt32							mActiveFirstChannel;		// union of the channels clients have played since
+		UInt32							mActiveNumChannels;			// the last one stopped; 0 channels for none yet
+		IOAudioClientBuffer **			mClipQueue;					// output clients that have mixed, a binary min-heap on mixedPosition
+		UInt32							mClipQueueCount;
+		UInt32							mClipQueueCapacity;			// grown by addClient(), so mixing never allocates
+		struct IOAudioClipSlot *		mClipSlots;					// each queued client's place in mClipQueue, hashed on the client
+		UInt32							mClipSlotsMask;				// mClipSlots has mClipSlotsMask + 1 entries, twice mClipQueueCapacity
+		bool							mConcurrentMixing;			// output clients mix without locking the stream for IO
+		UInt32							mStreamIODepth;				// nesting of lockStreamForIO()
+		IORWLock *						mOutputMixLock;				// shared by mixing clients, exclusive in lockStreamForIO()
+		IOLock *						mClipStateLock;				// positions, the clip queue and the clip while mixing concurrently
+		IOLock **						mMixTileLocks;				// striped over the mix buffer in tiles of frames
+		IOAudioMixSource *				mMixBatches;				// two batches of 2 * mClipQueueCapacity sources, one filling while the other mixes
+		UInt32							mMixBatchCount[2];
+		IOReturn						mMixBatchResult[2];
+		UInt32							mMixBatchOpen;				// number of the batch clients add their samples to
+		UInt32							mMixBatchDone;				// number of the last batch mixed
+		bool							mMixBatchMixing;			// a client is mixing a batch for the others
+		bool							mInputCacheEnabled;			// input clients share one conversion of the same frames
+		float *							mInputCache;				// converted input, laid out like the sample buffer
+		UInt32							mInputCacheSize;
+		UInt32							mInputCacheFrames;			// numSampleFramesPerBuffer it was laid out for
+		UInt64							mInputCacheStart;			// frames held, counted from the engine's start
+		UInt64							mInputCacheEnd;
+		UInt32							mInputCacheLoopCount;		// engine loop seen by the last read, to notice a restart
+		AbsoluteTime					mInputCacheLoopTime;
+		UInt32							mStreamID;					// kIOAudioStreamIDKey
+		IOMemoryDescriptor *			mSharedInputSampleBuffer;	// the sample buffer, for clients to map read-only
 	};
     
     ExpansionData *reserved;
@@ -164,6 +213,167 @@ public:
 	virtual UInt32 getNumSampleFramesRead();
 	// OSMetaClassDeclareReservedUsed(IOAudioStream, 11);
 	virtual void setDefaultNumSampleFramesRead(UInt32);
+	// OSMetaClassDeclareReservedUsed(IOAudioStream, 12);
+    /*!
+	 * @function setFusedOutputConversion
+	 * @abstract Allows IOAudioFamily to convert a single client's samples directly into the sample buffer.
+	 * @discussion When enabled and exactly one client is playing on a mixable stream, the client's Float32
+	 * samples are clipped and converted straight into the sample buffer, skipping the mix buffer and the
+	 * engine's clipOutputSamples() for those frames.  Only enable this if clipOutputSamples() does nothing
+	 * but convert to the stream format and the sample buffer is signed linear PCM with a bit width of
+	 * 16, 24 or 32; a smaller bit depth is placed in the word as fAlignment says.  As soon as a second
+	 * client starts, the mix buffer is refilled from the sample buffer and the regular mix and clip path
+	 * is used.  On an engine with more than one output stream, the regular clip is then left to
+	 * IOAudioEngine::clipOutputStreams(), which converts it together with the other streams' clips.
+	 * @param enable True to allow the fused path.
+	 */
+	virtual void setFusedOutputConversion(bool enable);
+	// OSMetaClassDeclareReservedUsed(IOAudioStream, 13);
+    /*!
+	 * @function setSampleBufferWriteCombined
+	 * @abstract Tells IOAudioFamily that the sample buffer is in uncached or write-combined memory.
+	 * @discussion Conversions the family does into the sample buffer then use non-temporal stores, which
+	 * avoid the read-for-ownership stalls ordinary stores cause in such memory.  A driver's own
+	 * clipOutputSamples() can check isSampleBufferWriteCombined() and use the IOAF_..._ToWriteCombine converters.
+	 * @param writeCombined True if the sample buffer is uncached or write-combined.
+	 */
+	virtual void setSampleBufferWriteCombined(bool writeCombined);
+	// OSMetaClassDeclareReservedUsed(IOAudioStream, 14);
+    /*!
+	 * @function isSampleBufferWriteCombined
+	 * @abstract Returns the value set with setSampleBufferWriteCombined().  The default is false.
+	 */
+	virtual bool isSampleBufferWriteCombined();
+	// OSMetaClassDeclareReservedUsed(IOAudioStream, 15);
+    /*!
+	 * @function setDefaultControlGainRamp
+	 * @abstract Makes IOAudioFamily apply the stream's default volume and mute controls to the output in software.
+	 * @discussion When enabled, the gain of the volume and mute controls attached with addDefaultAudioControl()
+	 * is applied to the mix buffer as it is clipped, and a change in either control's value is spread over
+	 * numSampleFrames frames rather than taking effect at once.  The volume control's value is mapped to dB
+	 * linearly across the range it falls in.  Only enable this on a mixable output stream whose driver does not
+	 * apply those controls itself.  With setFusedOutputConversion() enabled the family applies the gain as it
+	 * converts into the sample buffer, in place of clipOutputSamples(), unless the stream is dithered, write-combined
+	 * or narrower than its container; otherwise the frames are scaled in the mix buffer before they are clipped.
+	 * @param enable True to apply the controls in software.
+	 * @param numSampleFrames The number of sample frames a change of value is ramped over; 0 changes it at once.
+	 * @param exponential True to ramp in dB, false to ramp the linear gain.  Ramps to or from silence are always linear.
+	 * @result Returns kIOReturnSuccess, or kIOReturnUnsupported for an input stream.
+	 */
+	virtual IOReturn setDefaultControlGainRamp(bool enable, UInt32 numSampleFrames, bool exponential = false);
+	// OSMetaClassDeclareReservedUsed(IOAudioStream, 16);
+    /*!
+	 * @function defaultAudioControlChanged
+	 * @abstract Called by a control attached with addDefaultAudioControl() when its value changes.
+	 * @discussion The default implementation starts a gain ramp if setDefaultControlGainRamp() is enabled.
+	 * @param control The control whose value changed.
+	 */
+	virtual void defaultAudioControlChanged(IOAudioControl *control);
+	// OSMetaClassDeclareReservedUsed(IOAudioStream, 17);
+    /*!
+	 * @function setOutputDither
+	 * @abstract Adds TPDF dither to the 16 and 24-bit output conversions IOAudioFamily does for this stream.
+	 * @discussion Without dither, quiet material is truncated to the sample buffer's bit depth with an error that
+	 * follows the signal and is heard as distortion.  With it, triangular noise of +/-1 LSB is added before
+	 * rounding, and noiseShaping also feeds each channel's quantization error back into its next sample to move
+	 * the noise toward high frequencies.  The family applies it in the fused output path; a driver's own
+	 * clipOutputSamples() can pass getOutputDitherState() to the IOAF_Float32To...Dithered converters.
+	 * Shaping is skipped for streams of more than kIOAF_DitherMaxChannels channels.
+	 * @param enable True to dither the output.
+	 * @param noiseShaping True to shape the dither noise as well.
+	 * @result Returns kIOReturnSuccess, kIOReturnUnsupported for an input stream or kIOReturnNoMemory.
+	 */
+	virtual IOReturn setOutputDither(bool enable, bool noiseShaping = false);
+	// OSMetaClassDeclareReservedUsed(IOAudioStream, 18);
+    /*!
+	 * @function getOutputDitherState
+	 * @abstract Returns the stream's dither state, or NULL if setOutputDither() is not enabled.
+	 * @discussion Only use the state with the stream locked for IO, as it is in clipOutputSamples().
+	 * @param noiseShaping If not NULL, set to the noiseShaping value passed to setOutputDither().
+	 */
+	virtual IOAF_DitherState *getOutputDitherState(bool *noiseShaping = NULL);
+	// OSMetaClassDeclareReservedUsed(IOAudioStream, 19);
+    /*!
+	 * @function setActiveChannelTracking
+	 * @abstract Lets IOAudioFamily skip the channels of a wide output stream that no client is playing.
+	 * @discussion When enabled, the family keeps the range of channels in which any client has sent a non-zero
+	 * sample since the stream last had no clients, and only those channels are mixed into the mix buffer and
+	 * converted by the fused output path; the rest of the mix and sample buffers are left as the erase head left
+	 * them.  A driver's clipOutputSamples() can call getActiveChannels() and convert with the IOAF_...Channels
+	 * converters.  Only enable this on a mixable output stream whose engine does not override mixOutputSamples(),
+	 * as the family mixes the active channels itself.
+	 * @param enable True to track the active channels.
+	 */
+	virtual void setActiveChannelTracking(bool enable);
+	// OSMetaClassDeclareReservedUsed(IOAudioStream, 20);
+    /*!
+	 * @function getActiveChannels
+	 * @abstract Returns the range of channels, counted from the stream's first channel, that clients have played.
+	 * @discussion Returns all the channels if setActiveChannelTracking() is not enabled, and none if no client has
+	 * played anything yet.  The range only grows until the last client stops.  Call with the stream locked for
+	 * IO, as it is in clipOutputSamples().
+	 * @param firstChannel Set to the first active channel.
+	 * @param numChannels Set to the number of active channels.
+	 */
+	virtual void getActiveChannels(UInt32 *firstChannel, UInt32 *numChannels);
+	// OSMetaClassDeclareReservedUsed(IOAudioStream, 21);
+    /*!
+	 * @function setConcurrentOutputMixing
+	 * @abstract Lets the clients of a mixable output stream mix at the same time.
+	 * @discussion Normally every client holds the stream locked for IO while its samples are mixed and clipped,
+	 * so clients on different threads wait for each other.  When enabled, clients of a mixable stream without
+	 * AudioIOFunctions only share a lock that format changes and client additions and removals take exclusively.
+	 * A lone client mixes its samples a tile of frames at a time, so mixOutputSamples() may be called from several
+	 * threads at once, though never for the same frames.  With more than one client, the samples of every client
+	 * that arrives while a mix is under way are mixed together, in one call to mixOutputSamplesFromSources() made
+	 * by one of them while the others wait.  Clipping is still done by one client at a time, up to the frame every
+	 * client has finished mixing, but without the stream locked for IO; clipOutputSamples() and resetClipPosition()
+	 * must not lock the stream.  The fused output path is not used while this is enabled.
+	 * @param enable True to let clients mix concurrently.
+	 * @result Returns kIOReturnSuccess, kIOReturnUnsupported for an input stream or kIOReturnNoMemory.
+	 */
+	virtual IOReturn setConcurrentOutputMixing(bool enable);
+	// OSMetaClassDeclareReservedUsed(IOAudioStream, 22);
+    /*!
+	 * @function lockStreamForOutputMix
+	 * @abstract Locks the stream for a client's call to processOutputSamples().
+	 * @discussion Shares the stream with other mixing clients if setConcurrentOutputMixing() is enabled and the
+	 * format allows it, and otherwise locks the stream for IO.
+	 */
+	virtual void lockStreamForOutputMix();
+	// OSMetaClassDeclareReservedUsed(IOAudioStream, 23);
+    /*!
+	 * @function unlockStreamForOutputMix
+	 * @abstract Undoes lockStreamForOutputMix().
+	 */
+	virtual void unlockStreamForOutputMix();
+	// OSMetaClassDeclareReservedUsed(IOAudioStream, 24);
+    /*!
+	 * @function setInputConversionCache
+	 * @abstract Lets the clients of a mixable input stream share the conversion of the frames they read.
+	 * @discussion Normally the frames every client reads are converted from the sample buffer for that client.
+	 * When enabled and more than one client is recording, frames converted for one client are kept, laid out
+	 * like the sample buffer, and copied to the others that read them before the engine writes over them.  Only
+	 * enable this if the stream's AudioIOFunctions or the engine's convertInputSamplesVBR() produce the same
+	 * samples each time they are asked for the same frames, and read exactly the frames asked for.
+	 * @param enable True to share the converted input.
+	 * @result Returns kIOReturnSuccess, kIOReturnUnsupported for an output stream or kIOReturnNoMemory.
+	 */
+	virtual IOReturn setInputConversionCache(bool enable);
+	// OSMetaClassDeclareReservedUsed(IOAudioStream, 25);
+    /*!
+	 * @function setSharedInputSampleBuffer
+	 * @abstract Lets clients map an input stream's sample buffer and read native Float32 samples from it directly.
+	 * @discussion While the stream's format is native-endian 32-bit float, a client can map the sample buffer
+	 * read-only with kIOAudioInputSampleBuffer, and its input IO then only reports the frames read instead of
+	 * copying them into the client's buffer.  The descriptor must describe exactly the memory passed to
+	 * setSampleBuffer(), in pages holding nothing else, as whole pages are mapped into the client.  Setting a
+	 * new sample buffer clears it.
+	 * @param sampleBufferDescriptor The sample buffer's memory, which the stream retains, or NULL to stop sharing it.
+	 * @result Returns kIOReturnSuccess, kIOReturnUnsupported for an output stream or kIOReturnBadArgument if the
+	 * descriptor is smaller than the sample buffer.
+	 */
+	virtual IOReturn setSharedInputSampleBuffer(IOMemoryDescriptor *sampleBufferDescriptor);
 
 private:
     OSMetaClassDeclareReservedUsed(IOAudioStream, 0);
@@ -178,21 +388,21 @@ private:
     OSMetaClassDeclareReservedUsed(IOAudioStream, 9);
     OSMetaClassDeclareReservedUsed(IOAudioStream, 10);
     OSMetaClassDeclareReservedUsed(IOAudioStream, 11);
+    OSMetaClassDeclareReservedUsed(IOAudioStream, 12);
+    OSMetaClassDeclareReservedUsed(IOAudioStream, 13);
+    OSMetaClassDeclareReservedUsed(IOAudioStream, 14);
+    OSMetaClassDeclareReservedUsed(IOAudioStream, 15);
+    OSMetaClassDeclareReservedUsed(IOAudioStream, 16);
+    OSMetaClassDeclareReservedUsed(IOAudioStream, 17);
+    OSMetaClassDeclareReservedUsed(IOAudioStream, 18);
+    OSMetaClassDeclareReservedUsed(IOAudioStream, 19);
+    OSMetaClassDeclareReservedUsed(IOAudioStream, 20);
+    OSMetaClassDeclareReservedUsed(IOAudioStream, 21);
+    OSMetaClassDeclareReservedUsed(IOAudioStream, 22);
+    OSMetaClassDeclareReservedUsed(IOAudioStream, 23);
+    OSMetaClassDeclareReservedUsed(IOAudioStream, 24);
+    OSMetaClassDeclareReservedUsed(IOAudioStream, 25);
 
-    OSMetaClassDeclareReservedUnused(IOAudioStream, 12);
-    OSMetaClassDeclareReservedUnused(IOAudioStream, 13);
-    OSMetaClassDeclareReservedUnused(IOAudioStream, 14);
-    OSMetaClassDeclareReservedUnused(IOAudioStream, 15);
-    OSMetaClassDeclareReservedUnused(IOAudioStream, 16);
-    OSMetaClassDeclareReservedUnused(IOAudioStream, 17);
-    OSMetaClassDeclareReservedUnused(IOAudioStream, 18);
-    OSMetaClassDeclareReservedUnused(IOAudioStream, 19);
-    OSMetaClassDeclareReservedUnused(IOAudioStream, 20);
-    OSMetaClassDeclareReservedUnused(IOAudioStream, 21);
-    OSMetaClassDeclareReservedUnused(IOAudioStream, 22);
-    OSMetaClassDeclareReservedUnused(IOAudioStream, 23);
-    OSMetaClassDeclareReservedUnused(IOAudioStream, 24);
-    OSMetaClassDeclareReservedUnused(IOAudioStream, 25);
     OSMetaClassDeclareReservedUnused(IOAudioStream, 26);
     OSMetaClassDeclareReservedUnused(IOAudioStream, 27);
     OSMetaClassDeclareReservedUnused(IOAudioStream, 28);
@@ -285,6 +495,20 @@ protected:
 private:
     virtual void setDirection(IOAudioStreamDirection dir);
 
+    void resetDefaultControlGain();
+    void updateDefaultControlGain(IOAudioControl *control, UInt32 numRampFrames);
+    void applyDefaultControlGain(float *src, void *sampleBuf, UInt32 firstSampleFrame, UInt32 numSampleFrames);
+    IOReturn mixActiveChannels(const float *sourceBuf, UInt32 firstSampleFrame, UInt32 numSampleFrames, UInt32 firstChannel, UInt32 numActive);
+    bool outputMixesConcurrently();
+    IOReturn mixOutputBatch(const float *sourceBuf, UInt32 firstSampleFrame, UInt32 numSampleFrames, UInt32 numSampleFramesPerBuffer);
+    bool deferClip();
+    IOReturn processOutputSamplesConcurrently(IOAudioClientBuffer *clientBuffer, UInt32 firstSampleFrame, UInt32 loopCount, bool samplesAvailable);
+    IOReturn reallocateInputCache();
+    bool findInputCachePosition(UInt32 firstSampleFrame, UInt32 numSampleFrames, UInt64 *position);
+    IOReturn convertInputSamplesToCache(UInt32 firstSampleFrame, UInt32 numSampleFrames);
+    IOReturn readCachedInputSamples(IOAudioClientBuffer *clientBuffer, UInt32 firstSampleFrame, UInt64 position);
+    IOMemoryDescriptor *getSharedInputSampleBuffer();
+
 };
 
 #endif /* _IOKIT_IOAUDIOSTREAM_H */
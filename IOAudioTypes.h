@@ -35,15 +35,22 @@
  * @constant kIOAudioSampleBuffer This requests the IOAudioEngine's sample buffer
  * @constant kIOAudioStatusBuffer This requests the IOAudioEngine's status buffer.  It's type is IOAudioEngineStatus.
  * @constant kIOAudioMixBuffer This requests the IOAudioEngine's mix buffer
+ * @constant kIOAudioInputSampleBuffer This requests an input stream's sample buffer, read-only, if the stream
+ *  publishes kIOAudioStreamInputSampleBufferSharedKey.  The stream's kIOAudioStreamIDKey goes in the type above
+ *  kIOAudioMemoryStreamIDShift.  Once mapped, the client's input IO no longer copies that stream's samples.
 */
 typedef enum _IOAudioEngineMemory {
     kIOAudioStatusBuffer 			= 0,
     kIOAudioSampleBuffer			= 1,
     kIOAudioMixBuffer				= 2,
 	kIOAudioBytesInInputBuffer		= 3,
-	kIOAudioBytesInOutputBuffer		= 4
+	kIOAudioBytesInOutputBuffer		= 4,
+	kIOAudioInputSampleBuffer		= 5
 } IOAudioEngineMemory;
 
+#define kIOAudioMemoryStreamIDShift		16
+#define kIOAudioMemoryTypeMask			0xFFFF
+
 /*!
  * @enum IOAudioEngineCalls
  * @abstract The set of constants passed to IOAudioEngineUserClient::getExternalMethodForIndex() when making calls
@@ -124,6 +124,36 @@ void	Float32ToSwapInt24_Portable(const Float32 *src, UInt8 *vdest, unsigned int
 	RESTORE_ROUNDMODE
 }
 
+// ____________________________________________________________________________
+//
+void	Float32ToNativeInt24_Portable(const Float32 *src, UInt8 *dest, unsigned int nSamples)
+{
+	double maxInt32 = 2147483648.0;	// 1 << 31
+	double round = 128.0;
+	double max32 = maxInt32 - 1.0 - round;
+	double min32 = -2147483648.0;
+	int shift = 8, count;
+	
+	SET_ROUNDMODE
+
+	count = nSamples;
+	while (count--) {
+		double f1 = *src++ * maxInt32 + round;
+		SInt32 i1 = FloatToInt(f1, min32, max32) >> shift;
+#if TARGET_RT_BIG_ENDIAN
+		dest[0] = UInt8(i1 >> 16);
+		dest[1] = UInt8(i1 >> 8);
+		dest[2] = UInt8(i1);
+#else
+		dest[0] = UInt8(i1);
+		dest[1] = UInt8(i1 >> 8);
+		dest[2] = UInt8(i1 >> 16);
+#endif
+		dest += 3;
+	}
+	RESTORE_ROUNDMODE
+}
+
 // ____________________________________________________________________________
 //
 void	NativeInt24ToFloat32_Portable( const UInt8 *vsrc, Float32 *dest, unsigned int count )
@@ -240,3 +270,451 @@ void	SwapInt24ToFloat32_Portable( const UInt8 *vsrc, Float32 *dest, unsigned int
 		*dest++ = lv * scale;
 	}
 }
+
+// ____________________________________________________________________________
+//	16 and 32-bit. These are the reference the optimized converters are checked against: a sample
+//	is scaled, gets 0.5 (at its own width) added, is clipped and is rounded toward minus infinity,
+//	so 0.5 LSB rounds up. Negative overflow and NaN come out at negative full scale. At 32 bits the
+//	vector code clips at the biggest float below 2^31, so positive full scale is 2^31 - 128.
+
+void	Float32ToNativeInt16_Portable(const Float32 *src, SInt16 *dest, unsigned int count)
+{
+	double maxInt32 = 2147483648.0;	// 1 << 31
+	double round = 32768.0;
+	double max32 = maxInt32 - 1.0 - round;
+	double min32 = -2147483648.0;
+	
+	SET_ROUNDMODE
+	while (count--) {
+		double f1 = *src++ * maxInt32 + round;
+		*dest++ = (SInt16)(FloatToInt(f1, min32, max32) >> 16);
+	}
+	RESTORE_ROUNDMODE
+}
+
+void	Float32ToSwapInt16_Portable(const Float32 *src, SInt16 *dest, unsigned int count)
+{
+	double maxInt32 = 2147483648.0;	// 1 << 31
+	double round = 32768.0;
+	double max32 = maxInt32 - 1.0 - round;
+	double min32 = -2147483648.0;
+	
+	SET_ROUNDMODE
+	while (count--) {
+		double f1 = *src++ * maxInt32 + round;
+		*dest++ = (SInt16)OSSwapInt16((UInt16)(FloatToInt(f1, min32, max32) >> 16));
+	}
+	RESTORE_ROUNDMODE
+}
+
+void	NativeInt16ToFloat32_Portable(const SInt16 *src, Float32 *dest, unsigned int count)
+{
+	double scale = 1. / 32768.0;
+	
+	while (count--)
+		*dest++ = (Float32)(*src++ * scale);
+}
+
+void	SwapInt16ToFloat32_Portable(const SInt16 *src, Float32 *dest, unsigned int count)
+{
+	double scale = 1. / 32768.0;
+	
+	while (count--)
+		*dest++ = (Float32)((SInt16)OSSwapInt16((UInt16)*src++) * scale);
+}
+
+void	Float32ToNativeInt32_Portable(const Float32 *src, SInt32 *dest, unsigned int count)
+{
+	double maxInt32 = 2147483648.0;	// 1 << 31
+	double round = 0.5;
+	double max32 = 2147483520.0;	// 2^31 - 128
+	double min32 = -2147483648.0;
+	
+	SET_ROUNDMODE
+	while (count--) {
+		double f1 = *src++ * maxInt32 + round;
+		*dest++ = (f1 >= max32) ? (SInt32)max32 : FloatToInt(f1, min32, max32);
+	}
+	RESTORE_ROUNDMODE
+}
+
+void	Float32ToSwapInt32_Portable(const Float32 *src, SInt32 *dest, unsigned int count)
+{
+	double maxInt32 = 2147483648.0;	// 1 << 31
+	double round = 0.5;
+	double max32 = 2147483520.0;	// 2^31 - 128
+	double min32 = -2147483648.0;
+	
+	SET_ROUNDMODE
+	while (count--) {
+		double f1 = *src++ * maxInt32 + round;
+		SInt32 i1 = (f1 >= max32) ? (SInt32)max32 : FloatToInt(f1, min32, max32);
+		*dest++ = (SInt32)OSSwapInt32((UInt32)i1);
+	}
+	RESTORE_ROUNDMODE
+}
+
+void	NativeInt32ToFloat32_Portable(const SInt32 *src, Float32 *dest, unsigned int count)
+{
+	double scale = 1. / 2147483648.0;
+	
+	while (count--)
+		*dest++ = (Float32)(*src++ * scale);
+}
+
+void	SwapInt32ToFloat32_Portable(const SInt32 *src, Float32 *dest, unsigned int count)
+{
+	double scale = 1. / 2147483648.0;
+	
+	while (count--)
+		*dest++ = (Float32)((SInt32)OSSwapInt32((UInt32)*src++) * scale);
+}
+
+// ____________________________________________________________________________
+//	Mixing: one single-precision add per source per sample, sources in order.
+
+void	MixFloat32_Portable(const Float32 *src, Float32 *dest, unsigned int count)
+{
+	while (count--)
+		*dest++ += *src++;
+}
+
+void	MixFloat32Multi_Portable(const Float32 * const src[], unsigned int nSources, Float32 *dest, unsigned int count)
+{
+	unsigned int i, s;
+	
+	for (i = 0; i < count; ++i) {
+		Float32 f = dest[i];
+		for (s = 0; s < nSources; ++s)
+			f += src[s][i];
+		dest[i] = f;
+	}
+}
+
+// ____________________________________________________________________________
+//	G.711 decoding, computed from the code rather than looked up: 16-bit values, scaled as
+//	NativeInt16ToFloat32 does.
+
+void	ALawToFloat32_Portable(const UInt8 *src, Float32 *dest, unsigned int count)
+{
+	while (count--) {
+		unsigned int a = *src++ ^ 0x55;
+		unsigned int seg = (a & 0x70) >> 4;
+		SInt32 t = (a & 0x0F) << 4;
+		
+		if (seg == 0)
+			t += 8;
+		else
+			t = (t + 0x108) << (seg - 1);
+		*dest++ = (Float32)(((a & 0x80) ? t : -t) * (1. / 32768.0));
+	}
+}
+
+void	MuLawToFloat32_Portable(const UInt8 *src, Float32 *dest, unsigned int count)
+{
+	while (count--) {
+		unsigned int u = ~*src++ & 0xFF;
+		SInt32 t = (((u & 0x0F) << 3) + 0x84) << ((u & 0x70) >> 4);
+		
+		*dest++ = (Float32)(((u & 0x80) ? 0x84 - t : t - 0x84) * (1. / 32768.0));
+	}
+}
+
+// ____________________________________________________________________________
+//	Float64, 8-bit and G.711 encoding. The 8 and 16-bit values are scaled, rounded and clipped in
+//	single precision, as the vector code does; the G.711 encoders take the sample rounded to 16 bits.
+
+void	Float32ToFloat64_Portable(const Float32 *src, Float64 *dest, unsigned int count)
+{
+	while (count--)
+		*dest++ = *src++;
+}
+
+void	Float64ToFloat32_Portable(const Float64 *src, Float32 *dest, unsigned int count)
+{
+	while (count--)
+		*dest++ = (Float32)*src++;
+}
+
+// -scale to scale - 1; NaN comes out at negative full scale
+static SInt32	Float32ToIntValue_Portable(Float32 f, Float32 scale)
+{
+	SInt32 i;
+	
+	f = f * scale + 0.5f;
+	if (!(f > -scale))
+		return -(SInt32)scale;
+	if (f >= scale - 1.0f)
+		return (SInt32)scale - 1;
+	i = (SInt32)f;
+	return (i > f) ? i - 1 : i;
+}
+
+void	Float32ToSInt8_Portable(const Float32 *src, SInt8 *dest, unsigned int count)
+{
+	while (count--)
+		*dest++ = (SInt8)Float32ToIntValue_Portable(*src++, 128.0f);
+}
+
+void	Float32ToUInt8_Portable(const Float32 *src, UInt8 *dest, unsigned int count)
+{
+	while (count--)
+		*dest++ = (UInt8)(Float32ToIntValue_Portable(*src++, 128.0f) + 128);
+}
+
+void	SInt8ToFloat32_Portable(const SInt8 *src, Float32 *dest, unsigned int count)
+{
+	while (count--)
+		*dest++ = (Float32)*src++ * (1.0f / 128.0f);
+}
+
+void	UInt8ToFloat32_Portable(const UInt8 *src, Float32 *dest, unsigned int count)
+{
+	while (count--)
+		*dest++ = (Float32)((SInt32)*src++ - 128) * (1.0f / 128.0f);
+}
+
+// the classic segment search on 13 bits
+void	Float32ToALaw_Portable(const Float32 *src, UInt8 *dest, unsigned int count)
+{
+	while (count--) {
+		SInt32 pcm = Float32ToIntValue_Portable(*src++, 32768.0f) >> 3;
+		UInt8 mask = 0xD5;
+		unsigned int seg, a;
+		
+		if (pcm < 0) {
+			mask = 0x55;
+			pcm = -pcm - 1;
+		}
+		for (seg = 0; seg < 8 && pcm >= (0x20 << seg); ++seg)
+			;
+		if (seg >= 8)
+			a = 0x7F;
+		else
+			a = (seg << 4) | ((pcm >> (seg < 2 ? 1 : seg)) & 0x0F);
+		*dest++ = (UInt8)(a ^ mask);
+	}
+}
+
+// the classic biased encoder on 16 bits
+void	Float32ToMuLaw_Portable(const Float32 *src, UInt8 *dest, unsigned int count)
+{
+	while (count--) {
+		SInt32 pcm = Float32ToIntValue_Portable(*src++, 32768.0f);
+		unsigned int sign = 0, seg;
+		
+		if (pcm < 0) {
+			sign = 0x80;
+			pcm = -pcm;
+		}
+		if (pcm > 32635)
+			pcm = 32635;
+		pcm += 0x84;
+		for (seg = 0; seg < 7 && (pcm >> (seg + 8)) != 0; ++seg)
+			;
+		*dest++ = (UInt8)~(sign | (seg << 4) | ((pcm >> (seg + 3)) & 0x0F));
+	}
+}
+
+// ____________________________________________________________________________
+//	The write-combined copies are plain copies here.
+
+void	bcopy_Portable(const void *src, void *dest, unsigned int count)
+{
+	const UInt8 *s = (const UInt8 *)src;
+	UInt8 *d = (UInt8 *)dest;
+	
+	while (count--)
+		*d++ = *s++;
+}
+
+// ____________________________________________________________________________
+//	TPDF dither, the reference for the vector versions (see Float32ToIntDithered_X86) and the
+//	fallback where there are none. One xorshift generator makes the noise, two samples to a
+//	random number: the sum of two bytes less 255, triangular over +/-255/256 LSB. A chunk at a
+//	time is quantized, in double, to whole LSBs that the plain converter then keeps exactly.
+
+#define kDitherChunkSamples	256
+
+static inline UInt32	Xorshift32_Portable(UInt32 *s)
+{
+	UInt32 x = *s;
+	
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *s = x;
+}
+
+// chunk[i] = the dithered src[i], in whole LSBs times lsb; c is the channel of src[0]
+static void	DitherChunk_Portable(const Float32 *src, Float32 *chunk, unsigned int count, unsigned int nChannels, unsigned int c, UInt32 seed[], Float32 *shapingError, double scale)
+{
+	UInt32 r = 0;
+	unsigned int i;
+	
+	for (i = 0; i < count; ++i) {
+		Float32 x = src[i];
+		double v, q;
+		SInt32 n;
+		
+		if ((i & 1) == 0)
+			r = Xorshift32_Portable(&seed[0]);
+		else
+			r >>= 16;
+		// clip first, so a full scale or NaN input can't run the error away
+		x = (x > -1.0f) ? x : -1.0f;
+		x = (x < 1.0f) ? x : 1.0f;
+		v = x * scale;
+		if (shapingError)
+			v -= shapingError[c];
+		// floor(v + noise + 0.5)
+		q = v + (double)((SInt32)(r & 0xFF) + (SInt32)((r >> 8) & 0xFF) - 127) * (1.0 / 256.0);
+		n = (SInt32)q;
+		if (n > q)
+			--n;
+		if (shapingError) {
+			shapingError[c] = (Float32)(n - v);
+			if (++c == nChannels)
+				c = 0;
+		}
+		chunk[i] = (Float32)(n / scale);
+	}
+}
+
+void	Float32ToNativeInt16Dithered_Portable(const Float32 *src, SInt16 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError)
+{
+	Float32 chunk[kDitherChunkSamples];
+	unsigned int c = 0;
+	
+	if (nChannels == 0)
+		return;
+	while (count > 0) {
+		unsigned int n = (count < kDitherChunkSamples) ? count : kDitherChunkSamples;
+		
+		DitherChunk_Portable(src, chunk, n, nChannels, c, seed, shapingError, 32768.0);
+		Float32ToNativeInt16_Portable(chunk, dest, n);
+		c = (c + n) % nChannels;
+		src += n;
+		dest += n;
+		count -= n;
+	}
+}
+
+void	Float32ToSwapInt16Dithered_Portable(const Float32 *src, SInt16 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError)
+{
+	Float32 chunk[kDitherChunkSamples];
+	unsigned int c = 0;
+	
+	if (nChannels == 0)
+		return;
+	while (count > 0) {
+		unsigned int n = (count < kDitherChunkSamples) ? count : kDitherChunkSamples;
+		
+		DitherChunk_Portable(src, chunk, n, nChannels, c, seed, shapingError, 32768.0);
+		Float32ToSwapInt16_Portable(chunk, dest, n);
+		c = (c + n) % nChannels;
+		src += n;
+		dest += n;
+		count -= n;
+	}
+}
+
+void	Float32ToNativeInt24Dithered_Portable(const Float32 *src, UInt8 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError)
+{
+	Float32 chunk[kDitherChunkSamples];
+	unsigned int c = 0;
+	
+	if (nChannels == 0)
+		return;
+	while (count > 0) {
+		unsigned int n = (count < kDitherChunkSamples) ? count : kDitherChunkSamples;
+		
+		DitherChunk_Portable(src, chunk, n, nChannels, c, seed, shapingError, 8388608.0);
+		Float32ToNativeInt24_Portable(chunk, dest, n);
+		c = (c + n) % nChannels;
+		src += n;
+		dest += 3 * n;
+		count -= n;
+	}
+}
+
+void	Float32ToSwapInt24Dithered_Portable(const Float32 *src, UInt8 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError)
+{
+	Float32 chunk[kDitherChunkSamples];
+	unsigned int c = 0;
+	
+	if (nChannels == 0)
+		return;
+	while (count > 0) {
+		unsigned int n = (count < kDitherChunkSamples) ? count : kDitherChunkSamples;
+		
+		DitherChunk_Portable(src, chunk, n, nChannels, c, seed, shapingError, 8388608.0);
+		Float32ToSwapInt24_Portable(chunk, dest, n);
+		c = (c + n) % nChannels;
+		src += n;
+		dest += 3 * n;
+		count -= n;
+	}
+}
+
+// ____________________________________________________________________________
+//	dB -> gain, and the per-frame step of a gain ramp. There is no libm in the kernel, so
+//	2^x and log2 are done here, in double, to well under a millionth.
+
+typedef union {
+	double	d;
+	UInt64	i;
+} PCMDoubleBits;
+
+static double Exp2(double x)
+{
+	PCMDoubleBits scale;
+	double n, f;
+
+	if (x < -1022.0)
+		return 0.0;
+	if (x > 1023.0)
+		x = 1023.0;
+	n = (double)(SInt32)(x < 0.0 ? x - 0.5 : x + 0.5);	// nearest integer
+	f = (x - n) * 0.69314718055994531;					// |f| <= ln(2) / 2
+	scale.i = (UInt64)((SInt64)n + 1023) << 52;
+	return scale.d * (1.0 + f * (1.0 + f * (1.0/2 + f * (1.0/6 + f * (1.0/24 + f * (1.0/120 + f * (1.0/720 + f * (1.0/5040))))))));
+}
+
+// x must be positive and normal
+static double Log2(double x)
+{
+	PCMDoubleBits m;
+	SInt32 e;
+	double s, s2;
+
+	m.d = x;
+	e = (SInt32)((m.i >> 52) & 0x7FF) - 1023;
+	m.i = (m.i & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL;	// mantissa, in [1, 2)
+	if (m.d > 1.4142135623730950) {
+		m.d *= 0.5;
+		++e;
+	}
+	// ln(m) = 2 atanh(s)
+	s = (m.d - 1.0) / (m.d + 1.0);
+	s2 = s * s;
+	return e + 2.0 * 1.4426950408889634 * s * (1.0 + s2 * (1.0/3 + s2 * (1.0/5 + s2 * (1.0/7 + s2 * (1.0/9 + s2 * (1.0/11))))));
+}
+
+Float32	DecibelsToGain_Portable(SInt32 dB)
+{
+	// 10^(dB/20) = 2^(dB * log2(10) / 20)
+	return (Float32)Exp2((double)dB * (0.16609640474436813 / 65536.0));
+}
+
+Float32	GainRampStep_Portable(Float32 fromGain, Float32 toGain, unsigned int nFrames, bool exponential)
+{
+	if (exponential) {
+		if (nFrames == 0 || fromGain <= 0.0f || toGain <= 0.0f)
+			return 1.0f;
+		return (Float32)Exp2(Log2((double)toGain / fromGain) / nFrames);
+	}
+	if (nFrames == 0)
+		return 0.0f;
+	return (toGain - fromGain) / nFrames;
+}
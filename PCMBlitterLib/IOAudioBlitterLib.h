@@ -61,7 +61,14 @@ typedef double	Float64;
 
 // can turn these off for debugging
 #define PCMBLIT_PPC	TARGET_CPU_PPC
-#define PCMBLIT_X86 (__i386__ || __LP64__)
+#ifndef PCMBLIT_X86
+#define PCMBLIT_X86 (__i386__ || __x86_64__)
+#endif
+
+// everything else gets the compiler-vector versions in IOAudioBlitterLibVector.cpp
+#ifndef PCMBLIT_VECTOR
+#define PCMBLIT_VECTOR (!PCMBLIT_X86 && !PCMBLIT_PPC)
+#endif
 
 #if TARGET_CPU_PPC && !PCMBLIT_PPC
 #warning "PPC optimizations turned off"
@@ -71,7 +78,9 @@ typedef double	Float64;
 #warning "X86 optimizations turned off"
 #endif
 
-#define PCMBLIT_INTERLEAVE_SUPPORT TARGET_CPU_PPC	// uses Altivec
+#define PCMBLIT_INTERLEAVE_SUPPORT (TARGET_CPU_PPC || PCMBLIT_X86)	// uses Altivec or SSE2
+
+#define kDitherSeeds	64	// the dither generators; kIOAF_DitherSeeds, one per lane of 4 AVX-512 vectors
 
 typedef const void *ConstVoidPtr;
 
@@ -120,7 +129,7 @@ __asm__ __volatile__ ( "mtfsf 7, %0" : : "f" (oldSetting) );
 
 #define RESTORE_ROUNDMODE SETCSR(_savemxcsr);
 #define SET_ROUNDMODE 		ROUNDMODE_NEG_INF
-#elif TARGET_OS_MAC && __LP64__
+#elif TARGET_OS_MAC && __x86_64__
 // our compiler does ALL floating point with SSE
 #define GETCSR()    ({ int _result; asm volatile ("stmxcsr %0" : "=m" (*&_result) ); /*return*/ _result; })
 #define SETCSR( a )    { int _temp = a; asm volatile( "ldmxcsr %0" : : "m" (*&_temp ) ); }
@@ -160,15 +169,22 @@ static inline SInt32 FloatToInt(double inf, double min32, double max32)
 			 /* inputs:   */ : "f" (inf));
 	i = u.i[1];
 	return i;
-#elif defined( __i386__ )  || defined( __LP64__ )
+#elif defined( __i386__ )  || defined( __x86_64__ )
 #pragma unused ( min32 )
+	SInt32 i;
 	
 	if (inf >= max32) return 0x7FFFFFFF;
-	return (SInt32)inf;
+	// cvtsd2si rounds as the MXCSR says (a cast would truncate toward zero); out of range or NaN gives 0x80000000
+	__asm__ __volatile__ ("cvtsd2si %1, %0" : "=r" (i) : "x" (inf));
+	return i;
 #else
+	SInt32 i;
+	
 	if (inf >= max32) return 0x7FFFFFFF;
-	else if (inf <= min32) return 0x80000000;
-	return (SInt32)inf;
+	else if (!(inf > min32)) return 0x80000000;	// NaN too, as on x86
+	// no round mode to set: round toward minus infinity here
+	i = (SInt32)inf;
+	return (i > inf) ? i - 1 : i;
 #endif
 }
 
@@ -186,8 +202,9 @@ public:
 	
 #if PCMBLIT_INTERLEAVE_SUPPORT
 	// optional methods
-	virtual void	Interleave(ConstVoidPtr , void *, int , unsigned int ) { }
-	virtual void	Deinterleave(ConstVoidPtr , void *, int , unsigned int ) {  }
+	// one buffer per channel <-> one interleaved buffer
+	virtual void	Interleave(const ConstVoidPtr [], void *, int , unsigned int ) { }
+	virtual void	Deinterleave(ConstVoidPtr , void * const [], int , unsigned int ) {  }
 #endif
 };
 
@@ -247,7 +264,7 @@ public:
 						 /* inputs:   */ : "b%" (0), "r" (p) 
 						 /* clobbers: */ : "memory");
 		return result;
-#elif PCMBLIT_X86 && !TARGET_OS_WIN32
+#elif !TARGET_OS_WIN32
 		return OSReadSwapInt16(p, 0);
 #else
 		return Endian16_Swap(*p);
@@ -257,7 +274,7 @@ public:
 	{
 #if PCMBLIT_PPC
 		__asm__ volatile("sthbrx %0, %1, %2" : : "r" (val), "b%" (0), "r" (p) : "memory");
-#elif PCMBLIT_X86 && !TARGET_OS_WIN32
+#elif !TARGET_OS_WIN32
 		OSWriteSwapInt16(p, 0, val);
 #else
 		*p = Endian16_Swap(val);
@@ -283,7 +300,7 @@ public:
 		register long lwbrxResult;
 		__asm__ volatile("lwbrx %0, %1, %2" : "=r" (lwbrxResult) : "b%" (0), "r" (p) : "memory");
 		return lwbrxResult;
-#elif PCMBLIT_X86 && !TARGET_OS_WIN32
+#elif !TARGET_OS_WIN32
 		return OSReadSwapInt32(p, 0);
 #else
 		return Endian32_Swap(*p);
@@ -294,7 +311,7 @@ public:
 		*p = val;
 #if PCMBLIT_PPC
 		__asm__ volatile("stwbrx %0, %1, %2" : : "r" (val), "b%" (0), "r" (p) : "memory");
-#elif PCMBLIT_X86 && !TARGET_OS_WIN32
+#elif !TARGET_OS_WIN32
 		OSWriteSwapInt32(p, 0, val);
 #else
 		*p = Endian32_Swap(val);
@@ -302,6 +319,65 @@ public:
 	}
 };
 
+// packed 24-bit samples; sizeof(PCMSInt24) is 3 so that pointer arithmetic steps one sample
+struct PCMSInt24 {
+	UInt8	b[3];
+};
+
+class PCMSInt24Native {
+public:
+	typedef PCMSInt24 value_type;
+
+	static SInt32 load(const value_type *p)
+	{
+		return (SInt32)(((UInt32)p->b[0] << 8) | ((UInt32)p->b[1] << 16) | ((UInt32)p->b[2] << 24)) >> 8;
+	}
+	static void store(value_type *p, int val)
+	{
+		p->b[0] = val;
+		p->b[1] = val >> 8;
+		p->b[2] = val >> 16;
+	}
+};
+
+class PCMSInt24Swap {
+public:
+	typedef PCMSInt24 value_type;
+
+	static SInt32 load(const value_type *p)
+	{
+		return (SInt32)(((UInt32)p->b[2] << 8) | ((UInt32)p->b[1] << 16) | ((UInt32)p->b[0] << 24)) >> 8;
+	}
+	static void store(value_type *p, int val)
+	{
+		p->b[2] = val;
+		p->b[1] = val >> 8;
+		p->b[0] = val >> 16;
+	}
+};
+
+class PCMFloat32Swap {
+public:
+	typedef Float32 value_type;
+
+	static value_type load(const value_type *vp) {
+		union {
+			Float32 f;
+			UInt32	i;
+		} u;
+		u.i = PCMSInt32Swap::load((const UInt32 *)vp);
+		return u.f;
+	}
+	static void store(value_type *vp, value_type val) {
+		union {
+			Float32 f;
+			UInt32	i;
+		} u;
+		u.f = val;
+		PCMSInt32Swap::store((UInt32 *)vp, u.i);
+	}
+};
+
 class PCMFloat64Swap {
 public:
 	typedef Float64 value_type;
@@ -641,6 +717,160 @@ public:
 	}
 #endif // PCMBLIT_INTERLEAVE_SUPPORT
 };
+
+// ____________________________________________________________________________
+//
+// TIntToIntBlitter
+// Converts between integer widths and byte orders without going through float. Samples are
+// left-justified to 32 bits; narrowing rounds to nearest (halves up) and clips at full scale,
+// the same result Float32ToInt would give for the exact value. Same-width conversions are
+// pure byte swaps.
+template <class SrcType, class DestType>
+class TIntToIntBlitter : public PCMBlitter {
+public:
+	typedef typename SrcType::value_type src_val;
+	typedef typename DestType::value_type dest_val;
+
+	enum {
+		kSrcShift = 32 - 8 * sizeof(src_val),
+		kDestShift = 32 - 8 * sizeof(dest_val),
+		kRoundShift = (kDestShift > 0) ? kDestShift - 1 : 0
+	};
+
+	virtual void	Convert(const void *vsrc, void *vdest, unsigned int nSamples)
+	{
+		ConvertSamples(vsrc, vdest, nSamples);
+	}
+
+	static void		ConvertSamples(const void *vsrc, void *vdest, unsigned int nSamples)
+	{
+		const src_val *src = (const src_val *)vsrc;
+		dest_val *dest = (dest_val *)vdest;
+
+		while (nSamples--) {
+			SInt32 i = (SInt32)((UInt32)(SInt32)SrcType::load(src) << kSrcShift);
+			if (kDestShift > 0) {
+				i = ((i >> kRoundShift) + 1) >> 1;
+				if (i > (0x7FFFFFFF >> kDestShift))
+					i = 0x7FFFFFFF >> kDestShift;
+			}
+			DestType::store(dest, i);
+			++src;
+			++dest;
+		}
+	}
+};
+
+// ____________________________________________________________________________
+//
+// TPCMConverter
+// One static Convert for every (source, destination) pair of the types above, so that a table
+// of plain function pointers can cover all formats. The kind argument selects the generic loop:
+// both integer, integer -> float, float -> integer, or both float. Hot pairs are given full
+// specializations which call the optimized routines (see IOAudioBlitterLibDispatch.cpp).
+//
+// Integer <-> float uses the same scale and rounding as the optimized converters: ints are
+// scaled by 1 / 2^(bitDepth - 1); floats are scaled by 2^(bitDepth - 1), rounded to nearest
+// (halves up) and clipped. A NaN converts to 0.
+template <class T> struct PCMIsFloat { enum { value = 0 }; };
+template <> struct PCMIsFloat<PCMFloat32> { enum { value = 1 }; };
+template <> struct PCMIsFloat<PCMFloat32Swap> { enum { value = 1 }; };
+template <> struct PCMIsFloat<PCMFloat64> { enum { value = 1 }; };
+template <> struct PCMIsFloat<PCMFloat64Swap> { enum { value = 1 }; };
+
+enum {
+	kPCMConvertIntToInt = 0,
+	kPCMConvertIntToFloat = 1,
+	kPCMConvertFloatToInt = 2,
+	kPCMConvertFloatToFloat = 3
+};
+
+template <class SrcType, class DestType, int kKind = (PCMIsFloat<SrcType>::value << 1) | PCMIsFloat<DestType>::value>
+class TPCMConverter;
+
+template <class SrcType, class DestType>
+class TPCMConverter<SrcType, DestType, kPCMConvertIntToInt> {
+public:
+	static void Convert(const void *vsrc, void *vdest, unsigned int nSamples)
+	{
+		TIntToIntBlitter<SrcType, DestType>::ConvertSamples(vsrc, vdest, nSamples);
+	}
+};
+
+template <class SrcType, class DestType>
+class TPCMConverter<SrcType, DestType, kPCMConvertIntToFloat> {
+public:
+	typedef typename SrcType::value_type src_val;
+	typedef typename DestType::value_type dest_val;
+
+	static void Convert(const void *vsrc, void *vdest, unsigned int nSamples)
+	{
+		const src_val *src = (const src_val *)vsrc;
+		dest_val *dest = (dest_val *)vdest;
+		const dest_val scale = dest_val(1.0 / double(1UL << (8 * sizeof(src_val) - 1)));
+
+		while (nSamples--) {
+			DestType::store(dest, dest_val((SInt32)SrcType::load(src)) * scale);
+			++src;
+			++dest;
+		}
+	}
+};
+
+template <class SrcType, class DestType>
+class TPCMConverter<SrcType, DestType, kPCMConvertFloatToInt> {
+public:
+	typedef typename SrcType::value_type src_val;
+	typedef typename DestType::value_type dest_val;
+
+	static void Convert(const void *vsrc, void *vdest, unsigned int nSamples)
+	{
+		const src_val *src = (const src_val *)vsrc;
+		dest_val *dest = (dest_val *)vdest;
+		const double scale = double(1UL << (8 * sizeof(dest_val) - 1));
+		const double maxInt = scale - 1.0;
+		const double minInt = -scale;
+
+		while (nSamples--) {
+			double f = double(SrcType::load(src)) * scale + 0.5;
+			SInt32 i;
+			if (f != f)
+				i = 0;		// converting a NaN to an integer is undefined
+			else if (f >= maxInt)
+				i = SInt32(maxInt);
+			else if (f <= minInt)
+				i = SInt32(minInt);
+			else {
+				// floor without the FPU rounding mode: truncation is wrong only for negative fractions
+				i = SInt32(f);
+				if (double(i) > f)
+					--i;
+			}
+			DestType::store(dest, i);
+			++src;
+			++dest;
+		}
+	}
+};
+
+template <class SrcType, class DestType>
+class TPCMConverter<SrcType, DestType, kPCMConvertFloatToFloat> {
+public:
+	typedef typename SrcType::value_type src_val;
+	typedef typename DestType::value_type dest_val;
+
+	static void Convert(const void *vsrc, void *vdest, unsigned int nSamples)
+	{
+		const src_val *src = (const src_val *)vsrc;
+		dest_val *dest = (dest_val *)vdest;
+
+		while (nSamples--) {
+			DestType::store(dest, dest_val(SrcType::load(src)));
+			++src;
+			++dest;
+		}
+	}
+};
 #endif // __cplusplus
 
 #ifdef __cplusplus
@@ -683,7 +913,7 @@ extern "C" {
 	//void	Deinterleave32_Altivec(const void *vsrc, void *vdstA, void *vdstB, unsigned int numFrames); untested
 	NO_EXPORT void	Interleave32_Altivec(const void *vsrcA, const void *vsrcB, void *vdst, unsigned int numFrames);
 	
-#elif defined( __i386__ ) || defined( __LP64__ )
+#elif defined( __i386__ ) || defined( __x86_64__ )
 #pragma mark -
 #pragma mark X86 SSE2
 	// ____________________________________________________________________________________
@@ -700,25 +930,262 @@ extern "C" {
 	NO_EXPORT void	SwapInt32ToFloat32_X86( const SInt32 *src, Float32 *dest, unsigned int count );
 	NO_EXPORT void	Float32ToNativeInt32_X86( const Float32 *src, SInt32 *dest, unsigned int count );
 	NO_EXPORT void	Float32ToSwapInt32_X86( const Float32 *src, SInt32 *dest, unsigned int count );
-#elif __LP64__
+
+	// interleaved buffers hold nChannels samples per frame; the others are one buffer per channel
+	NO_EXPORT void	Interleave32_X86( const void * const src[], void *dest, unsigned int nChannels, unsigned int nFrames );
+	NO_EXPORT void	Deinterleave32_X86( const void *src, void * const dest[], unsigned int nChannels, unsigned int nFrames );
+	NO_EXPORT void	DeinterleaveFloat32ToNativeInt16_X86( const Float32 *src, SInt16 * const dest[], unsigned int nChannels, unsigned int nFrames );
+	NO_EXPORT void	DeinterleaveFloat32ToSwapInt16_X86( const Float32 *src, SInt16 * const dest[], unsigned int nChannels, unsigned int nFrames );
+	NO_EXPORT void	DeinterleaveFloat32ToNativeInt32_X86( const Float32 *src, SInt32 * const dest[], unsigned int nChannels, unsigned int nFrames );
+	NO_EXPORT void	DeinterleaveFloat32ToSwapInt32_X86( const Float32 *src, SInt32 * const dest[], unsigned int nChannels, unsigned int nFrames );
+	NO_EXPORT void	InterleaveNativeInt16ToFloat32_X86( const SInt16 * const src[], Float32 *dest, unsigned int nChannels, unsigned int nFrames );
+	NO_EXPORT void	InterleaveSwapInt16ToFloat32_X86( const SInt16 * const src[], Float32 *dest, unsigned int nChannels, unsigned int nFrames );
+	NO_EXPORT void	InterleaveNativeInt32ToFloat32_X86( const SInt32 * const src[], Float32 *dest, unsigned int nChannels, unsigned int nFrames );
+	NO_EXPORT void	InterleaveSwapInt32ToFloat32_X86( const SInt32 * const src[], Float32 *dest, unsigned int nChannels, unsigned int nFrames );
+
+	// dest[i] += src[i]
+	NO_EXPORT void	MixFloat32_X86( const Float32 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	MixFloat32Multi_X86( const Float32 * const src[], unsigned int nSources, Float32 *dest, unsigned int count );
+
+	// non-temporal stores, for destinations in uncached or write-combined memory
+	NO_EXPORT void	Float32ToNativeInt16_X86NT( const Float32 *src, SInt16 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToSwapInt16_X86NT( const Float32 *src, SInt16 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToNativeInt24_X86NT( const Float32 *src, UInt8 *dst, unsigned int numToConvert );
+	NO_EXPORT void	Float32ToSwapInt24_X86NT( const Float32 *src, UInt8 *dst, unsigned int numToConvert );
+	NO_EXPORT void	Float32ToNativeInt32_X86NT( const Float32 *src, SInt32 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToSwapInt32_X86NT( const Float32 *src, SInt32 *dest, unsigned int count );
+
+	// bytes to write-combined memory with streaming stores; the source is prefetched this far ahead
+	#define kWCPrefetchDistance	512
+	NO_EXPORT void	bcopy_ToWriteCombine_X86( const void *src, void *dest, unsigned int count );
+
+	// src is interleaved with nChannels channels; each sample is scaled by gain[its channel] before conversion
+	NO_EXPORT void	Float32ToNativeInt16WithGain_X86( const Float32 *src, SInt16 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels );
+	NO_EXPORT void	Float32ToSwapInt16WithGain_X86( const Float32 *src, SInt16 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels );
+	NO_EXPORT void	Float32ToNativeInt24WithGain_X86( const Float32 *src, UInt8 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels );
+	NO_EXPORT void	Float32ToSwapInt24WithGain_X86( const Float32 *src, UInt8 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels );
+	NO_EXPORT void	Float32ToNativeInt32WithGain_X86( const Float32 *src, SInt32 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels );
+	NO_EXPORT void	Float32ToSwapInt32WithGain_X86( const Float32 *src, SInt32 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels );
+
+	// TPDF dither, fresh for every sample, from 4 vectors of xorshift generators in seed[kDitherSeeds]. With shapingError
+	// (one per channel, rounded up to a multiple of 4) the quantization error is fed back, per channel. Calls must
+	// start on a frame boundary.
+	NO_EXPORT void	Float32ToNativeInt16Dithered_X86( const Float32 *src, SInt16 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+	NO_EXPORT void	Float32ToSwapInt16Dithered_X86( const Float32 *src, SInt16 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+	NO_EXPORT void	Float32ToNativeInt24Dithered_X86( const Float32 *src, UInt8 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+	NO_EXPORT void	Float32ToSwapInt24Dithered_X86( const Float32 *src, UInt8 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+
+	// IOAF_Float32ToIntBatch under one round mode setup; the job type is in IOAudioBlitterLibDispatch.h
+	struct IOAF_ConversionJob;
+	NO_EXPORT void	Float32ToIntBatch_X86( const struct IOAF_ConversionJob *jobs, unsigned int nJobs );
+
+	// dest = src * g(frame), g(n) = gain + n * step, or gain * step^n if exponential; returns g(nFrames)
+	NO_EXPORT Float32	GainRampFloat32_X86( const Float32 *src, Float32 *dest, unsigned int nChannels, unsigned int nFrames, Float32 gain, Float32 step, bool exponential );
+
+	// integer -> integer without going through float; same-width swaps are symmetric
+	NO_EXPORT void	ByteSwapInt16_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	ByteSwapInt24_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	ByteSwapInt32_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt16ToNativeInt24_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt16ToSwapInt24_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt16ToNativeInt32_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt16ToSwapInt32_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt16ToNativeInt24_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt16ToSwapInt24_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt16ToNativeInt32_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt16ToSwapInt32_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt24ToNativeInt16_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt24ToSwapInt16_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt24ToNativeInt32_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt24ToSwapInt32_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt24ToNativeInt16_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt24ToSwapInt16_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt24ToNativeInt32_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt24ToSwapInt32_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt32ToNativeInt16_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt32ToSwapInt16_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt32ToNativeInt24_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt32ToSwapInt24_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt32ToNativeInt16_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt32ToSwapInt16_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt32ToNativeInt24_X86( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt32ToSwapInt24_X86( const void *src, void *dest, unsigned int count );
+
+	// Float64 and the 8-bit formats; A-law and mu-law are G.711, encoded from 16 bits
+	NO_EXPORT void	Float32ToFloat64_X86( const Float32 *src, Float64 *dest, unsigned int count );
+	NO_EXPORT void	Float64ToFloat32_X86( const Float64 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToSInt8_X86( const Float32 *src, SInt8 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToUInt8_X86( const Float32 *src, UInt8 *dest, unsigned int count );
+	NO_EXPORT void	SInt8ToFloat32_X86( const SInt8 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	UInt8ToFloat32_X86( const UInt8 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToALaw_X86( const Float32 *src, UInt8 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToMuLaw_X86( const Float32 *src, UInt8 *dest, unsigned int count );
+	NO_EXPORT void	ALawToFloat32_X86( const UInt8 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	MuLawToFloat32_X86( const UInt8 *src, Float32 *dest, unsigned int count );
+
+	// bitDepth-bit samples in 16, 24 or 32-bit containers (bitWidth), high aligned or low aligned
+	NO_EXPORT void	Float32ToNativeIntJustified_X86( const Float32 *src, void *dest, unsigned int count, unsigned int bitDepth, unsigned int bitWidth, bool highAligned );
+	NO_EXPORT void	Float32ToSwapIntJustified_X86( const Float32 *src, void *dest, unsigned int count, unsigned int bitDepth, unsigned int bitWidth, bool highAligned );
+	NO_EXPORT void	NativeIntJustifiedToFloat32_X86( const void *src, Float32 *dest, unsigned int count, unsigned int bitDepth, unsigned int bitWidth, bool highAligned );
+	NO_EXPORT void	SwapIntJustifiedToFloat32_X86( const void *src, Float32 *dest, unsigned int count, unsigned int bitDepth, unsigned int bitWidth, bool highAligned );
+
 #pragma mark -
-#pragma mark X86 SSE2
+#pragma mark X86 SSSE3
 	// ____________________________________________________________________________________
-	// X86 SSE2
-	NO_EXPORT void	NativeInt16ToFloat32_X86( const SInt16 *src, Float32 *dest, unsigned int count );
-	NO_EXPORT void	SwapInt16ToFloat32_X86( const SInt16 *src, Float32 *dest, unsigned int count );
-	NO_EXPORT void	Float32ToNativeInt16_X86( const Float32 *src, SInt16 *dest, unsigned int count );
-	NO_EXPORT void	Float32ToSwapInt16_X86( const Float32 *src, SInt16 *dest, unsigned int count );
-	
-	NO_EXPORT void	Float32ToNativeInt24_X86( const Float32 *src, UInt8 *dst, unsigned int numToConvert );
-	NO_EXPORT void	Float32ToSwapInt24_X86( const Float32 *src, UInt8 *dst, unsigned int numToConvert );
-	
-	NO_EXPORT void	NativeInt32ToFloat32_X86( const SInt32 *src, Float32 *dest, unsigned int count );
-	NO_EXPORT void	SwapInt32ToFloat32_X86( const SInt32 *src, Float32 *dest, unsigned int count );
-	NO_EXPORT void	Float32ToNativeInt32_X86( const Float32 *src, SInt32 *dest, unsigned int count );
-	NO_EXPORT void	Float32ToSwapInt32_X86( const Float32 *src, SInt32 *dest, unsigned int count );
+	// X86 SSSE3 -- only reachable through the dispatch table, after a CPUID check
+	NO_EXPORT void	NativeInt24ToFloat32_SSSE3( const UInt8 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	SwapInt24ToFloat32_SSSE3( const UInt8 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToNativeInt24_SSSE3( const Float32 *src, UInt8 *dst, unsigned int numToConvert );
+	NO_EXPORT void	Float32ToSwapInt24_SSSE3( const Float32 *src, UInt8 *dst, unsigned int numToConvert );
+	NO_EXPORT void	ALawToFloat32_SSSE3( const UInt8 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	MuLawToFloat32_SSSE3( const UInt8 *src, Float32 *dest, unsigned int count );
+
+#pragma mark -
+#pragma mark X86 AVX2
+	// ____________________________________________________________________________________
+	// X86 AVX2 -- only reachable through the dispatch table, after a CPUID/XGETBV check
+	NO_EXPORT void	NativeInt16ToFloat32_AVX2( const SInt16 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	SwapInt16ToFloat32_AVX2( const SInt16 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToNativeInt16_AVX2( const Float32 *src, SInt16 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToSwapInt16_AVX2( const Float32 *src, SInt16 *dest, unsigned int count );
+
+	NO_EXPORT void	NativeInt24ToFloat32_AVX2( const UInt8 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	SwapInt24ToFloat32_AVX2( const UInt8 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToNativeInt24_AVX2( const Float32 *src, UInt8 *dst, unsigned int numToConvert );
+	NO_EXPORT void	Float32ToSwapInt24_AVX2( const Float32 *src, UInt8 *dst, unsigned int numToConvert );
+
+	NO_EXPORT void	NativeInt32ToFloat32_AVX2( const SInt32 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	SwapInt32ToFloat32_AVX2( const SInt32 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToNativeInt32_AVX2( const Float32 *src, SInt32 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToSwapInt32_AVX2( const Float32 *src, SInt32 *dest, unsigned int count );
+
+	// see Float32ToNativeInt16Dithered_X86; the noise shaped path is the SSE2 one
+	NO_EXPORT void	Float32ToNativeInt16Dithered_AVX2( const Float32 *src, SInt16 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+	NO_EXPORT void	Float32ToSwapInt16Dithered_AVX2( const Float32 *src, SInt16 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+	NO_EXPORT void	Float32ToNativeInt24Dithered_AVX2( const Float32 *src, UInt8 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+	NO_EXPORT void	Float32ToSwapInt24Dithered_AVX2( const Float32 *src, UInt8 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+
+	NO_EXPORT void	MixFloat32_AVX2( const Float32 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	MixFloat32Multi_AVX2( const Float32 * const src[], unsigned int nSources, Float32 *dest, unsigned int count );
+
+	NO_EXPORT void	bcopy_FromWriteCombine_AVX2( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	bcopy_ToWriteCombine_AVX2( const void *src, void *dest, unsigned int count );
+
+#pragma mark -
+#pragma mark X86 AVX-512
+	// ____________________________________________________________________________________
+	// X86 AVX-512F and BW -- only reachable through the dispatch table, after a CPUID/XGETBV check
+	NO_EXPORT void	bcopy_FromWriteCombine_AVX512( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	bcopy_ToWriteCombine_AVX512( const void *src, void *dest, unsigned int count );
+
+	// see Float32ToNativeInt16Dithered_X86; the noise shaped path is the SSE2 one
+	NO_EXPORT void	Float32ToNativeInt16Dithered_AVX512( const Float32 *src, SInt16 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+	NO_EXPORT void	Float32ToSwapInt16Dithered_AVX512( const Float32 *src, SInt16 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+	NO_EXPORT void	Float32ToNativeInt24Dithered_AVX512( const Float32 *src, UInt8 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+	NO_EXPORT void	Float32ToSwapInt24Dithered_AVX512( const Float32 *src, UInt8 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+#endif
+
+#if PCMBLIT_VECTOR
+#pragma mark -
+#pragma mark Vector
+	// ____________________________________________________________________________________
+	// GCC/Clang vector extensions, for everything without a hand-written backend
+	NO_EXPORT void	NativeInt16ToFloat32_Vector( const SInt16 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	SwapInt16ToFloat32_Vector( const SInt16 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToNativeInt16_Vector( const Float32 *src, SInt16 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToSwapInt16_Vector( const Float32 *src, SInt16 *dest, unsigned int count );
 	
+	NO_EXPORT void	NativeInt24ToFloat32_Vector( const UInt8 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	SwapInt24ToFloat32_Vector( const UInt8 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToNativeInt24_Vector( const Float32 *src, UInt8 *dst, unsigned int numToConvert );
+	NO_EXPORT void	Float32ToSwapInt24_Vector( const Float32 *src, UInt8 *dst, unsigned int numToConvert );
 	
+	NO_EXPORT void	NativeInt32ToFloat32_Vector( const SInt32 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	SwapInt32ToFloat32_Vector( const SInt32 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToNativeInt32_Vector( const Float32 *src, SInt32 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToSwapInt32_Vector( const Float32 *src, SInt32 *dest, unsigned int count );
+
+	// interleaved buffers hold nChannels samples per frame; the others are one buffer per channel
+	NO_EXPORT void	Interleave32_Vector( const void * const src[], void *dest, unsigned int nChannels, unsigned int nFrames );
+	NO_EXPORT void	Deinterleave32_Vector( const void *src, void * const dest[], unsigned int nChannels, unsigned int nFrames );
+	NO_EXPORT void	DeinterleaveFloat32ToNativeInt16_Vector( const Float32 *src, SInt16 * const dest[], unsigned int nChannels, unsigned int nFrames );
+	NO_EXPORT void	DeinterleaveFloat32ToSwapInt16_Vector( const Float32 *src, SInt16 * const dest[], unsigned int nChannels, unsigned int nFrames );
+	NO_EXPORT void	DeinterleaveFloat32ToNativeInt32_Vector( const Float32 *src, SInt32 * const dest[], unsigned int nChannels, unsigned int nFrames );
+	NO_EXPORT void	DeinterleaveFloat32ToSwapInt32_Vector( const Float32 *src, SInt32 * const dest[], unsigned int nChannels, unsigned int nFrames );
+	NO_EXPORT void	InterleaveNativeInt16ToFloat32_Vector( const SInt16 * const src[], Float32 *dest, unsigned int nChannels, unsigned int nFrames );
+	NO_EXPORT void	InterleaveSwapInt16ToFloat32_Vector( const SInt16 * const src[], Float32 *dest, unsigned int nChannels, unsigned int nFrames );
+	NO_EXPORT void	InterleaveNativeInt32ToFloat32_Vector( const SInt32 * const src[], Float32 *dest, unsigned int nChannels, unsigned int nFrames );
+	NO_EXPORT void	InterleaveSwapInt32ToFloat32_Vector( const SInt32 * const src[], Float32 *dest, unsigned int nChannels, unsigned int nFrames );
+
+	// dest[i] += src[i]
+	NO_EXPORT void	MixFloat32_Vector( const Float32 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	MixFloat32Multi_Vector( const Float32 * const src[], unsigned int nSources, Float32 *dest, unsigned int count );
+
+	// src is interleaved with nChannels channels; each sample is scaled by gain[its channel] before conversion
+	NO_EXPORT void	Float32ToNativeInt16WithGain_Vector( const Float32 *src, SInt16 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels );
+	NO_EXPORT void	Float32ToSwapInt16WithGain_Vector( const Float32 *src, SInt16 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels );
+	NO_EXPORT void	Float32ToNativeInt24WithGain_Vector( const Float32 *src, UInt8 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels );
+	NO_EXPORT void	Float32ToSwapInt24WithGain_Vector( const Float32 *src, UInt8 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels );
+	NO_EXPORT void	Float32ToNativeInt32WithGain_Vector( const Float32 *src, SInt32 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels );
+	NO_EXPORT void	Float32ToSwapInt32WithGain_Vector( const Float32 *src, SInt32 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels );
+
+	// TPDF dither, fresh for every sample, from 4 vectors of xorshift generators in seed[kDitherSeeds]. With shapingError
+	// (one per channel, rounded up to a multiple of 4) the quantization error is fed back, per channel. Calls must
+	// start on a frame boundary.
+	NO_EXPORT void	Float32ToNativeInt16Dithered_Vector( const Float32 *src, SInt16 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+	NO_EXPORT void	Float32ToSwapInt16Dithered_Vector( const Float32 *src, SInt16 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+	NO_EXPORT void	Float32ToNativeInt24Dithered_Vector( const Float32 *src, UInt8 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+	NO_EXPORT void	Float32ToSwapInt24Dithered_Vector( const Float32 *src, UInt8 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+
+	// dest = src * g(frame), g(n) = gain + n * step, or gain * step^n if exponential; returns g(nFrames)
+	NO_EXPORT Float32	GainRampFloat32_Vector( const Float32 *src, Float32 *dest, unsigned int nChannels, unsigned int nFrames, Float32 gain, Float32 step, bool exponential );
+
+	// integer -> integer without going through float; same-width swaps are symmetric
+	NO_EXPORT void	ByteSwapInt16_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	ByteSwapInt24_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	ByteSwapInt32_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt16ToNativeInt24_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt16ToSwapInt24_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt16ToNativeInt32_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt16ToSwapInt32_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt16ToNativeInt24_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt16ToSwapInt24_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt16ToNativeInt32_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt16ToSwapInt32_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt24ToNativeInt16_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt24ToSwapInt16_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt24ToNativeInt32_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt24ToSwapInt32_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt24ToNativeInt16_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt24ToSwapInt16_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt24ToNativeInt32_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt24ToSwapInt32_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt32ToNativeInt16_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt32ToSwapInt16_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt32ToNativeInt24_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	NativeInt32ToSwapInt24_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt32ToNativeInt16_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt32ToSwapInt16_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt32ToNativeInt24_Vector( const void *src, void *dest, unsigned int count );
+	NO_EXPORT void	SwapInt32ToSwapInt24_Vector( const void *src, void *dest, unsigned int count );
+
+	// Float64 and the 8-bit formats; A-law and mu-law are G.711, encoded from 16 bits
+	NO_EXPORT void	Float32ToFloat64_Vector( const Float32 *src, Float64 *dest, unsigned int count );
+	NO_EXPORT void	Float64ToFloat32_Vector( const Float64 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToSInt8_Vector( const Float32 *src, SInt8 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToUInt8_Vector( const Float32 *src, UInt8 *dest, unsigned int count );
+	NO_EXPORT void	SInt8ToFloat32_Vector( const SInt8 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	UInt8ToFloat32_Vector( const UInt8 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToALaw_Vector( const Float32 *src, UInt8 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToMuLaw_Vector( const Float32 *src, UInt8 *dest, unsigned int count );
+	NO_EXPORT void	ALawToFloat32_Vector( const UInt8 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	MuLawToFloat32_Vector( const UInt8 *src, Float32 *dest, unsigned int count );
+
+	// bitDepth-bit samples in 16, 24 or 32-bit containers (bitWidth), high aligned or low aligned
+	NO_EXPORT void	Float32ToNativeIntJustified_Vector( const Float32 *src, void *dest, unsigned int count, unsigned int bitDepth, unsigned int bitWidth, bool highAligned );
+	NO_EXPORT void	Float32ToSwapIntJustified_Vector( const Float32 *src, void *dest, unsigned int count, unsigned int bitDepth, unsigned int bitWidth, bool highAligned );
+	NO_EXPORT void	NativeIntJustifiedToFloat32_Vector( const void *src, Float32 *dest, unsigned int count, unsigned int bitDepth, unsigned int bitWidth, bool highAligned );
+	NO_EXPORT void	SwapIntJustifiedToFloat32_Vector( const void *src, Float32 *dest, unsigned int count, unsigned int bitDepth, unsigned int bitWidth, bool highAligned );
 #endif
 	
 #pragma mark -
@@ -739,6 +1206,76 @@ extern "C" {
 	NO_EXPORT void	Float32ToSwapInt32_Portable( const Float32 *src, SInt32 *dest, unsigned int count );
 	NO_EXPORT void	NativeInt32ToFloat32_Portable( const SInt32 *src, Float32 *dest, unsigned int count );
 	NO_EXPORT void	SwapInt32ToFloat32_Portable( const SInt32 *src, Float32 *dest, unsigned int count );
+
+	NO_EXPORT void	MixFloat32_Portable( const Float32 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	MixFloat32Multi_Portable( const Float32 * const src[], unsigned int nSources, Float32 *dest, unsigned int count );
+	NO_EXPORT void	ALawToFloat32_Portable( const UInt8 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	MuLawToFloat32_Portable( const UInt8 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToFloat64_Portable( const Float32 *src, Float64 *dest, unsigned int count );
+	NO_EXPORT void	Float64ToFloat32_Portable( const Float64 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToSInt8_Portable( const Float32 *src, SInt8 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToUInt8_Portable( const Float32 *src, UInt8 *dest, unsigned int count );
+	NO_EXPORT void	SInt8ToFloat32_Portable( const SInt8 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	UInt8ToFloat32_Portable( const UInt8 *src, Float32 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToALaw_Portable( const Float32 *src, UInt8 *dest, unsigned int count );
+	NO_EXPORT void	Float32ToMuLaw_Portable( const Float32 *src, UInt8 *dest, unsigned int count );
+	NO_EXPORT void	bcopy_Portable( const void *src, void *dest, unsigned int count );
+
+	// TPDF dither from one xorshift generator, seed[0]; shapingError as for Float32ToNativeInt16Dithered_X86
+	NO_EXPORT void	Float32ToNativeInt16Dithered_Portable( const Float32 *src, SInt16 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+	NO_EXPORT void	Float32ToSwapInt16Dithered_Portable( const Float32 *src, SInt16 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+	NO_EXPORT void	Float32ToNativeInt24Dithered_Portable( const Float32 *src, UInt8 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+	NO_EXPORT void	Float32ToSwapInt24Dithered_Portable( const Float32 *src, UInt8 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+
+	// dB is 16.16 fixed point; the step is for GainRampFloat32_X86
+	NO_EXPORT Float32	DecibelsToGain_Portable( SInt32 dB );
+	NO_EXPORT Float32	GainRampStep_Portable( Float32 fromGain, Float32 toGain, unsigned int nFrames, bool exponential );
+
+#pragma mark -
+#pragma mark Dispatch tables
+	// ____________________________________________________________________________________
+	// The converters IOAudioBlitterLibDispatch.cpp reaches through a table, one table per backend
+	typedef void (*IOAF_IntToFloat16Proc)( const SInt16 *src, Float32 *dest, unsigned int count );
+	typedef void (*IOAF_IntToFloat24Proc)( const UInt8 *src, Float32 *dest, unsigned int count );
+	typedef void (*IOAF_IntToFloat32Proc)( const SInt32 *src, Float32 *dest, unsigned int count );
+	typedef void (*IOAF_FloatToInt16Proc)( const Float32 *src, SInt16 *dest, unsigned int count );
+	typedef void (*IOAF_FloatToInt24Proc)( const Float32 *src, UInt8 *dest, unsigned int count );
+	typedef void (*IOAF_FloatToInt32Proc)( const Float32 *src, SInt32 *dest, unsigned int count );
+	typedef void (*IOAF_MixFloat32Proc)( const Float32 *src, Float32 *dest, unsigned int count );
+	typedef void (*IOAF_MixFloat32MultiProc)( const Float32 * const src[], unsigned int nSources, Float32 *dest, unsigned int count );
+	typedef void (*IOAF_LawToFloat32Proc)( const UInt8 *src, Float32 *dest, unsigned int count );
+	typedef void (*IOAF_CopyProc)( const void *src, void *dest, unsigned int count );
+	typedef void (*IOAF_FloatToInt16DitheredProc)( const Float32 *src, SInt16 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+	typedef void (*IOAF_FloatToInt24DitheredProc)( const Float32 *src, UInt8 *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+
+	typedef struct IOAF_ConverterTable {
+		IOAF_IntToFloat16Proc	nativeInt16ToFloat32;
+		IOAF_IntToFloat16Proc	swapInt16ToFloat32;
+		IOAF_IntToFloat24Proc	nativeInt24ToFloat32;
+		IOAF_IntToFloat24Proc	swapInt24ToFloat32;
+		IOAF_IntToFloat32Proc	nativeInt32ToFloat32;
+		IOAF_IntToFloat32Proc	swapInt32ToFloat32;
+		IOAF_FloatToInt16Proc	float32ToNativeInt16;
+		IOAF_FloatToInt16Proc	float32ToSwapInt16;
+		IOAF_FloatToInt24Proc	float32ToNativeInt24;
+		IOAF_FloatToInt24Proc	float32ToSwapInt24;
+		IOAF_FloatToInt32Proc	float32ToNativeInt32;
+		IOAF_FloatToInt32Proc	float32ToSwapInt32;
+		IOAF_MixFloat32Proc		mixFloat32;
+		IOAF_MixFloat32MultiProc	mixFloat32Multi;
+		IOAF_LawToFloat32Proc	aLawToFloat32;
+		IOAF_LawToFloat32Proc	muLawToFloat32;
+		IOAF_CopyProc			bcopyFromWriteCombine;
+		IOAF_CopyProc			bcopyToWriteCombine;
+		IOAF_FloatToInt16DitheredProc	float32ToNativeInt16Dithered;
+		IOAF_FloatToInt16DitheredProc	float32ToSwapInt16Dithered;
+		IOAF_FloatToInt24DitheredProc	float32ToNativeInt24Dithered;
+		IOAF_FloatToInt24DitheredProc	float32ToSwapInt24Dithered;
+	} IOAF_ConverterTable;
+
+	// Fills in the tables this CPU can run, the table of _Portable references first, and returns
+	// how many there are (at most maxTables). For the host test harness in PCMBlitterLib/Tests.
+	NO_EXPORT unsigned int	IOAF_GetConverterTables( const IOAF_ConverterTable *tables[], const char *names[], unsigned int maxTables );
 	
 #ifdef __cplusplus
 };
@@ -0,0 +1,1296 @@
+/*	Copyright: 	© Copyright 2005-2010 Apple Computer, Inc. All rights reserved.
+ 
+ Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+ ("Apple") in consideration of your agreement to the following terms, and your
+ use, installation, modification or redistribution of this Apple software
+ constitutes acceptance of these terms.  If you do not agree with these terms,
+ please do not use, install, modify or redistribute this Apple software.
+ 
+ In consideration of your agreement to abide by the following terms, and subject
+ to these terms, Apple grants you a personal, non-exclusive license, under Apple’s
+ copyrights in this original Apple software (the "Apple Software"), to use,
+ reproduce, modify and redistribute the Apple Software, with or without
+ modifications, in source and/or binary forms; provided that if you redistribute
+ the Apple Software in its entirety and without modifications, you must retain
+ this notice and the following text and disclaimers in all such redistributions of
+ the Apple Software.  Neither the name, trademarks, service marks or logos of
+ Apple Computer, Inc. may be used to endorse or promote products derived from the
+ Apple Software without specific prior written permission from Apple.  Except as
+ expressly stated in this notice, no other rights or licenses, express or implied,
+ are granted by Apple herein, including but not limited to any patent rights that
+ may be infringed by your derivative works or by other works in which the Apple
+ Software may be incorporated.
+ 
+ The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+ WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+ WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+ COMBINATION WITH YOUR PRODUCTS.
+ 
+ IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+ OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+ (INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*=============================================================================
+	IOAudioBlitterLibAVX2.cpp
+
+=============================================================================*/
+
+#include <TargetConditionals.h>
+
+#if __i386__ || __x86_64__
+#define _MM_MALLOC_H_INCLUDED 1	// we don't want this header
+#include <immintrin.h>
+#include "IOAudioBlitterLib.h"
+#include <libkern/OSByteOrder.h>
+
+/*
+	AVX2 (256-bit) versions of the X86 blitters.
+
+	This file is compiled with -mavx2. Nothing in here may be called unless the dispatcher
+	has verified that both the CPU and the OS (XCR0) support AVX2; see IOAudioBlitterLibDispatch.cpp.
+
+	The structure mirrors IOAudioBlitterLibX86.cpp: one unaligned vector to get one side
+	aligned, an aligned main loop, then one overlapping unaligned vector at the end.
+	Buffers too short for a single 256-bit vector are handed to the SSE2 routines.
+*/
+
+#define kMaxFloat32 2147483520.0f
+	// this is the biggest floating point number that result from a 32-bit int (bits are lost)
+	// it's 2^31 - 128
+
+static inline __m256i  byteswap16_avx2( __m256i v )
+{
+	const __m256i vswap = _mm256_setr_epi8(	1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+											1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 );
+	return _mm256_shuffle_epi8( v, vswap );
+}
+
+static inline __m256i  byteswap32_avx2( __m256i v )
+{
+	const __m256i vswap = _mm256_setr_epi8(	3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+											3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 );
+	return _mm256_shuffle_epi8( v, vswap );
+}
+
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Float -> Int
+
+void Float32ToNativeInt16_AVX2( const Float32 *src, SInt16 *dst, unsigned int numToConvert )
+{
+	const float *src0 = src;
+	int16_t *dst0 = dst;
+	unsigned int count = numToConvert;
+
+	if (count < 16) {
+		Float32ToNativeInt16_X86(src, dst, count);
+		return;
+	}
+
+	// vector -- requires 16+ samples
+	ROUNDMODE_NEG_INF
+	const __m256 vround = _mm256_set1_ps(0.5f);
+	const __m256 vmin = _mm256_set1_ps(-32768.0f);
+	const __m256 vmax = _mm256_set1_ps(32767.0f);
+	const __m256 vscale = _mm256_set1_ps(32768.0f);
+	__m256 vf0, vf1;
+	__m256i vi0, vi1, vpack0;
+
+	// _mm256_packs_epi32 packs within each 128-bit lane, so put the quadwords back in order afterwards
+#define F32TOLE16 \
+	vf0 = _mm256_mul_ps(vf0, vscale);			\
+	vf1 = _mm256_mul_ps(vf1, vscale);			\
+	vf0 = _mm256_add_ps(vf0, vround);			\
+	vf1 = _mm256_add_ps(vf1, vround);			\
+	vf0 = _mm256_max_ps(vf0, vmin);				\
+	vf1 = _mm256_max_ps(vf1, vmin);				\
+	vf0 = _mm256_min_ps(vf0, vmax);				\
+	vf1 = _mm256_min_ps(vf1, vmax);				\
+	vi0 = _mm256_cvtps_epi32(vf0);				\
+	vi1 = _mm256_cvtps_epi32(vf1);				\
+	vpack0 = _mm256_packs_epi32(vi0, vi1);		\
+	vpack0 = _mm256_permute4x64_epi64(vpack0, 0xD8);
+
+	int falign = (uintptr_t)src & 0x1F;
+	int ialign = (uintptr_t)dst & 0x1F;
+
+	if (falign != 0 || ialign != 0) {
+		// do one unaligned conversion
+		vf0 = _mm256_loadu_ps(src);
+		vf1 = _mm256_loadu_ps(src+8);
+		F32TOLE16
+		_mm256_storeu_si256((__m256i *)dst, vpack0);
+
+		// advance such that the destination ints are aligned
+		unsigned int n = (32 - ialign) / 2;
+		src += n;
+		dst += n;
+		count -= n;
+
+		falign = (uintptr_t)src & 0x1F;
+		if (falign != 0) {
+			// unaligned loads, aligned stores
+			while (count >= 16) {
+				vf0 = _mm256_loadu_ps(src);
+				vf1 = _mm256_loadu_ps(src+8);
+				F32TOLE16
+				_mm256_store_si256((__m256i *)dst, vpack0);
+				src += 16;
+				dst += 16;
+				count -= 16;
+			}
+			goto VectorCleanup;
+		}
+	}
+
+	// aligned loads, aligned stores
+	while (count >= 16) {
+		vf0 = _mm256_load_ps(src);
+		vf1 = _mm256_load_ps(src+8);
+		F32TOLE16
+		_mm256_store_si256((__m256i *)dst, vpack0);
+
+		src += 16;
+		dst += 16;
+		count -= 16;
+	}
+VectorCleanup:
+	if (count > 0) {
+		// unaligned cleanup -- just do one unaligned vector at the end
+		src = src0 + numToConvert - 16;
+		dst = dst0 + numToConvert - 16;
+		vf0 = _mm256_loadu_ps(src);
+		vf1 = _mm256_loadu_ps(src+8);
+		F32TOLE16
+		_mm256_storeu_si256((__m256i *)dst, vpack0);
+	}
+	RESTORE_ROUNDMODE
+}
+
+// ===================================================================================================
+
+void Float32ToSwapInt16_AVX2( const Float32 *src, SInt16 *dst, unsigned int numToConvert )
+{
+	const float *src0 = src;
+	int16_t *dst0 = dst;
+	unsigned int count = numToConvert;
+
+	if (count < 16) {
+		Float32ToSwapInt16_X86(src, dst, count);
+		return;
+	}
+
+	// vector -- requires 16+ samples
+	ROUNDMODE_NEG_INF
+	const __m256 vround = _mm256_set1_ps(0.5f);
+	const __m256 vmin = _mm256_set1_ps(-32768.0f);
+	const __m256 vmax = _mm256_set1_ps(32767.0f);
+	const __m256 vscale = _mm256_set1_ps(32768.0f);
+	__m256 vf0, vf1;
+	__m256i vi0, vi1, vpack0;
+
+#define F32TOBE16 \
+	F32TOLE16									\
+	vpack0 = byteswap16_avx2(vpack0);
+
+	int falign = (uintptr_t)src & 0x1F;
+	int ialign = (uintptr_t)dst & 0x1F;
+
+	if (falign != 0 || ialign != 0) {
+		// do one unaligned conversion
+		vf0 = _mm256_loadu_ps(src);
+		vf1 = _mm256_loadu_ps(src+8);
+		F32TOBE16
+		_mm256_storeu_si256((__m256i *)dst, vpack0);
+
+		// advance such that the destination ints are aligned
+		unsigned int n = (32 - ialign) / 2;
+		src += n;
+		dst += n;
+		count -= n;
+
+		falign = (uintptr_t)src & 0x1F;
+		if (falign != 0) {
+			// unaligned loads, aligned stores
+			while (count >= 16) {
+				vf0 = _mm256_loadu_ps(src);
+				vf1 = _mm256_loadu_ps(src+8);
+				F32TOBE16
+				_mm256_store_si256((__m256i *)dst, vpack0);
+				src += 16;
+				dst += 16;
+				count -= 16;
+			}
+			goto VectorCleanup;
+		}
+	}
+
+	// aligned loads, aligned stores
+	while (count >= 16) {
+		vf0 = _mm256_load_ps(src);
+		vf1 = _mm256_load_ps(src+8);
+		F32TOBE16
+		_mm256_store_si256((__m256i *)dst, vpack0);
+
+		src += 16;
+		dst += 16;
+		count -= 16;
+	}
+VectorCleanup:
+	if (count > 0) {
+		// unaligned cleanup -- just do one unaligned vector at the end
+		src = src0 + numToConvert - 16;
+		dst = dst0 + numToConvert - 16;
+		vf0 = _mm256_loadu_ps(src);
+		vf1 = _mm256_loadu_ps(src+8);
+		F32TOBE16
+		_mm256_storeu_si256((__m256i *)dst, vpack0);
+	}
+	RESTORE_ROUNDMODE
+}
+
+// ===================================================================================================
+
+void Float32ToNativeInt32_AVX2( const Float32 *src, SInt32 *dst, unsigned int numToConvert )
+{
+	const float *src0 = src;
+	SInt32 *dst0 = dst;
+	unsigned int count = numToConvert;
+
+	if (count < 8) {
+		Float32ToNativeInt32_X86(src, dst, count);
+		return;
+	}
+
+	// vector -- requires 8+ samples
+	ROUNDMODE_NEG_INF
+	const __m256 vround = _mm256_set1_ps(0.5f);
+	const __m256 vmin = _mm256_set1_ps(-2147483648.0f);
+	const __m256 vmax = _mm256_set1_ps(kMaxFloat32);
+	const __m256 vscale = _mm256_set1_ps(2147483648.0f);
+	__m256 vf0;
+	__m256i vi0;
+
+#define F32TOLE32(x) \
+	vf##x = _mm256_mul_ps(vf##x, vscale);		\
+	vf##x = _mm256_add_ps(vf##x, vround);		\
+	vf##x = _mm256_max_ps(vf##x, vmin);			\
+	vf##x = _mm256_min_ps(vf##x, vmax);			\
+	vi##x = _mm256_cvtps_epi32(vf##x);
+
+	int falign = (uintptr_t)src & 0x1F;
+	int ialign = (uintptr_t)dst & 0x1F;
+
+	if (falign != 0 || ialign != 0) {
+		// do one unaligned conversion
+		vf0 = _mm256_loadu_ps(src);
+		F32TOLE32(0)
+		_mm256_storeu_si256((__m256i *)dst, vi0);
+
+		// and advance such that the destination ints are aligned
+		unsigned int n = (32 - ialign) / 4;
+		src += n;
+		dst += n;
+		count -= n;
+
+		falign = (uintptr_t)src & 0x1F;
+		if (falign != 0) {
+			// unaligned loads, aligned stores
+			while (count >= 8) {
+				vf0 = _mm256_loadu_ps(src);
+				F32TOLE32(0)
+				_mm256_store_si256((__m256i *)dst, vi0);
+				src += 8;
+				dst += 8;
+				count -= 8;
+			}
+			goto VectorCleanup;
+		}
+	}
+
+	while (count >= 8) {
+		vf0 = _mm256_load_ps(src);
+		F32TOLE32(0)
+		_mm256_store_si256((__m256i *)dst, vi0);
+
+		src += 8;
+		dst += 8;
+		count -= 8;
+	}
+VectorCleanup:
+	if (count > 0) {
+		// unaligned cleanup -- just do one unaligned vector at the end
+		src = src0 + numToConvert - 8;
+		dst = dst0 + numToConvert - 8;
+		vf0 = _mm256_loadu_ps(src);
+		F32TOLE32(0)
+		_mm256_storeu_si256((__m256i *)dst, vi0);
+	}
+	RESTORE_ROUNDMODE
+}
+
+// ===================================================================================================
+
+void Float32ToSwapInt32_AVX2( const Float32 *src, SInt32 *dst, unsigned int numToConvert )
+{
+	const float *src0 = src;
+	SInt32 *dst0 = dst;
+	unsigned int count = numToConvert;
+
+	if (count < 8) {
+		Float32ToSwapInt32_X86(src, dst, count);
+		return;
+	}
+
+	// vector -- requires 8+ samples
+	ROUNDMODE_NEG_INF
+	const __m256 vround = _mm256_set1_ps(0.5f);
+	const __m256 vmin = _mm256_set1_ps(-2147483648.0f);
+	const __m256 vmax = _mm256_set1_ps(kMaxFloat32);
+	const __m256 vscale = _mm256_set1_ps(2147483648.0f);
+	__m256 vf0;
+	__m256i vi0;
+
+#define F32TOBE32(x) \
+	F32TOLE32(x)								\
+	vi##x = byteswap32_avx2(vi##x);
+
+	int falign = (uintptr_t)src & 0x1F;
+	int ialign = (uintptr_t)dst & 0x1F;
+
+	if (falign != 0 || ialign != 0) {
+		// do one unaligned conversion
+		vf0 = _mm256_loadu_ps(src);
+		F32TOBE32(0)
+		_mm256_storeu_si256((__m256i *)dst, vi0);
+
+		// and advance such that the destination ints are aligned
+		unsigned int n = (32 - ialign) / 4;
+		src += n;
+		dst += n;
+		count -= n;
+
+		falign = (uintptr_t)src & 0x1F;
+		if (falign != 0) {
+			// unaligned loads, aligned stores
+			while (count >= 8) {
+				vf0 = _mm256_loadu_ps(src);
+				F32TOBE32(0)
+				_mm256_store_si256((__m256i *)dst, vi0);
+				src += 8;
+				dst += 8;
+				count -= 8;
+			}
+			goto VectorCleanup;
+		}
+	}
+
+	while (count >= 8) {
+		vf0 = _mm256_load_ps(src);
+		F32TOBE32(0)
+		_mm256_store_si256((__m256i *)dst, vi0);
+
+		src += 8;
+		dst += 8;
+		count -= 8;
+	}
+VectorCleanup:
+	if (count > 0) {
+		// unaligned cleanup -- just do one unaligned vector at the end
+		src = src0 + numToConvert - 8;
+		dst = dst0 + numToConvert - 8;
+		vf0 = _mm256_loadu_ps(src);
+		F32TOBE32(0)
+		_mm256_storeu_si256((__m256i *)dst, vi0);
+	}
+	RESTORE_ROUNDMODE
+}
+
+// ===================================================================================================
+
+// The 24-bit packers round at 24-bit precision (scale by 2^23) and then gather the low three bytes
+// of each 32-bit lane with a byte shuffle. Each 128-bit lane yields 12 bytes; the upper lane is
+// shuffled up by 4 bytes so that both halves can be written with two overlapping 16-byte stores
+// that never touch memory past the 24 bytes of the 8 samples.
+#define F32TOI24(x) \
+	vf##x = _mm256_mul_ps(vf##x, vscale);		\
+	vf##x = _mm256_add_ps(vf##x, vround);		\
+	vf##x = _mm256_max_ps(vf##x, vmin);			\
+	vf##x = _mm256_min_ps(vf##x, vmax);			\
+	vi##x = _mm256_cvtps_epi32(vf##x);
+
+#define STOREI24(d) \
+	vi0 = _mm256_shuffle_epi8(vi0, vshuf);		\
+	vlo = _mm256_castsi256_si128(vi0);			\
+	vhi = _mm_or_si128(_mm256_extracti128_si256(vi0, 1), _mm_srli_si128(vlo, 8));	\
+	_mm_storeu_si128((__m128i *)(d), vlo);		\
+	_mm_storeu_si128((__m128i *)((d) + 8), vhi);
+
+static inline void Float32ToInt24_AVX2( const Float32 *src, UInt8 *dst, unsigned int numToConvert, const __m256i vshuf )
+{
+	const Float32 *src0 = src;
+	UInt8 *dst0 = dst;
+	unsigned int count = numToConvert;
+
+	// vector -- requires 8+ samples
+	ROUNDMODE_NEG_INF
+	const __m256 vround = _mm256_set1_ps(0.5f);
+	const __m256 vmin = _mm256_set1_ps(-8388608.0f);
+	const __m256 vmax = _mm256_set1_ps(8388607.0f);
+	const __m256 vscale = _mm256_set1_ps(8388608.0f);
+	__m256 vf0;
+	__m256i vi0;
+	__m128i vlo, vhi;
+
+	int falign = (uintptr_t)src & 0x1F;
+
+	if (falign != 0) {
+		// do one unaligned conversion
+		vf0 = _mm256_loadu_ps(src);
+		F32TOI24(0)
+		STOREI24(dst)
+
+		// and advance such that the source floats are aligned
+		unsigned int n = (32 - falign) / 4;
+		src += n;
+		dst += 3*n;	// bytes
+		count -= n;
+	}
+
+	while (count >= 8) {
+		vf0 = _mm256_load_ps(src);
+		F32TOI24(0)
+		STOREI24(dst)	// destination always unaligned
+
+		src += 8;
+		dst += 24;	// bytes
+		count -= 8;
+	}
+
+	if (count > 0) {
+		// unaligned cleanup -- just do one unaligned vector at the end
+		src = src0 + numToConvert - 8;
+		dst = dst0 + 3*numToConvert - 24;
+		vf0 = _mm256_loadu_ps(src);
+		F32TOI24(0)
+		STOREI24(dst)
+	}
+	RESTORE_ROUNDMODE
+}
+
+void Float32ToNativeInt24_AVX2( const Float32 *src, UInt8 *dst, unsigned int numToConvert )
+{
+	if (numToConvert < 8) {
+		Float32ToNativeInt24_Portable(src, dst, numToConvert);
+		return;
+	}
+	const __m256i vshuf = _mm256_setr_epi8(	0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+											-1, -1, -1, -1, 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14 );
+	Float32ToInt24_AVX2(src, dst, numToConvert, vshuf);
+}
+
+void Float32ToSwapInt24_AVX2( const Float32 *src, UInt8 *dst, unsigned int numToConvert )
+{
+	if (numToConvert < 8) {
+		Float32ToSwapInt24_Portable(src, dst, numToConvert);
+		return;
+	}
+	const __m256i vshuf = _mm256_setr_epi8(	2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+											-1, -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12 );
+	Float32ToInt24_AVX2(src, dst, numToConvert, vshuf);
+}
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Float -> Int dithered
+
+/*
+	Plain TPDF dither; see Float32ToIntDithered_X86 for how the noise is made. Four vectors of eight
+	xorshift generators, seed[0] to seed[31], each make 16 samples of noise a step, so that a round
+	of 64 samples keeps four independent shift/xor chains in flight under the float conversion.
+	vpmaddubsw sums the two bytes of each 16-bit half in one instruction. The sum of the scaled
+	sample and the bias is rounded down by the round mode, so it floors exactly.
+
+	The noise shaped path is bound by its per-channel recursion, not by the vector width, and is
+	the SSE2 one.
+*/
+
+#define kDitherGenerators_AVX2		4
+#define kDitherRoundSamples_AVX2	64		// one DitherBias16_AVX2 step of each generator
+
+static inline __m256i Xorshift32_AVX2( __m256i &s )
+{
+	s = _mm256_xor_si256(s, _mm256_slli_epi32(s, 13));
+	s = _mm256_xor_si256(s, _mm256_srli_epi32(s, 17));
+	s = _mm256_xor_si256(s, _mm256_slli_epi32(s, 5));
+	return s;
+}
+
+// 16 samples of TPDF noise in LSB units, plus 0.5
+static inline void DitherBias16_AVX2( __m256i &s, __m256 &bias0, __m256 &bias1 )
+{
+	const __m256i ones = _mm256_set1_epi8(1);
+	const __m256i exponent = _mm256_set1_epi16(0x4700);
+	const __m256 offset = _mm256_set1_ps(32768.0f + 127.0f / 256.0f);
+	__m256i u = _mm256_maddubs_epi16(Xorshift32_AVX2(s), ones);	// a + b
+
+	bias0 = _mm256_sub_ps(_mm256_castsi256_ps(_mm256_unpacklo_epi16(u, exponent)), offset);
+	bias1 = _mm256_sub_ps(_mm256_castsi256_ps(_mm256_unpackhi_epi16(u, exponent)), offset);
+}
+
+static inline void Float32ToInt16TPDF_AVX2( const Float32 *src, SInt16 *dst, unsigned int count, UInt32 seed[], bool swap )
+{
+	const __m256 vmax = _mm256_set1_ps(32767.0f);
+	const __m256 vscale = _mm256_set1_ps(32768.0f);
+	__m256i s0 = _mm256_loadu_si256((__m256i const *)seed);
+	__m256i s1 = _mm256_loadu_si256((__m256i const *)seed + 1);
+	__m256i s2 = _mm256_loadu_si256((__m256i const *)seed + 2);
+	__m256i s3 = _mm256_loadu_si256((__m256i const *)seed + 3);
+	__m256 vb0, vb1, vf0, vf1;
+	__m256i vpack0;
+
+	// packs saturates, so only the top needs clipping; min(vmax, v) is v when v is a NaN,
+	// which converts to negative full scale as in the undithered converters
+#define F32TOI16DITHERED(s, in, out) \
+	DitherBias16_AVX2(s, vb0, vb1);										\
+	vf0 = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(in), vscale), vb0);		\
+	vf1 = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps((in) + 8), vscale), vb1);	\
+	vf0 = _mm256_min_ps(vmax, vf0);										\
+	vf1 = _mm256_min_ps(vmax, vf1);										\
+	vpack0 = _mm256_packs_epi32(_mm256_cvtps_epi32(vf0), _mm256_cvtps_epi32(vf1));	\
+	vpack0 = _mm256_permute4x64_epi64(vpack0, 0xD8);						\
+	if (swap)															\
+		vpack0 = byteswap16_avx2(vpack0);								\
+	_mm256_storeu_si256((__m256i *)(out), vpack0);
+
+	ROUNDMODE_NEG_INF
+	for ( ; count >= kDitherRoundSamples_AVX2; count -= kDitherRoundSamples_AVX2) {
+		F32TOI16DITHERED(s0, src, dst)
+		F32TOI16DITHERED(s1, src + 16, dst + 16)
+		F32TOI16DITHERED(s2, src + 32, dst + 32)
+		F32TOI16DITHERED(s3, src + 48, dst + 48)
+		src += kDitherRoundSamples_AVX2;
+		dst += kDitherRoundSamples_AVX2;
+	}
+	for ( ; count >= 16; count -= 16) {
+		F32TOI16DITHERED(s0, src, dst)
+		src += 16;
+		dst += 16;
+	}
+	if (count > 0) {
+		// a last partial vector goes through the stack
+		Float32 tmp[16];
+		SInt16 out[16];
+		unsigned int i;
+
+		for (i = 0; i < 16; ++i)
+			tmp[i] = (i < count) ? src[i] : 0.0f;
+		F32TOI16DITHERED(s0, tmp, out)
+		for (i = 0; i < count; ++i)
+			dst[i] = out[i];
+	}
+	RESTORE_ROUNDMODE
+
+	_mm256_storeu_si256((__m256i *)seed, s0);
+	_mm256_storeu_si256((__m256i *)seed + 1, s1);
+	_mm256_storeu_si256((__m256i *)seed + 2, s2);
+	_mm256_storeu_si256((__m256i *)seed + 3, s3);
+}
+
+static inline void Float32ToInt24TPDF_AVX2( const Float32 *src, UInt8 *dst, unsigned int count, UInt32 seed[], const __m256i vshuf )
+{
+	const __m256 vmin = _mm256_set1_ps(-8388608.0f);
+	const __m256 vmax = _mm256_set1_ps(8388607.0f);
+	const __m256 vscale = _mm256_set1_ps(8388608.0f);
+	__m256i s0 = _mm256_loadu_si256((__m256i const *)seed);
+	__m256i s1 = _mm256_loadu_si256((__m256i const *)seed + 1);
+	__m256i s2 = _mm256_loadu_si256((__m256i const *)seed + 2);
+	__m256i s3 = _mm256_loadu_si256((__m256i const *)seed + 3);
+	__m256 vb0, vb1, vf0;
+	__m256i vi0;
+	__m128i vlo, vhi;
+
+	// as F32TOI24 with the bias for the 0.5, 16 samples to a step
+#define F32TOI24DITHERED(s, in, out) \
+	DitherBias16_AVX2(s, vb0, vb1);										\
+	vf0 = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(in), vscale), vb0);		\
+	vf0 = _mm256_min_ps(_mm256_max_ps(vf0, vmin), vmax);					\
+	vi0 = _mm256_cvtps_epi32(vf0);										\
+	STOREI24(out)														\
+	vf0 = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps((in) + 8), vscale), vb1);	\
+	vf0 = _mm256_min_ps(_mm256_max_ps(vf0, vmin), vmax);					\
+	vi0 = _mm256_cvtps_epi32(vf0);										\
+	STOREI24((out) + 24)
+
+	ROUNDMODE_NEG_INF
+	for ( ; count >= kDitherRoundSamples_AVX2; count -= kDitherRoundSamples_AVX2) {
+		F32TOI24DITHERED(s0, src, dst)
+		F32TOI24DITHERED(s1, src + 16, dst + 48)
+		F32TOI24DITHERED(s2, src + 32, dst + 96)
+		F32TOI24DITHERED(s3, src + 48, dst + 144)
+		src += kDitherRoundSamples_AVX2;
+		dst += 3 * kDitherRoundSamples_AVX2;	// bytes
+	}
+	for ( ; count >= 16; count -= 16) {
+		F32TOI24DITHERED(s0, src, dst)
+		src += 16;
+		dst += 48;	// bytes
+	}
+	if (count > 0) {
+		// a last partial vector goes through the stack
+		Float32 tmp[16];
+		UInt8 out[48];
+		unsigned int i;
+
+		for (i = 0; i < 16; ++i)
+			tmp[i] = (i < count) ? src[i] : 0.0f;
+		F32TOI24DITHERED(s0, tmp, out)
+		for (i = 0; i < 3 * count; ++i)
+			dst[i] = out[i];
+	}
+	RESTORE_ROUNDMODE
+
+	_mm256_storeu_si256((__m256i *)seed, s0);
+	_mm256_storeu_si256((__m256i *)seed + 1, s1);
+	_mm256_storeu_si256((__m256i *)seed + 2, s2);
+	_mm256_storeu_si256((__m256i *)seed + 3, s3);
+}
+
+void Float32ToNativeInt16Dithered_AVX2( const Float32 *src, SInt16 *dst, unsigned int numToConvert, unsigned int nChannels, UInt32 seed[], Float32 *shapingError )
+{
+	if (shapingError || nChannels == 0) {
+		Float32ToNativeInt16Dithered_X86(src, dst, numToConvert, nChannels, seed, shapingError);
+		return;
+	}
+	Float32ToInt16TPDF_AVX2(src, dst, numToConvert, seed, false);
+}
+
+void Float32ToSwapInt16Dithered_AVX2( const Float32 *src, SInt16 *dst, unsigned int numToConvert, unsigned int nChannels, UInt32 seed[], Float32 *shapingError )
+{
+	if (shapingError || nChannels == 0) {
+		Float32ToSwapInt16Dithered_X86(src, dst, numToConvert, nChannels, seed, shapingError);
+		return;
+	}
+	Float32ToInt16TPDF_AVX2(src, dst, numToConvert, seed, true);
+}
+
+void Float32ToNativeInt24Dithered_AVX2( const Float32 *src, UInt8 *dst, unsigned int numToConvert, unsigned int nChannels, UInt32 seed[], Float32 *shapingError )
+{
+	if (shapingError || nChannels == 0) {
+		Float32ToNativeInt24Dithered_X86(src, dst, numToConvert, nChannels, seed, shapingError);
+		return;
+	}
+	const __m256i vshuf = _mm256_setr_epi8(	0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+											-1, -1, -1, -1, 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14 );
+	Float32ToInt24TPDF_AVX2(src, dst, numToConvert, seed, vshuf);
+}
+
+void Float32ToSwapInt24Dithered_AVX2( const Float32 *src, UInt8 *dst, unsigned int numToConvert, unsigned int nChannels, UInt32 seed[], Float32 *shapingError )
+{
+	if (shapingError || nChannels == 0) {
+		Float32ToSwapInt24Dithered_X86(src, dst, numToConvert, nChannels, seed, shapingError);
+		return;
+	}
+	const __m256i vshuf = _mm256_setr_epi8(	2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+											-1, -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12 );
+	Float32ToInt24TPDF_AVX2(src, dst, numToConvert, seed, vshuf);
+}
+
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Int -> Float
+
+void NativeInt16ToFloat32_AVX2( const SInt16 *src, Float32 *dst, unsigned int numToConvert )
+{
+	const SInt16 *src0 = src;
+	Float32 *dst0 = dst;
+	unsigned int count = numToConvert;
+
+	if (count < 16) {
+		NativeInt16ToFloat32_X86(src, dst, count);
+		return;
+	}
+
+	// vector -- requires 16+ samples
+	// sign-extend each half of the 16-bit words to 32-bit values
+#define LEI16TOF32 \
+	vi0 = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(vpack0)); \
+	vi1 = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(vpack0, 1)); \
+	vf0 = _mm256_cvtepi32_ps(vi0); \
+	vf1 = _mm256_cvtepi32_ps(vi1); \
+	vf0 = _mm256_mul_ps(vf0, vscale); \
+	vf1 = _mm256_mul_ps(vf1, vscale);
+
+	const __m256 vscale = _mm256_set1_ps(1.0/32768.0f);
+	__m256 vf0, vf1;
+	__m256i vi0, vi1, vpack0;
+
+	int ialign = (uintptr_t)src & 0x1F;
+	int falign = (uintptr_t)dst & 0x1F;
+
+	if (falign != 0 || ialign != 0) {
+		// do one unaligned conversion
+		vpack0 = _mm256_loadu_si256((__m256i const *)src);
+		LEI16TOF32
+		_mm256_storeu_ps(dst, vf0);
+		_mm256_storeu_ps(dst+8, vf1);
+
+		// and advance such that the destination floats are aligned
+		unsigned int n = (32 - falign) / 4;
+		src += n;
+		dst += n;
+		count -= n;
+
+		ialign = (uintptr_t)src & 0x1F;
+		if (ialign != 0) {
+			// unaligned loads, aligned stores
+			while (count >= 16) {
+				vpack0 = _mm256_loadu_si256((__m256i const *)src);
+				LEI16TOF32
+				_mm256_store_ps(dst, vf0);
+				_mm256_store_ps(dst+8, vf1);
+				src += 16;
+				dst += 16;
+				count -= 16;
+			}
+			goto VectorCleanup;
+		}
+	}
+
+	// aligned loads, aligned stores
+	while (count >= 16) {
+		vpack0 = _mm256_load_si256((__m256i const *)src);
+		LEI16TOF32
+		_mm256_store_ps(dst, vf0);
+		_mm256_store_ps(dst+8, vf1);
+		src += 16;
+		dst += 16;
+		count -= 16;
+	}
+
+VectorCleanup:
+	if (count > 0) {
+		// unaligned cleanup -- just do one unaligned vector at the end
+		src = src0 + numToConvert - 16;
+		dst = dst0 + numToConvert - 16;
+		vpack0 = _mm256_loadu_si256((__m256i const *)src);
+		LEI16TOF32
+		_mm256_storeu_ps(dst, vf0);
+		_mm256_storeu_ps(dst+8, vf1);
+	}
+}
+
+// ===================================================================================================
+
+void SwapInt16ToFloat32_AVX2( const SInt16 *src, Float32 *dst, unsigned int numToConvert )
+{
+	const SInt16 *src0 = src;
+	Float32 *dst0 = dst;
+	unsigned int count = numToConvert;
+
+	if (count < 16) {
+		SwapInt16ToFloat32_X86(src, dst, count);
+		return;
+	}
+
+	// vector -- requires 16+ samples
+#define BEI16TOF32 \
+	vpack0 = byteswap16_avx2(vpack0); \
+	LEI16TOF32
+
+	const __m256 vscale = _mm256_set1_ps(1.0/32768.0f);
+	__m256 vf0, vf1;
+	__m256i vi0, vi1, vpack0;
+
+	int ialign = (uintptr_t)src & 0x1F;
+	int falign = (uintptr_t)dst & 0x1F;
+
+	if (falign != 0 || ialign != 0) {
+		// do one unaligned conversion
+		vpack0 = _mm256_loadu_si256((__m256i const *)src);
+		BEI16TOF32
+		_mm256_storeu_ps(dst, vf0);
+		_mm256_storeu_ps(dst+8, vf1);
+
+		// and advance such that the destination floats are aligned
+		unsigned int n = (32 - falign) / 4;
+		src += n;
+		dst += n;
+		count -= n;
+
+		ialign = (uintptr_t)src & 0x1F;
+		if (ialign != 0) {
+			// unaligned loads, aligned stores
+			while (count >= 16) {
+				vpack0 = _mm256_loadu_si256((__m256i const *)src);
+				BEI16TOF32
+				_mm256_store_ps(dst, vf0);
+				_mm256_store_ps(dst+8, vf1);
+				src += 16;
+				dst += 16;
+				count -= 16;
+			}
+			goto VectorCleanup;
+		}
+	}
+
+	// aligned loads, aligned stores
+	while (count >= 16) {
+		vpack0 = _mm256_load_si256((__m256i const *)src);
+		BEI16TOF32
+		_mm256_store_ps(dst, vf0);
+		_mm256_store_ps(dst+8, vf1);
+		src += 16;
+		dst += 16;
+		count -= 16;
+	}
+
+VectorCleanup:
+	if (count > 0) {
+		// unaligned cleanup -- just do one unaligned vector at the end
+		src = src0 + numToConvert - 16;
+		dst = dst0 + numToConvert - 16;
+		vpack0 = _mm256_loadu_si256((__m256i const *)src);
+		BEI16TOF32
+		_mm256_storeu_ps(dst, vf0);
+		_mm256_storeu_ps(dst+8, vf1);
+	}
+}
+
+// ===================================================================================================
+
+// Each 128-bit lane expands four packed 3-byte samples into the high three bytes of 32-bit ints.
+// The upper lane is loaded 8 bytes in (not 12) so that neither load reads past the 24 bytes of
+// the 8 samples; its shuffle indices are offset by 4 to compensate.
+#define I24TOF32(s) \
+	vi0 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((__m128i const *)(s))), \
+								  _mm_loadu_si128((__m128i const *)((s) + 8)), 1); \
+	vi0 = _mm256_shuffle_epi8(vi0, vshuf); \
+	vf0 = _mm256_cvtepi32_ps(vi0); \
+	vf0 = _mm256_mul_ps(vf0, vscale);
+
+static inline void Int24ToFloat32_AVX2( const UInt8 *src, Float32 *dst, unsigned int numToConvert, const __m256i vshuf )
+{
+	const UInt8 *src0 = src;
+	Float32 *dst0 = dst;
+	unsigned int count = numToConvert;
+
+	// vector -- requires 8+ samples
+	const __m256 vscale = _mm256_set1_ps(1.0/2147483648.0f);
+	__m256 vf0;
+	__m256i vi0;
+
+	int falign = (uintptr_t)dst & 0x1F;
+
+	if (falign != 0) {
+		// do one unaligned conversion
+		I24TOF32(src)
+		_mm256_storeu_ps(dst, vf0);
+
+		// and advance such that the destination floats are aligned
+		unsigned int n = (32 - falign) / 4;
+		src += 3*n;	// bytes
+		dst += n;
+		count -= n;
+	}
+
+	// source always unaligned, aligned stores
+	while (count >= 8) {
+		I24TOF32(src)
+		_mm256_store_ps(dst, vf0);
+		src += 24;	// bytes
+		dst += 8;
+		count -= 8;
+	}
+
+	if (count > 0) {
+		// unaligned cleanup -- just do one unaligned vector at the end
+		src = src0 + 3*numToConvert - 24;
+		dst = dst0 + numToConvert - 8;
+		I24TOF32(src)
+		_mm256_storeu_ps(dst, vf0);
+	}
+}
+
+void NativeInt24ToFloat32_AVX2( const UInt8 *src, Float32 *dst, unsigned int numToConvert )
+{
+	if (numToConvert < 8) {
+		NativeInt24ToFloat32_Portable(src, dst, numToConvert);
+		return;
+	}
+	const __m256i vshuf = _mm256_setr_epi8(	-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+											-1, 4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15 );
+	Int24ToFloat32_AVX2(src, dst, numToConvert, vshuf);
+}
+
+void SwapInt24ToFloat32_AVX2( const UInt8 *src, Float32 *dst, unsigned int numToConvert )
+{
+	if (numToConvert < 8) {
+		SwapInt24ToFloat32_Portable(src, dst, numToConvert);
+		return;
+	}
+	const __m256i vshuf = _mm256_setr_epi8(	-1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9,
+											-1, 6, 5, 4, -1, 9, 8, 7, -1, 12, 11, 10, -1, 15, 14, 13 );
+	Int24ToFloat32_AVX2(src, dst, numToConvert, vshuf);
+}
+
+// ===================================================================================================
+
+void NativeInt32ToFloat32_AVX2( const SInt32 *src, Float32 *dst, unsigned int numToConvert )
+{
+	const SInt32 *src0 = src;
+	Float32 *dst0 = dst;
+	unsigned int count = numToConvert;
+
+	if (count < 8) {
+		NativeInt32ToFloat32_X86(src, dst, count);
+		return;
+	}
+
+	// vector -- requires 8+ samples
+#define LEI32TOF32(x) \
+	vf##x = _mm256_cvtepi32_ps(vi##x); \
+	vf##x = _mm256_mul_ps(vf##x, vscale);
+
+	const __m256 vscale = _mm256_set1_ps(1.0/2147483648.0f);
+	__m256 vf0;
+	__m256i vi0;
+
+	int ialign = (uintptr_t)src & 0x1F;
+	int falign = (uintptr_t)dst & 0x1F;
+
+	if (falign != 0 || ialign != 0) {
+		// do one unaligned conversion
+		vi0 = _mm256_loadu_si256((__m256i const *)src);
+		LEI32TOF32(0)
+		_mm256_storeu_ps(dst, vf0);
+
+		// and advance such that the destination floats are aligned
+		unsigned int n = (32 - falign) / 4;
+		src += n;
+		dst += n;
+		count -= n;
+
+		ialign = (uintptr_t)src & 0x1F;
+		if (ialign != 0) {
+			// unaligned loads, aligned stores
+			while (count >= 8) {
+				vi0 = _mm256_loadu_si256((__m256i const *)src);
+				LEI32TOF32(0)
+				_mm256_store_ps(dst, vf0);
+				src += 8;
+				dst += 8;
+				count -= 8;
+			}
+			goto VectorCleanup;
+		}
+	}
+
+	// aligned loads, aligned stores
+	while (count >= 8) {
+		vi0 = _mm256_load_si256((__m256i const *)src);
+		LEI32TOF32(0)
+		_mm256_store_ps(dst, vf0);
+		src += 8;
+		dst += 8;
+		count -= 8;
+	}
+
+VectorCleanup:
+	if (count > 0) {
+		// unaligned cleanup -- just do one unaligned vector at the end
+		src = src0 + numToConvert - 8;
+		dst = dst0 + numToConvert - 8;
+		vi0 = _mm256_loadu_si256((__m256i const *)src);
+		LEI32TOF32(0)
+		_mm256_storeu_ps(dst, vf0);
+	}
+}
+
+// ===================================================================================================
+
+void SwapInt32ToFloat32_AVX2( const SInt32 *src, Float32 *dst, unsigned int numToConvert )
+{
+	const SInt32 *src0 = src;
+	Float32 *dst0 = dst;
+	unsigned int count = numToConvert;
+
+	if (count < 8) {
+		SwapInt32ToFloat32_X86(src, dst, count);
+		return;
+	}
+
+	// vector -- requires 8+ samples
+#define BEI32TOF32(x) \
+	vi##x = byteswap32_avx2(vi##x); \
+	LEI32TOF32(x)
+
+	const __m256 vscale = _mm256_set1_ps(1.0/2147483648.0f);
+	__m256 vf0;
+	__m256i vi0;
+
+	int ialign = (uintptr_t)src & 0x1F;
+	int falign = (uintptr_t)dst & 0x1F;
+
+	if (falign != 0 || ialign != 0) {
+		// do one unaligned conversion
+		vi0 = _mm256_loadu_si256((__m256i const *)src);
+		BEI32TOF32(0)
+		_mm256_storeu_ps(dst, vf0);
+
+		// and advance such that the destination floats are aligned
+		unsigned int n = (32 - falign) / 4;
+		src += n;
+		dst += n;
+		count -= n;
+
+		ialign = (uintptr_t)src & 0x1F;
+		if (ialign != 0) {
+			// unaligned loads, aligned stores
+			while (count >= 8) {
+				vi0 = _mm256_loadu_si256((__m256i const *)src);
+				BEI32TOF32(0)
+				_mm256_store_ps(dst, vf0);
+				src += 8;
+				dst += 8;
+				count -= 8;
+			}
+			goto VectorCleanup;
+		}
+	}
+
+	// aligned loads, aligned stores
+	while (count >= 8) {
+		vi0 = _mm256_load_si256((__m256i const *)src);
+		BEI32TOF32(0)
+		_mm256_store_ps(dst, vf0);
+		src += 8;
+		dst += 8;
+		count -= 8;
+	}
+
+VectorCleanup:
+	if (count > 0) {
+		// unaligned cleanup -- just do one unaligned vector at the end
+		src = src0 + numToConvert - 8;
+		dst = dst0 + numToConvert - 8;
+		vi0 = _mm256_loadu_si256((__m256i const *)src);
+		BEI32TOF32(0)
+		_mm256_storeu_ps(dst, vf0);
+	}
+}
+
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Mix
+
+// See MixFloat32_X86: the ends are done by the SSE2 routine rather than with overlapping vectors,
+// since the destination is updated in place. No FMA is used, so results match a scalar add exactly.
+void MixFloat32_AVX2( const Float32 *src, Float32 *dst, unsigned int count )
+{
+	if (count < 16) {
+		MixFloat32_X86(src, dst, count);
+		return;
+	}
+
+	// bring the destination up to 32-byte alignment
+	unsigned int n = ((32 - ((uintptr_t)dst & 0x1F)) & 0x1F) / 4;
+	if (n != 0) {
+		MixFloat32_X86(src, dst, n);
+		src += n;
+		dst += n;
+		count -= n;
+	}
+
+	if (((uintptr_t)src & 0x1F) != 0) {
+		// unaligned loads, aligned stores
+		while (count >= 16) {
+			__m256 vd0 = _mm256_load_ps(dst);
+			__m256 vd1 = _mm256_load_ps(dst + 8);
+			vd0 = _mm256_add_ps(vd0, _mm256_loadu_ps(src));
+			vd1 = _mm256_add_ps(vd1, _mm256_loadu_ps(src + 8));
+			_mm256_store_ps(dst, vd0);
+			_mm256_store_ps(dst + 8, vd1);
+			src += 16;
+			dst += 16;
+			count -= 16;
+		}
+	} else {
+		// aligned loads, aligned stores
+		while (count >= 16) {
+			__m256 vd0 = _mm256_load_ps(dst);
+			__m256 vd1 = _mm256_load_ps(dst + 8);
+			vd0 = _mm256_add_ps(vd0, _mm256_load_ps(src));
+			vd1 = _mm256_add_ps(vd1, _mm256_load_ps(src + 8));
+			_mm256_store_ps(dst, vd0);
+			_mm256_store_ps(dst + 8, vd1);
+			src += 16;
+			dst += 16;
+			count -= 16;
+		}
+	}
+
+	if (count >= 8) {
+		_mm256_store_ps(dst, _mm256_add_ps(_mm256_load_ps(dst), _mm256_loadu_ps(src)));
+		src += 8;
+		dst += 8;
+		count -= 8;
+	}
+
+	if (count > 0) {
+		MixFloat32_X86(src, dst, count);
+	}
+}
+
+// See MixFloat32Multi_X86. Two cache lines of the mix buffer are kept in registers per iteration.
+void MixFloat32Multi_AVX2( const Float32 * const src[], unsigned int nSources, Float32 *dst, unsigned int count )
+{
+	unsigned int i = 0;
+
+	if (count < 32) {
+		MixFloat32Multi_X86(src, nSources, dst, count);
+		return;
+	}
+
+	// scalar head -- until the destination is 32-byte aligned
+	for ( ; ((uintptr_t)(dst + i) & 0x1F) != 0; ++i) {
+		Float32 f = dst[i];
+		for (unsigned int s = 0; s < nSources; ++s)
+			f += src[s][i];
+		dst[i] = f;
+	}
+
+	for ( ; i + 32 <= count; i += 32) {
+		__m256 vd0 = _mm256_load_ps(dst + i);
+		__m256 vd1 = _mm256_load_ps(dst + i + 8);
+		__m256 vd2 = _mm256_load_ps(dst + i + 16);
+		__m256 vd3 = _mm256_load_ps(dst + i + 24);
+		for (unsigned int s = 0; s < nSources; ++s) {
+			const Float32 *p = src[s] + i;
+			vd0 = _mm256_add_ps(vd0, _mm256_loadu_ps(p));
+			vd1 = _mm256_add_ps(vd1, _mm256_loadu_ps(p + 8));
+			vd2 = _mm256_add_ps(vd2, _mm256_loadu_ps(p + 16));
+			vd3 = _mm256_add_ps(vd3, _mm256_loadu_ps(p + 24));
+		}
+		_mm256_store_ps(dst + i, vd0);
+		_mm256_store_ps(dst + i + 8, vd1);
+		_mm256_store_ps(dst + i + 16, vd2);
+		_mm256_store_ps(dst + i + 24, vd3);
+	}
+
+	for ( ; i + 8 <= count; i += 8) {
+		__m256 vd0 = _mm256_load_ps(dst + i);
+		for (unsigned int s = 0; s < nSources; ++s)
+			vd0 = _mm256_add_ps(vd0, _mm256_loadu_ps(src[s] + i));
+		_mm256_store_ps(dst + i, vd0);
+	}
+
+	// scalar tail
+	for ( ; i < count; ++i) {
+		Float32 f = dst[i];
+		for (unsigned int s = 0; s < nSources; ++s)
+			f += src[s][i];
+		dst[i] = f;
+	}
+}
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Write-combined copy
+
+// See bcopy_ToWriteCombine_X86. Loads from write-combined memory are uncached, so the copy from it
+// aligns the source and reads it with streaming loads, which fetch a whole line at a time.
+void bcopy_FromWriteCombine_AVX2( const void *pSrc, void *pDst, unsigned int count )
+{
+	const UInt8 *src = (const UInt8 *)pSrc;
+	UInt8 *dst = (UInt8 *)pDst;
+	unsigned int head = (32 - ((uintptr_t)src & 0x1F)) & 0x1F;
+	bool streamed = false;
+
+	if (count >= head + 32) {
+		// scalar head -- until the source is 32-byte aligned
+		count -= head;
+		while (head--)
+			*dst++ = *src++;
+
+		for ( ; count >= 128; count -= 128) {
+			_mm_prefetch((const char *)src + kWCPrefetchDistance, _MM_HINT_T0);	// a no-op if the source really is write-combined
+			__m256i v0 = _mm256_stream_load_si256((__m256i *)src);
+			__m256i v1 = _mm256_stream_load_si256((__m256i *)src + 1);
+			__m256i v2 = _mm256_stream_load_si256((__m256i *)src + 2);
+			__m256i v3 = _mm256_stream_load_si256((__m256i *)src + 3);
+			_mm256_storeu_si256((__m256i *)dst, v0);
+			_mm256_storeu_si256((__m256i *)dst + 1, v1);
+			_mm256_storeu_si256((__m256i *)dst + 2, v2);
+			_mm256_storeu_si256((__m256i *)dst + 3, v3);
+			src += 128;
+			dst += 128;
+		}
+		for ( ; count >= 32; count -= 32) {
+			_mm256_storeu_si256((__m256i *)dst, _mm256_stream_load_si256((__m256i *)src));
+			src += 32;
+			dst += 32;
+		}
+		streamed = true;
+	}
+
+	// scalar tail
+	while (count--)
+		*dst++ = *src++;
+
+	if (streamed)
+		_mm_mfence();
+}
+
+void bcopy_ToWriteCombine_AVX2( const void *pSrc, void *pDst, unsigned int count )
+{
+	const UInt8 *src = (const UInt8 *)pSrc;
+	UInt8 *dst = (UInt8 *)pDst;
+	unsigned int head = (32 - ((uintptr_t)dst & 0x1F)) & 0x1F;
+	bool streamed = false;
+
+	if (count >= head + 32) {
+		// scalar head -- until the destination is 32-byte aligned
+		count -= head;
+		while (head--)
+			*dst++ = *src++;
+
+		for ( ; count >= 128; count -= 128) {
+			_mm_prefetch((const char *)src + kWCPrefetchDistance, _MM_HINT_NTA);
+			__m256i v0 = _mm256_loadu_si256((__m256i const *)src);
+			__m256i v1 = _mm256_loadu_si256((__m256i const *)src + 1);
+			__m256i v2 = _mm256_loadu_si256((__m256i const *)src + 2);
+			__m256i v3 = _mm256_loadu_si256((__m256i const *)src + 3);
+			_mm256_stream_si256((__m256i *)dst, v0);
+			_mm256_stream_si256((__m256i *)dst + 1, v1);
+			_mm256_stream_si256((__m256i *)dst + 2, v2);
+			_mm256_stream_si256((__m256i *)dst + 3, v3);
+			src += 128;
+			dst += 128;
+		}
+		for ( ; count >= 32; count -= 32) {
+			_mm256_stream_si256((__m256i *)dst, _mm256_loadu_si256((__m256i const *)src));
+			src += 32;
+			dst += 32;
+		}
+		streamed = true;
+	}
+
+	// scalar tail
+	while (count--)
+		*dst++ = *src++;
+
+	if (streamed)
+		_mm_sfence();
+}
+
+
+#endif // __i386__ || __x86_64__
@@ -0,0 +1,358 @@
+/*	Copyright: 	© Copyright 2005-2010 Apple Computer, Inc. All rights reserved.
+ 
+ Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+ ("Apple") in consideration of your agreement to the following terms, and your
+ use, installation, modification or redistribution of this Apple software
+ constitutes acceptance of these terms.  If you do not agree with these terms,
+ please do not use, install, modify or redistribute this Apple software.
+ 
+ In consideration of your agreement to abide by the following terms, and subject
+ to these terms, Apple grants you a personal, non-exclusive license, under Apple’s
+ copyrights in this original Apple software (the "Apple Software"), to use,
+ reproduce, modify and redistribute the Apple Software, with or without
+ modifications, in source and/or binary forms; provided that if you redistribute
+ the Apple Software in its entirety and without modifications, you must retain
+ this notice and the following text and disclaimers in all such redistributions of
+ the Apple Software.  Neither the name, trademarks, service marks or logos of
+ Apple Computer, Inc. may be used to endorse or promote products derived from the
+ Apple Software without specific prior written permission from Apple.  Except as
+ expressly stated in this notice, no other rights or licenses, express or implied,
+ are granted by Apple herein, including but not limited to any patent rights that
+ may be infringed by your derivative works or by other works in which the Apple
+ Software may be incorporated.
+ 
+ The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+ WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+ WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+ COMBINATION WITH YOUR PRODUCTS.
+ 
+ IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+ OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+ (INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*=============================================================================
+	IOAudioBlitterLibAVX512.cpp
+
+=============================================================================*/
+
+#include <TargetConditionals.h>
+
+#if __i386__ || __x86_64__
+#define _MM_MALLOC_H_INCLUDED 1	// we don't want this header
+#include <immintrin.h>
+#include "IOAudioBlitterLib.h"
+
+/*
+	AVX-512 (512-bit) versions of the write-combined copies and of plain TPDF dither.
+
+	This file is compiled with -mavx512f -mavx512bw. Nothing in here may be called unless the dispatcher
+	has verified that both the CPU and the OS (XCR0) support AVX-512F and BW; see IOAudioBlitterLibDispatch.cpp.
+*/
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Write-combined copy
+
+// See bcopy_FromWriteCombine_AVX2. A 512-bit streaming load or store moves a whole cache line,
+// so each instruction fills or drains one write-combining buffer.
+
+void bcopy_FromWriteCombine_AVX512( const void *pSrc, void *pDst, unsigned int count )
+{
+	const UInt8 *src = (const UInt8 *)pSrc;
+	UInt8 *dst = (UInt8 *)pDst;
+	unsigned int head = (64 - ((uintptr_t)src & 0x3F)) & 0x3F;
+	bool streamed = false;
+
+	if (count >= head + 64) {
+		// scalar head -- until the source is 64-byte aligned
+		count -= head;
+		while (head--)
+			*dst++ = *src++;
+
+		for ( ; count >= 256; count -= 256) {
+			_mm_prefetch((const char *)src + kWCPrefetchDistance, _MM_HINT_T0);	// a no-op if the source really is write-combined
+			__m512i v0 = _mm512_stream_load_si512((void *)src);
+			__m512i v1 = _mm512_stream_load_si512((void *)(src + 64));
+			__m512i v2 = _mm512_stream_load_si512((void *)(src + 128));
+			__m512i v3 = _mm512_stream_load_si512((void *)(src + 192));
+			_mm512_storeu_si512(dst, v0);
+			_mm512_storeu_si512(dst + 64, v1);
+			_mm512_storeu_si512(dst + 128, v2);
+			_mm512_storeu_si512(dst + 192, v3);
+			src += 256;
+			dst += 256;
+		}
+		for ( ; count >= 64; count -= 64) {
+			_mm512_storeu_si512(dst, _mm512_stream_load_si512((void *)src));
+			src += 64;
+			dst += 64;
+		}
+		streamed = true;
+	}
+
+	// scalar tail
+	while (count--)
+		*dst++ = *src++;
+
+	if (streamed)
+		_mm_mfence();
+}
+
+void bcopy_ToWriteCombine_AVX512( const void *pSrc, void *pDst, unsigned int count )
+{
+	const UInt8 *src = (const UInt8 *)pSrc;
+	UInt8 *dst = (UInt8 *)pDst;
+	unsigned int head = (64 - ((uintptr_t)dst & 0x3F)) & 0x3F;
+	bool streamed = false;
+
+	if (count >= head + 64) {
+		// scalar head -- until the destination is 64-byte aligned
+		count -= head;
+		while (head--)
+			*dst++ = *src++;
+
+		for ( ; count >= 256; count -= 256) {
+			_mm_prefetch((const char *)src + kWCPrefetchDistance, _MM_HINT_NTA);
+			__m512i v0 = _mm512_loadu_si512(src);
+			__m512i v1 = _mm512_loadu_si512(src + 64);
+			__m512i v2 = _mm512_loadu_si512(src + 128);
+			__m512i v3 = _mm512_loadu_si512(src + 192);
+			_mm512_stream_si512((__m512i *)dst, v0);
+			_mm512_stream_si512((__m512i *)(dst + 64), v1);
+			_mm512_stream_si512((__m512i *)(dst + 128), v2);
+			_mm512_stream_si512((__m512i *)(dst + 192), v3);
+			src += 256;
+			dst += 256;
+		}
+		for ( ; count >= 64; count -= 64) {
+			_mm512_stream_si512((__m512i *)dst, _mm512_loadu_si512(src));
+			src += 64;
+			dst += 64;
+		}
+		streamed = true;
+	}
+
+	// scalar tail
+	while (count--)
+		*dst++ = *src++;
+
+	if (streamed)
+		_mm_sfence();
+}
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Float -> Int dithered
+
+/*
+	Plain TPDF dither; see Float32ToIntDithered_X86 for how the noise is made and
+	Float32ToInt16TPDF_AVX2 for the layout. Four vectors of 16 generators, all of seed[], make 32
+	samples of noise each per step, for rounds of 128 samples. The scale and the bias go in with one
+	fused multiply-add, rounded down by the round mode. Tails are done with masked loads and stores.
+
+	The noise shaped path is bound by its per-channel recursion, not by the vector width, and is
+	the SSE2 one.
+*/
+
+#define kDitherRoundSamples_AVX512	128		// one DitherBias32_AVX512 step of each generator
+
+static inline __m512i Xorshift32_AVX512( __m512i &s )
+{
+	s = _mm512_xor_si512(s, _mm512_slli_epi32(s, 13));
+	s = _mm512_xor_si512(s, _mm512_srli_epi32(s, 17));
+	s = _mm512_xor_si512(s, _mm512_slli_epi32(s, 5));
+	return s;
+}
+
+// 32 samples of TPDF noise in LSB units, plus 0.5
+static inline void DitherBias32_AVX512( __m512i &s, __m512 &bias0, __m512 &bias1 )
+{
+	const __m512i ones = _mm512_set1_epi8(1);
+	const __m512i exponent = _mm512_set1_epi16(0x4700);
+	const __m512 offset = _mm512_set1_ps(32768.0f + 127.0f / 256.0f);
+	__m512i u = _mm512_maddubs_epi16(Xorshift32_AVX512(s), ones);	// a + b
+
+	bias0 = _mm512_sub_ps(_mm512_castsi512_ps(_mm512_unpacklo_epi16(u, exponent)), offset);
+	bias1 = _mm512_sub_ps(_mm512_castsi512_ps(_mm512_unpackhi_epi16(u, exponent)), offset);
+}
+
+static inline void Float32ToInt16TPDF_AVX512( const Float32 *src, SInt16 *dst, unsigned int count, UInt32 seed[], bool swap )
+{
+	const __m512 vmax = _mm512_set1_ps(32767.0f);
+	const __m512 vscale = _mm512_set1_ps(32768.0f);
+	const __m512i vperm = _mm512_setr_epi64(0, 2, 4, 6, 1, 3, 5, 7);
+	const __m512i vswap = _mm512_broadcast_i32x4(_mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14));
+	__m512i s0 = _mm512_loadu_si512(seed);
+	__m512i s1 = _mm512_loadu_si512(seed + 16);
+	__m512i s2 = _mm512_loadu_si512(seed + 32);
+	__m512i s3 = _mm512_loadu_si512(seed + 48);
+	__m512 vb0, vb1, vf0, vf1;
+	__m512i vpack0;
+
+	// as F32TOI16DITHERED in IOAudioBlitterLibAVX2.cpp, 32 samples to a step; packs works within
+	// each 128-bit lane, so put the quadwords back in order afterwards
+#define F32TOI16DITHERED(s, vf0, vf1) \
+	DitherBias32_AVX512(s, vb0, vb1);									\
+	vf0 = _mm512_min_ps(vmax, _mm512_fmadd_ps(vf0, vscale, vb0));		\
+	vf1 = _mm512_min_ps(vmax, _mm512_fmadd_ps(vf1, vscale, vb1));		\
+	vpack0 = _mm512_packs_epi32(_mm512_cvtps_epi32(vf0), _mm512_cvtps_epi32(vf1));	\
+	vpack0 = _mm512_permutexvar_epi64(vperm, vpack0);					\
+	if (swap)															\
+		vpack0 = _mm512_shuffle_epi8(vpack0, vswap);
+
+	ROUNDMODE_NEG_INF
+	for ( ; count >= kDitherRoundSamples_AVX512; count -= kDitherRoundSamples_AVX512) {
+		__m512 vf2, vf3, vf4, vf5, vf6, vf7;
+
+		vf0 = _mm512_loadu_ps(src);
+		vf1 = _mm512_loadu_ps(src + 16);
+		vf2 = _mm512_loadu_ps(src + 32);
+		vf3 = _mm512_loadu_ps(src + 48);
+		vf4 = _mm512_loadu_ps(src + 64);
+		vf5 = _mm512_loadu_ps(src + 80);
+		vf6 = _mm512_loadu_ps(src + 96);
+		vf7 = _mm512_loadu_ps(src + 112);
+		F32TOI16DITHERED(s0, vf0, vf1)
+		_mm512_storeu_si512(dst, vpack0);
+		F32TOI16DITHERED(s1, vf2, vf3)
+		_mm512_storeu_si512(dst + 32, vpack0);
+		F32TOI16DITHERED(s2, vf4, vf5)
+		_mm512_storeu_si512(dst + 64, vpack0);
+		F32TOI16DITHERED(s3, vf6, vf7)
+		_mm512_storeu_si512(dst + 96, vpack0);
+		src += kDitherRoundSamples_AVX512;
+		dst += kDitherRoundSamples_AVX512;
+	}
+	for ( ; count >= 32; count -= 32) {
+		vf0 = _mm512_loadu_ps(src);
+		vf1 = _mm512_loadu_ps(src + 16);
+		F32TOI16DITHERED(s0, vf0, vf1)
+		_mm512_storeu_si512(dst, vpack0);
+		src += 32;
+		dst += 32;
+	}
+	if (count > 0) {
+		const __mmask32 mask = (1U << count) - 1;
+
+		vf0 = _mm512_maskz_loadu_ps((__mmask16)mask, src);
+		vf1 = _mm512_maskz_loadu_ps((__mmask16)(mask >> 16), src + 16);
+		F32TOI16DITHERED(s0, vf0, vf1)
+		_mm512_mask_storeu_epi16(dst, mask, vpack0);
+	}
+	RESTORE_ROUNDMODE
+
+	_mm512_storeu_si512(seed, s0);
+	_mm512_storeu_si512(seed + 16, s1);
+	_mm512_storeu_si512(seed + 32, s2);
+	_mm512_storeu_si512(seed + 48, s3);
+}
+
+static inline void Float32ToInt24TPDF_AVX512( const Float32 *src, UInt8 *dst, unsigned int count, UInt32 seed[], const __m128i shuf )
+{
+	const __m512 vmin = _mm512_set1_ps(-8388608.0f);
+	const __m512 vmax = _mm512_set1_ps(8388607.0f);
+	const __m512 vscale = _mm512_set1_ps(8388608.0f);
+	const __m512i vshuf = _mm512_broadcast_i32x4(shuf);
+	const __m512i vperm = _mm512_setr_epi32(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, 0, 0, 0, 0);
+	__m512i s0 = _mm512_loadu_si512(seed);
+	__m512i s1 = _mm512_loadu_si512(seed + 16);
+	__m512i s2 = _mm512_loadu_si512(seed + 32);
+	__m512i s3 = _mm512_loadu_si512(seed + 48);
+	__m512 vb0, vb1, vf0, vf1;
+	__m512i vi0, vi1;
+
+	// the byte shuffle leaves 12 bytes at the bottom of each 128-bit lane, and the dword
+	// permute closes them up into 48
+#define F32TOI24(vf, vb, vi) \
+	vf = _mm512_fmadd_ps(vf, vscale, vb);								\
+	vf = _mm512_min_ps(_mm512_max_ps(vf, vmin), vmax);					\
+	vi = _mm512_shuffle_epi8(_mm512_cvtps_epi32(vf), vshuf);			\
+	vi = _mm512_permutexvar_epi32(vperm, vi);
+
+#define F32TOI24DITHERED(s) \
+	DitherBias32_AVX512(s, vb0, vb1);									\
+	F32TOI24(vf0, vb0, vi0)												\
+	F32TOI24(vf1, vb1, vi1)
+
+#define F32TOI24DITHEREDSTEP(s, in, out) \
+	vf0 = _mm512_loadu_ps(in);											\
+	vf1 = _mm512_loadu_ps((in) + 16);									\
+	F32TOI24DITHERED(s)													\
+	_mm512_mask_storeu_epi32((out), 0x0FFF, vi0);						\
+	_mm512_mask_storeu_epi32((out) + 48, 0x0FFF, vi1);
+
+	ROUNDMODE_NEG_INF
+	for ( ; count >= kDitherRoundSamples_AVX512; count -= kDitherRoundSamples_AVX512) {
+		F32TOI24DITHEREDSTEP(s0, src, dst)
+		F32TOI24DITHEREDSTEP(s1, src + 32, dst + 96)
+		F32TOI24DITHEREDSTEP(s2, src + 64, dst + 192)
+		F32TOI24DITHEREDSTEP(s3, src + 96, dst + 288)
+		src += kDitherRoundSamples_AVX512;
+		dst += 3 * kDitherRoundSamples_AVX512;	// bytes
+	}
+	for ( ; count >= 32; count -= 32) {
+		F32TOI24DITHEREDSTEP(s0, src, dst)
+		src += 32;
+		dst += 96;	// bytes
+	}
+	if (count > 0) {
+		const __mmask32 mask = (1U << count) - 1;
+		const UInt64 bytes0 = (count >= 16) ? 0xFFFFFFFFFFFFULL : (1ULL << (3 * count)) - 1;
+		const UInt64 bytes1 = (count > 16) ? (1ULL << (3 * (count - 16))) - 1 : 0;
+
+		vf0 = _mm512_maskz_loadu_ps((__mmask16)mask, src);
+		vf1 = _mm512_maskz_loadu_ps((__mmask16)(mask >> 16), src + 16);
+		F32TOI24DITHERED(s0)
+		_mm512_mask_storeu_epi8(dst, bytes0, vi0);
+		_mm512_mask_storeu_epi8(dst + 48, bytes1, vi1);
+	}
+	RESTORE_ROUNDMODE
+
+	_mm512_storeu_si512(seed, s0);
+	_mm512_storeu_si512(seed + 16, s1);
+	_mm512_storeu_si512(seed + 32, s2);
+	_mm512_storeu_si512(seed + 48, s3);
+}
+
+void Float32ToNativeInt16Dithered_AVX512( const Float32 *src, SInt16 *dst, unsigned int numToConvert, unsigned int nChannels, UInt32 seed[], Float32 *shapingError )
+{
+	if (shapingError || nChannels == 0) {
+		Float32ToNativeInt16Dithered_X86(src, dst, numToConvert, nChannels, seed, shapingError);
+		return;
+	}
+	Float32ToInt16TPDF_AVX512(src, dst, numToConvert, seed, false);
+}
+
+void Float32ToSwapInt16Dithered_AVX512( const Float32 *src, SInt16 *dst, unsigned int numToConvert, unsigned int nChannels, UInt32 seed[], Float32 *shapingError )
+{
+	if (shapingError || nChannels == 0) {
+		Float32ToSwapInt16Dithered_X86(src, dst, numToConvert, nChannels, seed, shapingError);
+		return;
+	}
+	Float32ToInt16TPDF_AVX512(src, dst, numToConvert, seed, true);
+}
+
+void Float32ToNativeInt24Dithered_AVX512( const Float32 *src, UInt8 *dst, unsigned int numToConvert, unsigned int nChannels, UInt32 seed[], Float32 *shapingError )
+{
+	if (shapingError || nChannels == 0) {
+		Float32ToNativeInt24Dithered_X86(src, dst, numToConvert, nChannels, seed, shapingError);
+		return;
+	}
+	Float32ToInt24TPDF_AVX512(src, dst, numToConvert, seed, _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1));
+}
+
+void Float32ToSwapInt24Dithered_AVX512( const Float32 *src, UInt8 *dst, unsigned int numToConvert, unsigned int nChannels, UInt32 seed[], Float32 *shapingError )
+{
+	if (shapingError || nChannels == 0) {
+		Float32ToSwapInt24Dithered_X86(src, dst, numToConvert, nChannels, seed, shapingError);
+		return;
+	}
+	Float32ToInt24TPDF_AVX512(src, dst, numToConvert, seed, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+#endif // __i386__ || __x86_64__
@@ -42,8 +42,11 @@
 
 #include "IOAudioBlitterLibDispatch.h"
 #include "IOAudioBlitterLib.h"
+#include <IOKit/IOLib.h>
+#if PCMBLIT_X86
 #include <xmmintrin.h>
 #include <smmintrin.h>
+#endif
 
 /*
 	PCM int<->float library.
@@ -63,70 +66,1226 @@
 	16-bit ints must be 2-byte aligned.
 	
 	On Intel, the haveVector argument is ignored and some implementations assume SSE2.
+	SSSE3, AVX2 and AVX-512 implementations are selected at load time when the CPU supports them.
+	Other architectures get the compiler-vector versions in IOAudioBlitterLibVector.cpp, which
+	produce the same results as the SSE2 ones.
 */
 
 
+// ____________________________________________________________________________________
+// Runtime CPU dispatch
+//
+// The converters are reached through a table of function pointers. When the kext is loaded,
+// IOAF_SelectConverters() probes the CPU once and picks the widest implementations that both the
+// processor and the OS-enabled register state allow; every x86 Mac has at least SSE2.
+//
+// The tables' type is in IOAudioBlitterLib.h. Every backend is checked against the table of
+// _Portable references: in DEBUG builds before its table is put into service (see below), and on
+// the host by the harness in PCMBlitterLib/Tests.
+
+static const IOAF_ConverterTable sPortableConverters = {
+	NativeInt16ToFloat32_Portable,
+	SwapInt16ToFloat32_Portable,
+	NativeInt24ToFloat32_Portable,
+	SwapInt24ToFloat32_Portable,
+	NativeInt32ToFloat32_Portable,
+	SwapInt32ToFloat32_Portable,
+	Float32ToNativeInt16_Portable,
+	Float32ToSwapInt16_Portable,
+	Float32ToNativeInt24_Portable,
+	Float32ToSwapInt24_Portable,
+	Float32ToNativeInt32_Portable,
+	Float32ToSwapInt32_Portable,
+	MixFloat32_Portable,
+	MixFloat32Multi_Portable,
+	ALawToFloat32_Portable,
+	MuLawToFloat32_Portable,
+	bcopy_Portable,
+	bcopy_Portable,
+	Float32ToNativeInt16Dithered_Portable,
+	Float32ToSwapInt16Dithered_Portable,
+	Float32ToNativeInt24Dithered_Portable,
+	Float32ToSwapInt24Dithered_Portable
+};
+
+#define kMaxConverterTables	5
+
+#if PCMBLIT_X86
+static void bcopy_FromWriteCombine_SSE41( const void *src, void *dest, unsigned int count );
+
+static const IOAF_ConverterTable sSSE2Converters = {
+	NativeInt16ToFloat32_X86,
+	SwapInt16ToFloat32_X86,
+	NativeInt24ToFloat32_Portable,
+	SwapInt24ToFloat32_Portable,
+	NativeInt32ToFloat32_X86,
+	SwapInt32ToFloat32_X86,
+	Float32ToNativeInt16_X86,
+	Float32ToSwapInt16_X86,
+	Float32ToNativeInt24_X86,
+	Float32ToSwapInt24_Portable,
+	Float32ToNativeInt32_X86,
+	Float32ToSwapInt32_X86,
+	MixFloat32_X86,
+	MixFloat32Multi_X86,
+	ALawToFloat32_X86,
+	MuLawToFloat32_X86,
+	bcopy_FromWriteCombine_SSE41,
+	bcopy_ToWriteCombine_X86,
+	Float32ToNativeInt16Dithered_X86,
+	Float32ToSwapInt16Dithered_X86,
+	Float32ToNativeInt24Dithered_X86,
+	Float32ToSwapInt24Dithered_X86
+};
+
+// SSE2 plus pshufb-based packed 24-bit conversion and G.711 decoding
+static const IOAF_ConverterTable sSSSE3Converters = {
+	NativeInt16ToFloat32_X86,
+	SwapInt16ToFloat32_X86,
+	NativeInt24ToFloat32_SSSE3,
+	SwapInt24ToFloat32_SSSE3,
+	NativeInt32ToFloat32_X86,
+	SwapInt32ToFloat32_X86,
+	Float32ToNativeInt16_X86,
+	Float32ToSwapInt16_X86,
+	Float32ToNativeInt24_SSSE3,
+	Float32ToSwapInt24_SSSE3,
+	Float32ToNativeInt32_X86,
+	Float32ToSwapInt32_X86,
+	MixFloat32_X86,
+	MixFloat32Multi_X86,
+	ALawToFloat32_SSSE3,
+	MuLawToFloat32_SSSE3,
+	bcopy_FromWriteCombine_SSE41,
+	bcopy_ToWriteCombine_X86,
+	Float32ToNativeInt16Dithered_X86,
+	Float32ToSwapInt16Dithered_X86,
+	Float32ToNativeInt24Dithered_X86,
+	Float32ToSwapInt24Dithered_X86
+};
+
+static const IOAF_ConverterTable sAVX2Converters = {
+	NativeInt16ToFloat32_AVX2,
+	SwapInt16ToFloat32_AVX2,
+	NativeInt24ToFloat32_AVX2,
+	SwapInt24ToFloat32_AVX2,
+	NativeInt32ToFloat32_AVX2,
+	SwapInt32ToFloat32_AVX2,
+	Float32ToNativeInt16_AVX2,
+	Float32ToSwapInt16_AVX2,
+	Float32ToNativeInt24_AVX2,
+	Float32ToSwapInt24_AVX2,
+	Float32ToNativeInt32_AVX2,
+	Float32ToSwapInt32_AVX2,
+	MixFloat32_AVX2,
+	MixFloat32Multi_AVX2,
+	ALawToFloat32_SSSE3,
+	MuLawToFloat32_SSSE3,
+	bcopy_FromWriteCombine_AVX2,
+	bcopy_ToWriteCombine_AVX2,
+	Float32ToNativeInt16Dithered_AVX2,
+	Float32ToSwapInt16Dithered_AVX2,
+	Float32ToNativeInt24Dithered_AVX2,
+	Float32ToSwapInt24Dithered_AVX2
+};
+
+// AVX2 plus 64-byte (one cache line) write-combined copies and 512-bit TPDF dither
+static const IOAF_ConverterTable sAVX512Converters = {
+	NativeInt16ToFloat32_AVX2,
+	SwapInt16ToFloat32_AVX2,
+	NativeInt24ToFloat32_AVX2,
+	SwapInt24ToFloat32_AVX2,
+	NativeInt32ToFloat32_AVX2,
+	SwapInt32ToFloat32_AVX2,
+	Float32ToNativeInt16_AVX2,
+	Float32ToSwapInt16_AVX2,
+	Float32ToNativeInt24_AVX2,
+	Float32ToSwapInt24_AVX2,
+	Float32ToNativeInt32_AVX2,
+	Float32ToSwapInt32_AVX2,
+	MixFloat32_AVX2,
+	MixFloat32Multi_AVX2,
+	ALawToFloat32_SSSE3,
+	MuLawToFloat32_SSSE3,
+	bcopy_FromWriteCombine_AVX512,
+	bcopy_ToWriteCombine_AVX512,
+	Float32ToNativeInt16Dithered_AVX512,
+	Float32ToSwapInt16Dithered_AVX512,
+	Float32ToNativeInt24Dithered_AVX512,
+	Float32ToSwapInt24Dithered_AVX512
+};
+
+static inline void IOAF_cpuid( UInt32 leaf, UInt32 subleaf, UInt32 regs[4] )
+{
+	__asm__ volatile ( "cpuid"
+					   : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
+					   : "a" (leaf), "c" (subleaf) );
+}
+
+static inline UInt64 IOAF_xgetbv( UInt32 xcr )
+{
+	UInt32 lo, hi;
+	__asm__ volatile ( ".byte 0x0f, 0x01, 0xd0"		// xgetbv
+					   : "=a" (lo), "=d" (hi)
+					   : "c" (xcr) );
+	return ((UInt64)hi << 32) | lo;
+}
+
+static bool IOAF_CPUSupportsSSSE3()
+{
+	UInt32 regs[4];
+
+	IOAF_cpuid(1, 0, regs);
+	return (regs[2] & (1 << 9)) != 0;
+}
+
+static bool IOAF_CPUSupportsAVX2()
+{
+	UInt32 regs[4];
+
+	IOAF_cpuid(0, 0, regs);
+	if (regs[0] < 7)
+		return false;
+
+	// AVX and OSXSAVE, then ask the OS whether it saves the YMM state on context switch
+	IOAF_cpuid(1, 0, regs);
+	if ((regs[2] & ((1 << 27) | (1 << 28))) != ((1 << 27) | (1 << 28)))
+		return false;
+	if ((IOAF_xgetbv(0) & 0x6) != 0x6)
+		return false;
+
+	IOAF_cpuid(7, 0, regs);
+	return (regs[1] & (1 << 5)) != 0;
+}
+
+static bool IOAF_CPUSupportsAVX512()
+{
+	UInt32 regs[4];
+
+	if (!IOAF_CPUSupportsAVX2())
+		return false;
+
+	// the OS must also save the opmask and both halves of the ZMM state
+	if ((IOAF_xgetbv(0) & 0xE6) != 0xE6)
+		return false;
+
+	// AVX-512F, and BW for the 16-bit packs and byte shuffles of the dithered converters
+	IOAF_cpuid(7, 0, regs);
+	return (regs[1] & ((1 << 16) | (1 << 30))) == ((1 << 16) | (1 << 30));
+}
+
+// the tables this CPU can run, widest first
+static unsigned int IOAF_SupportedConverters( const IOAF_ConverterTable *tables[], const char *names[] )
+{
+	unsigned int n = 0;
+
+	if (IOAF_CPUSupportsAVX512()) {
+		tables[n] = &sAVX512Converters;
+		names[n++] = "AVX-512";
+	}
+	if (IOAF_CPUSupportsAVX2()) {
+		tables[n] = &sAVX2Converters;
+		names[n++] = "AVX2";
+	}
+	if (IOAF_CPUSupportsSSSE3()) {
+		tables[n] = &sSSSE3Converters;
+		names[n++] = "SSSE3";
+	}
+	tables[n] = &sSSE2Converters;
+	names[n++] = "SSE2";
+	return n;
+}
+#else
+// Everything else has one set of converters, written with compiler vector extensions; there are
+// no streaming loads or stores to use, so the write-combined copies are plain ones.
+
+static void bcopy_Vector( const void *src, void *dest, unsigned int count )
+{
+	bcopy(src, dest, count);
+}
+
+static const IOAF_ConverterTable sVectorConverters = {
+	NativeInt16ToFloat32_Vector,
+	SwapInt16ToFloat32_Vector,
+	NativeInt24ToFloat32_Vector,
+	SwapInt24ToFloat32_Vector,
+	NativeInt32ToFloat32_Vector,
+	SwapInt32ToFloat32_Vector,
+	Float32ToNativeInt16_Vector,
+	Float32ToSwapInt16_Vector,
+	Float32ToNativeInt24_Vector,
+	Float32ToSwapInt24_Vector,
+	Float32ToNativeInt32_Vector,
+	Float32ToSwapInt32_Vector,
+	MixFloat32_Vector,
+	MixFloat32Multi_Vector,
+	ALawToFloat32_Vector,
+	MuLawToFloat32_Vector,
+	bcopy_Vector,
+	bcopy_Vector,
+	Float32ToNativeInt16Dithered_Vector,
+	Float32ToSwapInt16Dithered_Vector,
+	Float32ToNativeInt24Dithered_Vector,
+	Float32ToSwapInt24Dithered_Vector
+};
+
+static unsigned int IOAF_SupportedConverters( const IOAF_ConverterTable *tables[], const char *names[] )
+{
+	tables[0] = &sVectorConverters;
+	names[0] = "Vector";
+	return 1;
+}
+#endif // PCMBLIT_X86
+
+static const IOAF_ConverterTable *sConverters = &sPortableConverters;
+
+#ifdef DEBUG
+// ____________________________________________________________________________________
+// Differential check (DEBUG builds)
+//
+// Before a table is put into service, every entry is run against the _Portable reference over a
+// range of lengths that exercise the scalar, unaligned-head, aligned and overlapping-tail paths,
+// and over every source and destination misalignment within 16 bytes. The float input includes
+// values at and beyond full scale in both directions, denormals and NaNs. Outputs, and the
+// guard bytes after them, must match exactly; otherwise the next narrower table is tried.
+// PCMBlitterLib/Tests runs a much larger version of this on the host, without a kext.
+
+#define kVerifyMaxSamples	131
+#define kVerifyGuardBytes	32
+
+static UInt32	sVerifySrc[kVerifyMaxSamples + 4];
+static UInt8	sVerifyRef[kVerifyMaxSamples * 4 + 16 + kVerifyGuardBytes];
+static UInt8	sVerifyTest[kVerifyMaxSamples * 4 + 16 + kVerifyGuardBytes];
+
+static void IOAF_FillVerifySource()
+{
+	static const UInt32 specials[] = {
+		0x3F800000,		// 1.0
+		0xBF800000,		// -1.0
+		0x3FC00000,		// 1.5
+		0xC0400000,		// -3.0
+		0x3F7FFFFF,		// just below 1.0
+		0x00000001,		// smallest denormal
+		0x7FC00000,		// quiet NaN
+		0xFFC00000,		// negative quiet NaN
+		0x7F800000,		// +inf
+		0xFF800000		// -inf
+	};
+	UInt32 seed = 0x12345678;
+	unsigned int i;
+
+	// the bit patterns are built directly, so no floating point arithmetic happens here
+	for (i = 0; i < sizeof(sVerifySrc) / sizeof(sVerifySrc[0]); ++i) {
+		seed = seed * 1664525 + 1013904223;
+		if ((i % 7) == 3)
+			sVerifySrc[i] = specials[(i / 7) % (sizeof(specials) / sizeof(specials[0]))];
+		else
+			sVerifySrc[i] = 0x3F000000 | (seed & 0x807FFFFF);	// +/-[0.5, 1.0)
+	}
+}
+
+template <typename S, typename D>
+static bool IOAF_VerifyProc( const char *table, const char *name, void (*ref)(const S *, D *, unsigned int), void (*test)(const S *, D *, unsigned int), unsigned int destBytesPerSample )
+{
+	static const unsigned int counts[] = { 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 23, 24, 25, 31, 32, 33, 63, 64, 65, kVerifyMaxSamples };
+	unsigned int srcOffset, destOffset, c;
+
+	if (ref == test)
+		return true;
+
+	for (srcOffset = 0; srcOffset < 16; srcOffset += sizeof(S)) {
+		for (destOffset = 0; destOffset < 16; destOffset += sizeof(D)) {
+			for (c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+				const S *src = (const S *)((const UInt8 *)sVerifySrc + srcOffset);
+				unsigned int size = destOffset + counts[c] * destBytesPerSample + kVerifyGuardBytes;
+
+				memset(sVerifyRef, 0xA5, size);
+				memset(sVerifyTest, 0xA5, size);
+				ref(src, (D *)(sVerifyRef + destOffset), counts[c]);
+				test(src, (D *)(sVerifyTest + destOffset), counts[c]);
+				if (memcmp(sVerifyRef, sVerifyTest, size) != 0) {
+					IOLog("IOAudioBlitterLib: %s %s does not match the portable version (count %u, source offset %u, dest offset %u)\n", table, name, counts[c], srcOffset, destOffset);
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+// the copies take byte counts; seen as UInt8 -> UInt8 they fit IOAF_VerifyProc
+typedef void (*IOAF_ByteCopyProc)( const UInt8 *src, UInt8 *dest, unsigned int count );
+
+static bool IOAF_VerifyConverters( const IOAF_ConverterTable *table, const char *tableName )
+{
+	const IOAF_ConverterTable *ref = &sPortableConverters;
+	bool ok = true;
+
+	IOAF_FillVerifySource();
+
+	ok &= IOAF_VerifyProc(tableName, "NativeInt16ToFloat32", ref->nativeInt16ToFloat32, table->nativeInt16ToFloat32, 4);
+	ok &= IOAF_VerifyProc(tableName, "SwapInt16ToFloat32", ref->swapInt16ToFloat32, table->swapInt16ToFloat32, 4);
+	ok &= IOAF_VerifyProc(tableName, "NativeInt24ToFloat32", ref->nativeInt24ToFloat32, table->nativeInt24ToFloat32, 4);
+	ok &= IOAF_VerifyProc(tableName, "SwapInt24ToFloat32", ref->swapInt24ToFloat32, table->swapInt24ToFloat32, 4);
+	ok &= IOAF_VerifyProc(tableName, "NativeInt32ToFloat32", ref->nativeInt32ToFloat32, table->nativeInt32ToFloat32, 4);
+	ok &= IOAF_VerifyProc(tableName, "SwapInt32ToFloat32", ref->swapInt32ToFloat32, table->swapInt32ToFloat32, 4);
+	ok &= IOAF_VerifyProc(tableName, "Float32ToNativeInt16", ref->float32ToNativeInt16, table->float32ToNativeInt16, 2);
+	ok &= IOAF_VerifyProc(tableName, "Float32ToSwapInt16", ref->float32ToSwapInt16, table->float32ToSwapInt16, 2);
+	ok &= IOAF_VerifyProc(tableName, "Float32ToNativeInt24", ref->float32ToNativeInt24, table->float32ToNativeInt24, 3);
+	ok &= IOAF_VerifyProc(tableName, "Float32ToSwapInt24", ref->float32ToSwapInt24, table->float32ToSwapInt24, 3);
+	ok &= IOAF_VerifyProc(tableName, "Float32ToNativeInt32", ref->float32ToNativeInt32, table->float32ToNativeInt32, 4);
+	ok &= IOAF_VerifyProc(tableName, "Float32ToSwapInt32", ref->float32ToSwapInt32, table->float32ToSwapInt32, 4);
+	ok &= IOAF_VerifyProc(tableName, "MixFloat32", ref->mixFloat32, table->mixFloat32, 4);
+	ok &= IOAF_VerifyProc(tableName, "ALawToFloat32", ref->aLawToFloat32, table->aLawToFloat32, 4);
+	ok &= IOAF_VerifyProc(tableName, "MuLawToFloat32", ref->muLawToFloat32, table->muLawToFloat32, 4);
+	ok &= IOAF_VerifyProc(tableName, "bcopy_WriteCombine", (IOAF_ByteCopyProc)ref->bcopyFromWriteCombine, (IOAF_ByteCopyProc)table->bcopyFromWriteCombine, 1);
+	ok &= IOAF_VerifyProc(tableName, "bcopy_ToWriteCombine", (IOAF_ByteCopyProc)ref->bcopyToWriteCombine, (IOAF_ByteCopyProc)table->bcopyToWriteCombine, 1);
+
+	return ok;
+}
+#endif // DEBUG
+
+__attribute__((constructor)) static void IOAF_SelectConverters()
+{
+	const IOAF_ConverterTable *tables[kMaxConverterTables];
+	const char *names[kMaxConverterTables];
+	unsigned int n = IOAF_SupportedConverters(tables, names);
+
+#ifdef DEBUG
+	// the widest table that matches the portable references, or those themselves
+	unsigned int i;
+
+	for (i = 0; i < n && !IOAF_VerifyConverters(tables[i], names[i]); ++i)
+		;
+	sConverters = (i < n) ? tables[i] : &sPortableConverters;
+#else
+	sConverters = tables[0];
+#endif
+}
+
+unsigned int IOAF_GetConverterTables( const IOAF_ConverterTable *tables[], const char *names[], unsigned int maxTables )
+{
+	const IOAF_ConverterTable *supported[kMaxConverterTables];
+	const char *supportedNames[kMaxConverterTables];
+	unsigned int n = IOAF_SupportedConverters(supported, supportedNames);
+	unsigned int count = 0, i;
+
+	if (maxTables > 0) {
+		tables[0] = &sPortableConverters;
+		names[0] = "Portable";
+		count = 1;
+	}
+	for (i = 0; i < n && count < maxTables; ++i, ++count) {
+		tables[count] = supported[i];
+		names[count] = supportedNames[i];
+	}
+	return count;
+}
+
+// the converters without a table entry are called directly
+#if PCMBLIT_X86
+#define IOAF_BACKEND(name)		name##_X86
+#define IOAF_BACKEND_NT(name)	name##_X86NT
+#else
+#define IOAF_BACKEND(name)		name##_Vector
+#define IOAF_BACKEND_NT(name)	name##_Vector
+#endif
+
+// ____________________________________________________________________________________
+
 void IOAF_NativeInt16ToFloat32( const SInt16 *src, Float32 *dest, unsigned int count )
 {
-	NativeInt16ToFloat32_X86(src, dest, count);
+	sConverters->nativeInt16ToFloat32(src, dest, count);
 }
 
 void IOAF_SwapInt16ToFloat32( const SInt16 *src, Float32 *dest, unsigned int count )
 {
-	SwapInt16ToFloat32_X86(src, dest, count);
+	sConverters->swapInt16ToFloat32(src, dest, count);
 }
 
 void IOAF_NativeInt24ToFloat32( const UInt8 *src, Float32 *dest, unsigned int count )
 {
-	NativeInt24ToFloat32_Portable(src, dest, count);
+	sConverters->nativeInt24ToFloat32(src, dest, count);
 }
 
 void IOAF_SwapInt24ToFloat32( const UInt8 *src, Float32 *dest, unsigned int count )
 {
-	SwapInt24ToFloat32_Portable(src, dest, count);
+	sConverters->swapInt24ToFloat32(src, dest, count);
 }
 
 void IOAF_NativeInt32ToFloat32( const SInt32 *src, Float32 *dest, unsigned int count )
 {
-	NativeInt32ToFloat32_X86(src, dest, count);
+	sConverters->nativeInt32ToFloat32(src, dest, count);
 }
 
 void IOAF_SwapInt32ToFloat32( const SInt32 *src, Float32 *dest, unsigned int count )
 {
-	SwapInt32ToFloat32_X86(src, dest, count);
+	sConverters->swapInt32ToFloat32(src, dest, count);
 }
 
 void IOAF_Float32ToNativeInt16( const Float32 *src, SInt16 *dest, unsigned int count )
 {
-	Float32ToNativeInt16_X86(src, dest, count);
+	sConverters->float32ToNativeInt16(src, dest, count);
 }
 
 void IOAF_Float32ToSwapInt16( const Float32 *src, SInt16 *dest, unsigned int count )
 {
-	Float32ToSwapInt16_X86(src, dest, count);
+	sConverters->float32ToSwapInt16(src, dest, count);
 }
 
 void IOAF_Float32ToNativeInt24( const Float32 *src, UInt8 *dest, unsigned int count )
 {
-	Float32ToNativeInt24_X86(src, dest, count);
+	sConverters->float32ToNativeInt24(src, dest, count);
 }
 
 void IOAF_Float32ToSwapInt24( const Float32 *src, UInt8 *dest, unsigned int count )
 {
-	Float32ToSwapInt24_Portable(src, dest, count);
+	sConverters->float32ToSwapInt24(src, dest, count);
 }
 
 void IOAF_Float32ToNativeInt32( const Float32 *src, SInt32 *dest, unsigned int count )
 {
-	Float32ToNativeInt32_X86(src, dest, count);
+	sConverters->float32ToNativeInt32(src, dest, count);
 }
 
 void IOAF_Float32ToSwapInt32( const Float32 *src, SInt32 *dest, unsigned int count )
 {
-	Float32ToSwapInt32_X86(src, dest, count);
+	sConverters->float32ToSwapInt32(src, dest, count);
 }
 
-void IOAF_bcopy_WriteCombine(const void *pSrc, void *pDst, unsigned int count)
+// Streaming stores are bound by the bus, not the ALUs, so there are no wider versions of these.
+
+void IOAF_Float32ToNativeInt16_ToWriteCombine( const Float32 *src, SInt16 *dest, unsigned int count )
+{
+	IOAF_BACKEND_NT(Float32ToNativeInt16)(src, dest, count);
+}
+
+void IOAF_Float32ToSwapInt16_ToWriteCombine( const Float32 *src, SInt16 *dest, unsigned int count )
+{
+	IOAF_BACKEND_NT(Float32ToSwapInt16)(src, dest, count);
+}
+
+void IOAF_Float32ToNativeInt24_ToWriteCombine( const Float32 *src, UInt8 *dest, unsigned int count )
+{
+	IOAF_BACKEND_NT(Float32ToNativeInt24)(src, dest, count);
+}
+
+void IOAF_Float32ToSwapInt24_ToWriteCombine( const Float32 *src, UInt8 *dest, unsigned int count )
+{
+	IOAF_BACKEND_NT(Float32ToSwapInt24)(src, dest, count);
+}
+
+void IOAF_Float32ToNativeInt32_ToWriteCombine( const Float32 *src, SInt32 *dest, unsigned int count )
+{
+	IOAF_BACKEND_NT(Float32ToNativeInt32)(src, dest, count);
+}
+
+void IOAF_Float32ToSwapInt32_ToWriteCombine( const Float32 *src, SInt32 *dest, unsigned int count )
+{
+	IOAF_BACKEND_NT(Float32ToSwapInt32)(src, dest, count);
+}
+
+void IOAF_Float32ToNativeInt16WithGain( const Float32 *src, SInt16 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels )
+{
+	IOAF_BACKEND(Float32ToNativeInt16WithGain)(src, dest, count, gain, nChannels);
+}
+
+void IOAF_Float32ToSwapInt16WithGain( const Float32 *src, SInt16 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels )
+{
+	IOAF_BACKEND(Float32ToSwapInt16WithGain)(src, dest, count, gain, nChannels);
+}
+
+void IOAF_Float32ToNativeInt24WithGain( const Float32 *src, UInt8 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels )
+{
+	IOAF_BACKEND(Float32ToNativeInt24WithGain)(src, dest, count, gain, nChannels);
+}
+
+void IOAF_Float32ToSwapInt24WithGain( const Float32 *src, UInt8 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels )
+{
+	IOAF_BACKEND(Float32ToSwapInt24WithGain)(src, dest, count, gain, nChannels);
+}
+
+void IOAF_Float32ToNativeInt32WithGain( const Float32 *src, SInt32 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels )
+{
+	IOAF_BACKEND(Float32ToNativeInt32WithGain)(src, dest, count, gain, nChannels);
+}
+
+void IOAF_Float32ToSwapInt32WithGain( const Float32 *src, SInt32 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels )
+{
+	IOAF_BACKEND(Float32ToSwapInt32WithGain)(src, dest, count, gain, nChannels);
+}
+
+void IOAF_DitherStateInit( IOAF_DitherState *state, UInt32 seed )
+{
+	unsigned int i;
+
+	// scramble a different start for each lane; xorshift must never be seeded with 0
+	for (i = 0; i < kIOAF_DitherSeeds; ++i) {
+		UInt32 x = seed + (i + 1) * 0x9E3779B9;
+		x = (x ^ (x >> 16)) * 0x85EBCA6B;
+		x = (x ^ (x >> 13)) * 0xC2B2AE35;
+		x ^= x >> 16;
+		state->seed[i] = x ? x : 1;
+	}
+	bzero(state->error, sizeof(state->error));
+}
+
+#if kDitherSeeds != kIOAF_DitherSeeds
+#error "IOAudioBlitterLib.h and IOAudioBlitterLibDispatch.h disagree on the number of dither generators"
+#endif
+
+// the converters want the error array rounded up to whole vectors, which kIOAF_DitherMaxChannels is
+#define IOAF_DITHER_SHAPING(state, noiseShaping, nChannels) \
+	(((noiseShaping) && ((nChannels) <= kIOAF_DitherMaxChannels)) ? (state)->error : NULL)
+
+void IOAF_Float32ToNativeInt16Dithered( const Float32 *src, SInt16 *dest, unsigned int count, unsigned int nChannels, bool noiseShaping, IOAF_DitherState *state )
+{
+	sConverters->float32ToNativeInt16Dithered(src, dest, count, nChannels, state->seed, IOAF_DITHER_SHAPING(state, noiseShaping, nChannels));
+}
+
+void IOAF_Float32ToSwapInt16Dithered( const Float32 *src, SInt16 *dest, unsigned int count, unsigned int nChannels, bool noiseShaping, IOAF_DitherState *state )
+{
+	sConverters->float32ToSwapInt16Dithered(src, dest, count, nChannels, state->seed, IOAF_DITHER_SHAPING(state, noiseShaping, nChannels));
+}
+
+void IOAF_Float32ToNativeInt24Dithered( const Float32 *src, UInt8 *dest, unsigned int count, unsigned int nChannels, bool noiseShaping, IOAF_DitherState *state )
+{
+	sConverters->float32ToNativeInt24Dithered(src, dest, count, nChannels, state->seed, IOAF_DITHER_SHAPING(state, noiseShaping, nChannels));
+}
+
+void IOAF_Float32ToSwapInt24Dithered( const Float32 *src, UInt8 *dest, unsigned int count, unsigned int nChannels, bool noiseShaping, IOAF_DitherState *state )
+{
+	sConverters->float32ToSwapInt24Dithered(src, dest, count, nChannels, state->seed, IOAF_DITHER_SHAPING(state, noiseShaping, nChannels));
+}
+
+Float32 IOAF_GainRampFloat32( const Float32 *src, Float32 *dest, unsigned int nChannels, unsigned int nFrames, Float32 gain, Float32 step, bool exponential )
+{
+	return IOAF_BACKEND(GainRampFloat32)(src, dest, nChannels, nFrames, gain, step, exponential);
+}
+
+Float32 IOAF_GainRampStep( Float32 fromGain, Float32 toGain, unsigned int nFrames, bool exponential )
+{
+	return GainRampStep_Portable(fromGain, toGain, nFrames, exponential);
+}
+
+Float32 IOAF_DecibelsToGain( SInt32 dB )
+{
+	return DecibelsToGain_Portable(dB);
+}
+
+void IOAF_ByteSwapInt16( const SInt16 *src, SInt16 *dest, unsigned int count )
+{
+	IOAF_BACKEND(ByteSwapInt16)(src, dest, count);
+}
+
+void IOAF_ByteSwapInt24( const UInt8 *src, UInt8 *dest, unsigned int count )
+{
+	IOAF_BACKEND(ByteSwapInt24)(src, dest, count);
+}
+
+void IOAF_ByteSwapInt32( const SInt32 *src, SInt32 *dest, unsigned int count )
+{
+	IOAF_BACKEND(ByteSwapInt32)(src, dest, count);
+}
+
+void IOAF_Float32ToFloat64( const Float32 *src, Float64 *dest, unsigned int count )
+{
+	IOAF_BACKEND(Float32ToFloat64)(src, dest, count);
+}
+
+void IOAF_Float64ToFloat32( const Float64 *src, Float32 *dest, unsigned int count )
+{
+	IOAF_BACKEND(Float64ToFloat32)(src, dest, count);
+}
+
+void IOAF_Float32ToSInt8( const Float32 *src, SInt8 *dest, unsigned int count )
+{
+	IOAF_BACKEND(Float32ToSInt8)(src, dest, count);
+}
+
+void IOAF_Float32ToUInt8( const Float32 *src, UInt8 *dest, unsigned int count )
+{
+	IOAF_BACKEND(Float32ToUInt8)(src, dest, count);
+}
+
+void IOAF_SInt8ToFloat32( const SInt8 *src, Float32 *dest, unsigned int count )
+{
+	IOAF_BACKEND(SInt8ToFloat32)(src, dest, count);
+}
+
+void IOAF_UInt8ToFloat32( const UInt8 *src, Float32 *dest, unsigned int count )
+{
+	IOAF_BACKEND(UInt8ToFloat32)(src, dest, count);
+}
+
+void IOAF_Float32ToALaw( const Float32 *src, UInt8 *dest, unsigned int count )
+{
+	IOAF_BACKEND(Float32ToALaw)(src, dest, count);
+}
+
+void IOAF_Float32ToMuLaw( const Float32 *src, UInt8 *dest, unsigned int count )
+{
+	IOAF_BACKEND(Float32ToMuLaw)(src, dest, count);
+}
+
+void IOAF_ALawToFloat32( const UInt8 *src, Float32 *dest, unsigned int count )
+{
+	sConverters->aLawToFloat32(src, dest, count);
+}
+
+void IOAF_MuLawToFloat32( const UInt8 *src, Float32 *dest, unsigned int count )
+{
+	sConverters->muLawToFloat32(src, dest, count);
+}
+
+// [srcFormat][destFormat]; NULL where the formats are identical
+static const IOAF_PCMConverterProc sIntToIntConverters[kIOAF_NumIntFormats][kIOAF_NumIntFormats] = {
+	{ NULL, IOAF_BACKEND(ByteSwapInt16), IOAF_BACKEND(NativeInt16ToNativeInt24), IOAF_BACKEND(NativeInt16ToSwapInt24), IOAF_BACKEND(NativeInt16ToNativeInt32), IOAF_BACKEND(NativeInt16ToSwapInt32) },
+	{ IOAF_BACKEND(ByteSwapInt16), NULL, IOAF_BACKEND(SwapInt16ToNativeInt24), IOAF_BACKEND(SwapInt16ToSwapInt24), IOAF_BACKEND(SwapInt16ToNativeInt32), IOAF_BACKEND(SwapInt16ToSwapInt32) },
+	{ IOAF_BACKEND(NativeInt24ToNativeInt16), IOAF_BACKEND(NativeInt24ToSwapInt16), NULL, IOAF_BACKEND(ByteSwapInt24), IOAF_BACKEND(NativeInt24ToNativeInt32), IOAF_BACKEND(NativeInt24ToSwapInt32) },
+	{ IOAF_BACKEND(SwapInt24ToNativeInt16), IOAF_BACKEND(SwapInt24ToSwapInt16), IOAF_BACKEND(ByteSwapInt24), NULL, IOAF_BACKEND(SwapInt24ToNativeInt32), IOAF_BACKEND(SwapInt24ToSwapInt32) },
+	{ IOAF_BACKEND(NativeInt32ToNativeInt16), IOAF_BACKEND(NativeInt32ToSwapInt16), IOAF_BACKEND(NativeInt32ToNativeInt24), IOAF_BACKEND(NativeInt32ToSwapInt24), NULL, IOAF_BACKEND(ByteSwapInt32) },
+	{ IOAF_BACKEND(SwapInt32ToNativeInt16), IOAF_BACKEND(SwapInt32ToSwapInt16), IOAF_BACKEND(SwapInt32ToNativeInt24), IOAF_BACKEND(SwapInt32ToSwapInt24), IOAF_BACKEND(ByteSwapInt32), NULL }
+};
+
+static const unsigned int sIntFormatBytes[kIOAF_NumIntFormats] = { 2, 2, 3, 3, 4, 4 };
+
+void IOAF_IntToInt( const void *src, IOAF_IntFormat srcFormat, void *dest, IOAF_IntFormat destFormat, unsigned int count )
+{
+	IOAF_PCMConverterProc proc = sIntToIntConverters[srcFormat][destFormat];
+
+	if (proc)
+		proc(src, dest, count);
+	else if (src != dest)
+		bcopy(src, dest, count * sIntFormatBytes[srcFormat]);
+}
+
+// ____________________________________________________________________________________
+// Samples narrower than their container; a full-width sample is left to the regular converters
+
+void IOAF_Float32ToNativeIntJustified( const Float32 *src, void *dest, unsigned int count, unsigned int bitDepth, unsigned int bitWidth, bool highAligned )
+{
+	if (bitDepth < bitWidth)
+		IOAF_BACKEND(Float32ToNativeIntJustified)(src, dest, count, bitDepth, bitWidth, highAligned);
+	else if (bitWidth == 16)
+		IOAF_Float32ToNativeInt16(src, (SInt16 *)dest, count);
+	else if (bitWidth == 24)
+		IOAF_Float32ToNativeInt24(src, (UInt8 *)dest, count);
+	else if (bitWidth == 32)
+		IOAF_Float32ToNativeInt32(src, (SInt32 *)dest, count);
+}
+
+void IOAF_Float32ToSwapIntJustified( const Float32 *src, void *dest, unsigned int count, unsigned int bitDepth, unsigned int bitWidth, bool highAligned )
+{
+	if (bitDepth < bitWidth)
+		IOAF_BACKEND(Float32ToSwapIntJustified)(src, dest, count, bitDepth, bitWidth, highAligned);
+	else if (bitWidth == 16)
+		IOAF_Float32ToSwapInt16(src, (SInt16 *)dest, count);
+	else if (bitWidth == 24)
+		IOAF_Float32ToSwapInt24(src, (UInt8 *)dest, count);
+	else if (bitWidth == 32)
+		IOAF_Float32ToSwapInt32(src, (SInt32 *)dest, count);
+}
+
+void IOAF_NativeIntJustifiedToFloat32( const void *src, Float32 *dest, unsigned int count, unsigned int bitDepth, unsigned int bitWidth, bool highAligned )
+{
+	if (bitDepth < bitWidth)
+		IOAF_BACKEND(NativeIntJustifiedToFloat32)(src, dest, count, bitDepth, bitWidth, highAligned);
+	else if (bitWidth == 16)
+		IOAF_NativeInt16ToFloat32((const SInt16 *)src, dest, count);
+	else if (bitWidth == 24)
+		IOAF_NativeInt24ToFloat32((const UInt8 *)src, dest, count);
+	else if (bitWidth == 32)
+		IOAF_NativeInt32ToFloat32((const SInt32 *)src, dest, count);
+}
+
+void IOAF_SwapIntJustifiedToFloat32( const void *src, Float32 *dest, unsigned int count, unsigned int bitDepth, unsigned int bitWidth, bool highAligned )
+{
+	if (bitDepth < bitWidth)
+		IOAF_BACKEND(SwapIntJustifiedToFloat32)(src, dest, count, bitDepth, bitWidth, highAligned);
+	else if (bitWidth == 16)
+		IOAF_SwapInt16ToFloat32((const SInt16 *)src, dest, count);
+	else if (bitWidth == 24)
+		IOAF_SwapInt24ToFloat32((const UInt8 *)src, dest, count);
+	else if (bitWidth == 32)
+		IOAF_SwapInt32ToFloat32((const SInt32 *)src, dest, count);
+}
+
+// ____________________________________________________________________________________
+// PCM converter matrix
+//
+// One converter for every pair of the sample types in IOAudioBlitterLib.h, generated from
+// TPCMConverter. The pairs a stream is likely to use are specialized here to call the optimized
+// routines; the rest get the generic loops.
+
+#define IOAF_SPECIALIZE_CONVERTER(SrcType, DestType, proc, SrcPtr, DestPtr) \
+template <> class TPCMConverter<SrcType, DestType> { \
+public: \
+	static void Convert(const void *src, void *dest, unsigned int count) { proc((SrcPtr)src, (DestPtr)dest, count); } \
+};
+
+#define IOAF_SPECIALIZE_COPY(Type) \
+template <> class TPCMConverter<Type, Type> { \
+public: \
+	static void Convert(const void *src, void *dest, unsigned int count) { if (src != dest) bcopy(src, dest, count * sizeof(Type::value_type)); } \
+};
+
+IOAF_SPECIALIZE_CONVERTER(PCMSInt16Native, PCMFloat32, IOAF_NativeInt16ToFloat32, const SInt16 *, Float32 *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt16Swap, PCMFloat32, IOAF_SwapInt16ToFloat32, const SInt16 *, Float32 *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt24Native, PCMFloat32, IOAF_NativeInt24ToFloat32, const UInt8 *, Float32 *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt24Swap, PCMFloat32, IOAF_SwapInt24ToFloat32, const UInt8 *, Float32 *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt32Native, PCMFloat32, IOAF_NativeInt32ToFloat32, const SInt32 *, Float32 *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt32Swap, PCMFloat32, IOAF_SwapInt32ToFloat32, const SInt32 *, Float32 *)
+
+IOAF_SPECIALIZE_CONVERTER(PCMFloat32, PCMSInt16Native, IOAF_Float32ToNativeInt16, const Float32 *, SInt16 *)
+IOAF_SPECIALIZE_CONVERTER(PCMFloat32, PCMSInt16Swap, IOAF_Float32ToSwapInt16, const Float32 *, SInt16 *)
+IOAF_SPECIALIZE_CONVERTER(PCMFloat32, PCMSInt24Native, IOAF_Float32ToNativeInt24, const Float32 *, UInt8 *)
+IOAF_SPECIALIZE_CONVERTER(PCMFloat32, PCMSInt24Swap, IOAF_Float32ToSwapInt24, const Float32 *, UInt8 *)
+IOAF_SPECIALIZE_CONVERTER(PCMFloat32, PCMSInt32Native, IOAF_Float32ToNativeInt32, const Float32 *, SInt32 *)
+IOAF_SPECIALIZE_CONVERTER(PCMFloat32, PCMSInt32Swap, IOAF_Float32ToSwapInt32, const Float32 *, SInt32 *)
+
+IOAF_SPECIALIZE_CONVERTER(PCMSInt8, PCMFloat32, IOAF_BACKEND(SInt8ToFloat32), const SInt8 *, Float32 *)
+IOAF_SPECIALIZE_CONVERTER(PCMUInt8, PCMFloat32, IOAF_BACKEND(UInt8ToFloat32), const UInt8 *, Float32 *)
+IOAF_SPECIALIZE_CONVERTER(PCMFloat32, PCMSInt8, IOAF_BACKEND(Float32ToSInt8), const Float32 *, SInt8 *)
+IOAF_SPECIALIZE_CONVERTER(PCMFloat32, PCMUInt8, IOAF_BACKEND(Float32ToUInt8), const Float32 *, UInt8 *)
+IOAF_SPECIALIZE_CONVERTER(PCMFloat32, PCMFloat64, IOAF_BACKEND(Float32ToFloat64), const Float32 *, Float64 *)
+IOAF_SPECIALIZE_CONVERTER(PCMFloat64, PCMFloat32, IOAF_BACKEND(Float64ToFloat32), const Float64 *, Float32 *)
+
+IOAF_SPECIALIZE_CONVERTER(PCMSInt16Native, PCMSInt16Swap, IOAF_BACKEND(ByteSwapInt16), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt16Native, PCMSInt24Native, IOAF_BACKEND(NativeInt16ToNativeInt24), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt16Native, PCMSInt24Swap, IOAF_BACKEND(NativeInt16ToSwapInt24), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt16Native, PCMSInt32Native, IOAF_BACKEND(NativeInt16ToNativeInt32), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt16Native, PCMSInt32Swap, IOAF_BACKEND(NativeInt16ToSwapInt32), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt16Swap, PCMSInt16Native, IOAF_BACKEND(ByteSwapInt16), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt16Swap, PCMSInt24Native, IOAF_BACKEND(SwapInt16ToNativeInt24), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt16Swap, PCMSInt24Swap, IOAF_BACKEND(SwapInt16ToSwapInt24), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt16Swap, PCMSInt32Native, IOAF_BACKEND(SwapInt16ToNativeInt32), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt16Swap, PCMSInt32Swap, IOAF_BACKEND(SwapInt16ToSwapInt32), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt24Native, PCMSInt16Native, IOAF_BACKEND(NativeInt24ToNativeInt16), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt24Native, PCMSInt16Swap, IOAF_BACKEND(NativeInt24ToSwapInt16), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt24Native, PCMSInt24Swap, IOAF_BACKEND(ByteSwapInt24), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt24Native, PCMSInt32Native, IOAF_BACKEND(NativeInt24ToNativeInt32), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt24Native, PCMSInt32Swap, IOAF_BACKEND(NativeInt24ToSwapInt32), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt24Swap, PCMSInt16Native, IOAF_BACKEND(SwapInt24ToNativeInt16), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt24Swap, PCMSInt16Swap, IOAF_BACKEND(SwapInt24ToSwapInt16), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt24Swap, PCMSInt24Native, IOAF_BACKEND(ByteSwapInt24), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt24Swap, PCMSInt32Native, IOAF_BACKEND(SwapInt24ToNativeInt32), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt24Swap, PCMSInt32Swap, IOAF_BACKEND(SwapInt24ToSwapInt32), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt32Native, PCMSInt16Native, IOAF_BACKEND(NativeInt32ToNativeInt16), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt32Native, PCMSInt16Swap, IOAF_BACKEND(NativeInt32ToSwapInt16), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt32Native, PCMSInt24Native, IOAF_BACKEND(NativeInt32ToNativeInt24), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt32Native, PCMSInt24Swap, IOAF_BACKEND(NativeInt32ToSwapInt24), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt32Native, PCMSInt32Swap, IOAF_BACKEND(ByteSwapInt32), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt32Swap, PCMSInt16Native, IOAF_BACKEND(SwapInt32ToNativeInt16), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt32Swap, PCMSInt16Swap, IOAF_BACKEND(SwapInt32ToSwapInt16), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt32Swap, PCMSInt24Native, IOAF_BACKEND(SwapInt32ToNativeInt24), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt32Swap, PCMSInt24Swap, IOAF_BACKEND(SwapInt32ToSwapInt24), const void *, void *)
+IOAF_SPECIALIZE_CONVERTER(PCMSInt32Swap, PCMSInt32Native, IOAF_BACKEND(ByteSwapInt32), const void *, void *)
+
+IOAF_SPECIALIZE_COPY(PCMSInt8)
+IOAF_SPECIALIZE_COPY(PCMUInt8)
+IOAF_SPECIALIZE_COPY(PCMSInt16Native)
+IOAF_SPECIALIZE_COPY(PCMSInt16Swap)
+IOAF_SPECIALIZE_COPY(PCMSInt24Native)
+IOAF_SPECIALIZE_COPY(PCMSInt24Swap)
+IOAF_SPECIALIZE_COPY(PCMSInt32Native)
+IOAF_SPECIALIZE_COPY(PCMSInt32Swap)
+IOAF_SPECIALIZE_COPY(PCMFloat32)
+IOAF_SPECIALIZE_COPY(PCMFloat32Swap)
+IOAF_SPECIALIZE_COPY(PCMFloat64)
+IOAF_SPECIALIZE_COPY(PCMFloat64Swap)
+
+enum {
+	kIOAF_PCMSInt8 = 0,
+	kIOAF_PCMUInt8,
+	kIOAF_PCMNativeInt16,
+	kIOAF_PCMSwapInt16,
+	kIOAF_PCMNativeInt24,
+	kIOAF_PCMSwapInt24,
+	kIOAF_PCMNativeInt32,
+	kIOAF_PCMSwapInt32,
+	kIOAF_PCMNativeFloat32,
+	kIOAF_PCMSwapFloat32,
+	kIOAF_PCMNativeFloat64,
+	kIOAF_PCMSwapFloat64,
+	kIOAF_PCMNumFormats
+};
+
+#define IOAF_CONVERTER_ROW(SrcType) { \
+	TPCMConverter<SrcType, PCMSInt8>::Convert, TPCMConverter<SrcType, PCMUInt8>::Convert, \
+	TPCMConverter<SrcType, PCMSInt16Native>::Convert, TPCMConverter<SrcType, PCMSInt16Swap>::Convert, \
+	TPCMConverter<SrcType, PCMSInt24Native>::Convert, TPCMConverter<SrcType, PCMSInt24Swap>::Convert, \
+	TPCMConverter<SrcType, PCMSInt32Native>::Convert, TPCMConverter<SrcType, PCMSInt32Swap>::Convert, \
+	TPCMConverter<SrcType, PCMFloat32>::Convert, TPCMConverter<SrcType, PCMFloat32Swap>::Convert, \
+	TPCMConverter<SrcType, PCMFloat64>::Convert, TPCMConverter<SrcType, PCMFloat64Swap>::Convert }
+
+// [source][destination], indexed as the enum above
+static const IOAF_PCMConverterProc sPCMConverters[kIOAF_PCMNumFormats][kIOAF_PCMNumFormats] = {
+	IOAF_CONVERTER_ROW(PCMSInt8),
+	IOAF_CONVERTER_ROW(PCMUInt8),
+	IOAF_CONVERTER_ROW(PCMSInt16Native),
+	IOAF_CONVERTER_ROW(PCMSInt16Swap),
+	IOAF_CONVERTER_ROW(PCMSInt24Native),
+	IOAF_CONVERTER_ROW(PCMSInt24Swap),
+	IOAF_CONVERTER_ROW(PCMSInt32Native),
+	IOAF_CONVERTER_ROW(PCMSInt32Swap),
+	IOAF_CONVERTER_ROW(PCMFloat32),
+	IOAF_CONVERTER_ROW(PCMFloat32Swap),
+	IOAF_CONVERTER_ROW(PCMFloat64),
+	IOAF_CONVERTER_ROW(PCMFloat64Swap)
+};
+
+static int IOAF_PCMFormatIndex( const IOAudioStreamFormat *format )
+{
+#if TARGET_RT_BIG_ENDIAN
+	bool swap = (format->fByteOrder != kIOAudioStreamByteOrderBigEndian);
+#else
+	bool swap = (format->fByteOrder == kIOAudioStreamByteOrderBigEndian);
+#endif
+
+	// the converters scale and clip to the full container, so a sample narrower than its container
+	// would leave garbage in the pad bits; those formats use the IOAF_*IntJustified routines
+	if (format->fBitDepth != format->fBitWidth)
+		return -1;
+
+	switch (format->fNumericRepresentation) {
+		case kIOAudioStreamNumericRepresentationSignedInt:
+			if (format->fSampleFormat != kIOAudioStreamSampleFormatLinearPCM)
+				break;
+			switch (format->fBitWidth) {
+				case 8:		return kIOAF_PCMSInt8;
+				case 16:	return swap ? kIOAF_PCMSwapInt16 : kIOAF_PCMNativeInt16;
+				case 24:	return swap ? kIOAF_PCMSwapInt24 : kIOAF_PCMNativeInt24;
+				case 32:	return swap ? kIOAF_PCMSwapInt32 : kIOAF_PCMNativeInt32;
+			}
+			break;
+		case kIOAudioStreamNumericRepresentationUnsignedInt:
+			if (format->fSampleFormat == kIOAudioStreamSampleFormatLinearPCM && format->fBitWidth == 8)
+				return kIOAF_PCMUInt8;
+			break;
+		case kIOAudioStreamNumericRepresentationIEEE754Float:
+			if (format->fSampleFormat != kIOAudioStreamSampleFormatLinearPCM && format->fSampleFormat != kIOAudioStreamSampleFormatIEEEFloat)
+				break;
+			switch (format->fBitWidth) {
+				case 32:	return swap ? kIOAF_PCMSwapFloat32 : kIOAF_PCMNativeFloat32;
+				case 64:	return swap ? kIOAF_PCMSwapFloat64 : kIOAF_PCMNativeFloat64;
+			}
+			break;
+	}
+	return -1;
+}
+
+IOAF_PCMConverterProc IOAF_GetPCMConverter( const IOAudioStreamFormat *srcFormat, const IOAudioStreamFormat *destFormat )
+{
+	int srcIndex = IOAF_PCMFormatIndex(srcFormat);
+	int destIndex = IOAF_PCMFormatIndex(destFormat);
+
+	if (srcIndex < 0 || destIndex < 0)
+		return NULL;
+	return sPCMConverters[srcIndex][destIndex];
+}
+
+void IOAF_MixFloat32( const Float32 *src, Float32 *dest, unsigned int count )
+{
+	sConverters->mixFloat32(src, dest, count);
+}
+
+void IOAF_MixFloat32Multi( const Float32 * const src[], unsigned int nSources, Float32 *dest, unsigned int count )
+{
+	sConverters->mixFloat32Multi(src, nSources, dest, count);
+}
+
+// ____________________________________________________________________________________
+// Channel subsets
+//
+// Each frame's run of channels goes through the regular converter, or the whole buffer in one
+// call when the run is the whole frame. Runs too short for a vector are mixed in place, which
+// gives the same sums, and are converted a block of frames at a time through a buffer padded
+// to a whole vector: the scalar code the converters use for short counts doesn't always round
+// the way the vector code does, and the result has to match converting the whole buffer. (A
+// buffer that is itself shorter than a vector is padded to its own length instead.)
+#define kMinVectorChannels	8
+#define kChannelBlockSamples	64
+
+void IOAF_MixFloat32Channels( const Float32 *src, Float32 *dest, unsigned int nFrames, unsigned int frameStride, unsigned int firstChannel, unsigned int nChannels )
+{
+	unsigned int frame, c;
+	
+	if (nChannels == 0)
+		return;
+	if (nChannels == frameStride) {
+		sConverters->mixFloat32(src, dest, nFrames * frameStride);
+		return;
+	}
+	src += firstChannel;
+	dest += firstChannel;
+	for (frame = 0; frame < nFrames; ++frame, src += frameStride, dest += frameStride) {
+		if (nChannels < kMinVectorChannels) {
+			for (c = 0; c < nChannels; ++c)
+				dest[c] += src[c];
+		} else {
+			sConverters->mixFloat32(src, dest, nChannels);
+		}
+	}
+}
+
+void IOAF_Float32FindActiveChannels( const Float32 *src, unsigned int nFrames, unsigned int frameStride, unsigned int *firstChannel, unsigned int *nChannels )
+{
+	const UInt32 *sample = (const UInt32 *)src;
+	unsigned int first = *firstChannel, end = *firstChannel + *nChannels;
+	unsigned int frame, c;
+	
+	if (*nChannels == 0) {
+		first = frameStride;
+		end = 0;
+	}
+	// shifting out the sign bit makes -0 zero
+	for (frame = 0; (frame < nFrames) && ((first > 0) || (end < frameStride)); ++frame, sample += frameStride) {
+		for (c = 0; c < first; ++c) {
+			if (sample[c] << 1) {
+				first = c;
+				if (end <= c)
+					end = c + 1;
+				break;
+			}
+		}
+		if (first >= end)
+			continue;	// the frame is silent
+		for (c = frameStride; c > end; --c) {
+			if (sample[c - 1] << 1) {
+				end = c;
+				break;
+			}
+		}
+	}
+	if (first < end) {
+		*firstChannel = first;
+		*nChannels = end - first;
+	}
+}
+
+template <typename D>
+static inline void IOAF_Float32ToIntChannels( void (*convert)(const Float32 *, D *, unsigned int), unsigned int bytesPerSample, const Float32 *src, D *dest, unsigned int nFrames, unsigned int frameStride, unsigned int firstChannel, unsigned int nChannels )
+{
+	UInt8 *dst = (UInt8 *)dest + (firstChannel * bytesPerSample);
+	unsigned int frame, i, n;
+	
+	if (nChannels == 0)
+		return;
+	if (nChannels == frameStride) {
+		convert(src, dest, nFrames * frameStride);
+		return;
+	}
+	src += firstChannel;
+	if (nChannels >= kMinVectorChannels) {
+		for (frame = 0; frame < nFrames; ++frame, src += frameStride, dst += frameStride * bytesPerSample)
+			convert(src, (D *)dst, nChannels);
+		return;
+	}
+	
+	Float32 block[kChannelBlockSamples] __attribute__((aligned(16)));
+	UInt8 converted[kChannelBlockSamples * 4] __attribute__((aligned(16)));
+	const unsigned int blockFrames = kChannelBlockSamples / nChannels;
+	const unsigned int minCount = (nFrames * frameStride < kMinVectorChannels) ? nFrames * frameStride : kMinVectorChannels;
+	
+	for (frame = 0; frame < nFrames; frame += n) {
+		n = (nFrames - frame < blockFrames) ? nFrames - frame : blockFrames;
+		for (i = 0; i < n; ++i)
+			memcpy(block + i * nChannels, src + (frame + i) * frameStride, nChannels * sizeof(Float32));
+		for (i = n * nChannels; i < minCount; ++i)
+			block[i] = 0.0f;
+		convert(block, (D *)converted, (n * nChannels < minCount) ? minCount : n * nChannels);
+		for (i = 0; i < n; ++i)
+			memcpy(dst + (frame + i) * frameStride * bytesPerSample, converted + i * nChannels * bytesPerSample, nChannels * bytesPerSample);
+	}
+}
+
+void IOAF_Float32ToNativeInt16Channels( const Float32 *src, SInt16 *dest, unsigned int nFrames, unsigned int frameStride, unsigned int firstChannel, unsigned int nChannels )
+{
+	IOAF_Float32ToIntChannels(sConverters->float32ToNativeInt16, 2, src, dest, nFrames, frameStride, firstChannel, nChannels);
+}
+
+void IOAF_Float32ToSwapInt16Channels( const Float32 *src, SInt16 *dest, unsigned int nFrames, unsigned int frameStride, unsigned int firstChannel, unsigned int nChannels )
+{
+	IOAF_Float32ToIntChannels(sConverters->float32ToSwapInt16, 2, src, dest, nFrames, frameStride, firstChannel, nChannels);
+}
+
+void IOAF_Float32ToNativeInt24Channels( const Float32 *src, UInt8 *dest, unsigned int nFrames, unsigned int frameStride, unsigned int firstChannel, unsigned int nChannels )
+{
+	IOAF_Float32ToIntChannels(sConverters->float32ToNativeInt24, 3, src, dest, nFrames, frameStride, firstChannel, nChannels);
+}
+
+void IOAF_Float32ToSwapInt24Channels( const Float32 *src, UInt8 *dest, unsigned int nFrames, unsigned int frameStride, unsigned int firstChannel, unsigned int nChannels )
+{
+	IOAF_Float32ToIntChannels(sConverters->float32ToSwapInt24, 3, src, dest, nFrames, frameStride, firstChannel, nChannels);
+}
+
+void IOAF_Float32ToNativeInt32Channels( const Float32 *src, SInt32 *dest, unsigned int nFrames, unsigned int frameStride, unsigned int firstChannel, unsigned int nChannels )
+{
+	IOAF_Float32ToIntChannels(sConverters->float32ToNativeInt32, 4, src, dest, nFrames, frameStride, firstChannel, nChannels);
+}
+
+void IOAF_Float32ToSwapInt32Channels( const Float32 *src, SInt32 *dest, unsigned int nFrames, unsigned int frameStride, unsigned int firstChannel, unsigned int nChannels )
+{
+	IOAF_Float32ToIntChannels(sConverters->float32ToSwapInt32, 4, src, dest, nFrames, frameStride, firstChannel, nChannels);
+}
+
+// ____________________________________________________________________________________
+// Gain ramps
+//
+// The ramp is applied into a block on the stack, which the regular converter then takes, so the
+// samples are read once. Blocks hold whole frames and, for up to 16 channels, a multiple of 32
+// samples, so the converter's vector code covers the same samples as it would for the whole buffer.
+// A frame too wide for a block is converted in pieces at its gain.
+#define kGainRampBlockSamples	512
+
+template <typename D>
+static inline Float32 IOAF_Float32ToIntWithGainRamp( void (*convert)(const Float32 *, D *, unsigned int), unsigned int bytesPerSample, const Float32 *src, D *dest, unsigned int nChannels, unsigned int nFrames, Float32 gain, Float32 step, bool exponential )
+{
+	Float32 block[kGainRampBlockSamples] __attribute__((aligned(16)));
+	UInt8 *dst = (UInt8 *)dest;
+	unsigned int blockFrames, frame, n, c;
+	Float32 g = gain;
+	
+	if ((nChannels == 0) || (nFrames == 0))
+		return gain;
+	
+	blockFrames = kGainRampBlockSamples / nChannels;
+	if (blockFrames >= 32)
+		blockFrames &= ~31U;
+	
+	for (frame = 0; frame < nFrames; frame += n) {
+		if (!exponential)
+			g = gain + (Float32)frame * step;
+		if (blockFrames == 0) {
+			n = 1;
+			for (c = 0; c < nChannels; c += kGainRampBlockSamples) {
+				unsigned int count = (nChannels - c < kGainRampBlockSamples) ? nChannels - c : kGainRampBlockSamples;
+				IOAF_BACKEND(GainRampFloat32)(src + c, block, 1, count, g, exponential ? 1.0f : 0.0f, exponential);
+				convert(block, (D *)(dst + c * bytesPerSample), count);
+			}
+			if (exponential)
+				g *= step;
+		} else {
+			n = (nFrames - frame < blockFrames) ? nFrames - frame : blockFrames;
+			g = IOAF_BACKEND(GainRampFloat32)(src, block, nChannels, n, g, step, exponential);
+			convert(block, (D *)dst, n * nChannels);
+		}
+		src += n * nChannels;
+		dst += n * nChannels * bytesPerSample;
+	}
+	
+	return exponential ? g : gain + (Float32)nFrames * step;
+}
+
+Float32 IOAF_Float32ToNativeInt16WithGainRamp( const Float32 *src, SInt16 *dest, unsigned int nChannels, unsigned int nFrames, Float32 gain, Float32 step, bool exponential )
+{
+	return IOAF_Float32ToIntWithGainRamp(sConverters->float32ToNativeInt16, 2, src, dest, nChannels, nFrames, gain, step, exponential);
+}
+
+Float32 IOAF_Float32ToSwapInt16WithGainRamp( const Float32 *src, SInt16 *dest, unsigned int nChannels, unsigned int nFrames, Float32 gain, Float32 step, bool exponential )
+{
+	return IOAF_Float32ToIntWithGainRamp(sConverters->float32ToSwapInt16, 2, src, dest, nChannels, nFrames, gain, step, exponential);
+}
+
+Float32 IOAF_Float32ToNativeInt24WithGainRamp( const Float32 *src, UInt8 *dest, unsigned int nChannels, unsigned int nFrames, Float32 gain, Float32 step, bool exponential )
+{
+	return IOAF_Float32ToIntWithGainRamp(sConverters->float32ToNativeInt24, 3, src, dest, nChannels, nFrames, gain, step, exponential);
+}
+
+Float32 IOAF_Float32ToSwapInt24WithGainRamp( const Float32 *src, UInt8 *dest, unsigned int nChannels, unsigned int nFrames, Float32 gain, Float32 step, bool exponential )
+{
+	return IOAF_Float32ToIntWithGainRamp(sConverters->float32ToSwapInt24, 3, src, dest, nChannels, nFrames, gain, step, exponential);
+}
+
+Float32 IOAF_Float32ToNativeInt32WithGainRamp( const Float32 *src, SInt32 *dest, unsigned int nChannels, unsigned int nFrames, Float32 gain, Float32 step, bool exponential )
+{
+	return IOAF_Float32ToIntWithGainRamp(sConverters->float32ToNativeInt32, 4, src, dest, nChannels, nFrames, gain, step, exponential);
+}
+
+Float32 IOAF_Float32ToSwapInt32WithGainRamp( const Float32 *src, SInt32 *dest, unsigned int nChannels, unsigned int nFrames, Float32 gain, Float32 step, bool exponential )
+{
+	return IOAF_Float32ToIntWithGainRamp(sConverters->float32ToSwapInt32, 4, src, dest, nChannels, nFrames, gain, step, exponential);
+}
+
+// ____________________________________________________________________________________
+// Batches
+
+void IOAF_Float32ToIntBatch( const IOAF_ConversionJob *jobs, unsigned int nJobs )
+{
+#if PCMBLIT_X86
+	Float32ToIntBatch_X86(jobs, nJobs);
+#else
+	// the vector backend rounds in each operation, so there is no setup to share between jobs
+	for (unsigned int n = 0; n < nJobs; ++n) {
+		const IOAF_ConversionJob *job = &jobs[n];
+
+		switch (job->format) {
+			case kIOAF_NativeInt16:	IOAF_Float32ToNativeInt16(job->src, (SInt16 *)job->dest, job->count);	break;
+			case kIOAF_SwapInt16:	IOAF_Float32ToSwapInt16(job->src, (SInt16 *)job->dest, job->count);		break;
+			case kIOAF_NativeInt24:	IOAF_Float32ToNativeInt24(job->src, (UInt8 *)job->dest, job->count);	break;
+			case kIOAF_SwapInt24:	IOAF_Float32ToSwapInt24(job->src, (UInt8 *)job->dest, job->count);		break;
+			case kIOAF_NativeInt32:	IOAF_Float32ToNativeInt32(job->src, (SInt32 *)job->dest, job->count);	break;
+			case kIOAF_SwapInt32:	IOAF_Float32ToSwapInt32(job->src, (SInt32 *)job->dest, job->count);		break;
+			default:																						break;
+		}
+	}
+#endif
+}
+
+void IOAF_Interleave32( const void * const src[], void *dest, unsigned int nChannels, unsigned int nFrames )
+{
+	IOAF_BACKEND(Interleave32)(src, dest, nChannels, nFrames);
+}
+
+void IOAF_Deinterleave32( const void *src, void * const dest[], unsigned int nChannels, unsigned int nFrames )
+{
+	IOAF_BACKEND(Deinterleave32)(src, dest, nChannels, nFrames);
+}
+
+void IOAF_DeinterleaveFloat32ToNativeInt16( const Float32 *src, SInt16 * const dest[], unsigned int nChannels, unsigned int nFrames )
+{
+	IOAF_BACKEND(DeinterleaveFloat32ToNativeInt16)(src, dest, nChannels, nFrames);
+}
+
+void IOAF_DeinterleaveFloat32ToNativeInt32( const Float32 *src, SInt32 * const dest[], unsigned int nChannels, unsigned int nFrames )
+{
+	IOAF_BACKEND(DeinterleaveFloat32ToNativeInt32)(src, dest, nChannels, nFrames);
+}
+
+void IOAF_DeinterleaveFloat32ToSwapInt16( const Float32 *src, SInt16 * const dest[], unsigned int nChannels, unsigned int nFrames )
+{
+	IOAF_BACKEND(DeinterleaveFloat32ToSwapInt16)(src, dest, nChannels, nFrames);
+}
+
+void IOAF_DeinterleaveFloat32ToSwapInt32( const Float32 *src, SInt32 * const dest[], unsigned int nChannels, unsigned int nFrames )
+{
+	IOAF_BACKEND(DeinterleaveFloat32ToSwapInt32)(src, dest, nChannels, nFrames);
+}
+
+void IOAF_InterleaveNativeInt16ToFloat32( const SInt16 * const src[], Float32 *dest, unsigned int nChannels, unsigned int nFrames )
+{
+	IOAF_BACKEND(InterleaveNativeInt16ToFloat32)(src, dest, nChannels, nFrames);
+}
+
+void IOAF_InterleaveNativeInt32ToFloat32( const SInt32 * const src[], Float32 *dest, unsigned int nChannels, unsigned int nFrames )
+{
+	IOAF_BACKEND(InterleaveNativeInt32ToFloat32)(src, dest, nChannels, nFrames);
+}
+
+void IOAF_InterleaveSwapInt16ToFloat32( const SInt16 * const src[], Float32 *dest, unsigned int nChannels, unsigned int nFrames )
+{
+	IOAF_BACKEND(InterleaveSwapInt16ToFloat32)(src, dest, nChannels, nFrames);
+}
+
+void IOAF_InterleaveSwapInt32ToFloat32( const SInt32 * const src[], Float32 *dest, unsigned int nChannels, unsigned int nFrames )
+{
+	IOAF_BACKEND(InterleaveSwapInt32ToFloat32)(src, dest, nChannels, nFrames);
+}
+
+#if PCMBLIT_X86
+// The original copy from write-combined memory: streaming loads when the source is 16-byte aligned.
+static void bcopy_FromWriteCombine_SSE41( const void *pSrc, void *pDst, unsigned int count )
 {
 	unsigned int n;
 	
@@ -224,4 +1383,44 @@ void IOAF_bcopy_WriteCombine(const void *pSrc, void *pDst, unsigned int count)
 		*(((char*)dst_data++)) = *((char*)src_data++);
 	
 	_mm_mfence();
-}
\ No newline at end of file
+}
+#endif // PCMBLIT_X86
+
+void IOAF_bcopy_WriteCombine(const void *pSrc, void *pDst, unsigned int count)
+{
+	sConverters->bcopyFromWriteCombine(pSrc, pDst, count);
+}
+
+void IOAF_bcopy_ToWriteCombine(const void *pSrc, void *pDst, unsigned int count)
+{
+	sConverters->bcopyToWriteCombine(pSrc, pDst, count);
+}
+// ____________________________________________________________________________________
+// Denormals
+//
+// MXCSR's FTZ (flush to zero) and DAZ (denormals are zero) bits. ldmxcsr is slow and
+// serializing, so it is only executed when the state actually changes.
+#define kMXCSRDisableDenormals	0x8040
+
+UInt32 IOAF_DisableDenormals()
+{
+#if PCMBLIT_X86
+	UInt32 savedState = _mm_getcsr();
+
+	if ((savedState & kMXCSRDisableDenormals) != kMXCSRDisableDenormals)
+		_mm_setcsr(savedState | kMXCSRDisableDenormals);
+	return savedState;
+#else
+	return 0;
+#endif
+}
+
+void IOAF_RestoreDenormals( UInt32 savedState )
+{
+#if PCMBLIT_X86
+	if ((savedState & kMXCSRDisableDenormals) != kMXCSRDisableDenormals)
+		_mm_setcsr(savedState);
+#else
+#pragma unused ( savedState )
+#endif
+}
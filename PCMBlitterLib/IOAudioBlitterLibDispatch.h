@@ -45,6 +45,14 @@
 #define __IOAudioBlitterLibDispatch_h__
 
 #include <libkern/OSTypes.h>
+#ifndef IOAUDIOFAMILY_SELF_BUILD
+#include <IOKit/audio/IOAudioTypes.h>
+#else
+#include "IOAudioTypes.h"
+#endif
+#ifndef __cplusplus
+#include <stdbool.h>	// for the bool parameters below
+#endif
 
 
 #pragma mark -
@@ -81,6 +89,110 @@
 #define IOAF_Float32ToBEInt32	IOAF_Float32ToSwapInt32
 #endif
 
+#if TARGET_RT_BIG_ENDIAN
+#define IOAF_Float32ToBEInt16_ToWriteCombine	IOAF_Float32ToNativeInt16_ToWriteCombine
+#define IOAF_Float32ToLEInt16_ToWriteCombine	IOAF_Float32ToSwapInt16_ToWriteCombine
+#define IOAF_Float32ToBEInt24_ToWriteCombine	IOAF_Float32ToNativeInt24_ToWriteCombine
+#define IOAF_Float32ToLEInt24_ToWriteCombine	IOAF_Float32ToSwapInt24_ToWriteCombine
+#define IOAF_Float32ToBEInt32_ToWriteCombine	IOAF_Float32ToNativeInt32_ToWriteCombine
+#define IOAF_Float32ToLEInt32_ToWriteCombine	IOAF_Float32ToSwapInt32_ToWriteCombine
+#else
+#define IOAF_Float32ToLEInt16_ToWriteCombine	IOAF_Float32ToNativeInt16_ToWriteCombine
+#define IOAF_Float32ToBEInt16_ToWriteCombine	IOAF_Float32ToSwapInt16_ToWriteCombine
+#define IOAF_Float32ToLEInt24_ToWriteCombine	IOAF_Float32ToNativeInt24_ToWriteCombine
+#define IOAF_Float32ToBEInt24_ToWriteCombine	IOAF_Float32ToSwapInt24_ToWriteCombine
+#define IOAF_Float32ToLEInt32_ToWriteCombine	IOAF_Float32ToNativeInt32_ToWriteCombine
+#define IOAF_Float32ToBEInt32_ToWriteCombine	IOAF_Float32ToSwapInt32_ToWriteCombine
+#endif
+
+#if TARGET_RT_BIG_ENDIAN
+#define IOAF_Float32ToBEInt16WithGain	IOAF_Float32ToNativeInt16WithGain
+#define IOAF_Float32ToLEInt16WithGain	IOAF_Float32ToSwapInt16WithGain
+#define IOAF_Float32ToBEInt24WithGain	IOAF_Float32ToNativeInt24WithGain
+#define IOAF_Float32ToLEInt24WithGain	IOAF_Float32ToSwapInt24WithGain
+#define IOAF_Float32ToBEInt32WithGain	IOAF_Float32ToNativeInt32WithGain
+#define IOAF_Float32ToLEInt32WithGain	IOAF_Float32ToSwapInt32WithGain
+#else
+#define IOAF_Float32ToLEInt16WithGain	IOAF_Float32ToNativeInt16WithGain
+#define IOAF_Float32ToBEInt16WithGain	IOAF_Float32ToSwapInt16WithGain
+#define IOAF_Float32ToLEInt24WithGain	IOAF_Float32ToNativeInt24WithGain
+#define IOAF_Float32ToBEInt24WithGain	IOAF_Float32ToSwapInt24WithGain
+#define IOAF_Float32ToLEInt32WithGain	IOAF_Float32ToNativeInt32WithGain
+#define IOAF_Float32ToBEInt32WithGain	IOAF_Float32ToSwapInt32WithGain
+#endif
+
+#if TARGET_RT_BIG_ENDIAN
+#define IOAF_Float32ToBEInt16WithGainRamp	IOAF_Float32ToNativeInt16WithGainRamp
+#define IOAF_Float32ToLEInt16WithGainRamp	IOAF_Float32ToSwapInt16WithGainRamp
+#define IOAF_Float32ToBEInt24WithGainRamp	IOAF_Float32ToNativeInt24WithGainRamp
+#define IOAF_Float32ToLEInt24WithGainRamp	IOAF_Float32ToSwapInt24WithGainRamp
+#define IOAF_Float32ToBEInt32WithGainRamp	IOAF_Float32ToNativeInt32WithGainRamp
+#define IOAF_Float32ToLEInt32WithGainRamp	IOAF_Float32ToSwapInt32WithGainRamp
+#else
+#define IOAF_Float32ToLEInt16WithGainRamp	IOAF_Float32ToNativeInt16WithGainRamp
+#define IOAF_Float32ToBEInt16WithGainRamp	IOAF_Float32ToSwapInt16WithGainRamp
+#define IOAF_Float32ToLEInt24WithGainRamp	IOAF_Float32ToNativeInt24WithGainRamp
+#define IOAF_Float32ToBEInt24WithGainRamp	IOAF_Float32ToSwapInt24WithGainRamp
+#define IOAF_Float32ToLEInt32WithGainRamp	IOAF_Float32ToNativeInt32WithGainRamp
+#define IOAF_Float32ToBEInt32WithGainRamp	IOAF_Float32ToSwapInt32WithGainRamp
+#endif
+
+#if TARGET_RT_BIG_ENDIAN
+#define IOAF_Float32ToBEInt16Dithered	IOAF_Float32ToNativeInt16Dithered
+#define IOAF_Float32ToLEInt16Dithered	IOAF_Float32ToSwapInt16Dithered
+#define IOAF_Float32ToBEInt24Dithered	IOAF_Float32ToNativeInt24Dithered
+#define IOAF_Float32ToLEInt24Dithered	IOAF_Float32ToSwapInt24Dithered
+#else
+#define IOAF_Float32ToLEInt16Dithered	IOAF_Float32ToNativeInt16Dithered
+#define IOAF_Float32ToBEInt16Dithered	IOAF_Float32ToSwapInt16Dithered
+#define IOAF_Float32ToLEInt24Dithered	IOAF_Float32ToNativeInt24Dithered
+#define IOAF_Float32ToBEInt24Dithered	IOAF_Float32ToSwapInt24Dithered
+#endif
+
+#if TARGET_RT_BIG_ENDIAN
+#define IOAF_Float32ToBEInt16Channels	IOAF_Float32ToNativeInt16Channels
+#define IOAF_Float32ToLEInt16Channels	IOAF_Float32ToSwapInt16Channels
+#define IOAF_Float32ToBEInt24Channels	IOAF_Float32ToNativeInt24Channels
+#define IOAF_Float32ToLEInt24Channels	IOAF_Float32ToSwapInt24Channels
+#define IOAF_Float32ToBEInt32Channels	IOAF_Float32ToNativeInt32Channels
+#define IOAF_Float32ToLEInt32Channels	IOAF_Float32ToSwapInt32Channels
+#else
+#define IOAF_Float32ToLEInt16Channels	IOAF_Float32ToNativeInt16Channels
+#define IOAF_Float32ToBEInt16Channels	IOAF_Float32ToSwapInt16Channels
+#define IOAF_Float32ToLEInt24Channels	IOAF_Float32ToNativeInt24Channels
+#define IOAF_Float32ToBEInt24Channels	IOAF_Float32ToSwapInt24Channels
+#define IOAF_Float32ToLEInt32Channels	IOAF_Float32ToNativeInt32Channels
+#define IOAF_Float32ToBEInt32Channels	IOAF_Float32ToSwapInt32Channels
+#endif
+
+#if TARGET_RT_BIG_ENDIAN
+#define kIOAF_BEInt16	kIOAF_NativeInt16
+#define kIOAF_LEInt16	kIOAF_SwapInt16
+#define kIOAF_BEInt24	kIOAF_NativeInt24
+#define kIOAF_LEInt24	kIOAF_SwapInt24
+#define kIOAF_BEInt32	kIOAF_NativeInt32
+#define kIOAF_LEInt32	kIOAF_SwapInt32
+#else
+#define kIOAF_LEInt16	kIOAF_NativeInt16
+#define kIOAF_BEInt16	kIOAF_SwapInt16
+#define kIOAF_LEInt24	kIOAF_NativeInt24
+#define kIOAF_BEInt24	kIOAF_SwapInt24
+#define kIOAF_LEInt32	kIOAF_NativeInt32
+#define kIOAF_BEInt32	kIOAF_SwapInt32
+#endif
+
+#if TARGET_RT_BIG_ENDIAN
+#define IOAF_Float32ToBEIntJustified	IOAF_Float32ToNativeIntJustified
+#define IOAF_Float32ToLEIntJustified	IOAF_Float32ToSwapIntJustified
+#define IOAF_BEIntJustifiedToFloat32	IOAF_NativeIntJustifiedToFloat32
+#define IOAF_LEIntJustifiedToFloat32	IOAF_SwapIntJustifiedToFloat32
+#else
+#define IOAF_Float32ToLEIntJustified	IOAF_Float32ToNativeIntJustified
+#define IOAF_Float32ToBEIntJustified	IOAF_Float32ToSwapIntJustified
+#define IOAF_LEIntJustifiedToFloat32	IOAF_NativeIntJustifiedToFloat32
+#define IOAF_BEIntJustifiedToFloat32	IOAF_SwapIntJustifiedToFloat32
+#endif
+
 /*!
  * @typedef Float32
  * @abstract Convenience type that represent a 32-bit floating point number
@@ -93,6 +205,69 @@ typedef float	Float32;
  */
 typedef double	Float64;
 
+/*!
+ * @enum IOAF_IntFormat
+ * @abstract Integer sample formats for IOAF_IntToInt
+ * @discussion 24-bit samples are packed, 3 bytes per sample.
+ */
+typedef enum {
+	kIOAF_NativeInt16 = 0,
+	kIOAF_SwapInt16,
+	kIOAF_NativeInt24,
+	kIOAF_SwapInt24,
+	kIOAF_NativeInt32,
+	kIOAF_SwapInt32,
+	kIOAF_NumIntFormats
+} IOAF_IntFormat;
+
+/*!
+ * @typedef IOAF_ConversionJob
+ * @abstract One buffer to be converted by IOAF_Float32ToIntBatch
+ * @field src Pointer to the data to convert
+ * @field dest Pointer to the converted data
+ * @field count The number of items to convert
+ * @field format The integer format to convert to
+ */
+typedef struct IOAF_ConversionJob {
+	const Float32	*src;
+	void			*dest;
+	unsigned int	count;
+	IOAF_IntFormat	format;
+} IOAF_ConversionJob;
+
+/*!
+ * @defined kIOAF_DitherMaxChannels
+ * @abstract The most channels IOAF_DitherState keeps a noise shaping error for; wider streams are dithered without shaping
+ */
+#define kIOAF_DitherMaxChannels		32
+
+/*!
+ * @defined kIOAF_DitherSeeds
+ * @abstract The number of 32-bit random number generators in IOAF_DitherState, one per vector lane of the widest converters
+ */
+#define kIOAF_DitherSeeds			64
+
+/*!
+ * @typedef IOAF_DitherState
+ * @abstract State carried from one buffer to the next by the dithered converters; keep one per stream
+ * @discussion Set it up with IOAF_DitherStateInit.
+ * @field seed The random number generator state
+ * @field error The last quantization error of each channel, for noise shaping
+ */
+typedef struct IOAF_DitherState {
+	UInt32		seed[kIOAF_DitherSeeds];
+	Float32		error[kIOAF_DitherMaxChannels];
+} IOAF_DitherState;
+
+/*!
+ * @typedef IOAF_PCMConverterProc
+ * @abstract A sample format converter, as returned by IOAF_GetPCMConverter
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of samples to convert
+ */
+typedef void (*IOAF_PCMConverterProc)( const void *src, void *dest, unsigned int count );
+
 /*!
  * @function IOAF_NativeInt16ToFloat32
  * @abstract Converts native 16-bit integer float to 32-bit float
@@ -201,6 +376,660 @@ extern void IOAF_Float32ToNativeInt32( const Float32 *src, SInt32 *dest, unsigne
  */
 extern void IOAF_Float32ToSwapInt32( const Float32 *src, SInt32 *dest, unsigned int count );
 
+/*!
+ * @function IOAF_Float32ToNativeInt16_ToWriteCombine
+ * @abstract Converts 32-bit floating point to native 16-bit integer in uncached or write-combined memory, using non-temporal stores
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ */
+extern void IOAF_Float32ToNativeInt16_ToWriteCombine( const Float32 *src, SInt16 *dest, unsigned int count );
+
+/*!
+ * @function IOAF_Float32ToSwapInt16_ToWriteCombine
+ * @abstract Converts 32-bit floating point to non-native 16-bit integer in uncached or write-combined memory, using non-temporal stores
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ */
+extern void IOAF_Float32ToSwapInt16_ToWriteCombine( const Float32 *src, SInt16 *dest, unsigned int count );
+
+/*!
+ * @function IOAF_Float32ToNativeInt24_ToWriteCombine
+ * @abstract Converts 32-bit floating point to native 24-bit integer in uncached or write-combined memory, using non-temporal stores
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ */
+extern void IOAF_Float32ToNativeInt24_ToWriteCombine( const Float32 *src, UInt8 *dest, unsigned int count );
+
+/*!
+ * @function IOAF_Float32ToSwapInt24_ToWriteCombine
+ * @abstract Converts 32-bit floating point to non-native 24-bit integer in uncached or write-combined memory, using non-temporal stores
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ */
+extern void IOAF_Float32ToSwapInt24_ToWriteCombine( const Float32 *src, UInt8 *dest, unsigned int count );
+
+/*!
+ * @function IOAF_Float32ToNativeInt32_ToWriteCombine
+ * @abstract Converts 32-bit floating point to native 32-bit integer in uncached or write-combined memory, using non-temporal stores
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ */
+extern void IOAF_Float32ToNativeInt32_ToWriteCombine( const Float32 *src, SInt32 *dest, unsigned int count );
+
+/*!
+ * @function IOAF_Float32ToSwapInt32_ToWriteCombine
+ * @abstract Converts 32-bit floating point to non-native 32-bit integer in uncached or write-combined memory, using non-temporal stores
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ */
+extern void IOAF_Float32ToSwapInt32_ToWriteCombine( const Float32 *src, SInt32 *dest, unsigned int count );
+
+/*!
+ * @function IOAF_Float32ToNativeInt16WithGain
+ * @abstract Converts interleaved 32-bit floating point to native 16-bit integer, scaling each sample by the gain of its channel
+ * @discussion Equivalent to multiplying src by the gains and then calling IOAF_Float32ToNativeInt16, in a single pass; each product is rounded toward minus infinity, so it may be one float ulp lower.
+ * @param src Pointer to the data to convert; src[0] belongs to channel 0
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ * @param gain Pointer to nChannels linear gain factors, one per channel
+ * @param nChannels The number of interleaved channels in src
+ */
+extern void IOAF_Float32ToNativeInt16WithGain( const Float32 *src, SInt16 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels );
+
+/*!
+ * @function IOAF_Float32ToSwapInt16WithGain
+ * @abstract Converts interleaved 32-bit floating point to non-native 16-bit integer, scaling each sample by the gain of its channel
+ * @discussion Equivalent to multiplying src by the gains and then calling IOAF_Float32ToSwapInt16, in a single pass; each product is rounded toward minus infinity, so it may be one float ulp lower.
+ * @param src Pointer to the data to convert; src[0] belongs to channel 0
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ * @param gain Pointer to nChannels linear gain factors, one per channel
+ * @param nChannels The number of interleaved channels in src
+ */
+extern void IOAF_Float32ToSwapInt16WithGain( const Float32 *src, SInt16 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels );
+
+/*!
+ * @function IOAF_Float32ToNativeInt24WithGain
+ * @abstract Converts interleaved 32-bit floating point to native 24-bit integer, scaling each sample by the gain of its channel
+ * @discussion Equivalent to multiplying src by the gains and then calling IOAF_Float32ToNativeInt24, in a single pass; each product is rounded toward minus infinity, so it may be one float ulp lower.
+ * @param src Pointer to the data to convert; src[0] belongs to channel 0
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ * @param gain Pointer to nChannels linear gain factors, one per channel
+ * @param nChannels The number of interleaved channels in src
+ */
+extern void IOAF_Float32ToNativeInt24WithGain( const Float32 *src, UInt8 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels );
+
+/*!
+ * @function IOAF_Float32ToSwapInt24WithGain
+ * @abstract Converts interleaved 32-bit floating point to non-native 24-bit integer, scaling each sample by the gain of its channel
+ * @discussion Equivalent to multiplying src by the gains and then calling IOAF_Float32ToSwapInt24, in a single pass; each product is rounded toward minus infinity, so it may be one float ulp lower.
+ * @param src Pointer to the data to convert; src[0] belongs to channel 0
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ * @param gain Pointer to nChannels linear gain factors, one per channel
+ * @param nChannels The number of interleaved channels in src
+ */
+extern void IOAF_Float32ToSwapInt24WithGain( const Float32 *src, UInt8 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels );
+
+/*!
+ * @function IOAF_Float32ToNativeInt32WithGain
+ * @abstract Converts interleaved 32-bit floating point to native 32-bit integer, scaling each sample by the gain of its channel
+ * @discussion Equivalent to multiplying src by the gains and then calling IOAF_Float32ToNativeInt32, in a single pass; each product is rounded toward minus infinity, so it may be one float ulp lower.
+ * @param src Pointer to the data to convert; src[0] belongs to channel 0
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ * @param gain Pointer to nChannels linear gain factors, one per channel
+ * @param nChannels The number of interleaved channels in src
+ */
+extern void IOAF_Float32ToNativeInt32WithGain( const Float32 *src, SInt32 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels );
+
+/*!
+ * @function IOAF_Float32ToSwapInt32WithGain
+ * @abstract Converts interleaved 32-bit floating point to non-native 32-bit integer, scaling each sample by the gain of its channel
+ * @discussion Equivalent to multiplying src by the gains and then calling IOAF_Float32ToSwapInt32, in a single pass; each product is rounded toward minus infinity, so it may be one float ulp lower.
+ * @param src Pointer to the data to convert; src[0] belongs to channel 0
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ * @param gain Pointer to nChannels linear gain factors, one per channel
+ * @param nChannels The number of interleaved channels in src
+ */
+extern void IOAF_Float32ToSwapInt32WithGain( const Float32 *src, SInt32 *dest, unsigned int count, const Float32 *gain, unsigned int nChannels );
+
+/*!
+ * @function IOAF_Float32ToNativeInt16WithGainRamp
+ * @abstract Converts interleaved 32-bit floating point to native 16-bit integer, scaling each frame by a gain that changes from frame to frame
+ * @discussion Equivalent to IOAF_GainRampFloat32 into a scratch buffer followed by IOAF_Float32ToNativeInt16, without
+ * the second pass: the samples are scaled a block at a time on their way to the converter. The ramp is restarted
+ * every block, so a gain may differ from IOAF_GainRampFloat32's in its last bit and a sample by one LSB.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param nChannels The number of interleaved channels
+ * @param nFrames The number of sample frames to convert
+ * @param gain The linear gain for the first frame
+ * @param step The per-frame increment, or for an exponential ramp the per-frame ratio
+ * @param exponential True if step is a ratio
+ * @result The gain for the frame after the last one, to pass in for the next buffer
+ */
+extern Float32 IOAF_Float32ToNativeInt16WithGainRamp( const Float32 *src, SInt16 *dest, unsigned int nChannels, unsigned int nFrames, Float32 gain, Float32 step, bool exponential );
+
+/*!
+ * @function IOAF_Float32ToSwapInt16WithGainRamp
+ * @abstract Converts interleaved 32-bit floating point to non-native 16-bit integer, scaling each frame by a gain that changes from frame to frame
+ * @discussion See IOAF_Float32ToNativeInt16WithGainRamp.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param nChannels The number of interleaved channels
+ * @param nFrames The number of sample frames to convert
+ * @param gain The linear gain for the first frame
+ * @param step The per-frame increment, or for an exponential ramp the per-frame ratio
+ * @param exponential True if step is a ratio
+ * @result The gain for the frame after the last one, to pass in for the next buffer
+ */
+extern Float32 IOAF_Float32ToSwapInt16WithGainRamp( const Float32 *src, SInt16 *dest, unsigned int nChannels, unsigned int nFrames, Float32 gain, Float32 step, bool exponential );
+
+/*!
+ * @function IOAF_Float32ToNativeInt24WithGainRamp
+ * @abstract Converts interleaved 32-bit floating point to native packed 24-bit integer, scaling each frame by a gain that changes from frame to frame
+ * @discussion See IOAF_Float32ToNativeInt16WithGainRamp.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param nChannels The number of interleaved channels
+ * @param nFrames The number of sample frames to convert
+ * @param gain The linear gain for the first frame
+ * @param step The per-frame increment, or for an exponential ramp the per-frame ratio
+ * @param exponential True if step is a ratio
+ * @result The gain for the frame after the last one, to pass in for the next buffer
+ */
+extern Float32 IOAF_Float32ToNativeInt24WithGainRamp( const Float32 *src, UInt8 *dest, unsigned int nChannels, unsigned int nFrames, Float32 gain, Float32 step, bool exponential );
+
+/*!
+ * @function IOAF_Float32ToSwapInt24WithGainRamp
+ * @abstract Converts interleaved 32-bit floating point to non-native packed 24-bit integer, scaling each frame by a gain that changes from frame to frame
+ * @discussion See IOAF_Float32ToNativeInt16WithGainRamp.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param nChannels The number of interleaved channels
+ * @param nFrames The number of sample frames to convert
+ * @param gain The linear gain for the first frame
+ * @param step The per-frame increment, or for an exponential ramp the per-frame ratio
+ * @param exponential True if step is a ratio
+ * @result The gain for the frame after the last one, to pass in for the next buffer
+ */
+extern Float32 IOAF_Float32ToSwapInt24WithGainRamp( const Float32 *src, UInt8 *dest, unsigned int nChannels, unsigned int nFrames, Float32 gain, Float32 step, bool exponential );
+
+/*!
+ * @function IOAF_Float32ToNativeInt32WithGainRamp
+ * @abstract Converts interleaved 32-bit floating point to native 32-bit integer, scaling each frame by a gain that changes from frame to frame
+ * @discussion See IOAF_Float32ToNativeInt16WithGainRamp.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param nChannels The number of interleaved channels
+ * @param nFrames The number of sample frames to convert
+ * @param gain The linear gain for the first frame
+ * @param step The per-frame increment, or for an exponential ramp the per-frame ratio
+ * @param exponential True if step is a ratio
+ * @result The gain for the frame after the last one, to pass in for the next buffer
+ */
+extern Float32 IOAF_Float32ToNativeInt32WithGainRamp( const Float32 *src, SInt32 *dest, unsigned int nChannels, unsigned int nFrames, Float32 gain, Float32 step, bool exponential );
+
+/*!
+ * @function IOAF_Float32ToSwapInt32WithGainRamp
+ * @abstract Converts interleaved 32-bit floating point to non-native 32-bit integer, scaling each frame by a gain that changes from frame to frame
+ * @discussion See IOAF_Float32ToNativeInt16WithGainRamp.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param nChannels The number of interleaved channels
+ * @param nFrames The number of sample frames to convert
+ * @param gain The linear gain for the first frame
+ * @param step The per-frame increment, or for an exponential ramp the per-frame ratio
+ * @param exponential True if step is a ratio
+ * @result The gain for the frame after the last one, to pass in for the next buffer
+ */
+extern Float32 IOAF_Float32ToSwapInt32WithGainRamp( const Float32 *src, SInt32 *dest, unsigned int nChannels, unsigned int nFrames, Float32 gain, Float32 step, bool exponential );
+
+/*!
+ * @function IOAF_DitherStateInit
+ * @abstract Seeds the random number generator of a dither state and clears its noise shaping history
+ * @param state The state to set up
+ * @param seed Any value; different seeds give uncorrelated noise
+ */
+extern void IOAF_DitherStateInit( IOAF_DitherState *state, UInt32 seed );
+
+/*!
+ * @function IOAF_Float32ToNativeInt16Dithered
+ * @abstract Converts interleaved 32-bit floating point to native 16-bit integer with TPDF dither, optionally noise shaped
+ * @discussion Triangular noise of +/-1 LSB is added before rounding. With noiseShaping, each channel's quantization
+ * error is also subtracted from its next sample, a first-order shaping that moves the noise toward high frequencies;
+ * this needs count to start on a frame boundary and is skipped for more than kIOAF_DitherMaxChannels channels.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ * @param nChannels The number of interleaved channels in src
+ * @param noiseShaping True to shape the quantization noise
+ * @param state The stream's dither state
+ */
+extern void IOAF_Float32ToNativeInt16Dithered( const Float32 *src, SInt16 *dest, unsigned int count, unsigned int nChannels, bool noiseShaping, IOAF_DitherState *state );
+
+/*!
+ * @function IOAF_Float32ToSwapInt16Dithered
+ * @abstract Converts interleaved 32-bit floating point to non-native 16-bit integer with TPDF dither, optionally noise shaped
+ * @discussion See IOAF_Float32ToNativeInt16Dithered.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ * @param nChannels The number of interleaved channels in src
+ * @param noiseShaping True to shape the quantization noise
+ * @param state The stream's dither state
+ */
+extern void IOAF_Float32ToSwapInt16Dithered( const Float32 *src, SInt16 *dest, unsigned int count, unsigned int nChannels, bool noiseShaping, IOAF_DitherState *state );
+
+/*!
+ * @function IOAF_Float32ToNativeInt24Dithered
+ * @abstract Converts interleaved 32-bit floating point to native packed 24-bit integer with TPDF dither, optionally noise shaped
+ * @discussion See IOAF_Float32ToNativeInt16Dithered; the dither is +/-1 LSB of the 24-bit result.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ * @param nChannels The number of interleaved channels in src
+ * @param noiseShaping True to shape the quantization noise
+ * @param state The stream's dither state
+ */
+extern void IOAF_Float32ToNativeInt24Dithered( const Float32 *src, UInt8 *dest, unsigned int count, unsigned int nChannels, bool noiseShaping, IOAF_DitherState *state );
+
+/*!
+ * @function IOAF_Float32ToSwapInt24Dithered
+ * @abstract Converts interleaved 32-bit floating point to non-native packed 24-bit integer with TPDF dither, optionally noise shaped
+ * @discussion See IOAF_Float32ToNativeInt16Dithered; the dither is +/-1 LSB of the 24-bit result.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ * @param nChannels The number of interleaved channels in src
+ * @param noiseShaping True to shape the quantization noise
+ * @param state The stream's dither state
+ */
+extern void IOAF_Float32ToSwapInt24Dithered( const Float32 *src, UInt8 *dest, unsigned int count, unsigned int nChannels, bool noiseShaping, IOAF_DitherState *state );
+
+/*!
+ * @function IOAF_GainRampFloat32
+ * @abstract Scales interleaved 32-bit floating point samples by a gain that changes from frame to frame
+ * @discussion Frame n is scaled by gain + n * step, or by gain * step^n for an exponential ramp, which is a straight
+ * line in dB. A step of 0 (linear) or 1 (exponential) applies a constant gain, and does nothing for a gain of 1 in place.
+ * Use IOAF_GainRampStep to work out the step. src and dest may be the same buffer.
+ * @param src Pointer to the samples to scale
+ * @param dest Pointer to the scaled samples
+ * @param nChannels The number of interleaved channels
+ * @param nFrames The number of sample frames to scale
+ * @param gain The linear gain for the first frame
+ * @param step The per-frame increment, or for an exponential ramp the per-frame ratio
+ * @param exponential True if step is a ratio
+ * @result The gain for the frame after the last one, to pass in for the next buffer
+ */
+extern Float32 IOAF_GainRampFloat32( const Float32 *src, Float32 *dest, unsigned int nChannels, unsigned int nFrames, Float32 gain, Float32 step, bool exponential );
+
+/*!
+ * @function IOAF_GainRampStep
+ * @abstract Returns the step for IOAF_GainRampFloat32 that takes the gain from fromGain to toGain in nFrames frames
+ * @discussion An exponential ramp cannot start or end at silence; for a gain of 0 at either end this returns 1, a
+ * ramp that doesn't move, and a linear ramp should be used instead.
+ * @param fromGain The linear gain at the start of the ramp
+ * @param toGain The linear gain to reach
+ * @param nFrames The length of the ramp in sample frames
+ * @param exponential True for an exponential ramp
+ */
+extern Float32 IOAF_GainRampStep( Float32 fromGain, Float32 toGain, unsigned int nFrames, bool exponential );
+
+/*!
+ * @function IOAF_DecibelsToGain
+ * @abstract Converts a level in dB to a linear gain factor
+ * @param dB The level in dB, as an IOFixed (16.16 fixed point) value like the dB ranges of an IOAudioLevelControl
+ */
+extern Float32 IOAF_DecibelsToGain( SInt32 dB );
+
+/*!
+ * @function IOAF_ByteSwapInt16
+ * @abstract Reverses the byte order of 16-bit integer samples; may be done in place
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ */
+extern void IOAF_ByteSwapInt16( const SInt16 *src, SInt16 *dest, unsigned int count );
+
+/*!
+ * @function IOAF_ByteSwapInt24
+ * @abstract Reverses the byte order of packed 24-bit integer samples; may be done in place
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ */
+extern void IOAF_ByteSwapInt24( const UInt8 *src, UInt8 *dest, unsigned int count );
+
+/*!
+ * @function IOAF_ByteSwapInt32
+ * @abstract Reverses the byte order of 32-bit integer samples; may be done in place
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ */
+extern void IOAF_ByteSwapInt32( const SInt32 *src, SInt32 *dest, unsigned int count );
+
+/*!
+ * @function IOAF_IntToInt
+ * @abstract Converts between integer sample formats without an intermediate float buffer
+ * @discussion Widening is exact. Narrowing rounds to nearest and clips, matching a conversion to 32-bit float and back
+ * for every value that float can represent exactly. Identical formats are copied.
+ * @param src Pointer to the data to convert
+ * @param srcFormat The format of the data at src
+ * @param dest Pointer to the converted data
+ * @param destFormat The format to convert to
+ * @param count The number of items to convert
+ */
+extern void IOAF_IntToInt( const void *src, IOAF_IntFormat srcFormat, void *dest, IOAF_IntFormat destFormat, unsigned int count );
+
+/*!
+ * @function IOAF_Float32ToNativeIntJustified
+ * @abstract Converts 32-bit floating point to native endian integer samples narrower than their container
+ * @discussion For 20-bit samples in packed 24-bit words, 24-bit samples in 32-bit words and the like. The sample is
+ * rounded to bitDepth bits. High aligned, it fills the top of the container and the bits below it are zero; low
+ * aligned, it fills the bottom and is sign-extended above. A sample as wide as its container is converted as by
+ * IOAF_Float32ToNativeInt16 and the like.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ * @param bitDepth The number of significant bits in a sample, from 8 to bitWidth
+ * @param bitWidth The size of the container in bits: 16, 24 (packed) or 32
+ * @param highAligned true if the sample is in the high bits of the container, false if in the low bits
+ */
+extern void IOAF_Float32ToNativeIntJustified( const Float32 *src, void *dest, unsigned int count, unsigned int bitDepth, unsigned int bitWidth, bool highAligned );
+
+/*!
+ * @function IOAF_Float32ToSwapIntJustified
+ * @abstract Converts 32-bit floating point to byte swapped integer samples narrower than their container
+ * @discussion As IOAF_Float32ToNativeIntJustified, with the container byte swapped.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ * @param bitDepth The number of significant bits in a sample, from 8 to bitWidth
+ * @param bitWidth The size of the container in bits: 16, 24 (packed) or 32
+ * @param highAligned true if the sample is in the high bits of the container, false if in the low bits
+ */
+extern void IOAF_Float32ToSwapIntJustified( const Float32 *src, void *dest, unsigned int count, unsigned int bitDepth, unsigned int bitWidth, bool highAligned );
+
+/*!
+ * @function IOAF_NativeIntJustifiedToFloat32
+ * @abstract Converts native endian integer samples narrower than their container to 32-bit floating point
+ * @discussion Only the bitDepth bits of the sample are used: the bits below a high aligned sample and above a low
+ * aligned one are ignored, whatever the hardware left in them.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ * @param bitDepth The number of significant bits in a sample, from 8 to bitWidth
+ * @param bitWidth The size of the container in bits: 16, 24 (packed) or 32
+ * @param highAligned true if the sample is in the high bits of the container, false if in the low bits
+ */
+extern void IOAF_NativeIntJustifiedToFloat32( const void *src, Float32 *dest, unsigned int count, unsigned int bitDepth, unsigned int bitWidth, bool highAligned );
+
+/*!
+ * @function IOAF_SwapIntJustifiedToFloat32
+ * @abstract Converts byte swapped integer samples narrower than their container to 32-bit floating point
+ * @discussion As IOAF_NativeIntJustifiedToFloat32, with the container byte swapped.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ * @param bitDepth The number of significant bits in a sample, from 8 to bitWidth
+ * @param bitWidth The size of the container in bits: 16, 24 (packed) or 32
+ * @param highAligned true if the sample is in the high bits of the container, false if in the low bits
+ */
+extern void IOAF_SwapIntJustifiedToFloat32( const void *src, Float32 *dest, unsigned int count, unsigned int bitDepth, unsigned int bitWidth, bool highAligned );
+
+/*!
+ * @function IOAF_Float32ToFloat64
+ * @abstract Converts 32-bit floating point to 64-bit floating point
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ */
+extern void IOAF_Float32ToFloat64( const Float32 *src, Float64 *dest, unsigned int count );
+
+/*!
+ * @function IOAF_Float64ToFloat32
+ * @abstract Converts 64-bit floating point to 32-bit floating point, rounding to nearest
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ */
+extern void IOAF_Float64ToFloat32( const Float64 *src, Float32 *dest, unsigned int count );
+
+/*!
+ * @function IOAF_Float32ToSInt8
+ * @abstract Converts 32-bit floating point to signed 8-bit integer
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ */
+extern void IOAF_Float32ToSInt8( const Float32 *src, SInt8 *dest, unsigned int count );
+
+/*!
+ * @function IOAF_Float32ToUInt8
+ * @abstract Converts 32-bit floating point to unsigned 8-bit integer, with silence at 128
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ */
+extern void IOAF_Float32ToUInt8( const Float32 *src, UInt8 *dest, unsigned int count );
+
+/*!
+ * @function IOAF_SInt8ToFloat32
+ * @abstract Converts signed 8-bit integer to 32-bit floating point
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ */
+extern void IOAF_SInt8ToFloat32( const SInt8 *src, Float32 *dest, unsigned int count );
+
+/*!
+ * @function IOAF_UInt8ToFloat32
+ * @abstract Converts unsigned 8-bit integer, with silence at 128, to 32-bit floating point
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ */
+extern void IOAF_UInt8ToFloat32( const UInt8 *src, Float32 *dest, unsigned int count );
+
+/*!
+ * @function IOAF_Float32ToALaw
+ * @abstract Converts 32-bit floating point to G.711 A-law
+ * @discussion The samples are rounded to 16 bits first; the result matches the usual 16-bit reference encoder.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ */
+extern void IOAF_Float32ToALaw( const Float32 *src, UInt8 *dest, unsigned int count );
+
+/*!
+ * @function IOAF_Float32ToMuLaw
+ * @abstract Converts 32-bit floating point to G.711 mu-law
+ * @discussion The samples are rounded to 16 bits first; the result matches the usual 16-bit reference encoder.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ */
+extern void IOAF_Float32ToMuLaw( const Float32 *src, UInt8 *dest, unsigned int count );
+
+/*!
+ * @function IOAF_ALawToFloat32
+ * @abstract Converts G.711 A-law to 32-bit floating point, scaled as 16-bit integer samples would be
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ */
+extern void IOAF_ALawToFloat32( const UInt8 *src, Float32 *dest, unsigned int count );
+
+/*!
+ * @function IOAF_MuLawToFloat32
+ * @abstract Converts G.711 mu-law to 32-bit floating point, scaled as 16-bit integer samples would be
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param count The number of items to convert
+ */
+extern void IOAF_MuLawToFloat32( const UInt8 *src, Float32 *dest, unsigned int count );
+
+/*!
+ * @function IOAF_GetPCMConverter
+ * @abstract Returns the converter between two linear PCM stream formats
+ * @discussion The converter is chosen from fNumericRepresentation, fBitWidth and fByteOrder. Signed and unsigned
+ * 8-bit, signed 16-, packed 24- and 32-bit integers and 32- and 64-bit floats are supported in either byte order. A
+ * sample narrower than its container (fBitDepth < fBitWidth) is not supported; convert it with the IntJustified
+ * routines. The common pairs use the optimized routines above, the
+ * rest a generic loop. Look the converter up when a format changes and call it for each buffer.
+ * @param srcFormat The format of the data to convert
+ * @param destFormat The format to convert to
+ * @result The converter, or NULL if either format is not supported
+ */
+extern IOAF_PCMConverterProc IOAF_GetPCMConverter( const IOAudioStreamFormat *srcFormat, const IOAudioStreamFormat *destFormat );
+
+/*!
+ * @function IOAF_MixFloat32
+ * @abstract Adds 32-bit floating point samples into a mix buffer (dest[i] += src[i]); the result is identical to a scalar float add
+ * @param src Pointer to the samples to mix in
+ * @param dest Pointer to the mix buffer
+ * @param count The number of samples to mix
+ */
+extern void IOAF_MixFloat32( const Float32 *src, Float32 *dest, unsigned int count );
+
+/*!
+ * @function IOAF_MixFloat32Multi
+ * @abstract Adds several buffers of 32-bit floating point samples into a mix buffer, one cache line of the mix buffer at a time
+ * @discussion The result is identical to calling IOAF_MixFloat32 once for each source, in order.
+ * @param src Array of pointers to the samples to mix in; all cover the same range of the mix buffer
+ * @param nSources The number of entries in src
+ * @param dest Pointer to the mix buffer
+ * @param count The number of samples to mix from each source
+ */
+extern void IOAF_MixFloat32Multi( const Float32 * const src[], unsigned int nSources, Float32 *dest, unsigned int count );
+
+/*!
+ * @function IOAF_MixFloat32Channels
+ * @abstract Adds some of the channels of a buffer of interleaved 32-bit floating point samples into a mix buffer
+ * @discussion Both buffers hold frameStride samples per frame; the other channels of the mix buffer are not touched.
+ * @param src Pointer to the samples to mix in
+ * @param dest Pointer to the mix buffer
+ * @param nFrames The number of sample frames to mix
+ * @param frameStride The number of channels in a frame
+ * @param firstChannel The first channel to mix
+ * @param nChannels The number of channels to mix, starting with firstChannel
+ */
+extern void IOAF_MixFloat32Channels( const Float32 *src, Float32 *dest, unsigned int nFrames, unsigned int frameStride, unsigned int firstChannel, unsigned int nChannels );
+
+/*!
+ * @function IOAF_Float32FindActiveChannels
+ * @abstract Widens a range of channels to include every channel with a non-zero sample in a buffer
+ * @discussion Only the channels outside the range are looked at, so once the range covers the frame this returns at once.
+ * Negative zero counts as zero; a NaN does not.
+ * @param src Pointer to the interleaved samples
+ * @param nFrames The number of sample frames to look at
+ * @param frameStride The number of channels in a frame
+ * @param firstChannel On entry the first channel of the range, on return the first channel of the widened range
+ * @param nChannels On entry the number of channels in the range (0 for none), on return the number in the widened range
+ */
+extern void IOAF_Float32FindActiveChannels( const Float32 *src, unsigned int nFrames, unsigned int frameStride, unsigned int *firstChannel, unsigned int *nChannels );
+
+/*!
+ * @function IOAF_Float32ToNativeInt16Channels
+ * @abstract Converts some of the channels of interleaved 32-bit floating point to native 16-bit integer
+ * @discussion Both buffers hold frameStride samples per frame; the other channels of dest are not touched.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param nFrames The number of sample frames to convert
+ * @param frameStride The number of channels in a frame
+ * @param firstChannel The first channel to convert
+ * @param nChannels The number of channels to convert, starting with firstChannel
+ */
+extern void IOAF_Float32ToNativeInt16Channels( const Float32 *src, SInt16 *dest, unsigned int nFrames, unsigned int frameStride, unsigned int firstChannel, unsigned int nChannels );
+
+/*!
+ * @function IOAF_Float32ToSwapInt16Channels
+ * @abstract Converts some of the channels of interleaved 32-bit floating point to non-native 16-bit integer
+ * @discussion Both buffers hold frameStride samples per frame; the other channels of dest are not touched.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param nFrames The number of sample frames to convert
+ * @param frameStride The number of channels in a frame
+ * @param firstChannel The first channel to convert
+ * @param nChannels The number of channels to convert, starting with firstChannel
+ */
+extern void IOAF_Float32ToSwapInt16Channels( const Float32 *src, SInt16 *dest, unsigned int nFrames, unsigned int frameStride, unsigned int firstChannel, unsigned int nChannels );
+
+/*!
+ * @function IOAF_Float32ToNativeInt24Channels
+ * @abstract Converts some of the channels of interleaved 32-bit floating point to native 24-bit integer
+ * @discussion Both buffers hold frameStride samples per frame; the other channels of dest are not touched.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param nFrames The number of sample frames to convert
+ * @param frameStride The number of channels in a frame
+ * @param firstChannel The first channel to convert
+ * @param nChannels The number of channels to convert, starting with firstChannel
+ */
+extern void IOAF_Float32ToNativeInt24Channels( const Float32 *src, UInt8 *dest, unsigned int nFrames, unsigned int frameStride, unsigned int firstChannel, unsigned int nChannels );
+
+/*!
+ * @function IOAF_Float32ToSwapInt24Channels
+ * @abstract Converts some of the channels of interleaved 32-bit floating point to non-native 24-bit integer
+ * @discussion Both buffers hold frameStride samples per frame; the other channels of dest are not touched.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param nFrames The number of sample frames to convert
+ * @param frameStride The number of channels in a frame
+ * @param firstChannel The first channel to convert
+ * @param nChannels The number of channels to convert, starting with firstChannel
+ */
+extern void IOAF_Float32ToSwapInt24Channels( const Float32 *src, UInt8 *dest, unsigned int nFrames, unsigned int frameStride, unsigned int firstChannel, unsigned int nChannels );
+
+/*!
+ * @function IOAF_Float32ToNativeInt32Channels
+ * @abstract Converts some of the channels of interleaved 32-bit floating point to native 32-bit integer
+ * @discussion Both buffers hold frameStride samples per frame; the other channels of dest are not touched.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param nFrames The number of sample frames to convert
+ * @param frameStride The number of channels in a frame
+ * @param firstChannel The first channel to convert
+ * @param nChannels The number of channels to convert, starting with firstChannel
+ */
+extern void IOAF_Float32ToNativeInt32Channels( const Float32 *src, SInt32 *dest, unsigned int nFrames, unsigned int frameStride, unsigned int firstChannel, unsigned int nChannels );
+
+/*!
+ * @function IOAF_Float32ToSwapInt32Channels
+ * @abstract Converts some of the channels of interleaved 32-bit floating point to non-native 32-bit integer
+ * @discussion Both buffers hold frameStride samples per frame; the other channels of dest are not touched.
+ * @param src Pointer to the data to convert
+ * @param dest Pointer to the converted data
+ * @param nFrames The number of sample frames to convert
+ * @param frameStride The number of channels in a frame
+ * @param firstChannel The first channel to convert
+ * @param nChannels The number of channels to convert, starting with firstChannel
+ */
+extern void IOAF_Float32ToSwapInt32Channels( const Float32 *src, SInt32 *dest, unsigned int nFrames, unsigned int frameStride, unsigned int firstChannel, unsigned int nChannels );
+
+/*!
+ * @function IOAF_Float32ToIntBatch
+ * @abstract Converts several 32-bit floating point buffers to integer in one call
+ * @discussion Gives the same result as calling IOAF_Float32ToNativeInt16 and the like once per job, but the setup
+ * those repeat is done once for the batch, which pays off on many small buffers such as one 2-channel stream per
+ * ADAT or MADI pair. Adjacent jobs with the same format are converted side by side. No job's dest may overlap
+ * another job's src or dest.
+ * @param jobs Array of buffers to convert
+ * @param nJobs The number of entries in jobs
+ */
+extern void IOAF_Float32ToIntBatch( const IOAF_ConversionJob *jobs, unsigned int nJobs );
+
 /*!
  * @function IOAF_bcopy_WriteCombine
  * @abstract An efficient bcopy from "write combine" memory to regular memory. It is safe to assume that all memory has been copied when the function has completed
@@ -210,4 +1039,130 @@ extern void IOAF_Float32ToSwapInt32( const Float32 *src, SInt32 *dest, unsigned
  */
 extern void IOAF_bcopy_WriteCombine(const void *src, void *dest, unsigned int count );
 
+/*!
+ * @function IOAF_bcopy_ToWriteCombine
+ * @abstract An efficient bcopy from regular memory to "write combine" memory, such as an output DMA buffer. The data is globally visible when the function has completed
+ * @param src Pointer to the data to copy
+ * @param dest Pointer to the write combined destination
+ * @param count The number of bytes to copy
+ */
+extern void IOAF_bcopy_ToWriteCombine(const void *src, void *dest, unsigned int count );
+
+/*!
+ * @function IOAF_DisableDenormals
+ * @abstract Makes floating point flush denormal results and treat denormal inputs as zero, on the current CPU
+ * @discussion Decaying signals (reverb tails, fade-outs) go denormal, and each denormal operation can cost a hundred
+ * cycles on x86. Does nothing on other architectures. Call it once for a whole IO cycle rather than per conversion, and
+ * restore the state on the same thread without blocking in between.
+ * @result The previous state, to be passed to IOAF_RestoreDenormals
+ */
+extern UInt32 IOAF_DisableDenormals();
+
+/*!
+ * @function IOAF_RestoreDenormals
+ * @abstract Puts back the floating point state returned by IOAF_DisableDenormals
+ * @param savedState The value IOAF_DisableDenormals returned
+ */
+extern void IOAF_RestoreDenormals( UInt32 savedState );
+
+/*!
+ * @function IOAF_Interleave32
+ * @abstract Interleaves one buffer of 32-bit samples per channel into a single buffer; no conversion is done
+ * @param src Array of nChannels pointers, one per channel
+ * @param dest Pointer to the interleaved data
+ * @param nChannels The number of channels
+ * @param nFrames The number of sample frames to convert
+ */
+extern void IOAF_Interleave32( const void * const src[], void *dest, unsigned int nChannels, unsigned int nFrames );
+
+/*!
+ * @function IOAF_Deinterleave32
+ * @abstract Splits a buffer of interleaved 32-bit samples into one buffer per channel; no conversion is done
+ * @param src Pointer to the interleaved data
+ * @param dest Array of nChannels pointers, one per channel
+ * @param nChannels The number of channels
+ * @param nFrames The number of sample frames to convert
+ */
+extern void IOAF_Deinterleave32( const void *src, void * const dest[], unsigned int nChannels, unsigned int nFrames );
+
+/*!
+ * @function IOAF_DeinterleaveFloat32ToNativeInt16
+ * @abstract Converts interleaved 32-bit floating point to native 16-bit integer, one buffer per channel
+ * @param src Pointer to the interleaved data to convert
+ * @param dest Array of nChannels pointers to the converted data, one per channel
+ * @param nChannels The number of channels
+ * @param nFrames The number of sample frames to convert
+ */
+extern void IOAF_DeinterleaveFloat32ToNativeInt16( const Float32 *src, SInt16 * const dest[], unsigned int nChannels, unsigned int nFrames );
+
+/*!
+ * @function IOAF_DeinterleaveFloat32ToNativeInt32
+ * @abstract Converts interleaved 32-bit floating point to native 32-bit integer, one buffer per channel
+ * @param src Pointer to the interleaved data to convert
+ * @param dest Array of nChannels pointers to the converted data, one per channel
+ * @param nChannels The number of channels
+ * @param nFrames The number of sample frames to convert
+ */
+extern void IOAF_DeinterleaveFloat32ToNativeInt32( const Float32 *src, SInt32 * const dest[], unsigned int nChannels, unsigned int nFrames );
+
+/*!
+ * @function IOAF_DeinterleaveFloat32ToSwapInt16
+ * @abstract Converts interleaved 32-bit floating point to non-native 16-bit integer, one buffer per channel
+ * @param src Pointer to the interleaved data to convert
+ * @param dest Array of nChannels pointers to the converted data, one per channel
+ * @param nChannels The number of channels
+ * @param nFrames The number of sample frames to convert
+ */
+extern void IOAF_DeinterleaveFloat32ToSwapInt16( const Float32 *src, SInt16 * const dest[], unsigned int nChannels, unsigned int nFrames );
+
+/*!
+ * @function IOAF_DeinterleaveFloat32ToSwapInt32
+ * @abstract Converts interleaved 32-bit floating point to non-native 32-bit integer, one buffer per channel
+ * @param src Pointer to the interleaved data to convert
+ * @param dest Array of nChannels pointers to the converted data, one per channel
+ * @param nChannels The number of channels
+ * @param nFrames The number of sample frames to convert
+ */
+extern void IOAF_DeinterleaveFloat32ToSwapInt32( const Float32 *src, SInt32 * const dest[], unsigned int nChannels, unsigned int nFrames );
+
+/*!
+ * @function IOAF_InterleaveNativeInt16ToFloat32
+ * @abstract Converts native 16-bit integer, one buffer per channel, to interleaved 32-bit float
+ * @param src Array of nChannels pointers to the data to convert, one per channel
+ * @param dest Pointer to the interleaved converted data
+ * @param nChannels The number of channels
+ * @param nFrames The number of sample frames to convert
+ */
+extern void IOAF_InterleaveNativeInt16ToFloat32( const SInt16 * const src[], Float32 *dest, unsigned int nChannels, unsigned int nFrames );
+
+/*!
+ * @function IOAF_InterleaveNativeInt32ToFloat32
+ * @abstract Converts native 32-bit integer, one buffer per channel, to interleaved 32-bit float
+ * @param src Array of nChannels pointers to the data to convert, one per channel
+ * @param dest Pointer to the interleaved converted data
+ * @param nChannels The number of channels
+ * @param nFrames The number of sample frames to convert
+ */
+extern void IOAF_InterleaveNativeInt32ToFloat32( const SInt32 * const src[], Float32 *dest, unsigned int nChannels, unsigned int nFrames );
+
+/*!
+ * @function IOAF_InterleaveSwapInt16ToFloat32
+ * @abstract Converts non-native 16-bit integer, one buffer per channel, to interleaved 32-bit float
+ * @param src Array of nChannels pointers to the data to convert, one per channel
+ * @param dest Pointer to the interleaved converted data
+ * @param nChannels The number of channels
+ * @param nFrames The number of sample frames to convert
+ */
+extern void IOAF_InterleaveSwapInt16ToFloat32( const SInt16 * const src[], Float32 *dest, unsigned int nChannels, unsigned int nFrames );
+
+/*!
+ * @function IOAF_InterleaveSwapInt32ToFloat32
+ * @abstract Converts non-native 32-bit integer, one buffer per channel, to interleaved 32-bit float
+ * @param src Array of nChannels pointers to the data to convert, one per channel
+ * @param dest Pointer to the interleaved converted data
+ * @param nChannels The number of channels
+ * @param nFrames The number of sample frames to convert
+ */
+extern void IOAF_InterleaveSwapInt32ToFloat32( const SInt32 * const src[], Float32 *dest, unsigned int nChannels, unsigned int nFrames );
+
 #endif // __IOAudioBlitterLibDispatch_h__
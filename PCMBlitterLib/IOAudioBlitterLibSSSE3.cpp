@@ -0,0 +1,327 @@
+/*	Copyright: 	© Copyright 2005-2010 Apple Computer, Inc. All rights reserved.
+ 
+ Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+ ("Apple") in consideration of your agreement to the following terms, and your
+ use, installation, modification or redistribution of this Apple software
+ constitutes acceptance of these terms.  If you do not agree with these terms,
+ please do not use, install, modify or redistribute this Apple software.
+ 
+ In consideration of your agreement to abide by the following terms, and subject
+ to these terms, Apple grants you a personal, non-exclusive license, under Apple’s
+ copyrights in this original Apple software (the "Apple Software"), to use,
+ reproduce, modify and redistribute the Apple Software, with or without
+ modifications, in source and/or binary forms; provided that if you redistribute
+ the Apple Software in its entirety and without modifications, you must retain
+ this notice and the following text and disclaimers in all such redistributions of
+ the Apple Software.  Neither the name, trademarks, service marks or logos of
+ Apple Computer, Inc. may be used to endorse or promote products derived from the
+ Apple Software without specific prior written permission from Apple.  Except as
+ expressly stated in this notice, no other rights or licenses, express or implied,
+ are granted by Apple herein, including but not limited to any patent rights that
+ may be infringed by your derivative works or by other works in which the Apple
+ Software may be incorporated.
+ 
+ The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+ WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+ WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+ COMBINATION WITH YOUR PRODUCTS.
+ 
+ IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+ OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+ (INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*=============================================================================
+	IOAudioBlitterLibSSSE3.cpp
+
+=============================================================================*/
+
+#include <TargetConditionals.h>
+
+#if __i386__ || __x86_64__
+#define _MM_MALLOC_H_INCLUDED 1	// we don't want this header
+#include <tmmintrin.h>
+#include "IOAudioBlitterLib.h"
+#include <libkern/OSByteOrder.h>
+
+/*
+	SSSE3 versions of the packed 24-bit blitters and the G.711 decoders.
+
+	pshufb lets us move the three bytes of each sample into or out of a 32-bit lane directly,
+	in either byte order, instead of shifting and masking.
+
+	This file is compiled with -mssse3. Nothing in here may be called unless the dispatcher
+	has verified that the CPU supports SSSE3; see IOAudioBlitterLibDispatch.cpp.
+
+	Each iteration handles 8 samples (24 packed bytes) as two 16-byte loads or stores at byte
+	offsets 0 and 8, so memory past the last sample is never read or written. The second half
+	is shuffled with an extra offset of 4 bytes to compensate.
+*/
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Float -> Int24
+
+// Round at 24-bit precision (scale by 2^23), then gather the low three bytes of each 32-bit lane.
+#define F32TOI24(x) \
+	vf##x = _mm_mul_ps(vf##x, vscale);			\
+	vf##x = _mm_add_ps(vf##x, vround);			\
+	vf##x = _mm_max_ps(vf##x, vmin);			\
+	vf##x = _mm_min_ps(vf##x, vmax);			\
+	vi##x = _mm_cvtps_epi32(vf##x);
+
+#define STOREI24(d) \
+	vi0 = _mm_shuffle_epi8(vi0, vshuf0);		\
+	vi1 = _mm_shuffle_epi8(vi1, vshuf1);		\
+	vi1 = _mm_or_si128(vi1, _mm_srli_si128(vi0, 8));	\
+	_mm_storeu_si128((__m128i *)(d), vi0);		\
+	_mm_storeu_si128((__m128i *)((d) + 8), vi1);
+
+static inline void Float32ToInt24_SSSE3( const Float32 *src, UInt8 *dst, unsigned int numToConvert, const __m128i vshuf0, const __m128i vshuf1 )
+{
+	const Float32 *src0 = src;
+	UInt8 *dst0 = dst;
+	unsigned int count = numToConvert;
+
+	// vector -- requires 8+ samples
+	ROUNDMODE_NEG_INF
+	const __m128 vround = _mm_set1_ps(0.5f);
+	const __m128 vmin = _mm_set1_ps(-8388608.0f);
+	const __m128 vmax = _mm_set1_ps(8388607.0f);
+	const __m128 vscale = _mm_set1_ps(8388608.0f);
+	__m128 vf0, vf1;
+	__m128i vi0, vi1;
+
+	int falign = (uintptr_t)src & 0xF;
+
+	if (falign != 0) {
+		// do one unaligned conversion
+		vf0 = _mm_loadu_ps(src);
+		vf1 = _mm_loadu_ps(src+4);
+		F32TOI24(0)
+		F32TOI24(1)
+		STOREI24(dst)
+
+		// and advance such that the source floats are aligned
+		unsigned int n = (16 - falign) / 4;
+		src += n;
+		dst += 3*n;	// bytes
+		count -= n;
+	}
+
+	while (count >= 8) {
+		vf0 = _mm_load_ps(src);
+		vf1 = _mm_load_ps(src+4);
+		F32TOI24(0)
+		F32TOI24(1)
+		STOREI24(dst)	// destination always unaligned
+
+		src += 8;
+		dst += 24;	// bytes
+		count -= 8;
+	}
+
+	if (count > 0) {
+		// unaligned cleanup -- just do one unaligned vector at the end
+		src = src0 + numToConvert - 8;
+		dst = dst0 + 3*numToConvert - 24;
+		vf0 = _mm_loadu_ps(src);
+		vf1 = _mm_loadu_ps(src+4);
+		F32TOI24(0)
+		F32TOI24(1)
+		STOREI24(dst)
+	}
+	RESTORE_ROUNDMODE
+}
+
+void Float32ToNativeInt24_SSSE3( const Float32 *src, UInt8 *dst, unsigned int numToConvert )
+{
+	if (numToConvert < 8) {
+		Float32ToNativeInt24_Portable(src, dst, numToConvert);
+		return;
+	}
+	const __m128i vshuf0 = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+	const __m128i vshuf1 = _mm_setr_epi8(-1, -1, -1, -1, 0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14);
+	Float32ToInt24_SSSE3(src, dst, numToConvert, vshuf0, vshuf1);
+}
+
+void Float32ToSwapInt24_SSSE3( const Float32 *src, UInt8 *dst, unsigned int numToConvert )
+{
+	if (numToConvert < 8) {
+		Float32ToSwapInt24_Portable(src, dst, numToConvert);
+		return;
+	}
+	const __m128i vshuf0 = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+	const __m128i vshuf1 = _mm_setr_epi8(-1, -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12);
+	Float32ToInt24_SSSE3(src, dst, numToConvert, vshuf0, vshuf1);
+}
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Int24 -> Float
+
+// Expand packed 3-byte samples into the high three bytes of 32-bit ints, then scale by 2^-31.
+#define I24TOF32(s) \
+	vi0 = _mm_loadu_si128((__m128i const *)(s));			\
+	vi1 = _mm_loadu_si128((__m128i const *)((s) + 8));		\
+	vi0 = _mm_shuffle_epi8(vi0, vshuf0);		\
+	vi1 = _mm_shuffle_epi8(vi1, vshuf1);		\
+	vf0 = _mm_mul_ps(_mm_cvtepi32_ps(vi0), vscale);	\
+	vf1 = _mm_mul_ps(_mm_cvtepi32_ps(vi1), vscale);
+
+static inline void Int24ToFloat32_SSSE3( const UInt8 *src, Float32 *dst, unsigned int numToConvert, const __m128i vshuf0, const __m128i vshuf1 )
+{
+	const UInt8 *src0 = src;
+	Float32 *dst0 = dst;
+	unsigned int count = numToConvert;
+
+	// vector -- requires 8+ samples
+	const __m128 vscale = _mm_set1_ps(1.0/2147483648.0f);
+	__m128 vf0, vf1;
+	__m128i vi0, vi1;
+
+	int falign = (uintptr_t)dst & 0xF;
+
+	if (falign != 0) {
+		// do one unaligned conversion
+		I24TOF32(src)
+		_mm_storeu_ps(dst, vf0);
+		_mm_storeu_ps(dst+4, vf1);
+
+		// and advance such that the destination floats are aligned
+		unsigned int n = (16 - falign) / 4;
+		src += 3*n;	// bytes
+		dst += n;
+		count -= n;
+	}
+
+	// source always unaligned, aligned stores
+	while (count >= 8) {
+		I24TOF32(src)
+		_mm_store_ps(dst, vf0);
+		_mm_store_ps(dst+4, vf1);
+		src += 24;	// bytes
+		dst += 8;
+		count -= 8;
+	}
+
+	if (count > 0) {
+		// unaligned cleanup -- just do one unaligned vector at the end
+		src = src0 + 3*numToConvert - 24;
+		dst = dst0 + numToConvert - 8;
+		I24TOF32(src)
+		_mm_storeu_ps(dst, vf0);
+		_mm_storeu_ps(dst+4, vf1);
+	}
+}
+
+void NativeInt24ToFloat32_SSSE3( const UInt8 *src, Float32 *dst, unsigned int numToConvert )
+{
+	if (numToConvert < 8) {
+		NativeInt24ToFloat32_Portable(src, dst, numToConvert);
+		return;
+	}
+	const __m128i vshuf0 = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+	const __m128i vshuf1 = _mm_setr_epi8(-1, 4, 5, 6, -1, 7, 8, 9, -1, 10, 11, 12, -1, 13, 14, 15);
+	Int24ToFloat32_SSSE3(src, dst, numToConvert, vshuf0, vshuf1);
+}
+
+void SwapInt24ToFloat32_SSSE3( const UInt8 *src, Float32 *dst, unsigned int numToConvert )
+{
+	if (numToConvert < 8) {
+		SwapInt24ToFloat32_Portable(src, dst, numToConvert);
+		return;
+	}
+	const __m128i vshuf0 = _mm_setr_epi8(-1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9);
+	const __m128i vshuf1 = _mm_setr_epi8(-1, 6, 5, 4, -1, 9, 8, 7, -1, 12, 11, 10, -1, 15, 14, 13);
+	Int24ToFloat32_SSSE3(src, dst, numToConvert, vshuf0, vshuf1);
+}
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark G.711 -> Float
+
+/*
+	Within a segment a G.711 code decodes linearly: mu-law is ((mantissa << 3) + 132) << segment,
+	less 132, and A-law is ((mantissa << 3) + add) * mul, with add and mul depending only on the
+	segment. pshufb looks both up for 16 codes at once, so the 256-entry tables aren't needed.
+*/
+
+static inline void LawToFloat32_SSSE3( const UInt8 *src, Float32 *dst, unsigned int numToConvert,
+	const __m128i vinvert, const __m128i vaddLUT, const __m128i vmulLUT, const __m128i vbias, const __m128i vsignFlip )
+{
+	const UInt8 *src0 = src;
+	Float32 *dst0 = dst;
+	unsigned int count = numToConvert;
+	const __m128 vscale = _mm_set1_ps(1.0f / 32768.0f);
+	const __m128i vzero = _mm_setzero_si128();
+
+	while (count > 0) {
+		if (count < 16) {
+			// unaligned cleanup -- just do one overlapping block at the end
+			src = src0 + numToConvert - 16;
+			dst = dst0 + numToConvert - 16;
+			count = 16;
+		}
+		__m128i b = _mm_xor_si128(_mm_loadu_si128((__m128i const *)src), vinvert);
+		__m128i seg = _mm_and_si128(_mm_srli_epi16(b, 4), _mm_set1_epi8(0x07));
+		__m128i mant = _mm_slli_epi16(_mm_and_si128(b, _mm_set1_epi8(0x0F)), 3);	// < 128, so no carry between bytes
+		__m128i add = _mm_shuffle_epi8(vaddLUT, seg);
+		__m128i mul = _mm_shuffle_epi8(vmulLUT, seg);
+		__m128i sign = _mm_and_si128(b, _mm_set1_epi8((char)0x80));
+
+		for (int half = 0; half < 2; ++half) {
+			__m128i m16, s16, v;
+			if (half == 0) {
+				m16 = _mm_add_epi16(_mm_unpacklo_epi8(mant, vzero), _mm_unpacklo_epi8(add, vzero));
+				m16 = _mm_mullo_epi16(m16, _mm_unpacklo_epi8(mul, vzero));
+				s16 = _mm_unpacklo_epi8(vzero, sign);
+			} else {
+				m16 = _mm_add_epi16(_mm_unpackhi_epi8(mant, vzero), _mm_unpackhi_epi8(add, vzero));
+				m16 = _mm_mullo_epi16(m16, _mm_unpackhi_epi8(mul, vzero));
+				s16 = _mm_unpackhi_epi8(vzero, sign);
+			}
+			m16 = _mm_sub_epi16(m16, vbias);
+			s16 = _mm_xor_si128(_mm_srai_epi16(s16, 15), vsignFlip);
+			v = _mm_sub_epi16(_mm_xor_si128(m16, s16), s16);
+			_mm_storeu_ps(dst + 8 * half, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)), vscale));
+			_mm_storeu_ps(dst + 8 * half + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)), vscale));
+		}
+		src += 16;
+		dst += 16;
+		count -= 16;
+	}
+}
+
+void ALawToFloat32_SSSE3( const UInt8 *src, Float32 *dst, unsigned int numToConvert )
+{
+	if (numToConvert < 16) {
+		ALawToFloat32_X86(src, dst, numToConvert);
+		return;
+	}
+	// even bits are inverted; the sign bit is set for positive samples
+	const __m128i vinvert = _mm_set1_epi8(0x55);
+	const __m128i vaddLUT = _mm_setr_epi8(4, (char)132, (char)132, (char)132, (char)132, (char)132, (char)132, (char)132, 0, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i vmulLUT = _mm_setr_epi8(2, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0, 0);
+	LawToFloat32_SSSE3(src, dst, numToConvert, vinvert, vaddLUT, vmulLUT, _mm_setzero_si128(), _mm_set1_epi16(-1));
+}
+
+void MuLawToFloat32_SSSE3( const UInt8 *src, Float32 *dst, unsigned int numToConvert )
+{
+	if (numToConvert < 16) {
+		MuLawToFloat32_X86(src, dst, numToConvert);
+		return;
+	}
+	// all bits are inverted; the sign bit is set for negative samples
+	const __m128i vinvert = _mm_set1_epi8((char)0xFF);
+	const __m128i vaddLUT = _mm_set1_epi8((char)132);
+	const __m128i vmulLUT = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, (char)128, 0, 0, 0, 0, 0, 0, 0, 0);
+	LawToFloat32_SSSE3(src, dst, numToConvert, vinvert, vaddLUT, vmulLUT, _mm_set1_epi16(132), _mm_setzero_si128());
+}
+
+
+#endif // __i386__ || __x86_64__
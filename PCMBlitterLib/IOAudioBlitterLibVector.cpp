@@ -0,0 +1,1693 @@
+/*	Copyright: 	© Copyright 2005-2010 Apple Computer, Inc. All rights reserved.
+ 
+ Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+ ("Apple") in consideration of your agreement to the following terms, and your
+ use, installation, modification or redistribution of this Apple software
+ constitutes acceptance of these terms.  If you do not agree with these terms,
+ please do not use, install, modify or redistribute this Apple software.
+ 
+ In consideration of your agreement to abide by the following terms, and subject
+ to these terms, Apple grants you a personal, non-exclusive license, under Apple’s
+ copyrights in this original Apple software (the "Apple Software"), to use,
+ reproduce, modify and redistribute the Apple Software, with or without
+ modifications, in source and/or binary forms; provided that if you redistribute
+ the Apple Software in its entirety and without modifications, you must retain
+ this notice and the following text and disclaimers in all such redistributions of
+ the Apple Software.  Neither the name, trademarks, service marks or logos of
+ Apple Computer, Inc. may be used to endorse or promote products derived from the
+ Apple Software without specific prior written permission from Apple.  Except as
+ expressly stated in this notice, no other rights or licenses, express or implied,
+ are granted by Apple herein, including but not limited to any patent rights that
+ may be infringed by your derivative works or by other works in which the Apple
+ Software may be incorporated.
+ 
+ The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+ WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+ WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+ COMBINATION WITH YOUR PRODUCTS.
+ 
+ IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+ OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+ (INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*=============================================================================
+	IOAudioBlitterLibVector.cpp
+
+=============================================================================*/
+
+#include <TargetConditionals.h>
+#include "IOAudioBlitterLib.h"
+
+#if PCMBLIT_VECTOR
+
+/*
+	Converters written with the GCC/Clang vector extensions instead of intrinsics, for the
+	architectures that have no hand-written backend. The compiler maps the 128-bit vectors below
+	onto whatever the target has (NEON, for example), or splits them if it has nothing that wide.
+
+	Every routine follows its SSE2 counterpart operation for operation, so the results are the same
+	as the x86 build's, bit for bit. There is no rounding mode to set, so the arithmetic that x86
+	does in round-toward-minus-infinity mode rounds down explicitly (vAddDown, vMulDown), conversions
+	floor, and the clips select the way maxps/minps do, so a NaN comes out at negative full scale.
+	Buffers too short for a vector go through the same double-precision loop as on x86. The dither
+	generators are stepped exactly as on x86, so a dither state moves between the two.
+
+	Needs __builtin_convertvector and __builtin_shufflevector: clang, or GCC 12 or later.
+*/
+
+// the rounding has to match the SSE2 code's, so no fused multiply-adds
+#if __clang__
+#pragma STDC FP_CONTRACT OFF
+#else
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+typedef Float32	vFloat32	__attribute__((vector_size(16)));
+typedef SInt32	vSInt32		__attribute__((vector_size(16)));
+typedef UInt32	vUInt32		__attribute__((vector_size(16)));
+typedef SInt16	vSInt16		__attribute__((vector_size(16)));
+typedef UInt8	vUInt8		__attribute__((vector_size(16)));
+typedef SInt8	vSInt8		__attribute__((vector_size(16)));
+typedef SInt16	vSInt16x4	__attribute__((vector_size(8)));
+typedef UInt8	vUInt8x4	__attribute__((vector_size(4)));
+typedef SInt32	vSInt32x8	__attribute__((vector_size(32)));
+typedef Float32	vFloat32x8	__attribute__((vector_size(32)));
+typedef Float64	vFloat64x4	__attribute__((vector_size(32)));
+typedef SInt64	vSInt64x4	__attribute__((vector_size(32)));
+typedef SInt32	vSInt32x16	__attribute__((vector_size(64)));
+typedef Float32	vFloat32x16	__attribute__((vector_size(64)));
+
+#define kMaxFloat32 2147483520.0f
+	// the biggest float below 2^31; see IOAudioBlitterLibX86.cpp
+
+// loads and stores have no alignment requirement
+template <class V>
+static inline V vload( const void *p )
+{
+	V v;
+	__builtin_memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+template <class V>
+static inline void vstore( void *p, V v )
+{
+	__builtin_memcpy(p, &v, sizeof(v));
+}
+
+static inline vFloat32 vsplat( Float32 f ) { return (vFloat32){ f, f, f, f }; }
+static inline vSInt32 vsplat( SInt32 i ) { return (vSInt32){ i, i, i, i }; }
+
+// a where the mask is set, b elsewhere
+static inline vFloat32 vselect( vSInt32 mask, vFloat32 a, vFloat32 b ) { return (vFloat32)(((vSInt32)a & mask) | ((vSInt32)b & ~mask)); }
+static inline vSInt32 vselect( vSInt32 mask, vSInt32 a, vSInt32 b ) { return (a & mask) | (b & ~mask); }
+
+// as maxps/minps: the second operand if either is a NaN
+static inline vFloat32 vmax( vFloat32 a, vFloat32 b ) { return vselect(a > b, a, b); }
+static inline vFloat32 vmin( vFloat32 a, vFloat32 b ) { return vselect(a < b, a, b); }
+
+// cvtps2dq under ROUNDMODE_NEG_INF; the conversion truncates, so step down where that rounded up
+static inline vSInt32 vfloor( vFloat32 v )
+{
+	vSInt32 t = __builtin_convertvector(v, vSInt32);
+	return t + (__builtin_convertvector(t, vFloat32) > v);
+}
+
+// the next float toward minus infinity, where the mask is set
+static inline vFloat32 vstepdown( vSInt32 mask, vFloat32 v )
+{
+	vSInt32 bits = (vSInt32)v;
+	return (vFloat32)(bits + (mask & ((v > vsplat(0.0f)) | 1)));	// -1 above zero, +1 at or below
+}
+
+// a + b under ROUNDMODE_NEG_INF: the exact error of the rounded sum (Knuth's two-sum) says
+// whether it rounded up, and a zero sum is -0 unless both were +0
+static inline vFloat32 vAddDown( vFloat32 a, vFloat32 b )
+{
+	vFloat32 s = a + b;
+	vFloat32 bb = s - a;
+	vFloat32 err = (a - (s - bb)) + (b - bb);
+	vSInt32 zeroSign = (s == vsplat(0.0f)) & ((vSInt32)a | (vSInt32)b) & vsplat((SInt32)0x80000000);
+	return vstepdown(err < vsplat(0.0f), (vFloat32)((vSInt32)s | zeroSign));
+}
+
+// a * b under ROUNDMODE_NEG_INF; a product of two floats is exact in a double
+static inline vFloat32 vMulDown( vFloat32 a, vFloat32 b )
+{
+	vFloat64x4 p = __builtin_convertvector(a, vFloat64x4) * __builtin_convertvector(b, vFloat64x4);
+	vFloat32 r = __builtin_convertvector(p, vFloat32);
+	vSInt64x4 up = __builtin_convertvector(r, vFloat64x4) > p;
+	return vstepdown(__builtin_convertvector(up, vSInt32), r);
+}
+
+// scale, add the bias (0.5 to round, or 0.5 plus dither) and clip, then floor
+static inline vSInt32 vFloatToInt( vFloat32 vf, Float32 scale, vFloat32 bias, Float32 maxValue )
+{
+	vf = vAddDown(vf * vsplat(scale), bias);
+	vf = vmax(vf, vsplat(-scale));
+	vf = vmin(vf, vsplat(maxValue));
+	return vfloor(vf);
+}
+
+static inline vUInt8 vbyteswap16( vUInt8 v ) { return __builtin_shufflevector(v, v, 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14); }
+static inline vUInt8 vbyteswap32( vUInt8 v ) { return __builtin_shufflevector(v, v, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12); }
+static inline vSInt16 vbyteswap16( vSInt16 v ) { return (vSInt16)vbyteswap16((vUInt8)v); }
+static inline vSInt32 vbyteswap32( vSInt32 v ) { return (vSInt32)vbyteswap32((vUInt8)v); }
+
+static inline vSInt32x8 vconcat( vSInt32 a, vSInt32 b ) { return __builtin_shufflevector(a, b, 0, 1, 2, 3, 4, 5, 6, 7); }
+static inline vSInt32 vlow( vSInt32x8 v ) { return __builtin_shufflevector(v, v, 0, 1, 2, 3); }
+static inline vSInt32 vhigh( vSInt32x8 v ) { return __builtin_shufflevector(v, v, 4, 5, 6, 7); }
+
+/*
+	Packed 24-bit samples. The shuffles are written in terms of the bytes of a sample's value, so
+	the same code serves either host byte order: LANE_BYTE is where value byte b (0 being the least
+	significant) sits in a 32-bit lane in memory, and VALUE_BYTE which value byte the k'th byte of
+	a packed sample holds. Sixteen samples are 48 bytes, spread over three vectors.
+*/
+
+#if TARGET_RT_BIG_ENDIAN
+#define LANE_BYTE(b)	(3 - (b))
+#define VALUE_BYTE(k)	(kSwap ? (k) : 2 - (k))
+#else
+#define LANE_BYTE(b)	(b)
+#define VALUE_BYTE(k)	(kSwap ? 2 - (k) : (k))
+#endif
+
+#define SHUFFLE16(M, a) M(0, a), M(1, a), M(2, a), M(3, a), M(4, a), M(5, a), M(6, a), M(7, a), \
+	M(8, a), M(9, a), M(10, a), M(11, a), M(12, a), M(13, a), M(14, a), M(15, a)
+
+// byte n of the a'th output vector, from lanes 4a to 4a + 7 (the pair of vectors a and a + 1)
+#define PACK24(n, a)	((((16 * (a) + (n)) / 3) - 4 * (a)) * 4 + LANE_BYTE(VALUE_BYTE((16 * (a) + (n)) % 3)))
+
+// byte n of the lanes for samples 4g to 4g + 3, from bytes 0-31 (g < 2) or 16-47 of the packed data;
+// the least significant byte of each lane is left over, and set from byte 0 to be masked off
+#define UNPACK24(n, g)	((LANE_BYTE((n) % 4) == 0) ? 0 : \
+	3 * (4 * (g) + (n) / 4) + VALUE_BYTE(LANE_BYTE((n) % 4) - 1) - ((g) >= 2 ? 16 : 0))
+
+// the samples are in the low 24 bits of each lane
+template <bool kSwap>
+static inline void Pack24_Vector( UInt8 *dst, const vSInt32 v[4] )
+{
+	vUInt8 p0 = (vUInt8)v[0], p1 = (vUInt8)v[1], p2 = (vUInt8)v[2], p3 = (vUInt8)v[3];
+
+	vstore(dst, __builtin_shufflevector(p0, p1, SHUFFLE16(PACK24, 0)));
+	vstore(dst + 16, __builtin_shufflevector(p1, p2, SHUFFLE16(PACK24, 1)));
+	vstore(dst + 32, __builtin_shufflevector(p2, p3, SHUFFLE16(PACK24, 2)));
+}
+
+// the samples come out left-justified
+template <bool kSwap>
+static inline void Unpack24_Vector( const UInt8 *src, vSInt32 v[4] )
+{
+	const vSInt32 mask = vsplat((SInt32)0xFFFFFF00);
+	vUInt8 a = vload<vUInt8>(src), b = vload<vUInt8>(src + 16), c = vload<vUInt8>(src + 32);
+
+	v[0] = (vSInt32)__builtin_shufflevector(a, b, SHUFFLE16(UNPACK24, 0)) & mask;
+	v[1] = (vSInt32)__builtin_shufflevector(a, b, SHUFFLE16(UNPACK24, 1)) & mask;
+	v[2] = (vSInt32)__builtin_shufflevector(b, c, SHUFFLE16(UNPACK24, 2)) & mask;
+	v[3] = (vSInt32)__builtin_shufflevector(b, c, SHUFFLE16(UNPACK24, 3)) & mask;
+}
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Float -> Int
+
+/*
+	Each block op converts kSamplesPerBlock floats, with one bias vector per 4 of them, and stores
+	the result. The sizes are the x86 block ops' for 16 and 24 bits, which the dither relies on.
+	A partial last block goes through a whole one on the stack.
+*/
+
+#define kMaxBiasVectors	4
+
+// The scalar loop of Float32ToNativeInt32_X86 and friends, for buffers shorter than a vector: the
+// sample is scaled to 32 bits in a double, rounded by adding round, clipped to maxValue and floored;
+// cvtsd2si's out-of-range result is negative full scale.
+static inline SInt32 Float32ToInt32Scalar_Vector( Float32 f, double round, double maxValue = 2147483648.0 )
+{
+	double d = (double)f * 2147483648.0 + round;
+	SInt32 i;
+
+	if (d > maxValue)
+		d = maxValue;
+	if (d >= 2147483648.0 - 1.0 - round)
+		return 0x7FFFFFFF;
+	if (!(d >= -2147483648.0))
+		return (SInt32)0x80000000;
+	i = (SInt32)d;
+	return (i > d) ? i - 1 : i;
+}
+
+class Float32ToNativeInt16VectorOp {
+public:
+	static const unsigned int kBytesPerSample = 2, kSamplesPerBlock = 8, kMinVectorSamples = 8;
+	static inline SInt16 convert1(Float32 f) { return (SInt16)(Float32ToInt32Scalar_Vector(f, 32768.0) >> 16); }
+	static inline void convertScalar(const Float32 *src, UInt8 *dst, unsigned int count)
+	{
+		for (unsigned int i = 0; i < count; ++i)
+			((SInt16 *)dst)[i] = convert1(src[i]);
+	}
+	static inline vSInt16 convert8(const Float32 *src, const vFloat32 bias[])
+	{
+		vSInt32 v0 = vFloatToInt(vload<vFloat32>(src), 32768.0f, bias[0], 32767.0f);
+		vSInt32 v1 = vFloatToInt(vload<vFloat32>(src + 4), 32768.0f, bias[1], 32767.0f);
+		return __builtin_convertvector(vconcat(v0, v1), vSInt16);
+	}
+	static inline void convert(const Float32 *src, const vFloat32 bias[], UInt8 *dst) { vstore(dst, convert8(src, bias)); }
+};
+
+class Float32ToSwapInt16VectorOp : public Float32ToNativeInt16VectorOp {
+public:
+	static inline void convertScalar(const Float32 *src, UInt8 *dst, unsigned int count)
+	{
+		for (unsigned int i = 0; i < count; ++i)
+			((SInt16 *)dst)[i] = OSSwapInt16(convert1(src[i]));
+	}
+	static inline void convert(const Float32 *src, const vFloat32 bias[], UInt8 *dst) { vstore(dst, vbyteswap16(convert8(src, bias))); }
+};
+
+class Float32ToNativeInt32VectorOp {
+public:
+	static const unsigned int kBytesPerSample = 4, kSamplesPerBlock = 8, kMinVectorSamples = 4;
+	static inline void convertScalar(const Float32 *src, UInt8 *dst, unsigned int count)
+	{
+		for (unsigned int i = 0; i < count; ++i)
+			((SInt32 *)dst)[i] = Float32ToInt32Scalar_Vector(src[i], 0.5, kMaxFloat32);
+	}
+	static inline void convert(const Float32 *src, const vFloat32 bias[], UInt8 *dst)
+	{
+		vstore(dst, vFloatToInt(vload<vFloat32>(src), 2147483648.0f, bias[0], kMaxFloat32));
+		vstore(dst + 16, vFloatToInt(vload<vFloat32>(src + 4), 2147483648.0f, bias[1], kMaxFloat32));
+	}
+};
+
+class Float32ToSwapInt32VectorOp : public Float32ToNativeInt32VectorOp {
+public:
+	static inline void convertScalar(const Float32 *src, UInt8 *dst, unsigned int count)
+	{
+		for (unsigned int i = 0; i < count; ++i)
+			((SInt32 *)dst)[i] = OSSwapInt32(Float32ToInt32Scalar_Vector(src[i], 0.5, kMaxFloat32));
+	}
+	static inline void convert(const Float32 *src, const vFloat32 bias[], UInt8 *dst)
+	{
+		vstore(dst, vbyteswap32(vFloatToInt(vload<vFloat32>(src), 2147483648.0f, bias[0], kMaxFloat32)));
+		vstore(dst + 16, vbyteswap32(vFloatToInt(vload<vFloat32>(src + 4), 2147483648.0f, bias[1], kMaxFloat32)));
+	}
+};
+
+// as Float32ToNativeInt24_Portable, which rounds at 32 bits
+template <bool kSwap>
+class Float32ToInt24VectorOp {
+public:
+	static const unsigned int kBytesPerSample = 3, kSamplesPerBlock = 16, kMinVectorSamples = 8;
+	static inline void convertScalar(const Float32 *src, UInt8 *dst, unsigned int count)
+	{
+		for (unsigned int i = 0; i < count; ++i, dst += 3) {
+			SInt32 v = Float32ToInt32Scalar_Vector(src[i], 128.0) >> 8;
+			dst[VALUE_BYTE(0)] = (UInt8)v;
+			dst[VALUE_BYTE(1)] = (UInt8)(v >> 8);
+			dst[VALUE_BYTE(2)] = (UInt8)(v >> 16);
+		}
+	}
+	static inline void convert(const Float32 *src, const vFloat32 bias[], UInt8 *dst)
+	{
+		vSInt32 v[4];
+		for (int i = 0; i < 4; ++i)
+			v[i] = vFloatToInt(vload<vFloat32>(src + 4 * i), 8388608.0f, bias[i], 8388607.0f);
+		Pack24_Vector<kSwap>(dst, v);
+	}
+};
+
+typedef Float32ToInt24VectorOp<false> Float32ToNativeInt24VectorOp;
+typedef Float32ToInt24VectorOp<true> Float32ToSwapInt24VectorOp;
+
+template <class Op>
+static inline void ConvertPartialBlock_Vector( const Float32 *src, UInt8 *dst, unsigned int count, const vFloat32 bias[] )
+{
+	Float32 tmp[Op::kSamplesPerBlock];
+	UInt8 out[Op::kSamplesPerBlock * Op::kBytesPerSample];
+	unsigned int i;
+
+	for (i = 0; i < Op::kSamplesPerBlock; ++i)
+		tmp[i] = (i < count) ? src[i] : 0.0f;
+	Op::convert(tmp, bias, out);
+	for (i = 0; i < count * Op::kBytesPerSample; ++i)
+		dst[i] = out[i];
+}
+
+template <class Op>
+static inline void Float32ToInt_Vector( const Float32 *src, UInt8 *dst, unsigned int numToConvert )
+{
+	const vFloat32 half = vsplat(0.5f), bias[kMaxBiasVectors] = { half, half, half, half };
+	unsigned int count = numToConvert;
+
+	if (count < Op::kMinVectorSamples) {
+		Op::convertScalar(src, dst, count);
+		return;
+	}
+	for ( ; count >= Op::kSamplesPerBlock; count -= Op::kSamplesPerBlock) {
+		Op::convert(src, bias, dst);
+		src += Op::kSamplesPerBlock;
+		dst += Op::kSamplesPerBlock * Op::kBytesPerSample;
+	}
+	if (count)
+		ConvertPartialBlock_Vector<Op>(src, dst, count, bias);
+}
+
+void Float32ToNativeInt16_Vector( const Float32 *src, SInt16 *dst, unsigned int numToConvert )
+{
+	Float32ToInt_Vector<Float32ToNativeInt16VectorOp>(src, (UInt8 *)dst, numToConvert);
+}
+
+void Float32ToSwapInt16_Vector( const Float32 *src, SInt16 *dst, unsigned int numToConvert )
+{
+	Float32ToInt_Vector<Float32ToSwapInt16VectorOp>(src, (UInt8 *)dst, numToConvert);
+}
+
+void Float32ToNativeInt24_Vector( const Float32 *src, UInt8 *dst, unsigned int numToConvert )
+{
+	Float32ToInt_Vector<Float32ToNativeInt24VectorOp>(src, dst, numToConvert);
+}
+
+void Float32ToSwapInt24_Vector( const Float32 *src, UInt8 *dst, unsigned int numToConvert )
+{
+	Float32ToInt_Vector<Float32ToSwapInt24VectorOp>(src, dst, numToConvert);
+}
+
+void Float32ToNativeInt32_Vector( const Float32 *src, SInt32 *dst, unsigned int numToConvert )
+{
+	Float32ToInt_Vector<Float32ToNativeInt32VectorOp>(src, (UInt8 *)dst, numToConvert);
+}
+
+void Float32ToSwapInt32_Vector( const Float32 *src, SInt32 *dst, unsigned int numToConvert )
+{
+	Float32ToInt_Vector<Float32ToSwapInt32VectorOp>(src, (UInt8 *)dst, numToConvert);
+}
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Int -> Float
+
+// Each op converts kSamplesPerBlock samples; every integer is exact in a float except 32-bit ones,
+// which round to nearest as cvtdq2ps does.
+
+class NativeInt16ToFloat32VectorOp {
+public:
+	static const unsigned int kBytesPerSample = 2, kSamplesPerBlock = 8;
+	static inline vSInt16 load(const UInt8 *src) { return vload<vSInt16>(src); }
+	static inline void convert(const UInt8 *src, Float32 *dst)
+	{
+		const Float32 scale = 1.0f / 32768.0f;
+		vstore(dst, __builtin_convertvector(load(src), vFloat32x8) * (vFloat32x8){ scale, scale, scale, scale, scale, scale, scale, scale });
+	}
+};
+
+class SwapInt16ToFloat32VectorOp {
+public:
+	static const unsigned int kBytesPerSample = 2, kSamplesPerBlock = 8;
+	static inline void convert(const UInt8 *src, Float32 *dst)
+	{
+		const Float32 scale = 1.0f / 32768.0f;
+		vstore(dst, __builtin_convertvector(vbyteswap16(vload<vSInt16>(src)), vFloat32x8) * (vFloat32x8){ scale, scale, scale, scale, scale, scale, scale, scale });
+	}
+};
+
+template <bool kSwap>
+class Int32ToFloat32VectorOp {
+public:
+	static const unsigned int kBytesPerSample = 4, kSamplesPerBlock = 8;
+	static inline vFloat32 convert4(vSInt32 v)
+	{
+		return __builtin_convertvector(kSwap ? vbyteswap32(v) : v, vFloat32) * vsplat(1.0f / 2147483648.0f);
+	}
+	static inline void convert(const UInt8 *src, Float32 *dst)
+	{
+		vstore(dst, convert4(vload<vSInt32>(src)));
+		vstore(dst + 4, convert4(vload<vSInt32>(src + 16)));
+	}
+};
+
+template <bool kSwap>
+class Int24ToFloat32VectorOp {
+public:
+	static const unsigned int kBytesPerSample = 3, kSamplesPerBlock = 16;
+	static inline void convert(const UInt8 *src, Float32 *dst)
+	{
+		vSInt32 v[4];
+		Unpack24_Vector<kSwap>(src, v);
+		for (int i = 0; i < 4; ++i)
+			vstore(dst + 4 * i, __builtin_convertvector(v[i], vFloat32) * vsplat(1.0f / 2147483648.0f));
+	}
+};
+
+template <class Op>
+static inline void IntToFloat32_Vector( const UInt8 *src, Float32 *dst, unsigned int numToConvert )
+{
+	unsigned int count = numToConvert;
+	unsigned int i;
+
+	for ( ; count >= Op::kSamplesPerBlock; count -= Op::kSamplesPerBlock) {
+		Op::convert(src, dst);
+		src += Op::kSamplesPerBlock * Op::kBytesPerSample;
+		dst += Op::kSamplesPerBlock;
+	}
+	if (count) {
+		UInt8 tmp[Op::kSamplesPerBlock * Op::kBytesPerSample];
+		Float32 out[Op::kSamplesPerBlock];
+
+		for (i = 0; i < Op::kSamplesPerBlock * Op::kBytesPerSample; ++i)
+			tmp[i] = (i < count * Op::kBytesPerSample) ? src[i] : 0;
+		Op::convert(tmp, out);
+		for (i = 0; i < count; ++i)
+			dst[i] = out[i];
+	}
+}
+
+void NativeInt16ToFloat32_Vector( const SInt16 *src, Float32 *dst, unsigned int numToConvert )
+{
+	IntToFloat32_Vector<NativeInt16ToFloat32VectorOp>((const UInt8 *)src, dst, numToConvert);
+}
+
+void SwapInt16ToFloat32_Vector( const SInt16 *src, Float32 *dst, unsigned int numToConvert )
+{
+	IntToFloat32_Vector<SwapInt16ToFloat32VectorOp>((const UInt8 *)src, dst, numToConvert);
+}
+
+void NativeInt24ToFloat32_Vector( const UInt8 *src, Float32 *dst, unsigned int numToConvert )
+{
+	IntToFloat32_Vector<Int24ToFloat32VectorOp<false> >(src, dst, numToConvert);
+}
+
+void SwapInt24ToFloat32_Vector( const UInt8 *src, Float32 *dst, unsigned int numToConvert )
+{
+	IntToFloat32_Vector<Int24ToFloat32VectorOp<true> >(src, dst, numToConvert);
+}
+
+void NativeInt32ToFloat32_Vector( const SInt32 *src, Float32 *dst, unsigned int numToConvert )
+{
+	IntToFloat32_Vector<Int32ToFloat32VectorOp<false> >((const UInt8 *)src, dst, numToConvert);
+}
+
+void SwapInt32ToFloat32_Vector( const SInt32 *src, Float32 *dst, unsigned int numToConvert )
+{
+	IntToFloat32_Vector<Int32ToFloat32VectorOp<true> >((const UInt8 *)src, dst, numToConvert);
+}
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Interleave / Deinterleave
+
+/*
+	As in IOAudioBlitterLibX86.cpp: blocks of 4 frames, mono and stereo with one shuffle pair, any
+	other channel count 4 x 4 at a time with a transpose, and the channels and frames left over one
+	sample at a time through the same element ops.
+*/
+
+static inline void Transpose4_Vector( vFloat32 &v0, vFloat32 &v1, vFloat32 &v2, vFloat32 &v3 )
+{
+	vFloat32 t0 = __builtin_shufflevector(v0, v1, 0, 4, 1, 5);
+	vFloat32 t1 = __builtin_shufflevector(v2, v3, 0, 4, 1, 5);
+	vFloat32 t2 = __builtin_shufflevector(v0, v1, 2, 6, 3, 7);
+	vFloat32 t3 = __builtin_shufflevector(v2, v3, 2, 6, 3, 7);
+	v0 = __builtin_shufflevector(t0, t1, 0, 1, 4, 5);
+	v1 = __builtin_shufflevector(t0, t1, 2, 3, 6, 7);
+	v2 = __builtin_shufflevector(t2, t3, 0, 1, 4, 5);
+	v3 = __builtin_shufflevector(t2, t3, 2, 3, 6, 7);
+}
+
+// Float32 -> integer ops: convert() produces 32-bit lanes, store4()/store1() write 4 or 1 samples.
+class DeinterleaveRaw32VectorOp {
+public:
+	typedef UInt32 int_type;
+	static inline vSInt32 convert(vFloat32 vf) { return (vSInt32)vf; }
+	static inline void store4(int_type *p, vSInt32 vi) { vstore(p, vi); }
+	static inline void store1(int_type *p, vSInt32 vi) { *p = vi[0]; }
+};
+
+template <bool kSwap>
+class Float32ToInt32InterleaveVectorOp {
+public:
+	typedef SInt32 int_type;
+	static inline vSInt32 convert(vFloat32 vf)
+	{
+		vSInt32 vi = vFloatToInt(vf, 2147483648.0f, vsplat(0.5f), kMaxFloat32);
+		return kSwap ? vbyteswap32(vi) : vi;
+	}
+	static inline void store4(int_type *p, vSInt32 vi) { vstore(p, vi); }
+	static inline void store1(int_type *p, vSInt32 vi) { *p = vi[0]; }
+};
+
+// the swap is done on the value, so that the narrowing store keeps the right bytes
+template <bool kSwap>
+class Float32ToInt16InterleaveVectorOp {
+public:
+	typedef SInt16 int_type;
+	static inline vSInt32 convert(vFloat32 vf)
+	{
+		vSInt32 vi = vFloatToInt(vf, 32768.0f, vsplat(0.5f), 32767.0f);
+		return kSwap ? (((vi & 0xFF) << 8) | ((vi >> 8) & 0xFF)) : vi;
+	}
+	static inline void store4(int_type *p, vSInt32 vi) { vstore(p, __builtin_convertvector(vi, vSInt16x4)); }
+	static inline void store1(int_type *p, vSInt32 vi) { *p = (SInt16)vi[0]; }
+};
+
+// integer -> Float32 ops: load4()/load1() read 4 or 1 samples and return them as floats.
+class InterleaveRaw32VectorOp {
+public:
+	typedef UInt32 int_type;
+	static inline vFloat32 load4(const int_type *p) { return vload<vFloat32>(p); }
+	static inline Float32 load1(const int_type *p) { return vload4to1(p); }
+	static inline Float32 vload4to1(const int_type *p)
+	{
+		Float32 f;
+		__builtin_memcpy(&f, p, sizeof(f));
+		return f;
+	}
+};
+
+template <bool kSwap>
+class Int32ToFloat32InterleaveVectorOp {
+public:
+	typedef SInt32 int_type;
+	static inline vFloat32 load4(const int_type *p) { return Int32ToFloat32VectorOp<kSwap>::convert4(vload<vSInt32>(p)); }
+	static inline Float32 load1(const int_type *p) { return (Float32)(SInt32)(kSwap ? OSSwapInt32(*p) : *p) * (1.0f / 2147483648.0f); }
+};
+
+template <bool kSwap>
+class Int16ToFloat32InterleaveVectorOp {
+public:
+	typedef SInt16 int_type;
+	static inline vFloat32 load4(const int_type *p)
+	{
+		vSInt32 vi = __builtin_convertvector(vload<vSInt16x4>(p), vSInt32);
+		if (kSwap)
+			vi = (vi << 24 >> 16) | ((vi >> 8) & 0xFF);	// swapped and sign-extended
+		return __builtin_convertvector(vi, vFloat32) * vsplat(1.0f / 32768.0f);
+	}
+	static inline Float32 load1(const int_type *p) { return (Float32)(SInt16)(kSwap ? OSSwapInt16(*p) : *p) * (1.0f / 32768.0f); }
+};
+
+// ___________________________________________________________________________________________________
+// interleaved Float32 -> one buffer per channel
+template <class Op>
+static inline void DeinterleaveFromFloat32_Vector( const Float32 *src, typename Op::int_type * const dst[], unsigned int nChannels, unsigned int nFrames )
+{
+	unsigned int frames4 = nFrames & ~3U;
+	unsigned int f, c;
+
+	for (f = 0; f < frames4; f += 4) {
+		const Float32 *s = src + f * nChannels;
+		c = 0;
+		if (nChannels == 1) {
+			Op::store4(dst[0] + f, Op::convert(vload<vFloat32>(s)));
+			continue;
+		}
+		if (nChannels == 2) {
+			vFloat32 v0 = vload<vFloat32>(s);		// L0 R0 L1 R1
+			vFloat32 v1 = vload<vFloat32>(s + 4);	// L2 R2 L3 R3
+			Op::store4(dst[0] + f, Op::convert(__builtin_shufflevector(v0, v1, 0, 2, 4, 6)));
+			Op::store4(dst[1] + f, Op::convert(__builtin_shufflevector(v0, v1, 1, 3, 5, 7)));
+			continue;
+		}
+		for ( ; c + 4 <= nChannels; c += 4) {
+			// rows are frames, columns are channels; transposed, each row is one channel
+			vFloat32 v0 = vload<vFloat32>(s + c);
+			vFloat32 v1 = vload<vFloat32>(s + c + nChannels);
+			vFloat32 v2 = vload<vFloat32>(s + c + 2 * nChannels);
+			vFloat32 v3 = vload<vFloat32>(s + c + 3 * nChannels);
+			Transpose4_Vector(v0, v1, v2, v3);
+			Op::store4(dst[c] + f, Op::convert(v0));
+			Op::store4(dst[c+1] + f, Op::convert(v1));
+			Op::store4(dst[c+2] + f, Op::convert(v2));
+			Op::store4(dst[c+3] + f, Op::convert(v3));
+		}
+		for ( ; c < nChannels; c++) {
+			for (unsigned int i = 0; i < 4; i++)
+				Op::store1(dst[c] + f + i, Op::convert((vFloat32){ s[i * nChannels + c], 0.0f, 0.0f, 0.0f }));
+		}
+	}
+	// leftover frames
+	for ( ; f < nFrames; f++) {
+		const Float32 *s = src + f * nChannels;
+		for (c = 0; c < nChannels; c++)
+			Op::store1(dst[c] + f, Op::convert((vFloat32){ s[c], 0.0f, 0.0f, 0.0f }));
+	}
+}
+
+// ___________________________________________________________________________________________________
+// one buffer per channel -> interleaved Float32
+template <class Op>
+static inline void InterleaveToFloat32_Vector( const typename Op::int_type * const src[], Float32 *dst, unsigned int nChannels, unsigned int nFrames )
+{
+	unsigned int frames4 = nFrames & ~3U;
+	unsigned int f, c;
+
+	for (f = 0; f < frames4; f += 4) {
+		Float32 *d = dst + f * nChannels;
+		c = 0;
+		if (nChannels == 1) {
+			vstore(d, Op::load4(src[0] + f));
+			continue;
+		}
+		if (nChannels == 2) {
+			vFloat32 vA = Op::load4(src[0] + f);
+			vFloat32 vB = Op::load4(src[1] + f);
+			vstore(d, __builtin_shufflevector(vA, vB, 0, 4, 1, 5));
+			vstore(d + 4, __builtin_shufflevector(vA, vB, 2, 6, 3, 7));
+			continue;
+		}
+		for ( ; c + 4 <= nChannels; c += 4) {
+			// rows are channels, columns are frames; transposed, each row is one frame
+			vFloat32 v0 = Op::load4(src[c] + f);
+			vFloat32 v1 = Op::load4(src[c+1] + f);
+			vFloat32 v2 = Op::load4(src[c+2] + f);
+			vFloat32 v3 = Op::load4(src[c+3] + f);
+			Transpose4_Vector(v0, v1, v2, v3);
+			vstore(d + c, v0);
+			vstore(d + c + nChannels, v1);
+			vstore(d + c + 2 * nChannels, v2);
+			vstore(d + c + 3 * nChannels, v3);
+		}
+		for ( ; c < nChannels; c++) {
+			for (unsigned int i = 0; i < 4; i++)
+				d[i * nChannels + c] = Op::load1(src[c] + f + i);
+		}
+	}
+	// leftover frames
+	for ( ; f < nFrames; f++) {
+		Float32 *d = dst + f * nChannels;
+		for (c = 0; c < nChannels; c++)
+			d[c] = Op::load1(src[c] + f);
+	}
+}
+
+// ___________________________________________________________________________________________________
+
+void Interleave32_Vector( const void * const src[], void *dst, unsigned int nChannels, unsigned int nFrames )
+{
+	InterleaveToFloat32_Vector<InterleaveRaw32VectorOp>((const UInt32 * const *)src, (Float32 *)dst, nChannels, nFrames);
+}
+
+void Deinterleave32_Vector( const void *src, void * const dst[], unsigned int nChannels, unsigned int nFrames )
+{
+	DeinterleaveFromFloat32_Vector<DeinterleaveRaw32VectorOp>((const Float32 *)src, (UInt32 * const *)dst, nChannels, nFrames);
+}
+
+void DeinterleaveFloat32ToNativeInt16_Vector( const Float32 *src, SInt16 * const dst[], unsigned int nChannels, unsigned int nFrames )
+{
+	DeinterleaveFromFloat32_Vector<Float32ToInt16InterleaveVectorOp<false> >(src, dst, nChannels, nFrames);
+}
+
+void DeinterleaveFloat32ToSwapInt16_Vector( const Float32 *src, SInt16 * const dst[], unsigned int nChannels, unsigned int nFrames )
+{
+	DeinterleaveFromFloat32_Vector<Float32ToInt16InterleaveVectorOp<true> >(src, dst, nChannels, nFrames);
+}
+
+void DeinterleaveFloat32ToNativeInt32_Vector( const Float32 *src, SInt32 * const dst[], unsigned int nChannels, unsigned int nFrames )
+{
+	DeinterleaveFromFloat32_Vector<Float32ToInt32InterleaveVectorOp<false> >(src, dst, nChannels, nFrames);
+}
+
+void DeinterleaveFloat32ToSwapInt32_Vector( const Float32 *src, SInt32 * const dst[], unsigned int nChannels, unsigned int nFrames )
+{
+	DeinterleaveFromFloat32_Vector<Float32ToInt32InterleaveVectorOp<true> >(src, dst, nChannels, nFrames);
+}
+
+void InterleaveNativeInt16ToFloat32_Vector( const SInt16 * const src[], Float32 *dst, unsigned int nChannels, unsigned int nFrames )
+{
+	InterleaveToFloat32_Vector<Int16ToFloat32InterleaveVectorOp<false> >(src, dst, nChannels, nFrames);
+}
+
+void InterleaveSwapInt16ToFloat32_Vector( const SInt16 * const src[], Float32 *dst, unsigned int nChannels, unsigned int nFrames )
+{
+	InterleaveToFloat32_Vector<Int16ToFloat32InterleaveVectorOp<true> >(src, dst, nChannels, nFrames);
+}
+
+void InterleaveNativeInt32ToFloat32_Vector( const SInt32 * const src[], Float32 *dst, unsigned int nChannels, unsigned int nFrames )
+{
+	InterleaveToFloat32_Vector<Int32ToFloat32InterleaveVectorOp<false> >(src, dst, nChannels, nFrames);
+}
+
+void InterleaveSwapInt32ToFloat32_Vector( const SInt32 * const src[], Float32 *dst, unsigned int nChannels, unsigned int nFrames )
+{
+	InterleaveToFloat32_Vector<Int32ToFloat32InterleaveVectorOp<true> >(src, dst, nChannels, nFrames);
+}
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Mix
+
+// One add per sample in source order, as MixFloat32_X86 and MixFloat32Multi_X86 do.
+
+void MixFloat32_Vector( const Float32 *src, Float32 *dst, unsigned int count )
+{
+	for ( ; count >= 8; count -= 8) {
+		vstore(dst, vload<vFloat32>(dst) + vload<vFloat32>(src));
+		vstore(dst + 4, vload<vFloat32>(dst + 4) + vload<vFloat32>(src + 4));
+		src += 8;
+		dst += 8;
+	}
+	while (count > 0) {
+		*dst++ += *src++;
+		--count;
+	}
+}
+
+void MixFloat32Multi_Vector( const Float32 * const src[], unsigned int nSources, Float32 *dst, unsigned int count )
+{
+	unsigned int i = 0;
+
+	// one cache line of the mix buffer per iteration
+	for ( ; i + 16 <= count; i += 16) {
+		vFloat32 vd0 = vload<vFloat32>(dst + i);
+		vFloat32 vd1 = vload<vFloat32>(dst + i + 4);
+		vFloat32 vd2 = vload<vFloat32>(dst + i + 8);
+		vFloat32 vd3 = vload<vFloat32>(dst + i + 12);
+		for (unsigned int s = 0; s < nSources; ++s) {
+			const Float32 *p = src[s] + i;
+			vd0 += vload<vFloat32>(p);
+			vd1 += vload<vFloat32>(p + 4);
+			vd2 += vload<vFloat32>(p + 8);
+			vd3 += vload<vFloat32>(p + 12);
+		}
+		vstore(dst + i, vd0);
+		vstore(dst + i + 4, vd1);
+		vstore(dst + i + 8, vd2);
+		vstore(dst + i + 12, vd3);
+	}
+
+	for ( ; i < count; ++i) {
+		Float32 f = dst[i];
+		for (unsigned int s = 0; s < nSources; ++s)
+			f += src[s][i];
+		dst[i] = f;
+	}
+}
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Float -> Int with gain
+
+// See Float32ToIntWithGain_X86: the gains for a block come from a table repeating gain[] or, with
+// more than kMaxRepeatedGainChannels channels, are gathered where a block wraps.
+
+#define kMaxRepeatedGainChannels	16
+
+template <class Op>
+static inline void Float32ToIntWithGain_Vector( const Float32 *src, UInt8 *dst, unsigned int numToConvert, const Float32 *gain, unsigned int nChannels )
+{
+	static const unsigned int kBlock = Op::kSamplesPerBlock;
+	const vFloat32 half = vsplat(0.5f), bias[kMaxBiasVectors] = { half, half, half, half };
+	Float32 table[kMaxRepeatedGainChannels + kBlock];
+	Float32 wrapped[kBlock];
+	Float32 scaled[kBlock];
+	unsigned int count = numToConvert;
+	unsigned int channel = 0;
+	unsigned int i;
+
+	if (nChannels == 0)
+		return;
+
+	bool repeated = (nChannels <= kMaxRepeatedGainChannels);
+	if (repeated) {
+		for (i = 0; i < nChannels + kBlock; ++i)
+			table[i] = gain[i % nChannels];
+	}
+
+	while (count > 0) {
+		const Float32 *g;
+		unsigned int n = (count < kBlock) ? count : kBlock;
+
+		if (repeated)
+			g = table + channel;
+		else if (channel + kBlock <= nChannels)
+			g = gain + channel;
+		else {
+			for (i = 0; i < kBlock; ++i)
+				wrapped[i] = gain[(channel + i) % nChannels];
+			g = wrapped;
+		}
+
+		if (n == kBlock) {
+			for (i = 0; i < kBlock; i += 4)
+				vstore(scaled + i, vMulDown(vload<vFloat32>(src + i), vload<vFloat32>(g + i)));
+			Op::convert(scaled, bias, dst);
+		} else {
+			for (i = 0; i < kBlock; ++i)
+				scaled[i] = (i < n) ? src[i] : 0.0f;
+			for (i = 0; i < kBlock; i += 4)
+				vstore(scaled + i, vMulDown(vload<vFloat32>(scaled + i), vload<vFloat32>(g + i)));
+			ConvertPartialBlock_Vector<Op>(scaled, dst, n, bias);
+		}
+
+		src += n;
+		dst += n * Op::kBytesPerSample;
+		count -= n;
+		channel = (channel + n) % nChannels;
+	}
+}
+
+void Float32ToNativeInt16WithGain_Vector( const Float32 *src, SInt16 *dst, unsigned int numToConvert, const Float32 *gain, unsigned int nChannels )
+{
+	Float32ToIntWithGain_Vector<Float32ToNativeInt16VectorOp>(src, (UInt8 *)dst, numToConvert, gain, nChannels);
+}
+
+void Float32ToSwapInt16WithGain_Vector( const Float32 *src, SInt16 *dst, unsigned int numToConvert, const Float32 *gain, unsigned int nChannels )
+{
+	Float32ToIntWithGain_Vector<Float32ToSwapInt16VectorOp>(src, (UInt8 *)dst, numToConvert, gain, nChannels);
+}
+
+void Float32ToNativeInt24WithGain_Vector( const Float32 *src, UInt8 *dst, unsigned int numToConvert, const Float32 *gain, unsigned int nChannels )
+{
+	Float32ToIntWithGain_Vector<Float32ToNativeInt24VectorOp>(src, dst, numToConvert, gain, nChannels);
+}
+
+void Float32ToSwapInt24WithGain_Vector( const Float32 *src, UInt8 *dst, unsigned int numToConvert, const Float32 *gain, unsigned int nChannels )
+{
+	Float32ToIntWithGain_Vector<Float32ToSwapInt24VectorOp>(src, dst, numToConvert, gain, nChannels);
+}
+
+void Float32ToNativeInt32WithGain_Vector( const Float32 *src, SInt32 *dst, unsigned int numToConvert, const Float32 *gain, unsigned int nChannels )
+{
+	Float32ToIntWithGain_Vector<Float32ToNativeInt32VectorOp>(src, (UInt8 *)dst, numToConvert, gain, nChannels);
+}
+
+void Float32ToSwapInt32WithGain_Vector( const Float32 *src, SInt32 *dst, unsigned int numToConvert, const Float32 *gain, unsigned int nChannels )
+{
+	Float32ToIntWithGain_Vector<Float32ToSwapInt32VectorOp>(src, (UInt8 *)dst, numToConvert, gain, nChannels);
+}
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Float -> Int dithered
+
+/*
+	See Float32ToIntDithered_X86 for how the noise is made and shaped. The bias vectors are built
+	from the values of the random numbers rather than from their bytes in memory, so they come out
+	the same on either byte order.
+*/
+
+#define kDitherChunkSamples	256
+#define kDitherGenerators	4
+#define kDitherRoundSamples	32		// one DitherBias8_Vector step of each generator
+
+static inline vUInt32 Xorshift32_Vector( vUInt32 &s )
+{
+	s ^= s << 13;
+	s ^= s >> 17;
+	s ^= s << 5;
+	return s;
+}
+
+// 8 samples of TPDF noise in LSB units, plus 0.5: the low halves of the four 32-bit numbers, then the high halves
+static inline void DitherBias8_Vector( vUInt32 &s, vFloat32 bias[2] )
+{
+	const vUInt32 byteMask = { 0x00FF00FF, 0x00FF00FF, 0x00FF00FF, 0x00FF00FF };
+	const vUInt32 halfMask = { 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF };
+	const vUInt32 exponent = { 0x47000000, 0x47000000, 0x47000000, 0x47000000 };
+	const vFloat32 offset = vsplat(32768.0f + 127.0f / 256.0f);
+	vUInt32 r = Xorshift32_Vector(s);
+	vUInt32 u = (r & byteMask) + ((r >> 8) & byteMask);		// a + b in each half
+
+	bias[0] = (vFloat32)((u & halfMask) | exponent) - offset;
+	bias[1] = (vFloat32)((u >> 16) | exponent) - offset;
+}
+
+// hands out DitherBias8_Vector's noise a vector at a time
+static inline vFloat32 NextDitherBias_Vector( vUInt32 &s, vFloat32 bias[2], unsigned int &left )
+{
+	if (left == 0) {
+		DitherBias8_Vector(s, bias);
+		left = 2;
+	}
+	return bias[--left];
+}
+
+// plain TPDF; the generators are copied into locals so that they stay in registers
+template <class Op>
+static inline void Float32ToIntTPDF_Vector( const Float32 *src, UInt8 *dst, unsigned int count, vUInt32 s[kDitherGenerators] )
+{
+	vFloat32 bias[kDitherRoundSamples / 4];
+	vUInt32 s0 = s[0], s1 = s[1], s2 = s[2], s3 = s[3];
+	unsigned int b;
+
+	for ( ; count >= kDitherRoundSamples; count -= kDitherRoundSamples) {
+		DitherBias8_Vector(s0, bias);
+		DitherBias8_Vector(s1, bias + 2);
+		DitherBias8_Vector(s2, bias + 4);
+		DitherBias8_Vector(s3, bias + 6);
+		for (b = 0; b < kDitherRoundSamples; b += Op::kSamplesPerBlock) {
+			Op::convert(src, bias + b / 4, dst);
+			src += Op::kSamplesPerBlock;
+			dst += Op::kSamplesPerBlock * Op::kBytesPerSample;
+		}
+	}
+	if (count) {
+		const unsigned int padded = (count + Op::kSamplesPerBlock - 1) & ~(Op::kSamplesPerBlock - 1);
+
+		for (b = 0; b < padded; b += 8)
+			DitherBias8_Vector(s0, bias + b / 4);
+		for (b = 0; b + Op::kSamplesPerBlock <= count; b += Op::kSamplesPerBlock) {
+			Op::convert(src, bias + b / 4, dst);
+			src += Op::kSamplesPerBlock;
+			dst += Op::kSamplesPerBlock * Op::kBytesPerSample;
+		}
+		if (b < count)
+			ConvertPartialBlock_Vector<Op>(src, dst, count - b, bias + b / 4);
+	}
+	s[0] = s0;
+	s[1] = s1;
+	s[2] = s2;
+	s[3] = s3;
+}
+
+template <class Op>
+static inline void Float32ToIntDithered_Vector( const Float32 *src, UInt8 *dst, unsigned int numToConvert, unsigned int nChannels, UInt32 seed[], Float32 *shapingError )
+{
+	const Float32 scale = (Op::kBytesPerSample == 2) ? 32768.0f : 8388608.0f;
+	const vFloat32 vscale = vsplat(scale);
+	const vFloat32 lsb = vsplat(1.0f / scale);
+	const vFloat32 minusOne = vsplat(-1.0f), one = vsplat(1.0f);
+	Float32 tmp[4];
+	vUInt32 s[kDitherGenerators];
+	unsigned int count = numToConvert;
+	unsigned int n, i, c, g;
+
+	if (nChannels == 0)
+		return;
+	if (nChannels > kDitherChunkSamples)
+		shapingError = NULL;
+	for (g = 0; g < kDitherGenerators; ++g)
+		s[g] = vload<vUInt32>(seed + 4 * g);
+
+	if (!shapingError) {
+		Float32ToIntTPDF_Vector<Op>(src, dst, count, s);
+	} else {
+		const vFloat32 half = vsplat(0.5f), bias[kMaxBiasVectors] = { half, half, half, half };
+		Float32 chunk[kDitherChunkSamples + 4];	// a frame's last vector may spill over
+		const unsigned int chunkFrames = (nChannels < kDitherChunkSamples) ? kDitherChunkSamples / nChannels : 1;
+		vFloat32 next[2];
+		unsigned int nextLeft = 0;
+
+		while (count > 0) {
+			n = (count < chunkFrames * nChannels) ? count : chunkFrames * nChannels;
+			for (i = 0; i < n; i += nChannels) {
+				for (c = 0; c < nChannels && i + c < n; c += 4) {
+					vFloat32 x, v, q;
+
+					if (i + c + 4 <= count)
+						x = vload<vFloat32>(src + i + c);
+					else {
+						unsigned int k;
+						for (k = 0; k < 4; ++k)
+							tmp[k] = (i + c + k < count) ? src[i + c + k] : 0.0f;
+						x = vload<vFloat32>(tmp);
+					}
+					// clip first, so a full scale or NaN input can't run the error away
+					x = vmin(vmax(x, minusOne), one) * vscale;
+					v = vAddDown(x, -vload<vFloat32>(shapingError + c));
+					q = __builtin_convertvector(vfloor(vAddDown(v, NextDitherBias_Vector(s[0], next, nextLeft))), vFloat32);
+					vstore(shapingError + c, vAddDown(q, -v));
+					vstore(chunk + i + c, q * lsb);
+				}
+			}
+			// the samples are whole LSBs now, so the plain conversion keeps them
+			for (i = 0; i + Op::kSamplesPerBlock <= n; i += Op::kSamplesPerBlock)
+				Op::convert(chunk + i, bias, dst + i * Op::kBytesPerSample);
+			if (i < n)
+				ConvertPartialBlock_Vector<Op>(chunk + i, dst + i * Op::kBytesPerSample, n - i, bias);
+			src += n;
+			dst += n * Op::kBytesPerSample;
+			count -= n;
+		}
+	}
+
+	for (g = 0; g < kDitherGenerators; ++g)
+		vstore(seed + 4 * g, s[g]);
+}
+
+void Float32ToNativeInt16Dithered_Vector( const Float32 *src, SInt16 *dst, unsigned int numToConvert, unsigned int nChannels, UInt32 seed[], Float32 *shapingError )
+{
+	Float32ToIntDithered_Vector<Float32ToNativeInt16VectorOp>(src, (UInt8 *)dst, numToConvert, nChannels, seed, shapingError);
+}
+
+void Float32ToSwapInt16Dithered_Vector( const Float32 *src, SInt16 *dst, unsigned int numToConvert, unsigned int nChannels, UInt32 seed[], Float32 *shapingError )
+{
+	Float32ToIntDithered_Vector<Float32ToSwapInt16VectorOp>(src, (UInt8 *)dst, numToConvert, nChannels, seed, shapingError);
+}
+
+void Float32ToNativeInt24Dithered_Vector( const Float32 *src, UInt8 *dst, unsigned int numToConvert, unsigned int nChannels, UInt32 seed[], Float32 *shapingError )
+{
+	Float32ToIntDithered_Vector<Float32ToNativeInt24VectorOp>(src, dst, numToConvert, nChannels, seed, shapingError);
+}
+
+void Float32ToSwapInt24Dithered_Vector( const Float32 *src, UInt8 *dst, unsigned int numToConvert, unsigned int nChannels, UInt32 seed[], Float32 *shapingError )
+{
+	Float32ToIntDithered_Vector<Float32ToSwapInt24VectorOp>(src, dst, numToConvert, nChannels, seed, shapingError);
+}
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Gain ramp
+
+// See GainRamp_X86.
+
+template <bool kExponential>
+static inline Float32 GainRamp_Vector( const Float32 *src, Float32 *dest, unsigned int nChannels, unsigned int nFrames, Float32 gain, Float32 step )
+{
+	Float32 g = gain;
+	unsigned int n = 0;
+
+	if (nChannels == 1 || nChannels == 2) {
+		const unsigned int k = 4 / nChannels;		// frames per vector
+		const vFloat32 frameOf = (nChannels == 1) ? (vFloat32){ 0.0f, 1.0f, 2.0f, 3.0f } : (vFloat32){ 0.0f, 0.0f, 1.0f, 1.0f };
+		vFloat32 gv = vsplat(0.0f), mul = vsplat(0.0f);
+
+		if (kExponential) {
+			Float32 s2 = step * step;
+			gv = (nChannels == 1) ? (vFloat32){ gain, gain * step, gain * s2, gain * s2 * step } : (vFloat32){ gain, gain, gain * step, gain * step };
+			mul = vsplat((nChannels == 1) ? s2 * s2 : s2);
+		}
+		for ( ; n + k <= nFrames; n += k) {
+			if (!kExponential)
+				gv = vsplat(gain + (Float32)n * step) + frameOf * vsplat(step);
+			vstore(dest, vload<vFloat32>(src) * gv);
+			if (kExponential)
+				gv *= mul;
+			src += 4;
+			dest += 4;
+		}
+		if (kExponential)
+			g = gv[0];
+	}
+
+	for ( ; n < nFrames; ++n) {
+		if (!kExponential)
+			g = gain + (Float32)n * step;
+		vFloat32 gv = vsplat(g);
+		unsigned int c = 0;
+		for ( ; c + 4 <= nChannels; c += 4)
+			vstore(dest + c, vload<vFloat32>(src + c) * gv);
+		for ( ; c < nChannels; ++c)
+			dest[c] = src[c] * g;
+		if (kExponential)
+			g *= step;
+		src += nChannels;
+		dest += nChannels;
+	}
+
+	return kExponential ? g : gain + (Float32)nFrames * step;
+}
+
+// a ramp that doesn't move: one multiply per sample, nothing at all for unity gain in place
+static inline void ScaleFloat32_Vector( const Float32 *src, Float32 *dest, unsigned int count, Float32 gain )
+{
+	if (gain == 1.0f && src == dest)
+		return;
+
+	vFloat32 gv = vsplat(gain);
+	for ( ; count >= 4; count -= 4) {
+		vstore(dest, vload<vFloat32>(src) * gv);
+		src += 4;
+		dest += 4;
+	}
+	while (count--)
+		*dest++ = *src++ * gain;
+}
+
+Float32 GainRampFloat32_Vector( const Float32 *src, Float32 *dest, unsigned int nChannels, unsigned int nFrames, Float32 gain, Float32 step, bool exponential )
+{
+	if (exponential ? (step == 1.0f) : (step == 0.0f)) {
+		ScaleFloat32_Vector(src, dest, nChannels * nFrames, gain);
+		return gain;
+	}
+	if (exponential)
+		return GainRamp_Vector<true>(src, dest, nChannels, nFrames, gain, step);
+	return GainRamp_Vector<false>(src, dest, nChannels, nFrames, gain, step);
+}
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Int -> Int
+
+/*
+	As IntToInt_X86: each lane op moves 16 samples between memory and four vectors of left-justified
+	32-bit lanes, narrowing rounds and clips as TIntToIntBlitter does, and TIntToIntBlitter does the
+	last (count % 16) samples. In-place conversion between equal widths is safe.
+*/
+
+template <bool kSwap, class Native, class Swap>
+struct TLaneTraits { typedef Native traits; };
+
+template <class Native, class Swap>
+struct TLaneTraits<true, Native, Swap> { typedef Swap traits; };
+
+template <bool kSwap>
+class Int16VectorLaneOp {
+public:
+	typedef typename TLaneTraits<kSwap, PCMSInt16Native, PCMSInt16Swap>::traits traits;
+	static const unsigned int kBytesPerSample = 2;
+	static inline void load(const UInt8 *src, vSInt32 v[4])
+	{
+		for (int i = 0; i < 2; ++i) {
+			vSInt16 a = vload<vSInt16>(src + 16 * i);
+			vSInt32x8 w = __builtin_convertvector(kSwap ? vbyteswap16(a) : a, vSInt32x8) << 16;
+			v[2 * i] = vlow(w);
+			v[2 * i + 1] = vhigh(w);
+		}
+	}
+	// round to 16 bits; only a lane that rounds up past full scale needs clipping
+	static inline vSInt32 round16(vSInt32 v)
+	{
+		const vSInt32 max16 = vsplat((SInt32)0x7FFF);
+		v = ((v >> 15) + 1) >> 1;
+		return vselect(v > max16, max16, v);
+	}
+	static inline void store(UInt8 *dst, const vSInt32 v[4])
+	{
+		for (int i = 0; i < 2; ++i) {
+			vSInt16 a = __builtin_convertvector(vconcat(round16(v[2 * i]), round16(v[2 * i + 1])), vSInt16);
+			vstore(dst + 16 * i, kSwap ? vbyteswap16(a) : a);
+		}
+	}
+};
+
+template <bool kSwap>
+class Int32VectorLaneOp {
+public:
+	typedef typename TLaneTraits<kSwap, PCMSInt32Native, PCMSInt32Swap>::traits traits;
+	static const unsigned int kBytesPerSample = 4;
+	static inline void load(const UInt8 *src, vSInt32 v[4])
+	{
+		for (int i = 0; i < 4; ++i) {
+			v[i] = vload<vSInt32>(src + 16 * i);
+			if (kSwap)
+				v[i] = vbyteswap32(v[i]);
+		}
+	}
+	static inline void store(UInt8 *dst, const vSInt32 v[4])
+	{
+		for (int i = 0; i < 4; ++i)
+			vstore(dst + 16 * i, kSwap ? vbyteswap32(v[i]) : v[i]);
+	}
+};
+
+template <bool kSwap>
+class Int24VectorLaneOp {
+public:
+	typedef typename TLaneTraits<kSwap, PCMSInt24Native, PCMSInt24Swap>::traits traits;
+	static const unsigned int kBytesPerSample = 3;
+	static inline void load(const UInt8 *src, vSInt32 v[4]) { Unpack24_Vector<kSwap>(src, v); }
+	// round to 24 bits and clip the lanes that round up past full scale
+	static inline void store(UInt8 *dst, const vSInt32 v[4])
+	{
+		const vSInt32 max24 = vsplat((SInt32)0x7FFFFF);
+		vSInt32 r[4];
+		for (int i = 0; i < 4; ++i) {
+			r[i] = ((v[i] >> 7) + 1) >> 1;
+			r[i] = vselect(r[i] > max24, max24, r[i]);
+		}
+		Pack24_Vector<kSwap>(dst, r);
+	}
+};
+
+template <class SrcOp, class DestOp>
+static inline void IntToInt_Vector( const void *vsrc, void *vdst, unsigned int numToConvert )
+{
+	const UInt8 *src = (const UInt8 *)vsrc;
+	UInt8 *dst = (UInt8 *)vdst;
+	unsigned int count = numToConvert;
+	vSInt32 v[4];
+
+	while (count >= 16) {
+		SrcOp::load(src, v);
+		DestOp::store(dst, v);
+		src += 16 * SrcOp::kBytesPerSample;
+		dst += 16 * DestOp::kBytesPerSample;
+		count -= 16;
+	}
+	TIntToIntBlitter<typename SrcOp::traits, typename DestOp::traits>::ConvertSamples(src, dst, count);
+}
+
+typedef Int16VectorLaneOp<false>	NativeInt16VectorLaneOp;
+typedef Int16VectorLaneOp<true>		SwapInt16VectorLaneOp;
+typedef Int24VectorLaneOp<false>	NativeInt24VectorLaneOp;
+typedef Int24VectorLaneOp<true>		SwapInt24VectorLaneOp;
+typedef Int32VectorLaneOp<false>	NativeInt32VectorLaneOp;
+typedef Int32VectorLaneOp<true>		SwapInt32VectorLaneOp;
+
+// ___________________________________________________________________________________________________
+// pure byte swaps: same width, opposite byte order
+
+void ByteSwapInt16_Vector( const void *src, void *dst, unsigned int numToConvert )
+{
+	const UInt8 *s = (const UInt8 *)src;
+	UInt8 *d = (UInt8 *)dst;
+	unsigned int count = numToConvert;
+
+	for ( ; count >= 8; count -= 8) {
+		vstore(d, vbyteswap16(vload<vUInt8>(s)));
+		s += 16;
+		d += 16;
+	}
+	TIntToIntBlitter<PCMSInt16Native, PCMSInt16Swap>::ConvertSamples(s, d, count);
+}
+
+void ByteSwapInt24_Vector( const void *src, void *dst, unsigned int numToConvert )
+{
+	IntToInt_Vector<NativeInt24VectorLaneOp, SwapInt24VectorLaneOp>(src, dst, numToConvert);
+}
+
+void ByteSwapInt32_Vector( const void *src, void *dst, unsigned int numToConvert )
+{
+	const UInt8 *s = (const UInt8 *)src;
+	UInt8 *d = (UInt8 *)dst;
+	unsigned int count = numToConvert;
+
+	for ( ; count >= 4; count -= 4) {
+		vstore(d, vbyteswap32(vload<vUInt8>(s)));
+		s += 16;
+		d += 16;
+	}
+	TIntToIntBlitter<PCMSInt32Native, PCMSInt32Swap>::ConvertSamples(s, d, count);
+}
+
+// ___________________________________________________________________________________________________
+// width changes
+
+#define DEFINE_INT_TO_INT_VECTOR(Src, Dest) \
+void Src##To##Dest##_Vector( const void *src, void *dst, unsigned int numToConvert ) \
+{ \
+	IntToInt_Vector<Src##VectorLaneOp, Dest##VectorLaneOp>(src, dst, numToConvert); \
+}
+
+DEFINE_INT_TO_INT_VECTOR(NativeInt16, NativeInt24)
+DEFINE_INT_TO_INT_VECTOR(NativeInt16, SwapInt24)
+DEFINE_INT_TO_INT_VECTOR(SwapInt16, NativeInt24)
+DEFINE_INT_TO_INT_VECTOR(SwapInt16, SwapInt24)
+DEFINE_INT_TO_INT_VECTOR(NativeInt16, NativeInt32)
+DEFINE_INT_TO_INT_VECTOR(NativeInt16, SwapInt32)
+DEFINE_INT_TO_INT_VECTOR(SwapInt16, NativeInt32)
+DEFINE_INT_TO_INT_VECTOR(SwapInt16, SwapInt32)
+
+DEFINE_INT_TO_INT_VECTOR(NativeInt24, NativeInt16)
+DEFINE_INT_TO_INT_VECTOR(NativeInt24, SwapInt16)
+DEFINE_INT_TO_INT_VECTOR(SwapInt24, NativeInt16)
+DEFINE_INT_TO_INT_VECTOR(SwapInt24, SwapInt16)
+DEFINE_INT_TO_INT_VECTOR(NativeInt24, NativeInt32)
+DEFINE_INT_TO_INT_VECTOR(NativeInt24, SwapInt32)
+DEFINE_INT_TO_INT_VECTOR(SwapInt24, NativeInt32)
+DEFINE_INT_TO_INT_VECTOR(SwapInt24, SwapInt32)
+
+DEFINE_INT_TO_INT_VECTOR(NativeInt32, NativeInt16)
+DEFINE_INT_TO_INT_VECTOR(NativeInt32, SwapInt16)
+DEFINE_INT_TO_INT_VECTOR(SwapInt32, NativeInt16)
+DEFINE_INT_TO_INT_VECTOR(SwapInt32, SwapInt16)
+DEFINE_INT_TO_INT_VECTOR(NativeInt32, NativeInt24)
+DEFINE_INT_TO_INT_VECTOR(NativeInt32, SwapInt24)
+DEFINE_INT_TO_INT_VECTOR(SwapInt32, NativeInt24)
+DEFINE_INT_TO_INT_VECTOR(SwapInt32, SwapInt24)
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Float64, 8-bit and G.711
+
+/*
+	As in IOAudioBlitterLibX86.cpp, including the float-exponent G.711 encoders. The decoders
+	compute the 16-bit values with per-lane shifts, as the G.711 reference decoders do, instead of
+	using tables.
+*/
+
+void Float32ToFloat64_Vector( const Float32 *src, Float64 *dst, unsigned int numToConvert )
+{
+	unsigned int count = numToConvert;
+
+	for ( ; count >= 4; count -= 4) {
+		vstore(dst, __builtin_convertvector(vload<vFloat32>(src), vFloat64x4));
+		src += 4;
+		dst += 4;
+	}
+	while (count--)
+		*dst++ = *src++;
+}
+
+void Float64ToFloat32_Vector( const Float64 *src, Float32 *dst, unsigned int numToConvert )
+{
+	unsigned int count = numToConvert;
+
+	for ( ; count >= 4; count -= 4) {
+		vstore(dst, __builtin_convertvector(vload<vFloat64x4>(src), vFloat32));
+		src += 4;
+		dst += 4;
+	}
+	while (count--)
+		*dst++ = (Float32)*src++;
+}
+
+// Each op converts 4 floats to 4 byte values in 32-bit lanes.
+
+class Float32ToSInt8VectorByteOp {
+public:
+	static inline vSInt32 convert4(vFloat32 vf) { return vFloatToInt(vf, 128.0f, vsplat(0.5f), 127.0f); }
+};
+
+class Float32ToUInt8VectorByteOp {
+public:
+	static inline vSInt32 convert4(vFloat32 vf) { return Float32ToSInt8VectorByteOp::convert4(vf) + 128; }
+};
+
+// the sample rounded to 16 bits, as a float
+static inline vFloat32 Float32ToInt16Value_Vector( vFloat32 vf )
+{
+	return __builtin_convertvector(vFloatToInt(vf, 32768.0f, vsplat(0.5f), 32767.0f), vFloat32);
+}
+
+// see Float32ToMuLawByteOp
+class Float32ToMuLawVectorByteOp {
+public:
+	static inline vSInt32 convert4(vFloat32 vf)
+	{
+		vUInt32 v, sign;
+
+		vf = Float32ToInt16Value_Vector(vf);
+		sign = (vUInt32)vf & 0x80000000U;
+		vf = vmin((vFloat32)((vUInt32)vf & 0x7FFFFFFFU), vsplat(32635.0f));
+		v = ((vUInt32)(vf + vsplat(132.0f)) >> 19) - (134 << 4);
+		return (vSInt32)((v | (sign >> 24)) ^ 0xFF);
+	}
+};
+
+// see Float32ToALawByteOp
+class Float32ToALawVectorByteOp {
+public:
+	static inline vSInt32 convert4(vFloat32 vf)
+	{
+		vSInt32 vi, neg, low, v;
+
+		vi = __builtin_convertvector(Float32ToInt16Value_Vector(vf), vSInt32) >> 3;
+		neg = vi >> 31;
+		vi ^= neg;
+		low = vi < 32;
+		vi += low & 32;
+		v = (vSInt32)((vUInt32)__builtin_convertvector(vi, vFloat32) >> 19) - (131 << 4);
+		v += (vSInt32)((vUInt32)low << 4);
+		return v ^ (0xD5 ^ (neg & 0x80));
+	}
+};
+
+template <class Op>
+static inline vUInt8 Float32ToBytes16_Vector( const Float32 *src )
+{
+	vSInt32x8 lo = vconcat(Op::convert4(vload<vFloat32>(src)), Op::convert4(vload<vFloat32>(src + 4)));
+	vSInt32x8 hi = vconcat(Op::convert4(vload<vFloat32>(src + 8)), Op::convert4(vload<vFloat32>(src + 12)));
+	vSInt32x16 v = __builtin_shufflevector(lo, hi, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	return __builtin_convertvector(v, vUInt8);
+}
+
+template <class Op>
+static inline void Float32ToBytes_Vector( const Float32 *src, UInt8 *dst, unsigned int numToConvert )
+{
+	Float32 tmp[16];
+	UInt8 out[16];
+	unsigned int count = numToConvert;
+	unsigned int i;
+
+	for ( ; count >= 16; count -= 16) {
+		vstore(dst, Float32ToBytes16_Vector<Op>(src));
+		src += 16;
+		dst += 16;
+	}
+	if (count) {
+		for (i = 0; i < 16; ++i)
+			tmp[i] = (i < count) ? src[i] : 0.0f;
+		vstore(out, Float32ToBytes16_Vector<Op>(tmp));
+		for (i = 0; i < count; ++i)
+			dst[i] = out[i];
+	}
+}
+
+void Float32ToSInt8_Vector( const Float32 *src, SInt8 *dst, unsigned int numToConvert )
+{
+	Float32ToBytes_Vector<Float32ToSInt8VectorByteOp>(src, (UInt8 *)dst, numToConvert);
+}
+
+void Float32ToUInt8_Vector( const Float32 *src, UInt8 *dst, unsigned int numToConvert )
+{
+	Float32ToBytes_Vector<Float32ToUInt8VectorByteOp>(src, dst, numToConvert);
+}
+
+void Float32ToALaw_Vector( const Float32 *src, UInt8 *dst, unsigned int numToConvert )
+{
+	Float32ToBytes_Vector<Float32ToALawVectorByteOp>(src, dst, numToConvert);
+}
+
+void Float32ToMuLaw_Vector( const Float32 *src, UInt8 *dst, unsigned int numToConvert )
+{
+	Float32ToBytes_Vector<Float32ToMuLawVectorByteOp>(src, dst, numToConvert);
+}
+
+// flip is 0x80 for unsigned samples, which makes them signed
+static inline void Int8ToFloat32_Vector( const UInt8 *src, Float32 *dst, unsigned int numToConvert, UInt8 flip )
+{
+	const Float32 k = 1.0f / 128.0f;
+	const vFloat32x16 vscale = { k, k, k, k, k, k, k, k, k, k, k, k, k, k, k, k };
+	const vUInt8 vflip = { flip, flip, flip, flip, flip, flip, flip, flip, flip, flip, flip, flip, flip, flip, flip, flip };
+	unsigned int count = numToConvert;
+
+	for ( ; count >= 16; count -= 16) {
+		vSInt8 v = (vSInt8)(vload<vUInt8>(src) ^ vflip);
+		vstore(dst, __builtin_convertvector(v, vFloat32x16) * vscale);
+		src += 16;
+		dst += 16;
+	}
+	while (count--)
+		*dst++ = (Float32)(SInt8)(*src++ ^ flip) * (1.0f / 128.0f);
+}
+
+void SInt8ToFloat32_Vector( const SInt8 *src, Float32 *dst, unsigned int numToConvert )
+{
+	Int8ToFloat32_Vector((const UInt8 *)src, dst, numToConvert, 0);
+}
+
+void UInt8ToFloat32_Vector( const UInt8 *src, Float32 *dst, unsigned int numToConvert )
+{
+	Int8ToFloat32_Vector(src, dst, numToConvert, 0x80);
+}
+
+// A-law: inverted even bits; segment 0 is linear, segment s >= 1 is (mantissa + 16.5) << (s + 3)
+static inline vSInt32 ALawToLinear_Vector( vSInt32 a )
+{
+	vSInt32 seg, nonzero, t;
+
+	a ^= 0x55;
+	seg = (a >> 4) & 7;
+	nonzero = (seg != 0);
+	t = ((a & 0xF) << 4) + 8 + (nonzero & 0x100);
+	t <<= (seg - 1) & nonzero;
+	return vselect((a & 0x80) != 0, t, -t);
+}
+
+// mu-law: all bits inverted; ((mantissa << 3) + 132) << segment, less the bias of 132
+static inline vSInt32 MuLawToLinear_Vector( vSInt32 u )
+{
+	vSInt32 t;
+
+	u = ~u & 0xFF;
+	t = (((u & 0xF) << 3) + 0x84) << ((u >> 4) & 7);
+	return vselect((u & 0x80) != 0, 0x84 - t, t - 0x84);
+}
+
+template <bool kALaw>
+static inline vFloat32 LawToFloat32x4_Vector( const UInt8 *src )
+{
+	vSInt32 v = __builtin_convertvector(vload<vUInt8x4>(src), vSInt32);
+	v = kALaw ? ALawToLinear_Vector(v) : MuLawToLinear_Vector(v);
+	return __builtin_convertvector(v, vFloat32) * vsplat(1.0f / 32768.0f);
+}
+
+template <bool kALaw>
+static inline void LawToFloat32_Vector( const UInt8 *src, Float32 *dst, unsigned int numToConvert )
+{
+	UInt8 tmp[4];
+	Float32 out[4];
+	unsigned int count = numToConvert;
+	unsigned int i;
+
+	for ( ; count >= 4; count -= 4) {
+		vstore(dst, LawToFloat32x4_Vector<kALaw>(src));
+		src += 4;
+		dst += 4;
+	}
+	if (count) {
+		for (i = 0; i < 4; ++i)
+			tmp[i] = (i < count) ? src[i] : 0;
+		vstore(out, LawToFloat32x4_Vector<kALaw>(tmp));
+		for (i = 0; i < count; ++i)
+			dst[i] = out[i];
+	}
+}
+
+void ALawToFloat32_Vector( const UInt8 *src, Float32 *dst, unsigned int numToConvert )
+{
+	LawToFloat32_Vector<true>(src, dst, numToConvert);
+}
+
+void MuLawToFloat32_Vector( const UInt8 *src, Float32 *dst, unsigned int numToConvert )
+{
+	LawToFloat32_Vector<false>(src, dst, numToConvert);
+}
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Justified Int
+
+/*
+	Samples narrower than their container, high or low aligned, through the int -> int lane ops;
+	see the X86 backend for the scheme, which this follows to the bit.
+*/
+
+class JustifiedFormat_Vector {
+public:
+	JustifiedFormat_Vector( unsigned int bitDepth, unsigned int bitWidth, bool highAligned )
+	{
+		mScale = (Float32)(1U << (bitDepth - 1));
+		// above 24 bits the largest value below full scale is limited by the float's precision
+		mMaxValue = mScale - ((bitDepth <= 24) ? 1.0f : (Float32)(1U << (bitDepth - 25)));
+		mToTop = 32 - bitDepth;
+		mToPlace = highAligned ? 0 : bitWidth - bitDepth;
+		mSampleMask = vsplat((SInt32)(0xFFFFFFFFU << (32 - bitDepth)));
+		mHighAligned = highAligned;
+	}
+	inline vSInt32 fromFloat(vFloat32 vf) const
+	{
+		return (vFloatToInt(vf, mScale, vsplat(0.5f), mMaxValue) << mToTop) >> mToPlace;
+	}
+	inline vFloat32 toFloat(vSInt32 vi) const
+	{
+		vi = mHighAligned ? (vi & mSampleMask) : (vi << mToPlace);
+		return __builtin_convertvector(vi, vFloat32) * vsplat(1.0f / 2147483648.0f);
+	}
+
+private:
+	Float32	mScale, mMaxValue;
+	int		mToTop, mToPlace;
+	vSInt32	mSampleMask;
+	bool	mHighAligned;
+};
+
+template <class LaneOp>
+static inline void ConvertJustifiedBlock_Vector( const Float32 *src, UInt8 *dst, const JustifiedFormat_Vector &format )
+{
+	vSInt32 v[4];
+
+	for (int i = 0; i < 4; ++i)
+		v[i] = format.fromFloat(vload<vFloat32>(src + 4 * i));
+	LaneOp::store(dst, v);
+}
+
+template <class LaneOp>
+static inline void Float32ToIntJustified_Vector( const Float32 *src, UInt8 *dst, unsigned int numToConvert, const JustifiedFormat_Vector &format )
+{
+	unsigned int count = numToConvert;
+	unsigned int i;
+
+	for ( ; count >= 16; count -= 16) {
+		ConvertJustifiedBlock_Vector<LaneOp>(src, dst, format);
+		src += 16;
+		dst += 16 * LaneOp::kBytesPerSample;
+	}
+	if (count) {
+		Float32 in[16];
+		UInt8 out[16 * 4];
+
+		for (i = 0; i < 16; ++i)
+			in[i] = (i < count) ? src[i] : 0.0f;
+		ConvertJustifiedBlock_Vector<LaneOp>(in, out, format);
+		for (i = 0; i < count * LaneOp::kBytesPerSample; ++i)
+			dst[i] = out[i];
+	}
+}
+
+template <class LaneOp>
+static inline void ConvertJustifiedBlock_Vector( const UInt8 *src, Float32 *dst, const JustifiedFormat_Vector &format )
+{
+	vSInt32 v[4];
+
+	LaneOp::load(src, v);
+	for (int i = 0; i < 4; ++i)
+		vstore(dst + 4 * i, format.toFloat(v[i]));
+}
+
+template <class LaneOp>
+static inline void IntJustifiedToFloat32_Vector( const UInt8 *src, Float32 *dst, unsigned int numToConvert, const JustifiedFormat_Vector &format )
+{
+	unsigned int count = numToConvert;
+	unsigned int i;
+
+	for ( ; count >= 16; count -= 16) {
+		ConvertJustifiedBlock_Vector<LaneOp>(src, dst, format);
+		src += 16 * LaneOp::kBytesPerSample;
+		dst += 16;
+	}
+	if (count) {
+		UInt8 in[16 * 4];
+		Float32 out[16];
+
+		for (i = 0; i < 16 * LaneOp::kBytesPerSample; ++i)
+			in[i] = (i < count * LaneOp::kBytesPerSample) ? src[i] : 0;
+		ConvertJustifiedBlock_Vector<LaneOp>(in, out, format);
+		for (i = 0; i < count; ++i)
+			dst[i] = out[i];
+	}
+}
+
+void Float32ToNativeIntJustified_Vector( const Float32 *src, void *dst, unsigned int numToConvert, unsigned int bitDepth, unsigned int bitWidth, bool highAligned )
+{
+	JustifiedFormat_Vector format(bitDepth, bitWidth, highAligned);
+
+	switch (bitWidth) {
+		case 16:	Float32ToIntJustified_Vector<NativeInt16VectorLaneOp>(src, (UInt8 *)dst, numToConvert, format);	break;
+		case 24:	Float32ToIntJustified_Vector<NativeInt24VectorLaneOp>(src, (UInt8 *)dst, numToConvert, format);	break;
+		case 32:	Float32ToIntJustified_Vector<NativeInt32VectorLaneOp>(src, (UInt8 *)dst, numToConvert, format);	break;
+	}
+}
+
+void Float32ToSwapIntJustified_Vector( const Float32 *src, void *dst, unsigned int numToConvert, unsigned int bitDepth, unsigned int bitWidth, bool highAligned )
+{
+	JustifiedFormat_Vector format(bitDepth, bitWidth, highAligned);
+
+	switch (bitWidth) {
+		case 16:	Float32ToIntJustified_Vector<SwapInt16VectorLaneOp>(src, (UInt8 *)dst, numToConvert, format);	break;
+		case 24:	Float32ToIntJustified_Vector<SwapInt24VectorLaneOp>(src, (UInt8 *)dst, numToConvert, format);	break;
+		case 32:	Float32ToIntJustified_Vector<SwapInt32VectorLaneOp>(src, (UInt8 *)dst, numToConvert, format);	break;
+	}
+}
+
+void NativeIntJustifiedToFloat32_Vector( const void *src, Float32 *dst, unsigned int numToConvert, unsigned int bitDepth, unsigned int bitWidth, bool highAligned )
+{
+	JustifiedFormat_Vector format(bitDepth, bitWidth, highAligned);
+
+	switch (bitWidth) {
+		case 16:	IntJustifiedToFloat32_Vector<NativeInt16VectorLaneOp>((const UInt8 *)src, dst, numToConvert, format);	break;
+		case 24:	IntJustifiedToFloat32_Vector<NativeInt24VectorLaneOp>((const UInt8 *)src, dst, numToConvert, format);	break;
+		case 32:	IntJustifiedToFloat32_Vector<NativeInt32VectorLaneOp>((const UInt8 *)src, dst, numToConvert, format);	break;
+	}
+}
+
+void SwapIntJustifiedToFloat32_Vector( const void *src, Float32 *dst, unsigned int numToConvert, unsigned int bitDepth, unsigned int bitWidth, bool highAligned )
+{
+	JustifiedFormat_Vector format(bitDepth, bitWidth, highAligned);
+
+	switch (bitWidth) {
+		case 16:	IntJustifiedToFloat32_Vector<SwapInt16VectorLaneOp>((const UInt8 *)src, dst, numToConvert, format);	break;
+		case 24:	IntJustifiedToFloat32_Vector<SwapInt24VectorLaneOp>((const UInt8 *)src, dst, numToConvert, format);	break;
+		case 32:	IntJustifiedToFloat32_Vector<SwapInt32VectorLaneOp>((const UInt8 *)src, dst, numToConvert, format);	break;
+	}
+}
+
+#endif // PCMBLIT_VECTOR
@@ -42,10 +42,11 @@
 
 #include <TargetConditionals.h>
 
-#if __i386__ || __LP64__
+#if __i386__ || __x86_64__
 #define _MM_MALLOC_H_INCLUDED 1	// we don't want this header
 #include <xmmintrin.h>
 #include "IOAudioBlitterLib.h"
+#include "IOAudioBlitterLibDispatch.h"
 #include <libkern/OSByteOrder.h>
 
 #define kMaxFloat32 2147483520.0f
@@ -272,11 +273,7 @@ VectorCleanup:
 			f0 = f0 * scale + round;
 			SInt32 i0 = FloatToInt(f0, min32, max32);
 			i0 >>= 16;
-#if __ppc__			
 			*dst++ = OSSwapInt16(i0);
-#else
-			*dst++ = i0;
-#endif
 
 		}
 		RESTORE_ROUNDMODE
@@ -368,6 +365,7 @@ VectorCleanup:
 		while (count-- > 0) {
 			double f0 = *src++;
 			f0 = f0 * scale + round;
+			if (f0 > kMaxFloat32) f0 = kMaxFloat32;	// clip as the vector code does
 			SInt32 i0 = FloatToInt(f0, min32, max32);
 			*dst++ = i0;
 		}
@@ -461,12 +459,9 @@ VectorCleanup:
 		while (count-- > 0) {
 			double f0 = *src++;
 			f0 = f0 * scale + round;
+			if (f0 > kMaxFloat32) f0 = kMaxFloat32;	// clip as the vector code does
 			SInt32 i0 = FloatToInt(f0, min32, max32);
-#if __ppc__			
 			*dst++ = OSSwapInt32(i0);
-#else
-			*dst++ =  i0;
-#endif
 
 		}
 		RESTORE_ROUNDMODE
@@ -506,7 +501,9 @@ void Float32ToNativeInt24_X86( const Float32 *src, UInt8 *dst, unsigned int numT
 	if (count >= 6) {
 		// vector -- requires 6+ samples
 		ROUNDMODE_NEG_INF
-		const __m128 vround = (const __m128) { 0.5f, 0.5f, 0.5f, 0.5f };
+		// the sample is converted at 32 bits and its low byte dropped, so round at bit 8 (as the
+		// portable routine does) rather than at bit 0, which would leave the result truncated
+		const __m128 vround = (const __m128) { 128.0f, 128.0f, 128.0f, 128.0f };
 		const __m128 vmin = (const __m128) { -2147483648.0f, -2147483648.0f, -2147483648.0f, -2147483648.0f };
 		const __m128 vmax = (const __m128) { kMaxFloat32, kMaxFloat32, kMaxFloat32, kMaxFloat32  };
 		const __m128 vscale = (const __m128) { 2147483648.0f, 2147483648.0f, 2147483648.0f, 2147483648.0f  };
@@ -580,7 +577,7 @@ void Float32ToNativeInt24_X86( const Float32 *src, UInt8 *dst, unsigned int numT
 	
 	// scalar for small numbers of samples
 	if (count > 0) {
-		double scale = 2147483648.0, round = 0.5, max32 = 2147483648.0 - 1.0 - 0.5, min32 = 0.;
+		double scale = 2147483648.0, round = 128.0, max32 = 2147483648.0 - 1.0 - 128.0, min32 = 0.;
 		ROUNDMODE_NEG_INF
 		
 		while (count-- > 0) {
@@ -774,9 +771,7 @@ VectorCleanup:
 		double scale = 1./32768.f;
 		while (count-- > 0) {
 			SInt16 i = *src++;
-#if __ppc__
 			i = OSSwapInt16(i);
-#endif
 			double f = (double)i * scale;
 			*dst++ = f;
 		}
@@ -938,9 +933,7 @@ VectorCleanup:
 		double scale = 1./2147483648.0f;
 		while (count-- > 0) {
 			SInt32 i = *src++;
-#if __ppc__
 			i = OSSwapInt32(i);
-#endif
 
 			double f = (double)i * scale;
 			*dst++ = f;
@@ -948,6 +941,1893 @@ VectorCleanup:
 	}
 }
 
+// ===================================================================================================
+#pragma mark -
+#pragma mark Interleave / Deinterleave
+
+/*
+	Interleaved buffers hold nChannels samples per frame; the other side is one buffer per channel.
+
+	Each kernel works on blocks of 4 frames. Two channels are split or merged with one shuffle pair.
+	For any other channel count, a 4 frame x 4 channel block is moved with a transpose, so 4 and 8
+	channels (and multiples of 4 in general) never leave the vector path. Any channels past the last
+	group of four, and any frames past the last block of four, are done one sample at a time with
+	the same arithmetic as the vector path.
+
+	The element operations below define what happens to each sample on the way through: a plain
+	32-bit copy, or a conversion to or from 16/32-bit integers in either byte order. Float -> int
+	operations must run with ROUNDMODE_NEG_INF in effect.
+*/
+
+// Float32 -> integer ops: convert() produces 32-bit lanes, store4()/store1() write 4 or 1 samples.
+class DeinterleaveRaw32Op {
+public:
+	typedef UInt32 int_type;
+	static inline __m128i convert(__m128 vf) { return _mm_castps_si128(vf); }
+	static inline void store4(int_type *p, __m128i vi) { _mm_storeu_si128((__m128i *)p, vi); }
+	static inline void store1(int_type *p, __m128i vi) { *p = _mm_cvtsi128_si32(vi); }
+};
+
+class Float32ToNativeInt32Op {
+public:
+	typedef SInt32 int_type;
+	static inline __m128i convert(__m128 vf)
+	{
+		vf = _mm_mul_ps(vf, _mm_set1_ps(2147483648.0f));
+		vf = _mm_add_ps(vf, _mm_set1_ps(0.5f));
+		vf = _mm_max_ps(vf, _mm_set1_ps(-2147483648.0f));
+		vf = _mm_min_ps(vf, _mm_set1_ps(kMaxFloat32));
+		return _mm_cvtps_epi32(vf);
+	}
+	static inline void store4(int_type *p, __m128i vi) { _mm_storeu_si128((__m128i *)p, vi); }
+	static inline void store1(int_type *p, __m128i vi) { *p = _mm_cvtsi128_si32(vi); }
+};
+
+class Float32ToSwapInt32Op : public Float32ToNativeInt32Op {
+public:
+	static inline __m128i convert(__m128 vf) { return byteswap32(Float32ToNativeInt32Op::convert(vf)); }
+};
+
+class Float32ToNativeInt16Op {
+public:
+	typedef SInt16 int_type;
+	static inline __m128i convert(__m128 vf)
+	{
+		vf = _mm_mul_ps(vf, _mm_set1_ps(32768.0f));
+		vf = _mm_add_ps(vf, _mm_set1_ps(0.5f));
+		vf = _mm_max_ps(vf, _mm_set1_ps(-32768.0f));
+		vf = _mm_min_ps(vf, _mm_set1_ps(32767.0f));
+		__m128i vi = _mm_cvtps_epi32(vf);
+		return _mm_packs_epi32(vi, vi);
+	}
+	static inline void store4(int_type *p, __m128i vi) { _mm_storel_epi64((__m128i *)p, vi); }
+	static inline void store1(int_type *p, __m128i vi) { *p = (SInt16)_mm_cvtsi128_si32(vi); }
+};
+
+class Float32ToSwapInt16Op : public Float32ToNativeInt16Op {
+public:
+	static inline __m128i convert(__m128 vf) { return byteswap16(Float32ToNativeInt16Op::convert(vf)); }
+};
+
+// integer -> Float32 ops: load4()/load1() read 4 or 1 samples and return them as floats.
+class InterleaveRaw32Op {
+public:
+	typedef UInt32 int_type;
+	static inline __m128 load4(const int_type *p) { return _mm_loadu_ps((const float *)p); }
+	static inline __m128 load1(const int_type *p) { return _mm_load_ss((const float *)p); }
+};
+
+class NativeInt32ToFloat32Op {
+public:
+	typedef SInt32 int_type;
+	static inline __m128 convert(__m128i vi) { return _mm_mul_ps(_mm_cvtepi32_ps(vi), _mm_set1_ps(1.0/2147483648.0f)); }
+	static inline __m128 load4(const int_type *p) { return convert(_mm_loadu_si128((__m128i const *)p)); }
+	static inline __m128 load1(const int_type *p) { return convert(_mm_cvtsi32_si128(*p)); }
+};
+
+class SwapInt32ToFloat32Op : public NativeInt32ToFloat32Op {
+public:
+	static inline __m128 load4(const int_type *p) { return convert(byteswap32(_mm_loadu_si128((__m128i const *)p))); }
+	static inline __m128 load1(const int_type *p) { return convert(_mm_cvtsi32_si128(OSSwapInt32(*p))); }
+};
+
+class NativeInt16ToFloat32Op {
+public:
+	typedef SInt16 int_type;
+	// put the 16-bit words in the high word of 32-bit values
+	static inline __m128 convert(__m128i vi) { return NativeInt32ToFloat32Op::convert(_mm_unpacklo_epi16(_mm_setzero_si128(), vi)); }
+	static inline __m128 load4(const int_type *p) { return convert(_mm_loadl_epi64((__m128i const *)p)); }
+	static inline __m128 load1(const int_type *p) { return convert(_mm_cvtsi32_si128((UInt16)*p)); }
+};
+
+class SwapInt16ToFloat32Op : public NativeInt16ToFloat32Op {
+public:
+	static inline __m128 load4(const int_type *p) { return convert(byteswap16(_mm_loadl_epi64((__m128i const *)p))); }
+	static inline __m128 load1(const int_type *p) { return convert(_mm_cvtsi32_si128(OSSwapInt16(*p))); }
+};
+
+// ___________________________________________________________________________________________________
+// interleaved Float32 -> one buffer per channel
+template <class Op>
+static inline void DeinterleaveFromFloat32_X86( const Float32 *src, typename Op::int_type * const dst[], unsigned int nChannels, unsigned int nFrames )
+{
+	unsigned int frames4 = nFrames & ~3U;
+	unsigned int f, c;
+
+	for (f = 0; f < frames4; f += 4) {
+		const Float32 *s = src + f * nChannels;
+		c = 0;
+		if (nChannels == 1) {
+			Op::store4(dst[0] + f, Op::convert(_mm_loadu_ps(s)));
+			continue;
+		}
+		if (nChannels == 2) {
+			__m128 v0 = _mm_loadu_ps(s);		// L0 R0 L1 R1
+			__m128 v1 = _mm_loadu_ps(s + 4);	// L2 R2 L3 R3
+			Op::store4(dst[0] + f, Op::convert(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0))));
+			Op::store4(dst[1] + f, Op::convert(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1))));
+			continue;
+		}
+		for ( ; c + 4 <= nChannels; c += 4) {
+			// rows are frames, columns are channels; transposed, each row is one channel
+			__m128 v0 = _mm_loadu_ps(s + c);
+			__m128 v1 = _mm_loadu_ps(s + c + nChannels);
+			__m128 v2 = _mm_loadu_ps(s + c + 2 * nChannels);
+			__m128 v3 = _mm_loadu_ps(s + c + 3 * nChannels);
+			_MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+			Op::store4(dst[c] + f, Op::convert(v0));
+			Op::store4(dst[c+1] + f, Op::convert(v1));
+			Op::store4(dst[c+2] + f, Op::convert(v2));
+			Op::store4(dst[c+3] + f, Op::convert(v3));
+		}
+		for ( ; c < nChannels; c++) {
+			for (unsigned int i = 0; i < 4; i++)
+				Op::store1(dst[c] + f + i, Op::convert(_mm_load_ss(s + i * nChannels + c)));
+		}
+	}
+	// leftover frames
+	for ( ; f < nFrames; f++) {
+		const Float32 *s = src + f * nChannels;
+		for (c = 0; c < nChannels; c++)
+			Op::store1(dst[c] + f, Op::convert(_mm_load_ss(s + c)));
+	}
+}
+
+// ___________________________________________________________________________________________________
+// one buffer per channel -> interleaved Float32
+template <class Op>
+static inline void InterleaveToFloat32_X86( const typename Op::int_type * const src[], Float32 *dst, unsigned int nChannels, unsigned int nFrames )
+{
+	unsigned int frames4 = nFrames & ~3U;
+	unsigned int f, c;
+
+	for (f = 0; f < frames4; f += 4) {
+		Float32 *d = dst + f * nChannels;
+		c = 0;
+		if (nChannels == 1) {
+			_mm_storeu_ps(d, Op::load4(src[0] + f));
+			continue;
+		}
+		if (nChannels == 2) {
+			__m128 vA = Op::load4(src[0] + f);
+			__m128 vB = Op::load4(src[1] + f);
+			_mm_storeu_ps(d, _mm_unpacklo_ps(vA, vB));
+			_mm_storeu_ps(d + 4, _mm_unpackhi_ps(vA, vB));
+			continue;
+		}
+		for ( ; c + 4 <= nChannels; c += 4) {
+			// rows are channels, columns are frames; transposed, each row is one frame
+			__m128 v0 = Op::load4(src[c] + f);
+			__m128 v1 = Op::load4(src[c+1] + f);
+			__m128 v2 = Op::load4(src[c+2] + f);
+			__m128 v3 = Op::load4(src[c+3] + f);
+			_MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+			_mm_storeu_ps(d + c, v0);
+			_mm_storeu_ps(d + c + nChannels, v1);
+			_mm_storeu_ps(d + c + 2 * nChannels, v2);
+			_mm_storeu_ps(d + c + 3 * nChannels, v3);
+		}
+		for ( ; c < nChannels; c++) {
+			for (unsigned int i = 0; i < 4; i++)
+				_mm_store_ss(d + i * nChannels + c, Op::load1(src[c] + f + i));
+		}
+	}
+	// leftover frames
+	for ( ; f < nFrames; f++) {
+		Float32 *d = dst + f * nChannels;
+		for (c = 0; c < nChannels; c++)
+			_mm_store_ss(d + c, Op::load1(src[c] + f));
+	}
+}
+
+// ___________________________________________________________________________________________________
+
+void Interleave32_X86( const void * const src[], void *dst, unsigned int nChannels, unsigned int nFrames )
+{
+	InterleaveToFloat32_X86<InterleaveRaw32Op>((const UInt32 * const *)src, (Float32 *)dst, nChannels, nFrames);
+}
+
+void Deinterleave32_X86( const void *src, void * const dst[], unsigned int nChannels, unsigned int nFrames )
+{
+	DeinterleaveFromFloat32_X86<DeinterleaveRaw32Op>((const Float32 *)src, (UInt32 * const *)dst, nChannels, nFrames);
+}
+
+void DeinterleaveFloat32ToNativeInt16_X86( const Float32 *src, SInt16 * const dst[], unsigned int nChannels, unsigned int nFrames )
+{
+	ROUNDMODE_NEG_INF
+	DeinterleaveFromFloat32_X86<Float32ToNativeInt16Op>(src, dst, nChannels, nFrames);
+	RESTORE_ROUNDMODE
+}
+
+void DeinterleaveFloat32ToSwapInt16_X86( const Float32 *src, SInt16 * const dst[], unsigned int nChannels, unsigned int nFrames )
+{
+	ROUNDMODE_NEG_INF
+	DeinterleaveFromFloat32_X86<Float32ToSwapInt16Op>(src, dst, nChannels, nFrames);
+	RESTORE_ROUNDMODE
+}
+
+void DeinterleaveFloat32ToNativeInt32_X86( const Float32 *src, SInt32 * const dst[], unsigned int nChannels, unsigned int nFrames )
+{
+	ROUNDMODE_NEG_INF
+	DeinterleaveFromFloat32_X86<Float32ToNativeInt32Op>(src, dst, nChannels, nFrames);
+	RESTORE_ROUNDMODE
+}
+
+void DeinterleaveFloat32ToSwapInt32_X86( const Float32 *src, SInt32 * const dst[], unsigned int nChannels, unsigned int nFrames )
+{
+	ROUNDMODE_NEG_INF
+	DeinterleaveFromFloat32_X86<Float32ToSwapInt32Op>(src, dst, nChannels, nFrames);
+	RESTORE_ROUNDMODE
+}
+
+void InterleaveNativeInt16ToFloat32_X86( const SInt16 * const src[], Float32 *dst, unsigned int nChannels, unsigned int nFrames )
+{
+	InterleaveToFloat32_X86<NativeInt16ToFloat32Op>(src, dst, nChannels, nFrames);
+}
+
+void InterleaveSwapInt16ToFloat32_X86( const SInt16 * const src[], Float32 *dst, unsigned int nChannels, unsigned int nFrames )
+{
+	InterleaveToFloat32_X86<SwapInt16ToFloat32Op>(src, dst, nChannels, nFrames);
+}
+
+void InterleaveNativeInt32ToFloat32_X86( const SInt32 * const src[], Float32 *dst, unsigned int nChannels, unsigned int nFrames )
+{
+	InterleaveToFloat32_X86<NativeInt32ToFloat32Op>(src, dst, nChannels, nFrames);
+}
+
+void InterleaveSwapInt32ToFloat32_X86( const SInt32 * const src[], Float32 *dst, unsigned int nChannels, unsigned int nFrames )
+{
+	InterleaveToFloat32_X86<SwapInt32ToFloat32Op>(src, dst, nChannels, nFrames);
+}
+
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Mix
+
+/*
+	Accumulate a Float32 buffer into another: dst[i] += src[i].
+
+	The mix buffer is written in place, so unlike the converters the ends cannot be covered by an
+	overlapping unaligned vector (those samples would be added twice). Instead the samples before
+	the first aligned destination vector and after the last whole vector are added one at a time.
+	Every sample goes through exactly one single-precision add in either path, so the result is
+	bit-identical to a plain scalar loop.
+*/
+
+void MixFloat32_X86( const Float32 *src, Float32 *dst, unsigned int count )
+{
+	// scalar head -- until the destination is 16-byte aligned
+	while (count > 0 && ((uintptr_t)dst & 0xF) != 0) {
+		*dst++ += *src++;
+		--count;
+	}
+
+	if (((uintptr_t)src & 0xF) != 0) {
+		// unaligned loads, aligned stores
+		while (count >= 8) {
+			__m128 vd0 = _mm_load_ps(dst);
+			__m128 vd1 = _mm_load_ps(dst + 4);
+			vd0 = _mm_add_ps(vd0, _mm_loadu_ps(src));
+			vd1 = _mm_add_ps(vd1, _mm_loadu_ps(src + 4));
+			_mm_store_ps(dst, vd0);
+			_mm_store_ps(dst + 4, vd1);
+			src += 8;
+			dst += 8;
+			count -= 8;
+		}
+	} else {
+		// aligned loads, aligned stores
+		while (count >= 8) {
+			__m128 vd0 = _mm_load_ps(dst);
+			__m128 vd1 = _mm_load_ps(dst + 4);
+			vd0 = _mm_add_ps(vd0, _mm_load_ps(src));
+			vd1 = _mm_add_ps(vd1, _mm_load_ps(src + 4));
+			_mm_store_ps(dst, vd0);
+			_mm_store_ps(dst + 4, vd1);
+			src += 8;
+			dst += 8;
+			count -= 8;
+		}
+	}
+
+	if (count >= 4) {
+		_mm_store_ps(dst, _mm_add_ps(_mm_load_ps(dst), _mm_loadu_ps(src)));
+		src += 4;
+		dst += 4;
+		count -= 4;
+	}
+
+	// scalar tail
+	while (count > 0) {
+		*dst++ += *src++;
+		--count;
+	}
+}
+
+/*
+	Accumulate several Float32 buffers into one: dst[i] += src[0][i] + ... in source order.
+
+	Mixing the sources one call at a time walks the whole mix buffer once per source. Here the mix
+	buffer is processed a 64-byte cache line (16 floats) at a time: the line is loaded once, every
+	source is added to it in turn, and it is stored once. The adds happen in the same order as
+	nSources calls to MixFloat32_X86, so the result is bit-identical to that.
+*/
+
+static inline void MixFloat32Multi_Scalar( const Float32 * const src[], unsigned int nSources, Float32 *dst, unsigned int offset, unsigned int count )
+{
+	for (unsigned int i = offset; i < offset + count; ++i) {
+		Float32 f = dst[i];
+		for (unsigned int s = 0; s < nSources; ++s)
+			f += src[s][i];
+		dst[i] = f;
+	}
+}
+
+void MixFloat32Multi_X86( const Float32 * const src[], unsigned int nSources, Float32 *dst, unsigned int count )
+{
+	unsigned int i = 0;
+
+	// scalar head -- until the destination is 16-byte aligned
+	unsigned int n = ((16 - ((uintptr_t)dst & 0xF)) & 0xF) / 4;
+	if (n > count)
+		n = count;
+	MixFloat32Multi_Scalar(src, nSources, dst, 0, n);
+	i = n;
+
+	// one cache line of the mix buffer per iteration
+	for ( ; i + 16 <= count; i += 16) {
+		__m128 vd0 = _mm_load_ps(dst + i);
+		__m128 vd1 = _mm_load_ps(dst + i + 4);
+		__m128 vd2 = _mm_load_ps(dst + i + 8);
+		__m128 vd3 = _mm_load_ps(dst + i + 12);
+		for (unsigned int s = 0; s < nSources; ++s) {
+			const Float32 *p = src[s] + i;
+			vd0 = _mm_add_ps(vd0, _mm_loadu_ps(p));
+			vd1 = _mm_add_ps(vd1, _mm_loadu_ps(p + 4));
+			vd2 = _mm_add_ps(vd2, _mm_loadu_ps(p + 8));
+			vd3 = _mm_add_ps(vd3, _mm_loadu_ps(p + 12));
+		}
+		_mm_store_ps(dst + i, vd0);
+		_mm_store_ps(dst + i + 4, vd1);
+		_mm_store_ps(dst + i + 8, vd2);
+		_mm_store_ps(dst + i + 12, vd3);
+	}
+
+	for ( ; i + 4 <= count; i += 4) {
+		__m128 vd0 = _mm_load_ps(dst + i);
+		for (unsigned int s = 0; s < nSources; ++s)
+			vd0 = _mm_add_ps(vd0, _mm_loadu_ps(src[s] + i));
+		_mm_store_ps(dst + i, vd0);
+	}
+
+	// scalar tail
+	MixFloat32Multi_Scalar(src, nSources, dst, i, count - i);
+}
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Non-temporal Float -> Int
+
+/*
+	Variants of the Float32 -> integer converters for destinations in uncached or write-combined
+	memory, such as a hardware sample buffer mapped over PCIe. Ordinary stores to that memory stall
+	on read-for-ownership; these write whole 16-byte aligned blocks with _mm_stream_si128 instead.
+
+	The structure follows the regular converters: one unaligned block with ordinary stores to get the
+	destination aligned, streamed aligned blocks, then one overlapping block at the end. A single
+	sfence at the end makes the streamed data globally visible before the function returns. Buffers
+	too short to reach an aligned block go to the regular converter. Results are identical to the
+	regular converters (for 24-bit, to the portable routines, which all 24-bit float -> int paths match).
+
+	Each block op converts kSamplesPerBlock floats into kVectorsPerBlock 16-byte vectors.
+*/
+
+class Float32ToNativeInt16BlockOp {
+public:
+	static const unsigned int kBytesPerSample = 2, kSamplesPerBlock = 8, kVectorsPerBlock = 1;
+	static inline void convert(const Float32 *src, __m128i out[])
+	{
+		out[0] = _mm_packs_epi32(convert4(_mm_loadu_ps(src)), convert4(_mm_loadu_ps(src + 4)));
+	}
+	static inline void convertBiased(const Float32 *src, const __m128 bias[], __m128i out[])
+	{
+		out[0] = _mm_packs_epi32(convert4(_mm_loadu_ps(src), bias[0]), convert4(_mm_loadu_ps(src + 4), bias[1]));
+	}
+	static inline __m128i convert4(__m128 vf, __m128 bias = _mm_set1_ps(0.5f))
+	{
+		vf = _mm_mul_ps(vf, _mm_set1_ps(32768.0f));
+		vf = _mm_add_ps(vf, bias);
+		vf = _mm_max_ps(vf, _mm_set1_ps(-32768.0f));
+		vf = _mm_min_ps(vf, _mm_set1_ps(32767.0f));
+		return _mm_cvtps_epi32(vf);
+	}
+	static inline void convertScalar(const Float32 *src, UInt8 *dst, unsigned int count) { Float32ToNativeInt16_X86(src, (SInt16 *)dst, count); }
+};
+
+class Float32ToSwapInt16BlockOp : public Float32ToNativeInt16BlockOp {
+public:
+	static inline void convert(const Float32 *src, __m128i out[])
+	{
+		Float32ToNativeInt16BlockOp::convert(src, out);
+		out[0] = byteswap16(out[0]);
+	}
+	static inline void convertBiased(const Float32 *src, const __m128 bias[], __m128i out[])
+	{
+		Float32ToNativeInt16BlockOp::convertBiased(src, bias, out);
+		out[0] = byteswap16(out[0]);
+	}
+	static inline void convertScalar(const Float32 *src, UInt8 *dst, unsigned int count) { Float32ToSwapInt16_X86(src, (SInt16 *)dst, count); }
+};
+
+class Float32ToNativeInt32BlockOp {
+public:
+	static const unsigned int kBytesPerSample = 4, kSamplesPerBlock = 4, kVectorsPerBlock = 1;
+	static inline void convert(const Float32 *src, __m128i out[])
+	{
+		__m128 vf = _mm_loadu_ps(src);
+		vf = _mm_mul_ps(vf, _mm_set1_ps(2147483648.0f));
+		vf = _mm_add_ps(vf, _mm_set1_ps(0.5f));
+		vf = _mm_max_ps(vf, _mm_set1_ps(-2147483648.0f));
+		vf = _mm_min_ps(vf, _mm_set1_ps(kMaxFloat32));
+		out[0] = _mm_cvtps_epi32(vf);
+	}
+	static inline void convertScalar(const Float32 *src, UInt8 *dst, unsigned int count) { Float32ToNativeInt32_X86(src, (SInt32 *)dst, count); }
+};
+
+class Float32ToSwapInt32BlockOp : public Float32ToNativeInt32BlockOp {
+public:
+	static inline void convert(const Float32 *src, __m128i out[])
+	{
+		Float32ToNativeInt32BlockOp::convert(src, out);
+		out[0] = byteswap32(out[0]);
+	}
+	static inline void convertScalar(const Float32 *src, UInt8 *dst, unsigned int count) { Float32ToSwapInt32_X86(src, (SInt32 *)dst, count); }
+};
+
+// 16 samples are 48 bytes: four groups of 12 packed bytes spread over three vectors.
+// Pack32ToLE24 takes bytes 1-3 of each 32-bit lane. Shifting the sample up by 8 bits puts it there
+// low byte first; byte-swapping the lane puts it there high byte first.
+class Float32ToNativeInt24BlockOp {
+public:
+	static const unsigned int kBytesPerSample = 3, kSamplesPerBlock = 16, kVectorsPerBlock = 3;
+	static inline __m128i convert4(__m128 vf, __m128 bias, bool swap)
+	{
+		vf = _mm_mul_ps(vf, _mm_set1_ps(8388608.0f));
+		vf = _mm_add_ps(vf, bias);
+		vf = _mm_max_ps(vf, _mm_set1_ps(-8388608.0f));
+		vf = _mm_min_ps(vf, _mm_set1_ps(8388607.0f));
+		__m128i vi = _mm_cvtps_epi32(vf);
+		return swap ? byteswap32(vi) : _mm_slli_epi32(vi, 8);
+	}
+	static inline void pack(const Float32 *src, const __m128 bias[], __m128i out[], bool swap)
+	{
+		const __m128i mask = _mm_setr_epi32(0x00FFFFFF, 0, 0, 0);
+		__m128i p0 = Pack32ToLE24(convert4(_mm_loadu_ps(src), bias[0], swap), mask);
+		__m128i p1 = Pack32ToLE24(convert4(_mm_loadu_ps(src + 4), bias[1], swap), mask);
+		__m128i p2 = Pack32ToLE24(convert4(_mm_loadu_ps(src + 8), bias[2], swap), mask);
+		__m128i p3 = Pack32ToLE24(convert4(_mm_loadu_ps(src + 12), bias[3], swap), mask);
+		out[0] = _mm_or_si128(p0, _mm_slli_si128(p1, 12));
+		out[1] = _mm_or_si128(_mm_srli_si128(p1, 4), _mm_slli_si128(p2, 8));
+		out[2] = _mm_or_si128(_mm_srli_si128(p2, 8), _mm_slli_si128(p3, 4));
+	}
+	static inline void convert(const Float32 *src, __m128i out[])
+	{
+		const __m128 half = _mm_set1_ps(0.5f), bias[4] = { half, half, half, half };
+		pack(src, bias, out, false);
+	}
+	static inline void convertBiased(const Float32 *src, const __m128 bias[], __m128i out[]) { pack(src, bias, out, false); }
+	static inline void convertScalar(const Float32 *src, UInt8 *dst, unsigned int count) { Float32ToNativeInt24_Portable(src, dst, count); }
+};
+
+class Float32ToSwapInt24BlockOp : public Float32ToNativeInt24BlockOp {
+public:
+	static inline void convert(const Float32 *src, __m128i out[])
+	{
+		const __m128 half = _mm_set1_ps(0.5f), bias[4] = { half, half, half, half };
+		pack(src, bias, out, true);
+	}
+	static inline void convertBiased(const Float32 *src, const __m128 bias[], __m128i out[]) { pack(src, bias, out, true); }
+	static inline void convertScalar(const Float32 *src, UInt8 *dst, unsigned int count) { Float32ToSwapInt24_Portable(src, dst, count); }
+};
+
+template <class Op>
+static inline void Float32ToIntNT_X86( const Float32 *src, UInt8 *dst, unsigned int numToConvert )
+{
+	const Float32 *src0 = src;
+	UInt8 *dst0 = dst;
+	unsigned int count = numToConvert;
+	unsigned int n, i;
+	__m128i v[Op::kVectorsPerBlock];
+
+	// samples up to the first 16-byte aligned block of the destination
+	for (n = 0; n < 16 && (((uintptr_t)dst + n * Op::kBytesPerSample) & 0xF) != 0; ++n)
+		;
+	if (n == 16 || count < n + Op::kSamplesPerBlock) {
+		// misaligned samples or too short to reach an aligned block
+		Op::convertScalar(src, dst, count);
+		return;
+	}
+
+	ROUNDMODE_NEG_INF
+	if (n > 0) {
+		// do one unaligned block with ordinary stores
+		Op::convert(src, v);
+		for (i = 0; i < Op::kVectorsPerBlock; ++i)
+			_mm_storeu_si128((__m128i *)dst + i, v[i]);
+
+		// and advance such that the destination is aligned
+		src += n;
+		dst += n * Op::kBytesPerSample;
+		count -= n;
+	}
+
+	while (count >= Op::kSamplesPerBlock) {
+		Op::convert(src, v);
+		for (i = 0; i < Op::kVectorsPerBlock; ++i)
+			_mm_stream_si128((__m128i *)dst + i, v[i]);
+		src += Op::kSamplesPerBlock;
+		dst += Op::kVectorsPerBlock * 16;
+		count -= Op::kSamplesPerBlock;
+	}
+
+	if (count > 0) {
+		// unaligned cleanup -- just do one overlapping block at the end
+		src = src0 + numToConvert - Op::kSamplesPerBlock;
+		dst = dst0 + (numToConvert - Op::kSamplesPerBlock) * Op::kBytesPerSample;
+		Op::convert(src, v);
+		for (i = 0; i < Op::kVectorsPerBlock; ++i)
+			_mm_storeu_si128((__m128i *)dst + i, v[i]);
+	}
+	RESTORE_ROUNDMODE
+
+	_mm_sfence();
+}
+
+void Float32ToNativeInt16_X86NT( const Float32 *src, SInt16 *dst, unsigned int numToConvert )
+{
+	Float32ToIntNT_X86<Float32ToNativeInt16BlockOp>(src, (UInt8 *)dst, numToConvert);
+}
+
+void Float32ToSwapInt16_X86NT( const Float32 *src, SInt16 *dst, unsigned int numToConvert )
+{
+	Float32ToIntNT_X86<Float32ToSwapInt16BlockOp>(src, (UInt8 *)dst, numToConvert);
+}
+
+void Float32ToNativeInt24_X86NT( const Float32 *src, UInt8 *dst, unsigned int numToConvert )
+{
+	Float32ToIntNT_X86<Float32ToNativeInt24BlockOp>(src, dst, numToConvert);
+}
+
+void Float32ToSwapInt24_X86NT( const Float32 *src, UInt8 *dst, unsigned int numToConvert )
+{
+	Float32ToIntNT_X86<Float32ToSwapInt24BlockOp>(src, dst, numToConvert);
+}
+
+void Float32ToNativeInt32_X86NT( const Float32 *src, SInt32 *dst, unsigned int numToConvert )
+{
+	Float32ToIntNT_X86<Float32ToNativeInt32BlockOp>(src, (UInt8 *)dst, numToConvert);
+}
+
+void Float32ToSwapInt32_X86NT( const Float32 *src, SInt32 *dst, unsigned int numToConvert )
+{
+	Float32ToIntNT_X86<Float32ToSwapInt32BlockOp>(src, (UInt8 *)dst, numToConvert);
+}
+
+/*
+	Plain copies to write-combined memory, for hardware buffers that are filled without a format
+	conversion. As above, the destination is written with streaming stores, here after a scalar head
+	that aligns it; the cacheable source is prefetched kWCPrefetchDistance bytes ahead. The sfence
+	is only needed, and only done, if anything was streamed. The copies from write-combined memory
+	are in IOAudioBlitterLibDispatch.cpp (SSE4.1) and the AVX2 and AVX-512 files.
+*/
+void bcopy_ToWriteCombine_X86( const void *pSrc, void *pDst, unsigned int count )
+{
+	const UInt8 *src = (const UInt8 *)pSrc;
+	UInt8 *dst = (UInt8 *)pDst;
+	unsigned int head = (16 - ((uintptr_t)dst & 0xF)) & 0xF;
+	bool streamed = false;
+
+	if (count >= head + 16) {
+		// scalar head -- until the destination is 16-byte aligned
+		count -= head;
+		while (head--)
+			*dst++ = *src++;
+
+		for ( ; count >= 64; count -= 64) {
+			_mm_prefetch((const char *)src + kWCPrefetchDistance, _MM_HINT_NTA);
+			__m128i v0 = _mm_loadu_si128((__m128i const *)src);
+			__m128i v1 = _mm_loadu_si128((__m128i const *)src + 1);
+			__m128i v2 = _mm_loadu_si128((__m128i const *)src + 2);
+			__m128i v3 = _mm_loadu_si128((__m128i const *)src + 3);
+			_mm_stream_si128((__m128i *)dst, v0);
+			_mm_stream_si128((__m128i *)dst + 1, v1);
+			_mm_stream_si128((__m128i *)dst + 2, v2);
+			_mm_stream_si128((__m128i *)dst + 3, v3);
+			src += 64;
+			dst += 64;
+		}
+		for ( ; count >= 16; count -= 16) {
+			_mm_stream_si128((__m128i *)dst, _mm_loadu_si128((__m128i const *)src));
+			src += 16;
+			dst += 16;
+		}
+		streamed = true;
+	}
+
+	// scalar tail
+	while (count--)
+		*dst++ = *src++;
+
+	if (streamed)
+		_mm_sfence();
+}
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Float -> Int with gain
+
+/*
+	Float32 -> integer with a per-channel gain applied on the way, for drivers that do volume in
+	software. The source is interleaved, src[0] being channel 0, and gain[] holds one factor per
+	channel. Each block is multiplied by its gains into a local buffer which the block ops above
+	then convert, so there is no second pass over the mix buffer. The multiply runs in the
+	converters' round-toward-minus-infinity mode, so a product can be one float ulp lower than
+	scaling the buffer beforehand (in round-to-nearest) would give; that is at most one LSB for
+	16 and 24-bit output.
+
+	With up to kMaxRepeatedGainChannels channels the gains for any block are a contiguous run of
+	a table repeating gain[]; with more, only blocks that wrap past the last channel need their
+	gains gathered.
+*/
+
+#define kMaxRepeatedGainChannels	16
+
+template <class Op>
+static inline void Float32ToIntWithGain_X86( const Float32 *src, UInt8 *dst, unsigned int numToConvert, const Float32 *gain, unsigned int nChannels )
+{
+	static const unsigned int kBlock = Op::kSamplesPerBlock;
+	Float32 table[kMaxRepeatedGainChannels + kBlock];
+	Float32 wrapped[kBlock] __attribute__((aligned(16)));
+	Float32 scaled[kBlock] __attribute__((aligned(16)));
+	__m128i v[Op::kVectorsPerBlock];
+	unsigned int count = numToConvert;
+	unsigned int channel = 0;
+	unsigned int i;
+
+	if (nChannels == 0)
+		return;
+
+	bool repeated = (nChannels <= kMaxRepeatedGainChannels);
+	if (repeated) {
+		for (i = 0; i < nChannels + kBlock; ++i)
+			table[i] = gain[i % nChannels];
+	}
+
+	ROUNDMODE_NEG_INF
+	while (count > 0) {
+		const Float32 *g;
+		unsigned int n = (count < kBlock) ? count : kBlock;
+
+		if (repeated)
+			g = table + channel;
+		else if (channel + kBlock <= nChannels)
+			g = gain + channel;
+		else {
+			for (i = 0; i < kBlock; ++i)
+				wrapped[i] = gain[(channel + i) % nChannels];
+			g = wrapped;
+		}
+
+		if (n == kBlock) {
+			for (i = 0; i < kBlock; i += 4)
+				_mm_store_ps(scaled + i, _mm_mul_ps(_mm_loadu_ps(src + i), _mm_loadu_ps(g + i)));
+			Op::convert(scaled, v);
+			for (i = 0; i < Op::kVectorsPerBlock; ++i)
+				_mm_storeu_si128((__m128i *)dst + i, v[i]);
+		} else {
+			// last partial block: convert a zero-padded copy and keep only the samples asked for
+			UInt8 out[Op::kVectorsPerBlock * 16];
+			for (i = 0; i < kBlock; ++i)
+				scaled[i] = (i < n) ? src[i] * g[i] : 0.0f;
+			Op::convert(scaled, v);
+			for (i = 0; i < Op::kVectorsPerBlock; ++i)
+				_mm_storeu_si128((__m128i *)out + i, v[i]);
+			for (i = 0; i < n * Op::kBytesPerSample; ++i)
+				dst[i] = out[i];
+		}
+
+		src += n;
+		dst += n * Op::kBytesPerSample;
+		count -= n;
+		channel = (channel + n) % nChannels;
+	}
+	RESTORE_ROUNDMODE
+}
+
+void Float32ToNativeInt16WithGain_X86( const Float32 *src, SInt16 *dst, unsigned int numToConvert, const Float32 *gain, unsigned int nChannels )
+{
+	Float32ToIntWithGain_X86<Float32ToNativeInt16BlockOp>(src, (UInt8 *)dst, numToConvert, gain, nChannels);
+}
+
+void Float32ToSwapInt16WithGain_X86( const Float32 *src, SInt16 *dst, unsigned int numToConvert, const Float32 *gain, unsigned int nChannels )
+{
+	Float32ToIntWithGain_X86<Float32ToSwapInt16BlockOp>(src, (UInt8 *)dst, numToConvert, gain, nChannels);
+}
+
+void Float32ToNativeInt24WithGain_X86( const Float32 *src, UInt8 *dst, unsigned int numToConvert, const Float32 *gain, unsigned int nChannels )
+{
+	Float32ToIntWithGain_X86<Float32ToNativeInt24BlockOp>(src, dst, numToConvert, gain, nChannels);
+}
+
+void Float32ToSwapInt24WithGain_X86( const Float32 *src, UInt8 *dst, unsigned int numToConvert, const Float32 *gain, unsigned int nChannels )
+{
+	Float32ToIntWithGain_X86<Float32ToSwapInt24BlockOp>(src, dst, numToConvert, gain, nChannels);
+}
+
+void Float32ToNativeInt32WithGain_X86( const Float32 *src, SInt32 *dst, unsigned int numToConvert, const Float32 *gain, unsigned int nChannels )
+{
+	Float32ToIntWithGain_X86<Float32ToNativeInt32BlockOp>(src, (UInt8 *)dst, numToConvert, gain, nChannels);
+}
+
+void Float32ToSwapInt32WithGain_X86( const Float32 *src, SInt32 *dst, unsigned int numToConvert, const Float32 *gain, unsigned int nChannels )
+{
+	Float32ToIntWithGain_X86<Float32ToSwapInt32BlockOp>(src, (UInt8 *)dst, numToConvert, gain, nChannels);
+}
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Float -> Int dithered
+
+/*
+	Float32 -> 16 or 24-bit integer with TPDF dither, optionally noise shaped.
+
+	The noise comes from four vectors of xorshift generators, one per lane, stepped in turn so that
+	their shift/xor chains overlap, and every sample gets noise of its own. Each 32-bit random number
+	makes two samples of noise: the sum of the two bytes of each 16-bit half, less 255, which is
+	triangular over +/-255/256 LSB. The sum goes into the low mantissa bits of 32768.0f, whose last
+	place is 1/256; subtracting a constant then leaves the noise plus the 0.5 the block ops round
+	with. That bias replaces the 0.5 in the block ops' convertBiased().
+
+	Making the noise costs about as much as the conversion here; the AVX2 and AVX-512 versions do
+	it on wider vectors, and their integer work overlaps the float conversion.
+
+	Noise shaping feeds each channel's quantization error back into its next sample (first order,
+	1 - z^-1), moving the error up and away from the midrange. That recursion goes sample by sample
+	within a channel, so the shaped path works a frame at a time with the channels across the lanes,
+	quantizing into a local buffer that the block ops then convert as usual (the samples are already
+	exact multiples of one LSB). It is bound by the latency of the recursion rather than by the
+	noise. shapingError[] holds one error per channel, and calls must start on a frame boundary.
+*/
+
+#define kDitherChunkSamples	256
+#define kDitherGenerators	4
+#define kDitherRoundSamples	32		// one DitherBias8_X86 step of each generator
+
+static inline __m128i Xorshift32_X86( __m128i &s )
+{
+	s = _mm_xor_si128(s, _mm_slli_epi32(s, 13));
+	s = _mm_xor_si128(s, _mm_srli_epi32(s, 17));
+	s = _mm_xor_si128(s, _mm_slli_epi32(s, 5));
+	return s;
+}
+
+// 8 samples of TPDF noise in LSB units, plus 0.5
+static inline void DitherBias8_X86( __m128i &s, __m128 bias[2] )
+{
+	const __m128i lowByte = _mm_set1_epi16(0x00FF);
+	const __m128i exponent = _mm_set1_epi16(0x4700);
+	const __m128 offset = _mm_set1_ps(32768.0f + 127.0f / 256.0f);
+	__m128i r = Xorshift32_X86(s);
+	__m128i u = _mm_add_epi16(_mm_and_si128(r, lowByte), _mm_srli_epi16(r, 8));	// a + b
+
+	bias[0] = _mm_sub_ps(_mm_castsi128_ps(_mm_unpacklo_epi16(u, exponent)), offset);
+	bias[1] = _mm_sub_ps(_mm_castsi128_ps(_mm_unpackhi_epi16(u, exponent)), offset);
+}
+
+// hands out DitherBias8_X86's noise a vector at a time
+static inline __m128 NextDitherBias_X86( __m128i &s, __m128 bias[2], unsigned int &left )
+{
+	if (left == 0) {
+		DitherBias8_X86(s, bias);
+		left = 2;
+	}
+	return bias[--left];
+}
+
+// plain TPDF; the generators are copied into locals so that they stay in registers
+template <class Op>
+static inline void Float32ToIntTPDF_X86( const Float32 *src, UInt8 *dst, unsigned int count, __m128i s[kDitherGenerators] )
+{
+	__m128 bias[kDitherRoundSamples / 4];
+	__m128i v[Op::kVectorsPerBlock];
+	__m128i s0 = s[0], s1 = s[1], s2 = s[2], s3 = s[3];
+	unsigned int b, i;
+
+	for ( ; count >= kDitherRoundSamples; count -= kDitherRoundSamples) {
+		DitherBias8_X86(s0, bias);
+		DitherBias8_X86(s1, bias + 2);
+		DitherBias8_X86(s2, bias + 4);
+		DitherBias8_X86(s3, bias + 6);
+		for (b = 0; b < kDitherRoundSamples; b += Op::kSamplesPerBlock) {
+			Op::convertBiased(src, bias + b / 4, v);
+			for (i = 0; i < Op::kVectorsPerBlock; ++i)
+				_mm_storeu_si128((__m128i *)dst + i, v[i]);
+			src += Op::kSamplesPerBlock;
+			dst += Op::kSamplesPerBlock * Op::kBytesPerSample;
+		}
+	}
+	if (count) {
+		// a last partial round goes through whole blocks on the stack
+		Float32 tmp[kDitherRoundSamples];
+		UInt8 out[kDitherRoundSamples * Op::kBytesPerSample];
+		const unsigned int padded = (count + Op::kSamplesPerBlock - 1) & ~(Op::kSamplesPerBlock - 1);
+
+		for (b = 0; b < padded; b += 8)
+			DitherBias8_X86(s0, bias + b / 4);
+		for (i = 0; i < kDitherRoundSamples; ++i)
+			tmp[i] = (i < count) ? src[i] : 0.0f;
+		for (b = 0; b < count; b += Op::kSamplesPerBlock) {
+			Op::convertBiased(tmp + b, bias + b / 4, v);
+			for (i = 0; i < Op::kVectorsPerBlock; ++i)
+				_mm_storeu_si128((__m128i *)(out + b * Op::kBytesPerSample) + i, v[i]);
+		}
+		for (i = 0; i < count * Op::kBytesPerSample; ++i)
+			dst[i] = out[i];
+	}
+	s[0] = s0;
+	s[1] = s1;
+	s[2] = s2;
+	s[3] = s3;
+}
+
+template <class Op>
+static inline void ConvertQuantizedChunk_X86( const Float32 *chunk, UInt8 *dst, unsigned int count )
+{
+	__m128i v[Op::kVectorsPerBlock];
+	unsigned int i;
+
+	for ( ; count >= Op::kSamplesPerBlock; count -= Op::kSamplesPerBlock) {
+		Op::convert(chunk, v);
+		for (i = 0; i < Op::kVectorsPerBlock; ++i)
+			_mm_storeu_si128((__m128i *)dst + i, v[i]);
+		chunk += Op::kSamplesPerBlock;
+		dst += Op::kSamplesPerBlock * Op::kBytesPerSample;
+	}
+	if (count)
+		Op::convertScalar(chunk, dst, count);
+}
+
+template <class Op>
+static inline void Float32ToIntDithered_X86( const Float32 *src, UInt8 *dst, unsigned int numToConvert, unsigned int nChannels, UInt32 seed[], Float32 *shapingError )
+{
+	const Float32 scale = (Op::kBytesPerSample == 2) ? 32768.0f : 8388608.0f;
+	const __m128 vscale = _mm_set1_ps(scale);
+	const __m128 lsb = _mm_set1_ps(1.0f / scale);
+	const __m128 minusOne = _mm_set1_ps(-1.0f), one = _mm_set1_ps(1.0f);
+	Float32 tmp[4] __attribute__((aligned(16)));
+	__m128i s[kDitherGenerators];
+	unsigned int count = numToConvert;
+	unsigned int n, i, c, g;
+
+	if (nChannels == 0)
+		return;
+	if (nChannels > kDitherChunkSamples)
+		shapingError = NULL;
+	for (g = 0; g < kDitherGenerators; ++g)
+		s[g] = _mm_loadu_si128((__m128i const *)seed + g);
+
+	ROUNDMODE_NEG_INF
+	if (!shapingError) {
+		Float32ToIntTPDF_X86<Op>(src, dst, count, s);
+	} else {
+		Float32 chunk[kDitherChunkSamples + 4] __attribute__((aligned(16)));	// a frame's last vector may spill over
+		const unsigned int chunkFrames = (nChannels < kDitherChunkSamples) ? kDitherChunkSamples / nChannels : 1;
+		__m128 bias[2];
+		unsigned int biasLeft = 0;
+
+		while (count > 0 && nChannels <= 4) {
+			// a whole frame fits in one vector, so the error can stay in a register; the lanes
+			// past nChannels hold the next frame's samples and are overwritten when it comes round
+			__m128 err = _mm_loadu_ps(shapingError);
+
+			n = (count < chunkFrames * nChannels) ? count : chunkFrames * nChannels;
+			for (i = 0; i < n; i += nChannels) {
+				__m128 x, v, q;
+
+				if (i + 4 <= count)
+					x = _mm_loadu_ps(src + i);
+				else {
+					for (c = 0; c < 4; ++c)
+						tmp[c] = (i + c < count) ? src[i + c] : 0.0f;
+					x = _mm_load_ps(tmp);
+				}
+				// clip first, so a full scale or NaN input can't run the error away
+				x = _mm_mul_ps(_mm_min_ps(_mm_max_ps(x, minusOne), one), vscale);
+				v = _mm_sub_ps(x, err);
+				q = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_add_ps(v, NextDitherBias_X86(s[0], bias, biasLeft))));
+				err = _mm_sub_ps(q, v);
+				_mm_storeu_ps(chunk + i, _mm_mul_ps(q, lsb));
+			}
+			_mm_storeu_ps(shapingError, err);
+			ConvertQuantizedChunk_X86<Op>(chunk, dst, n);
+			src += n;
+			dst += n * Op::kBytesPerSample;
+			count -= n;
+		}
+		while (count > 0) {
+			n = (count < chunkFrames * nChannels) ? count : chunkFrames * nChannels;
+			for (i = 0; i < n; i += nChannels) {
+				for (c = 0; c < nChannels && i + c < n; c += 4) {
+					__m128 x, v, q;
+
+					if (i + c + 4 <= count)
+						x = _mm_loadu_ps(src + i + c);
+					else {
+						unsigned int k;
+						for (k = 0; k < 4; ++k)
+							tmp[k] = (i + c + k < count) ? src[i + c + k] : 0.0f;
+						x = _mm_load_ps(tmp);
+					}
+					x = _mm_mul_ps(_mm_min_ps(_mm_max_ps(x, minusOne), one), vscale);
+					v = _mm_sub_ps(x, _mm_loadu_ps(shapingError + c));
+					q = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_add_ps(v, NextDitherBias_X86(s[0], bias, biasLeft))));
+					_mm_storeu_ps(shapingError + c, _mm_sub_ps(q, v));
+					_mm_storeu_ps(chunk + i + c, _mm_mul_ps(q, lsb));
+				}
+			}
+			ConvertQuantizedChunk_X86<Op>(chunk, dst, n);
+			src += n;
+			dst += n * Op::kBytesPerSample;
+			count -= n;
+		}
+	}
+	RESTORE_ROUNDMODE
+
+	for (g = 0; g < kDitherGenerators; ++g)
+		_mm_storeu_si128((__m128i *)seed + g, s[g]);
+}
+
+void Float32ToNativeInt16Dithered_X86( const Float32 *src, SInt16 *dst, unsigned int numToConvert, unsigned int nChannels, UInt32 seed[], Float32 *shapingError )
+{
+	Float32ToIntDithered_X86<Float32ToNativeInt16BlockOp>(src, (UInt8 *)dst, numToConvert, nChannels, seed, shapingError);
+}
+
+void Float32ToSwapInt16Dithered_X86( const Float32 *src, SInt16 *dst, unsigned int numToConvert, unsigned int nChannels, UInt32 seed[], Float32 *shapingError )
+{
+	Float32ToIntDithered_X86<Float32ToSwapInt16BlockOp>(src, (UInt8 *)dst, numToConvert, nChannels, seed, shapingError);
+}
+
+void Float32ToNativeInt24Dithered_X86( const Float32 *src, UInt8 *dst, unsigned int numToConvert, unsigned int nChannels, UInt32 seed[], Float32 *shapingError )
+{
+	Float32ToIntDithered_X86<Float32ToNativeInt24BlockOp>(src, dst, numToConvert, nChannels, seed, shapingError);
+}
+
+void Float32ToSwapInt24Dithered_X86( const Float32 *src, UInt8 *dst, unsigned int numToConvert, unsigned int nChannels, UInt32 seed[], Float32 *shapingError )
+{
+	Float32ToIntDithered_X86<Float32ToSwapInt24BlockOp>(src, dst, numToConvert, nChannels, seed, shapingError);
+}
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Batched Float -> Int
+
+/*
+	Float32 -> integer for many small buffers in one call, e.g. one 2-channel stream per ADAT or MADI
+	pair. The round mode is set once for the batch instead of once per buffer. Adjacent jobs with the
+	same format are taken as a pair and converted a block of each at a time, both blocks loaded and
+	converted before either is stored, so the loads of one are in flight while the other converts.
+
+	The block ops do what the regular converters' vector paths do, and each job finishes with an
+	overlapping last block the same way, so every job comes out as its own converter would write it.
+	Jobs shorter than one block go to that converter, whose scalar path rounds differently.
+*/
+
+template <class Op>
+static inline void Float32ToIntBlocks_X86( const IOAF_ConversionJob *job, unsigned int done )
+{
+	const unsigned int kBlock = Op::kSamplesPerBlock;
+	const Float32 *src = job->src;
+	UInt8 *dst = (UInt8 *)job->dest;
+	unsigned int count = job->count;
+	unsigned int i;
+	__m128i v[Op::kVectorsPerBlock];
+
+	if (count < kBlock) {
+		Op::convertScalar(src, dst, count);
+		return;
+	}
+
+	for ( ; done + kBlock <= count; done += kBlock) {
+		Op::convert(src + done, v);
+		for (i = 0; i < Op::kVectorsPerBlock; ++i)
+			_mm_storeu_si128((__m128i *)(dst + done * Op::kBytesPerSample) + i, v[i]);
+	}
+
+	if (done < count) {
+		// unaligned cleanup -- just do one overlapping block at the end
+		done = count - kBlock;
+		Op::convert(src + done, v);
+		for (i = 0; i < Op::kVectorsPerBlock; ++i)
+			_mm_storeu_si128((__m128i *)(dst + done * Op::kBytesPerSample) + i, v[i]);
+	}
+}
+
+template <class Op>
+static inline void Float32ToIntJobs_X86( const IOAF_ConversionJob *a, const IOAF_ConversionJob *b )
+{
+	const unsigned int kBlock = Op::kSamplesPerBlock;
+	unsigned int done = 0;
+	unsigned int i;
+	__m128i va[Op::kVectorsPerBlock], vb[Op::kVectorsPerBlock];
+
+	if (b && a->count >= kBlock && b->count >= kBlock) {
+		// both jobs side by side for the blocks they have in common
+		unsigned int common = ((a->count < b->count) ? a->count : b->count) / kBlock * kBlock;
+		UInt8 *dstA = (UInt8 *)a->dest;
+		UInt8 *dstB = (UInt8 *)b->dest;
+
+		for ( ; done < common; done += kBlock) {
+			Op::convert(a->src + done, va);
+			Op::convert(b->src + done, vb);
+			for (i = 0; i < Op::kVectorsPerBlock; ++i) {
+				_mm_storeu_si128((__m128i *)(dstA + done * Op::kBytesPerSample) + i, va[i]);
+				_mm_storeu_si128((__m128i *)(dstB + done * Op::kBytesPerSample) + i, vb[i]);
+			}
+		}
+	}
+
+	Float32ToIntBlocks_X86<Op>(a, done);
+	if (b)
+		Float32ToIntBlocks_X86<Op>(b, done);
+}
+
+void Float32ToIntBatch_X86( const IOAF_ConversionJob *jobs, unsigned int nJobs )
+{
+	unsigned int n = 0;
+
+	ROUNDMODE_NEG_INF
+	while (n < nJobs) {
+		const IOAF_ConversionJob *a = &jobs[n++];
+		const IOAF_ConversionJob *b = NULL;
+
+		if (n < nJobs && jobs[n].format == a->format)
+			b = &jobs[n++];
+
+		switch (a->format) {
+			case kIOAF_NativeInt16:	Float32ToIntJobs_X86<Float32ToNativeInt16BlockOp>(a, b);	break;
+			case kIOAF_SwapInt16:	Float32ToIntJobs_X86<Float32ToSwapInt16BlockOp>(a, b);		break;
+			case kIOAF_NativeInt24:	Float32ToIntJobs_X86<Float32ToNativeInt24BlockOp>(a, b);	break;
+			case kIOAF_SwapInt24:	Float32ToIntJobs_X86<Float32ToSwapInt24BlockOp>(a, b);		break;
+			case kIOAF_NativeInt32:	Float32ToIntJobs_X86<Float32ToNativeInt32BlockOp>(a, b);	break;
+			case kIOAF_SwapInt32:	Float32ToIntJobs_X86<Float32ToSwapInt32BlockOp>(a, b);		break;
+			default:																			break;
+		}
+	}
+	RESTORE_ROUNDMODE
+}
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Gain ramp
+
+/*
+	Scales interleaved Float32 samples by a gain which changes every frame, so that a volume change
+	can be faded in instead of stepped. A linear ramp has g(n) = gain + n * step; each vector's gains
+	are computed from the frame number, so a long ramp does not accumulate error. An exponential ramp
+	has g(n) = gain * step^n, a straight line in dB, and multiplies its gains by step^k as it goes.
+	Mono and stereo put 4 and 2 frames in a vector; wider layouts broadcast each frame's gain across
+	its channels. src and dest may be the same buffer.
+*/
+
+template <bool kExponential>
+static inline Float32 GainRamp_X86( const Float32 *src, Float32 *dest, unsigned int nChannels, unsigned int nFrames, Float32 gain, Float32 step )
+{
+	Float32 g = gain;
+	unsigned int n = 0;
+
+	if (nChannels == 1 || nChannels == 2) {
+		const unsigned int k = 4 / nChannels;		// frames per vector
+		const __m128 frameOf = (nChannels == 1) ? _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f) : _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f);
+		__m128 gv = _mm_setzero_ps(), mul = _mm_setzero_ps();
+
+		if (kExponential) {
+			Float32 s2 = step * step;
+			gv = (nChannels == 1) ? _mm_setr_ps(gain, gain * step, gain * s2, gain * s2 * step) : _mm_setr_ps(gain, gain, gain * step, gain * step);
+			mul = _mm_set1_ps((nChannels == 1) ? s2 * s2 : s2);
+		}
+		for ( ; n + k <= nFrames; n += k) {
+			if (!kExponential)
+				gv = _mm_add_ps(_mm_set1_ps(gain + (Float32)n * step), _mm_mul_ps(frameOf, _mm_set1_ps(step)));
+			_mm_storeu_ps(dest, _mm_mul_ps(_mm_loadu_ps(src), gv));
+			if (kExponential)
+				gv = _mm_mul_ps(gv, mul);
+			src += 4;
+			dest += 4;
+		}
+		if (kExponential)
+			g = _mm_cvtss_f32(gv);
+	}
+
+	for ( ; n < nFrames; ++n) {
+		if (!kExponential)
+			g = gain + (Float32)n * step;
+		__m128 gv = _mm_set1_ps(g);
+		unsigned int c = 0;
+		for ( ; c + 4 <= nChannels; c += 4)
+			_mm_storeu_ps(dest + c, _mm_mul_ps(_mm_loadu_ps(src + c), gv));
+		for ( ; c < nChannels; ++c)
+			dest[c] = src[c] * g;
+		if (kExponential)
+			g *= step;
+		src += nChannels;
+		dest += nChannels;
+	}
+
+	return kExponential ? g : gain + (Float32)nFrames * step;
+}
+
+// a ramp that doesn't move: one multiply per sample, nothing at all for unity gain in place
+static inline void ScaleFloat32_X86( const Float32 *src, Float32 *dest, unsigned int count, Float32 gain )
+{
+	if (gain == 1.0f && src == dest)
+		return;
+
+	__m128 gv = _mm_set1_ps(gain);
+	for ( ; count >= 4; count -= 4) {
+		_mm_storeu_ps(dest, _mm_mul_ps(_mm_loadu_ps(src), gv));
+		src += 4;
+		dest += 4;
+	}
+	while (count--)
+		*dest++ = *src++ * gain;
+}
+
+Float32 GainRampFloat32_X86( const Float32 *src, Float32 *dest, unsigned int nChannels, unsigned int nFrames, Float32 gain, Float32 step, bool exponential )
+{
+	if (exponential ? (step == 1.0f) : (step == 0.0f)) {
+		ScaleFloat32_X86(src, dest, nChannels * nFrames, gain);
+		return gain;
+	}
+	if (exponential)
+		return GainRamp_X86<true>(src, dest, nChannels, nFrames, gain, step);
+	return GainRamp_X86<false>(src, dest, nChannels, nFrames, gain, step);
+}
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Int -> Int
+
+/*
+	Direct integer -> integer conversion, without going through float. Each lane op moves 16 samples
+	between memory and four vectors of 32-bit lanes holding the sample left-justified; any source
+	op can feed any destination op, so every width/byte-order pair is one instantiation of
+	IntToInt_X86. Narrowing rounds to nearest and clips exactly as TIntToIntBlitter does, which
+	also converts the last (count % 16) samples.
+
+	Loads and stores are unaligned and every sample is read before its block is written, so the
+	conversion may be done in place when the source and destination widths are equal.
+*/
+
+class NativeInt16LaneOp {
+public:
+	typedef PCMSInt16Native traits;
+	static const unsigned int kBytesPerSample = 2;
+	static inline void load(const UInt8 *src, __m128i v[4])
+	{
+		load(_mm_loadu_si128((__m128i const *)src), _mm_loadu_si128((__m128i const *)src + 1), v);
+	}
+	static inline void load(__m128i a, __m128i b, __m128i v[4])
+	{
+		const __m128i zero = _mm_setzero_si128();
+		v[0] = _mm_unpacklo_epi16(zero, a);
+		v[1] = _mm_unpackhi_epi16(zero, a);
+		v[2] = _mm_unpacklo_epi16(zero, b);
+		v[3] = _mm_unpackhi_epi16(zero, b);
+	}
+	// round to 16 bits; packs saturates the one lane that rounds up past full scale
+	static inline __m128i pack(__m128i v0, __m128i v1)
+	{
+		const __m128i one = _mm_set1_epi32(1);
+		v0 = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(v0, 15), one), 1);
+		v1 = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(v1, 15), one), 1);
+		return _mm_packs_epi32(v0, v1);
+	}
+	static inline void store(UInt8 *dst, const __m128i v[4])
+	{
+		_mm_storeu_si128((__m128i *)dst, pack(v[0], v[1]));
+		_mm_storeu_si128((__m128i *)dst + 1, pack(v[2], v[3]));
+	}
+};
+
+class SwapInt16LaneOp : public NativeInt16LaneOp {
+public:
+	typedef PCMSInt16Swap traits;
+	static inline void load(const UInt8 *src, __m128i v[4])
+	{
+		NativeInt16LaneOp::load(byteswap16(_mm_loadu_si128((__m128i const *)src)), byteswap16(_mm_loadu_si128((__m128i const *)src + 1)), v);
+	}
+	static inline void store(UInt8 *dst, const __m128i v[4])
+	{
+		_mm_storeu_si128((__m128i *)dst, byteswap16(pack(v[0], v[1])));
+		_mm_storeu_si128((__m128i *)dst + 1, byteswap16(pack(v[2], v[3])));
+	}
+};
+
+class NativeInt32LaneOp {
+public:
+	typedef PCMSInt32Native traits;
+	static const unsigned int kBytesPerSample = 4;
+	static inline void load(const UInt8 *src, __m128i v[4])
+	{
+		for (int i = 0; i < 4; ++i)
+			v[i] = _mm_loadu_si128((__m128i const *)src + i);
+	}
+	static inline void store(UInt8 *dst, const __m128i v[4])
+	{
+		for (int i = 0; i < 4; ++i)
+			_mm_storeu_si128((__m128i *)dst + i, v[i]);
+	}
+};
+
+class SwapInt32LaneOp {
+public:
+	typedef PCMSInt32Swap traits;
+	static const unsigned int kBytesPerSample = 4;
+	static inline void load(const UInt8 *src, __m128i v[4])
+	{
+		for (int i = 0; i < 4; ++i)
+			v[i] = byteswap32(_mm_loadu_si128((__m128i const *)src + i));
+	}
+	static inline void store(UInt8 *dst, const __m128i v[4])
+	{
+		for (int i = 0; i < 4; ++i)
+			_mm_storeu_si128((__m128i *)dst + i, byteswap32(v[i]));
+	}
+};
+
+// 16 packed samples are 48 bytes: four groups of 12 spread over three vectors, as in
+// Float32ToNativeInt24BlockOp.
+class NativeInt24LaneOp {
+public:
+	typedef PCMSInt24Native traits;
+	static const unsigned int kBytesPerSample = 3;
+
+	// spread the 4 samples in the low 12 bytes of g to bytes kShift to kShift + 2 of each lane
+	template <int kShift>
+	static inline __m128i unpack4(__m128i g, __m128i mask)
+	{
+		__m128i v = _mm_and_si128(_mm_slli_si128(g, kShift), mask);
+		v = _mm_or_si128(v, _mm_and_si128(_mm_slli_si128(g, kShift + 1), _mm_slli_si128(mask, 4)));
+		v = _mm_or_si128(v, _mm_and_si128(_mm_slli_si128(g, kShift + 2), _mm_slli_si128(mask, 8)));
+		v = _mm_or_si128(v, _mm_and_si128(_mm_slli_si128(g, kShift + 3), _mm_slli_si128(mask, 12)));
+		return v;
+	}
+	// native samples go to bytes 1-3 of each lane, left-justified; swapped ones to bytes 0-2,
+	// high byte first, ready for byteswap32
+	template <int kShift>
+	static inline void unpack(const UInt8 *src, __m128i v[4])
+	{
+		const __m128i mask = _mm_setr_epi32((int)(0xFFFFFFU << (8 * kShift)), 0, 0, 0);
+		__m128i a = _mm_loadu_si128((__m128i const *)src);
+		__m128i b = _mm_loadu_si128((__m128i const *)src + 1);
+		__m128i c = _mm_loadu_si128((__m128i const *)src + 2);
+		v[0] = unpack4<kShift>(a, mask);
+		v[1] = unpack4<kShift>(_mm_or_si128(_mm_srli_si128(a, 12), _mm_slli_si128(b, 4)), mask);
+		v[2] = unpack4<kShift>(_mm_or_si128(_mm_srli_si128(b, 8), _mm_slli_si128(c, 8)), mask);
+		v[3] = unpack4<kShift>(_mm_srli_si128(c, 4), mask);
+	}
+	// round to 24 bits and clip the lanes that round up past full scale
+	static inline __m128i round24(__m128i v)
+	{
+		const __m128i max24 = _mm_set1_epi32(0x7FFFFF);
+		v = _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(v, 7), _mm_set1_epi32(1)), 1);
+		__m128i over = _mm_cmpgt_epi32(v, max24);
+		return _mm_or_si128(_mm_andnot_si128(over, v), _mm_and_si128(over, max24));
+	}
+	static inline void pack(UInt8 *dst, const __m128i v[4], bool swap)
+	{
+		const __m128i mask = _mm_setr_epi32(0x00FFFFFF, 0, 0, 0);
+		__m128i p[4];
+		for (int i = 0; i < 4; ++i) {
+			__m128i vi = round24(v[i]);
+			p[i] = Pack32ToLE24(swap ? byteswap32(vi) : _mm_slli_epi32(vi, 8), mask);
+		}
+		_mm_storeu_si128((__m128i *)dst, _mm_or_si128(p[0], _mm_slli_si128(p[1], 12)));
+		_mm_storeu_si128((__m128i *)dst + 1, _mm_or_si128(_mm_srli_si128(p[1], 4), _mm_slli_si128(p[2], 8)));
+		_mm_storeu_si128((__m128i *)dst + 2, _mm_or_si128(_mm_srli_si128(p[2], 8), _mm_slli_si128(p[3], 4)));
+	}
+	static inline void load(const UInt8 *src, __m128i v[4]) { unpack<1>(src, v); }
+	static inline void store(UInt8 *dst, const __m128i v[4]) { pack(dst, v, false); }
+};
+
+class SwapInt24LaneOp : public NativeInt24LaneOp {
+public:
+	typedef PCMSInt24Swap traits;
+	static inline void load(const UInt8 *src, __m128i v[4])
+	{
+		unpack<0>(src, v);
+		for (int i = 0; i < 4; ++i)
+			v[i] = byteswap32(v[i]);
+	}
+	static inline void store(UInt8 *dst, const __m128i v[4]) { pack(dst, v, true); }
+};
+
+template <class SrcOp, class DestOp>
+static inline void IntToInt_X86( const void *vsrc, void *vdst, unsigned int numToConvert )
+{
+	const UInt8 *src = (const UInt8 *)vsrc;
+	UInt8 *dst = (UInt8 *)vdst;
+	unsigned int count = numToConvert;
+	__m128i v[4];
+
+	while (count >= 16) {
+		SrcOp::load(src, v);
+		DestOp::store(dst, v);
+		src += 16 * SrcOp::kBytesPerSample;
+		dst += 16 * DestOp::kBytesPerSample;
+		count -= 16;
+	}
+	TIntToIntBlitter<typename SrcOp::traits, typename DestOp::traits>::ConvertSamples(src, dst, count);
+}
+
+// ___________________________________________________________________________________________________
+// pure byte swaps: same width, opposite byte order
+
+void ByteSwapInt16_X86( const void *src, void *dst, unsigned int numToConvert )
+{
+	const __m128i *vsrc = (const __m128i *)src;
+	__m128i *vdst = (__m128i *)dst;
+	unsigned int count = numToConvert;
+
+	while (count >= 8) {
+		_mm_storeu_si128(vdst++, byteswap16(_mm_loadu_si128(vsrc++)));
+		count -= 8;
+	}
+	TIntToIntBlitter<PCMSInt16Native, PCMSInt16Swap>::ConvertSamples(vsrc, vdst, count);
+}
+
+void ByteSwapInt24_X86( const void *src, void *dst, unsigned int numToConvert )
+{
+	IntToInt_X86<NativeInt24LaneOp, SwapInt24LaneOp>(src, dst, numToConvert);
+}
+
+void ByteSwapInt32_X86( const void *src, void *dst, unsigned int numToConvert )
+{
+	const __m128i *vsrc = (const __m128i *)src;
+	__m128i *vdst = (__m128i *)dst;
+	unsigned int count = numToConvert;
+
+	while (count >= 4) {
+		_mm_storeu_si128(vdst++, byteswap32(_mm_loadu_si128(vsrc++)));
+		count -= 4;
+	}
+	TIntToIntBlitter<PCMSInt32Native, PCMSInt32Swap>::ConvertSamples(vsrc, vdst, count);
+}
+
+// ___________________________________________________________________________________________________
+// width changes
+
+#define DEFINE_INT_TO_INT_X86(Src, Dest) \
+void Src##To##Dest##_X86( const void *src, void *dst, unsigned int numToConvert ) \
+{ \
+	IntToInt_X86<Src##LaneOp, Dest##LaneOp>(src, dst, numToConvert); \
+}
+
+DEFINE_INT_TO_INT_X86(NativeInt16, NativeInt24)
+DEFINE_INT_TO_INT_X86(NativeInt16, SwapInt24)
+DEFINE_INT_TO_INT_X86(SwapInt16, NativeInt24)
+DEFINE_INT_TO_INT_X86(SwapInt16, SwapInt24)
+DEFINE_INT_TO_INT_X86(NativeInt16, NativeInt32)
+DEFINE_INT_TO_INT_X86(NativeInt16, SwapInt32)
+DEFINE_INT_TO_INT_X86(SwapInt16, NativeInt32)
+DEFINE_INT_TO_INT_X86(SwapInt16, SwapInt32)
+
+DEFINE_INT_TO_INT_X86(NativeInt24, NativeInt16)
+DEFINE_INT_TO_INT_X86(NativeInt24, SwapInt16)
+DEFINE_INT_TO_INT_X86(SwapInt24, NativeInt16)
+DEFINE_INT_TO_INT_X86(SwapInt24, SwapInt16)
+DEFINE_INT_TO_INT_X86(NativeInt24, NativeInt32)
+DEFINE_INT_TO_INT_X86(NativeInt24, SwapInt32)
+DEFINE_INT_TO_INT_X86(SwapInt24, NativeInt32)
+DEFINE_INT_TO_INT_X86(SwapInt24, SwapInt32)
+
+DEFINE_INT_TO_INT_X86(NativeInt32, NativeInt16)
+DEFINE_INT_TO_INT_X86(NativeInt32, SwapInt16)
+DEFINE_INT_TO_INT_X86(SwapInt32, NativeInt16)
+DEFINE_INT_TO_INT_X86(SwapInt32, SwapInt16)
+DEFINE_INT_TO_INT_X86(NativeInt32, NativeInt24)
+DEFINE_INT_TO_INT_X86(NativeInt32, SwapInt24)
+DEFINE_INT_TO_INT_X86(SwapInt32, NativeInt24)
+DEFINE_INT_TO_INT_X86(SwapInt32, SwapInt24)
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Float64, 8-bit and G.711
+
+/*
+	Float32 <-> Float64 is a plain cvtps2pd/cvtpd2ps. 8-bit samples are scaled by 2^7 and rounded
+	and clipped like the other integer formats; unsigned 8-bit is offset by 128.
+
+	A-law and mu-law (G.711) are encoded as the usual 16-bit reference encoders do it: round to
+	16 bits as Float32ToNativeInt16 does, then split the magnitude into a 3-bit segment and a 4-bit
+	mantissa. Both come out of the magnitude converted to float: its exponent is the segment plus a
+	constant, and its top four mantissa bits are the four bits after the leading one, so no table
+	or bit scan is needed. Decoding goes through 256-entry tables of the 16-bit values; the SSSE3
+	versions of the decoders compute the same values with pshufb lookups.
+
+	The byte formats are converted 16 samples at a time; a partial last block goes through a
+	whole one on the stack.
+*/
+
+static const SInt16 sALawToLinear[256] = {
+	-5504, -5248, -6016, -5760, -4480, -4224, -4992, -4736,
+	-7552, -7296, -8064, -7808, -6528, -6272, -7040, -6784,
+	-2752, -2624, -3008, -2880, -2240, -2112, -2496, -2368,
+	-3776, -3648, -4032, -3904, -3264, -3136, -3520, -3392,
+	-22016, -20992, -24064, -23040, -17920, -16896, -19968, -18944,
+	-30208, -29184, -32256, -31232, -26112, -25088, -28160, -27136,
+	-11008, -10496, -12032, -11520, -8960, -8448, -9984, -9472,
+	-15104, -14592, -16128, -15616, -13056, -12544, -14080, -13568,
+	-344, -328, -376, -360, -280, -264, -312, -296,
+	-472, -456, -504, -488, -408, -392, -440, -424,
+	-88, -72, -120, -104, -24, -8, -56, -40,
+	-216, -200, -248, -232, -152, -136, -184, -168,
+	-1376, -1312, -1504, -1440, -1120, -1056, -1248, -1184,
+	-1888, -1824, -2016, -1952, -1632, -1568, -1760, -1696,
+	-688, -656, -752, -720, -560, -528, -624, -592,
+	-944, -912, -1008, -976, -816, -784, -880, -848,
+	5504, 5248, 6016, 5760, 4480, 4224, 4992, 4736,
+	7552, 7296, 8064, 7808, 6528, 6272, 7040, 6784,
+	2752, 2624, 3008, 2880, 2240, 2112, 2496, 2368,
+	3776, 3648, 4032, 3904, 3264, 3136, 3520, 3392,
+	22016, 20992, 24064, 23040, 17920, 16896, 19968, 18944,
+	30208, 29184, 32256, 31232, 26112, 25088, 28160, 27136,
+	11008, 10496, 12032, 11520, 8960, 8448, 9984, 9472,
+	15104, 14592, 16128, 15616, 13056, 12544, 14080, 13568,
+	344, 328, 376, 360, 280, 264, 312, 296,
+	472, 456, 504, 488, 408, 392, 440, 424,
+	88, 72, 120, 104, 24, 8, 56, 40,
+	216, 200, 248, 232, 152, 136, 184, 168,
+	1376, 1312, 1504, 1440, 1120, 1056, 1248, 1184,
+	1888, 1824, 2016, 1952, 1632, 1568, 1760, 1696,
+	688, 656, 752, 720, 560, 528, 624, 592,
+	944, 912, 1008, 976, 816, 784, 880, 848
+};
+
+static const SInt16 sMuLawToLinear[256] = {
+	-32124, -31100, -30076, -29052, -28028, -27004, -25980, -24956,
+	-23932, -22908, -21884, -20860, -19836, -18812, -17788, -16764,
+	-15996, -15484, -14972, -14460, -13948, -13436, -12924, -12412,
+	-11900, -11388, -10876, -10364, -9852, -9340, -8828, -8316,
+	-7932, -7676, -7420, -7164, -6908, -6652, -6396, -6140,
+	-5884, -5628, -5372, -5116, -4860, -4604, -4348, -4092,
+	-3900, -3772, -3644, -3516, -3388, -3260, -3132, -3004,
+	-2876, -2748, -2620, -2492, -2364, -2236, -2108, -1980,
+	-1884, -1820, -1756, -1692, -1628, -1564, -1500, -1436,
+	-1372, -1308, -1244, -1180, -1116, -1052, -988, -924,
+	-876, -844, -812, -780, -748, -716, -684, -652,
+	-620, -588, -556, -524, -492, -460, -428, -396,
+	-372, -356, -340, -324, -308, -292, -276, -260,
+	-244, -228, -212, -196, -180, -164, -148, -132,
+	-120, -112, -104, -96, -88, -80, -72, -64,
+	-56, -48, -40, -32, -24, -16, -8, 0,
+	32124, 31100, 30076, 29052, 28028, 27004, 25980, 24956,
+	23932, 22908, 21884, 20860, 19836, 18812, 17788, 16764,
+	15996, 15484, 14972, 14460, 13948, 13436, 12924, 12412,
+	11900, 11388, 10876, 10364, 9852, 9340, 8828, 8316,
+	7932, 7676, 7420, 7164, 6908, 6652, 6396, 6140,
+	5884, 5628, 5372, 5116, 4860, 4604, 4348, 4092,
+	3900, 3772, 3644, 3516, 3388, 3260, 3132, 3004,
+	2876, 2748, 2620, 2492, 2364, 2236, 2108, 1980,
+	1884, 1820, 1756, 1692, 1628, 1564, 1500, 1436,
+	1372, 1308, 1244, 1180, 1116, 1052, 988, 924,
+	876, 844, 812, 780, 748, 716, 684, 652,
+	620, 588, 556, 524, 492, 460, 428, 396,
+	372, 356, 340, 324, 308, 292, 276, 260,
+	244, 228, 212, 196, 180, 164, 148, 132,
+	120, 112, 104, 96, 88, 80, 72, 64,
+	56, 48, 40, 32, 24, 16, 8, 0
+};
+
+void Float32ToFloat64_X86( const Float32 *src, Float64 *dst, unsigned int numToConvert )
+{
+	unsigned int count = numToConvert;
+
+	for ( ; count >= 4; count -= 4) {
+		__m128 vf = _mm_loadu_ps(src);
+		_mm_storeu_pd(dst, _mm_cvtps_pd(vf));
+		_mm_storeu_pd(dst + 2, _mm_cvtps_pd(_mm_movehl_ps(vf, vf)));
+		src += 4;
+		dst += 4;
+	}
+	while (count--)
+		*dst++ = *src++;
+}
+
+void Float64ToFloat32_X86( const Float64 *src, Float32 *dst, unsigned int numToConvert )
+{
+	unsigned int count = numToConvert;
+
+	for ( ; count >= 4; count -= 4) {
+		__m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(src));
+		__m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(src + 2));
+		_mm_storeu_ps(dst, _mm_movelh_ps(lo, hi));
+		src += 4;
+		dst += 4;
+	}
+	while (count--)
+		*dst++ = (Float32)*src++;
+}
+
+// Each op converts 4 floats to 4 byte values in 32-bit lanes, signed (-128 to 127) if kSigned,
+// otherwise unsigned (0 to 255).
+
+class Float32ToSInt8ByteOp {
+public:
+	static const bool kSigned = true;
+	static inline __m128i convert4(__m128 vf)
+	{
+		vf = _mm_mul_ps(vf, _mm_set1_ps(128.0f));
+		vf = _mm_add_ps(vf, _mm_set1_ps(0.5f));
+		vf = _mm_max_ps(vf, _mm_set1_ps(-128.0f));
+		vf = _mm_min_ps(vf, _mm_set1_ps(127.0f));
+		return _mm_cvtps_epi32(vf);
+	}
+};
+
+class Float32ToUInt8ByteOp {
+public:
+	static const bool kSigned = false;
+	static inline __m128i convert4(__m128 vf)
+	{
+		return _mm_add_epi32(Float32ToSInt8ByteOp::convert4(vf), _mm_set1_epi32(128));
+	}
+};
+
+// the sample rounded to 16 bits, as a float
+static inline __m128 Float32ToInt16Value_X86( __m128 vf )
+{
+	vf = _mm_mul_ps(vf, _mm_set1_ps(32768.0f));
+	vf = _mm_add_ps(vf, _mm_set1_ps(0.5f));
+	vf = _mm_max_ps(vf, _mm_set1_ps(-32768.0f));
+	vf = _mm_min_ps(vf, _mm_set1_ps(32767.0f));
+	return _mm_cvtepi32_ps(_mm_cvtps_epi32(vf));
+}
+
+// 132 + magnitude (clipped to 32635) is in [2^7, 2^15), so its exponent is 134 + segment
+class Float32ToMuLawByteOp {
+public:
+	static const bool kSigned = false;
+	static inline __m128i convert4(__m128 vf)
+	{
+		const __m128 signBit = _mm_set1_ps(-0.0f);
+		__m128 mag;
+		__m128i v;
+
+		vf = Float32ToInt16Value_X86(vf);
+		mag = _mm_min_ps(_mm_andnot_ps(signBit, vf), _mm_set1_ps(32635.0f));
+		v = _mm_srli_epi32(_mm_castps_si128(_mm_add_ps(mag, _mm_set1_ps(132.0f))), 19);
+		v = _mm_sub_epi32(v, _mm_set1_epi32(134 << 4));
+		v = _mm_or_si128(v, _mm_srli_epi32(_mm_castps_si128(_mm_and_ps(vf, signBit)), 24));
+		return _mm_xor_si128(v, _mm_set1_epi32(0xFF));
+	}
+};
+
+// On 13 bits, with negative samples as -p - 1, the magnitude is 0-4095. Segment 0 (below 32) has
+// the same mantissa as segment 1 would for magnitude + 32; otherwise the exponent is 131 + segment.
+class Float32ToALawByteOp {
+public:
+	static const bool kSigned = false;
+	static inline __m128i convert4(__m128 vf)
+	{
+		__m128i vi, neg, low, v;
+
+		vi = _mm_srai_epi32(_mm_cvtps_epi32(Float32ToInt16Value_X86(vf)), 3);
+		neg = _mm_srai_epi32(vi, 31);
+		vi = _mm_xor_si128(vi, neg);
+		low = _mm_cmplt_epi32(vi, _mm_set1_epi32(32));
+		vi = _mm_add_epi32(vi, _mm_and_si128(low, _mm_set1_epi32(32)));
+		v = _mm_srli_epi32(_mm_castps_si128(_mm_cvtepi32_ps(vi)), 19);
+		v = _mm_sub_epi32(v, _mm_set1_epi32(131 << 4));
+		v = _mm_add_epi32(v, _mm_slli_epi32(low, 4));
+		return _mm_xor_si128(v, _mm_xor_si128(_mm_set1_epi32(0xD5), _mm_and_si128(neg, _mm_set1_epi32(0x80))));
+	}
+};
+
+template <class Op>
+static inline __m128i Float32ToBytes16_X86( const Float32 *src )
+{
+	__m128i lo = _mm_packs_epi32(Op::convert4(_mm_loadu_ps(src)), Op::convert4(_mm_loadu_ps(src + 4)));
+	__m128i hi = _mm_packs_epi32(Op::convert4(_mm_loadu_ps(src + 8)), Op::convert4(_mm_loadu_ps(src + 12)));
+	return Op::kSigned ? _mm_packs_epi16(lo, hi) : _mm_packus_epi16(lo, hi);
+}
+
+template <class Op>
+static inline void Float32ToBytes_X86( const Float32 *src, UInt8 *dst, unsigned int numToConvert )
+{
+	Float32 tmp[16];
+	UInt8 out[16];
+	unsigned int count = numToConvert;
+	unsigned int i;
+
+	ROUNDMODE_NEG_INF
+	for ( ; count >= 16; count -= 16) {
+		_mm_storeu_si128((__m128i *)dst, Float32ToBytes16_X86<Op>(src));
+		src += 16;
+		dst += 16;
+	}
+	if (count) {
+		for (i = 0; i < 16; ++i)
+			tmp[i] = (i < count) ? src[i] : 0.0f;
+		_mm_storeu_si128((__m128i *)out, Float32ToBytes16_X86<Op>(tmp));
+		for (i = 0; i < count; ++i)
+			dst[i] = out[i];
+	}
+	RESTORE_ROUNDMODE
+}
+
+void Float32ToSInt8_X86( const Float32 *src, SInt8 *dst, unsigned int numToConvert )
+{
+	Float32ToBytes_X86<Float32ToSInt8ByteOp>(src, (UInt8 *)dst, numToConvert);
+}
+
+void Float32ToUInt8_X86( const Float32 *src, UInt8 *dst, unsigned int numToConvert )
+{
+	Float32ToBytes_X86<Float32ToUInt8ByteOp>(src, dst, numToConvert);
+}
+
+void Float32ToALaw_X86( const Float32 *src, UInt8 *dst, unsigned int numToConvert )
+{
+	Float32ToBytes_X86<Float32ToALawByteOp>(src, dst, numToConvert);
+}
+
+void Float32ToMuLaw_X86( const Float32 *src, UInt8 *dst, unsigned int numToConvert )
+{
+	Float32ToBytes_X86<Float32ToMuLawByteOp>(src, dst, numToConvert);
+}
+
+// flip is 0x80 for unsigned samples, which makes them signed
+static inline void Int8ToFloat32_X86( const UInt8 *src, Float32 *dst, unsigned int numToConvert, UInt8 flip )
+{
+	const __m128 vscale = _mm_set1_ps(1.0f / 128.0f);
+	const __m128i vflip = _mm_set1_epi8(flip);
+	unsigned int count = numToConvert;
+
+	for ( ; count >= 16; count -= 16) {
+		__m128i v = _mm_xor_si128(_mm_loadu_si128((__m128i const *)src), vflip);
+		__m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+		__m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8);
+		_mm_storeu_ps(dst, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16)), vscale));
+		_mm_storeu_ps(dst + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16)), vscale));
+		_mm_storeu_ps(dst + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16)), vscale));
+		_mm_storeu_ps(dst + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16)), vscale));
+		src += 16;
+		dst += 16;
+	}
+	while (count--)
+		*dst++ = (Float32)(SInt8)(*src++ ^ flip) * (1.0f / 128.0f);
+}
+
+void SInt8ToFloat32_X86( const SInt8 *src, Float32 *dst, unsigned int numToConvert )
+{
+	Int8ToFloat32_X86((const UInt8 *)src, dst, numToConvert, 0);
+}
+
+void UInt8ToFloat32_X86( const UInt8 *src, Float32 *dst, unsigned int numToConvert )
+{
+	Int8ToFloat32_X86(src, dst, numToConvert, 0x80);
+}
+
+// no gather in SSE2; four loads from a table that stays in L1 are as quick
+static inline void LawToFloat32_X86( const UInt8 *src, Float32 *dst, unsigned int numToConvert, const SInt16 table[256] )
+{
+	const __m128 vscale = _mm_set1_ps(1.0f / 32768.0f);
+	unsigned int count = numToConvert;
+
+	for ( ; count >= 4; count -= 4) {
+		__m128i vi = _mm_setr_epi32(table[src[0]], table[src[1]], table[src[2]], table[src[3]]);
+		_mm_storeu_ps(dst, _mm_mul_ps(_mm_cvtepi32_ps(vi), vscale));
+		src += 4;
+		dst += 4;
+	}
+	while (count--)
+		*dst++ = (Float32)table[*src++] * (1.0f / 32768.0f);
+}
+
+void ALawToFloat32_X86( const UInt8 *src, Float32 *dst, unsigned int numToConvert )
+{
+	LawToFloat32_X86(src, dst, numToConvert, sALawToLinear);
+}
+
+void MuLawToFloat32_X86( const UInt8 *src, Float32 *dst, unsigned int numToConvert )
+{
+	LawToFloat32_X86(src, dst, numToConvert, sMuLawToLinear);
+}
+
+// ===================================================================================================
+#pragma mark -
+#pragma mark Justified Int
+
+/*
+	Samples narrower than their container: bitDepth significant bits in 16, 24 or 32-bit words,
+	either high aligned (left-justified, the bits below the sample zero) or low aligned
+	(right-justified, the sign extended above it). 20-bit samples in packed 24-bit words and
+	24-bit samples in 32-bit words are the common cases.
+
+	Blocks of 16 go through the int -> int lane ops, so the sample is left-justified in a 32-bit
+	lane in between. Float -> int rounds to bitDepth bits as the full-width converters round to
+	theirs and shifts a low aligned sample down into place; the narrowing in the lane op's store
+	is then exact, as the bits it rounds away are zero. Int -> float drops the bits outside the
+	sample before scaling, whatever the hardware left there. A last partial block is converted
+	through a zero-padded one on the stack.
+*/
+
+class JustifiedFormat_X86 {
+public:
+	JustifiedFormat_X86( unsigned int bitDepth, unsigned int bitWidth, bool highAligned )
+	{
+		const Float32 fullScale = (Float32)(1U << (bitDepth - 1));
+
+		mScale = _mm_set1_ps(fullScale);
+		mMinValue = _mm_set1_ps(-fullScale);
+		// above 24 bits the largest value below full scale is limited by the float's precision
+		mMaxValue = _mm_set1_ps(fullScale - ((bitDepth <= 24) ? 1.0f : (Float32)(1U << (bitDepth - 25))));
+		mToTop = _mm_cvtsi32_si128(32 - bitDepth);
+		mToPlace = _mm_cvtsi32_si128(highAligned ? 0 : bitWidth - bitDepth);
+		mSampleMask = _mm_set1_epi32((int)(0xFFFFFFFFU << (32 - bitDepth)));
+		mHighAligned = highAligned;
+	}
+	// must be called under ROUNDMODE_NEG_INF
+	inline __m128i fromFloat(__m128 vf) const
+	{
+		vf = _mm_add_ps(_mm_mul_ps(vf, mScale), _mm_set1_ps(0.5f));
+		vf = _mm_min_ps(_mm_max_ps(vf, mMinValue), mMaxValue);
+		return _mm_sra_epi32(_mm_sll_epi32(_mm_cvtps_epi32(vf), mToTop), mToPlace);
+	}
+	inline __m128 toFloat(__m128i vi) const
+	{
+		vi = mHighAligned ? _mm_and_si128(vi, mSampleMask) : _mm_sll_epi32(vi, mToPlace);
+		return _mm_mul_ps(_mm_cvtepi32_ps(vi), _mm_set1_ps(1.0f / 2147483648.0f));
+	}
+
+private:
+	__m128	mScale, mMinValue, mMaxValue;
+	__m128i	mToTop, mToPlace, mSampleMask;
+	bool	mHighAligned;
+};
+
+template <class LaneOp>
+static inline void ConvertJustifiedBlock_X86( const Float32 *src, UInt8 *dst, const JustifiedFormat_X86 &format )
+{
+	__m128i v[4];
+
+	for (int i = 0; i < 4; ++i)
+		v[i] = format.fromFloat(_mm_loadu_ps(src + 4 * i));
+	LaneOp::store(dst, v);
+}
+
+template <class LaneOp>
+static inline void Float32ToIntJustified_X86( const Float32 *src, UInt8 *dst, unsigned int numToConvert, const JustifiedFormat_X86 &format )
+{
+	unsigned int count = numToConvert;
+	unsigned int i;
+
+	ROUNDMODE_NEG_INF
+	for ( ; count >= 16; count -= 16) {
+		ConvertJustifiedBlock_X86<LaneOp>(src, dst, format);
+		src += 16;
+		dst += 16 * LaneOp::kBytesPerSample;
+	}
+	if (count) {
+		Float32 in[16];
+		UInt8 out[16 * 4];
+
+		for (i = 0; i < 16; ++i)
+			in[i] = (i < count) ? src[i] : 0.0f;
+		ConvertJustifiedBlock_X86<LaneOp>(in, out, format);
+		for (i = 0; i < count * LaneOp::kBytesPerSample; ++i)
+			dst[i] = out[i];
+	}
+	RESTORE_ROUNDMODE
+}
+
+template <class LaneOp>
+static inline void ConvertJustifiedBlock_X86( const UInt8 *src, Float32 *dst, const JustifiedFormat_X86 &format )
+{
+	__m128i v[4];
+
+	LaneOp::load(src, v);
+	for (int i = 0; i < 4; ++i)
+		_mm_storeu_ps(dst + 4 * i, format.toFloat(v[i]));
+}
+
+template <class LaneOp>
+static inline void IntJustifiedToFloat32_X86( const UInt8 *src, Float32 *dst, unsigned int numToConvert, const JustifiedFormat_X86 &format )
+{
+	unsigned int count = numToConvert;
+	unsigned int i;
+
+	for ( ; count >= 16; count -= 16) {
+		ConvertJustifiedBlock_X86<LaneOp>(src, dst, format);
+		src += 16 * LaneOp::kBytesPerSample;
+		dst += 16;
+	}
+	if (count) {
+		UInt8 in[16 * 4];
+		Float32 out[16];
+
+		for (i = 0; i < 16 * LaneOp::kBytesPerSample; ++i)
+			in[i] = (i < count * LaneOp::kBytesPerSample) ? src[i] : 0;
+		ConvertJustifiedBlock_X86<LaneOp>(in, out, format);
+		for (i = 0; i < count; ++i)
+			dst[i] = out[i];
+	}
+}
+
+void Float32ToNativeIntJustified_X86( const Float32 *src, void *dst, unsigned int numToConvert, unsigned int bitDepth, unsigned int bitWidth, bool highAligned )
+{
+	JustifiedFormat_X86 format(bitDepth, bitWidth, highAligned);
+
+	switch (bitWidth) {
+		case 16:	Float32ToIntJustified_X86<NativeInt16LaneOp>(src, (UInt8 *)dst, numToConvert, format);	break;
+		case 24:	Float32ToIntJustified_X86<NativeInt24LaneOp>(src, (UInt8 *)dst, numToConvert, format);	break;
+		case 32:	Float32ToIntJustified_X86<NativeInt32LaneOp>(src, (UInt8 *)dst, numToConvert, format);	break;
+	}
+}
+
+void Float32ToSwapIntJustified_X86( const Float32 *src, void *dst, unsigned int numToConvert, unsigned int bitDepth, unsigned int bitWidth, bool highAligned )
+{
+	JustifiedFormat_X86 format(bitDepth, bitWidth, highAligned);
+
+	switch (bitWidth) {
+		case 16:	Float32ToIntJustified_X86<SwapInt16LaneOp>(src, (UInt8 *)dst, numToConvert, format);	break;
+		case 24:	Float32ToIntJustified_X86<SwapInt24LaneOp>(src, (UInt8 *)dst, numToConvert, format);	break;
+		case 32:	Float32ToIntJustified_X86<SwapInt32LaneOp>(src, (UInt8 *)dst, numToConvert, format);	break;
+	}
+}
+
+void NativeIntJustifiedToFloat32_X86( const void *src, Float32 *dst, unsigned int numToConvert, unsigned int bitDepth, unsigned int bitWidth, bool highAligned )
+{
+	JustifiedFormat_X86 format(bitDepth, bitWidth, highAligned);
+
+	switch (bitWidth) {
+		case 16:	IntJustifiedToFloat32_X86<NativeInt16LaneOp>((const UInt8 *)src, dst, numToConvert, format);	break;
+		case 24:	IntJustifiedToFloat32_X86<NativeInt24LaneOp>((const UInt8 *)src, dst, numToConvert, format);	break;
+		case 32:	IntJustifiedToFloat32_X86<NativeInt32LaneOp>((const UInt8 *)src, dst, numToConvert, format);	break;
+	}
+}
+
+void SwapIntJustifiedToFloat32_X86( const void *src, Float32 *dst, unsigned int numToConvert, unsigned int bitDepth, unsigned int bitWidth, bool highAligned )
+{
+	JustifiedFormat_X86 format(bitDepth, bitWidth, highAligned);
+
+	switch (bitWidth) {
+		case 16:	IntJustifiedToFloat32_X86<SwapInt16LaneOp>((const UInt8 *)src, dst, numToConvert, format);	break;
+		case 24:	IntJustifiedToFloat32_X86<SwapInt24LaneOp>((const UInt8 *)src, dst, numToConvert, format);	break;
+		case 32:	IntJustifiedToFloat32_X86<SwapInt32LaneOp>((const UInt8 *)src, dst, numToConvert, format);	break;
+	}
+}
 
 #endif // __i386__
 
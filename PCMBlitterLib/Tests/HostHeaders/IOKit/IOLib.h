@@ -0,0 +1,14 @@
+/*
+	Stand-in for the kernel header, for building PCMBlitterLib on a non-Apple host.
+*/
+
+#ifndef __IOLib_h__
+#define __IOLib_h__
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#define IOLog	printf
+
+#endif // __IOLib_h__
@@ -0,0 +1,26 @@
+/*
+	Stand-in for the SDK header, for building PCMBlitterLib on a non-Apple host; see ../CMakeLists.txt.
+	TARGET_OS_MAC is 1 so the library takes the same paths it does in the kext.
+*/
+
+#ifndef __TargetConditionals_h__
+#define __TargetConditionals_h__
+
+#define TARGET_OS_MAC			1
+#define TARGET_OS_WIN32			0
+
+#if defined(__ppc__) || defined(__ppc64__)
+#define TARGET_CPU_PPC			1
+#else
+#define TARGET_CPU_PPC			0
+#endif
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define TARGET_RT_BIG_ENDIAN	1
+#define TARGET_RT_LITTLE_ENDIAN	0
+#else
+#define TARGET_RT_BIG_ENDIAN	0
+#define TARGET_RT_LITTLE_ENDIAN	1
+#endif
+
+#endif // __TargetConditionals_h__
@@ -0,0 +1,41 @@
+/*
+	Stand-in for the kernel header, for building PCMBlitterLib on a non-Apple host. Only what the
+	library uses.
+*/
+
+#ifndef __OSByteOrder_h__
+#define __OSByteOrder_h__
+
+#include <stdint.h>
+
+#define OSSwapInt16(x)	((uint16_t)__builtin_bswap16((uint16_t)(x)))
+#define OSSwapInt32(x)	((uint32_t)__builtin_bswap32((uint32_t)(x)))
+#define OSSwapInt64(x)	((uint64_t)__builtin_bswap64((uint64_t)(x)))
+
+static inline uint16_t OSReadSwapInt16( const volatile void *base, uintptr_t offset )
+{
+	uint16_t v;
+	__builtin_memcpy(&v, (const char *)base + offset, sizeof(v));
+	return OSSwapInt16(v);
+}
+
+static inline uint32_t OSReadSwapInt32( const volatile void *base, uintptr_t offset )
+{
+	uint32_t v;
+	__builtin_memcpy(&v, (const char *)base + offset, sizeof(v));
+	return OSSwapInt32(v);
+}
+
+static inline void OSWriteSwapInt16( volatile void *base, uintptr_t offset, uint16_t data )
+{
+	data = OSSwapInt16(data);
+	__builtin_memcpy((char *)base + offset, &data, sizeof(data));
+}
+
+static inline void OSWriteSwapInt32( volatile void *base, uintptr_t offset, uint32_t data )
+{
+	data = OSSwapInt32(data);
+	__builtin_memcpy((char *)base + offset, &data, sizeof(data));
+}
+
+#endif // __OSByteOrder_h__
@@ -0,0 +1,26 @@
+/*
+	Stand-in for the kernel header, for building PCMBlitterLib on a non-Apple host.
+*/
+
+#ifndef __OSTypes_h__
+#define __OSTypes_h__
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint8_t		UInt8;
+typedef int8_t		SInt8;
+typedef uint16_t	UInt16;
+typedef int16_t		SInt16;
+typedef uint32_t	UInt32;
+typedef int32_t		SInt32;
+typedef uint64_t	UInt64;
+typedef int64_t		SInt64;
+
+#ifndef __cplusplus
+typedef _Bool		bool;
+#define true		1
+#define false		0
+#endif
+
+#endif // __OSTypes_h__
@@ -0,0 +1,25 @@
+/*
+	Stand-in for the kernel header, for building PCMBlitterLib on a non-Apple host: just the types
+	IOAudioTypes.h refers to.
+*/
+
+#ifndef __mach_message_h__
+#define __mach_message_h__
+
+#include <stdint.h>
+
+typedef struct {
+	uint32_t	hi;
+	uint32_t	lo;
+} AbsoluteTime;
+
+typedef struct {
+	uint32_t	msgh_bits;
+	uint32_t	msgh_size;
+	uint32_t	msgh_remote_port;
+	uint32_t	msgh_local_port;
+	uint32_t	msgh_voucher_port;
+	int32_t		msgh_id;
+} mach_msg_header_t;
+
+#endif // __mach_message_h__
@@ -0,0 +1,1401 @@
+/*	Copyright: 	© Copyright 2005-2010 Apple Computer, Inc. All rights reserved.
+ 
+ Disclaimer:	IMPORTANT:  This Apple software is supplied to you by Apple Computer, Inc.
+ ("Apple") in consideration of your agreement to the following terms, and your
+ use, installation, modification or redistribution of this Apple software
+ constitutes acceptance of these terms.  If you do not agree with these terms,
+ please do not use, install, modify or redistribute this Apple software.
+ 
+ In consideration of your agreement to abide by the following terms, and subject
+ to these terms, Apple grants you a personal, non-exclusive license, under Apple’s
+ copyrights in this original Apple software (the "Apple Software"), to use,
+ reproduce, modify and redistribute the Apple Software, with or without
+ modifications, in source and/or binary forms; provided that if you redistribute
+ the Apple Software in its entirety and without modifications, you must retain
+ this notice and the following text and disclaimers in all such redistributions of
+ the Apple Software.  Neither the name, trademarks, service marks or logos of
+ Apple Computer, Inc. may be used to endorse or promote products derived from the
+ Apple Software without specific prior written permission from Apple.  Except as
+ expressly stated in this notice, no other rights or licenses, express or implied,
+ are granted by Apple herein, including but not limited to any patent rights that
+ may be infringed by your derivative works or by other works in which the Apple
+ Software may be incorporated.
+ 
+ The Apple Software is provided by Apple on an "AS IS" basis.  APPLE MAKES NO
+ WARRANTIES, EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION THE IMPLIED
+ WARRANTIES OF NON-INFRINGEMENT, MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ PURPOSE, REGARDING THE APPLE SOFTWARE OR ITS USE AND OPERATION ALONE OR IN
+ COMBINATION WITH YOUR PRODUCTS.
+ 
+ IN NO EVENT SHALL APPLE BE LIABLE FOR ANY SPECIAL, INDIRECT, INCIDENTAL OR
+ CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ ARISING IN ANY WAY OUT OF THE USE, REPRODUCTION, MODIFICATION AND/OR DISTRIBUTION
+ OF THE APPLE SOFTWARE, HOWEVER CAUSED AND WHETHER UNDER THEORY OF CONTRACT, TORT
+ (INCLUDING NEGLIGENCE), STRICT LIABILITY OR OTHERWISE, EVEN IF APPLE HAS BEEN
+ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/*=============================================================================
+	IOAudioBlitterLibTest.cpp
+
+	Host test harness and benchmark for PCMBlitterLib; see CMakeLists.txt.
+
+	IOAudioBlitterLibTest verify
+		Runs every entry of every converter table this CPU can run against the table of _Portable
+		references: all lengths up to 40 samples and a spread of longer odd and even ones, every
+		source and destination offset within 16 bytes that the formats allow, and guard bytes on
+		both sides of the output. Float input covers full scale and beyond, the half-LSB rounding
+		boundaries at 16, 24 and 32 bits, denormals, infinities and NaNs; integer input is random.
+		The check is done with denormals enabled and again with them flushed. Output must match
+		bit for bit.
+
+		The entry points without a table entry are checked the same way against portable
+		references; those that take channel layouts, gains or formats as well get them from the
+		count. The dithered entries of every table, the references included, have to stay within
+		1 LSB of the undithered output.
+
+	IOAudioBlitterLibTest bench [-a]
+		Times the same entries, reference included, for 1 to 64K samples, aligned and misaligned
+		(every offset with -a), and reports ns/sample and GB/s (bytes read plus bytes written).
+=============================================================================*/
+
+#include "IOAudioBlitterLib.h"
+#include "IOAudioBlitterLibDispatch.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define kMaxTables			8
+#define kMaxSamples			(65536 + 64)
+#define kGuardBytes			64
+#define kMaxBytesPerSample	8
+#define kBufferBytes		(kGuardBytes + 16 + kMaxSamples * kMaxBytesPerSample + kGuardBytes)
+#define kGuardByte			0xA5
+#define kMaxMixSources		5
+#define kMaxReportedErrors	8
+
+// ____________________________________________________________________________________
+// The converters under test
+//
+// Every table entry but the multi-source mix takes (source, destination, count); they are called
+// through one pointer type, as the DEBUG check in IOAudioBlitterLibDispatch.cpp does.
+
+typedef void (*TestProc)( const void *src, void *dest, unsigned int count );
+
+enum {
+	kFloatSource,		// float in, whatever out
+	kDoubleSource,
+	kIntSource,			// random bytes in
+	kMix,				// float in, float accumulated into the destination
+	kMixMulti,
+	kCopy,				// bytes
+	kSparseSource		// float in, mostly +/-0
+};
+
+typedef struct {
+	const char *	name;
+	size_t			offset;			// of the entry in IOAF_ConverterTable
+	int				kind;
+	unsigned int	srcBytes;		// per sample
+	unsigned int	destBytes;
+} TableEntry;
+
+#define ENTRY(field)	#field, offsetof(IOAF_ConverterTable, field)
+
+static const TableEntry sTableEntries[] = {
+	{ ENTRY(nativeInt16ToFloat32), kIntSource, 2, 4 },
+	{ ENTRY(swapInt16ToFloat32), kIntSource, 2, 4 },
+	{ ENTRY(nativeInt24ToFloat32), kIntSource, 3, 4 },
+	{ ENTRY(swapInt24ToFloat32), kIntSource, 3, 4 },
+	{ ENTRY(nativeInt32ToFloat32), kIntSource, 4, 4 },
+	{ ENTRY(swapInt32ToFloat32), kIntSource, 4, 4 },
+	{ ENTRY(float32ToNativeInt16), kFloatSource, 4, 2 },
+	{ ENTRY(float32ToSwapInt16), kFloatSource, 4, 2 },
+	{ ENTRY(float32ToNativeInt24), kFloatSource, 4, 3 },
+	{ ENTRY(float32ToSwapInt24), kFloatSource, 4, 3 },
+	{ ENTRY(float32ToNativeInt32), kFloatSource, 4, 4 },
+	{ ENTRY(float32ToSwapInt32), kFloatSource, 4, 4 },
+	{ ENTRY(mixFloat32), kMix, 4, 4 },
+	{ ENTRY(mixFloat32Multi), kMixMulti, 4, 4 },
+	{ ENTRY(aLawToFloat32), kIntSource, 1, 4 },
+	{ ENTRY(muLawToFloat32), kIntSource, 1, 4 },
+	{ ENTRY(bcopyFromWriteCombine), kCopy, 1, 1 },
+	{ ENTRY(bcopyToWriteCombine), kCopy, 1, 1 }
+};
+
+#define kNumTableEntries	(sizeof(sTableEntries) / sizeof(sTableEntries[0]))
+
+// ____________________________________________________________________________________
+// Portable references for the other entry points
+//
+// The references are plain loops over the _Portable converters and the sample traits in
+// IOAudioBlitterLib.h, one sample at a time. Entry points that take more than (source,
+// destination, count) are called through adapters which work the other arguments out from the
+// count, so that the lengths VerifyEntry runs through also run through channel layouts, gains
+// and formats; the reference adapter does the same and converts the same samples.
+
+template <class S, class D>
+static void IntToIntReference( const void *src, void *dest, unsigned int count )
+{
+	TIntToIntBlitter<S, D>::ConvertSamples(src, dest, count);
+}
+
+template <IOAF_IntFormat kSrcFormat, IOAF_IntFormat kDestFormat>
+static void IntToInt( const void *src, void *dest, unsigned int count )
+{
+	IOAF_IntToInt(src, kSrcFormat, dest, kDestFormat, count);
+}
+
+static void Copy32( const Float32 *src, Float32 *dest, unsigned int count )
+{
+	memcpy(dest, src, count * 4);
+}
+
+// interleaved buffers have 1 to 9 channels; planar ones are the channels one after another
+static unsigned int InterleavedChannels( unsigned int count )
+{
+	return 1 + count % 9;
+}
+
+template <typename S, typename D, unsigned int kSrcBytes, unsigned int kDestBytes, void (*kPortable)( const S *, D *, unsigned int )>
+static void InterleaveReference( const void *src, void *dest, unsigned int count )
+{
+	unsigned int nChannels = InterleavedChannels(count), nFrames = count / nChannels, c, f;
+
+	for (c = 0; c < nChannels; ++c)
+		for (f = 0; f < nFrames; ++f)
+			kPortable((const S *)((const UInt8 *)src + (c * nFrames + f) * kSrcBytes), (D *)((UInt8 *)dest + (f * nChannels + c) * kDestBytes), 1);
+}
+
+template <typename S, typename D, unsigned int kSrcBytes, unsigned int kDestBytes, void (*kPortable)( const S *, D *, unsigned int )>
+static void DeinterleaveReference( const void *src, void *dest, unsigned int count )
+{
+	unsigned int nChannels = InterleavedChannels(count), nFrames = count / nChannels, c, f;
+
+	for (c = 0; c < nChannels; ++c)
+		for (f = 0; f < nFrames; ++f)
+			kPortable((const S *)((const UInt8 *)src + (f * nChannels + c) * kSrcBytes), (D *)((UInt8 *)dest + (c * nFrames + f) * kDestBytes), 1);
+}
+
+template <typename S, typename D, unsigned int kSrcBytes, void (*kEntry)( const S * const [], D *, unsigned int, unsigned int )>
+static void Interleave( const void *src, void *dest, unsigned int count )
+{
+	unsigned int nChannels = InterleavedChannels(count), nFrames = count / nChannels, c;
+	const S *planes[9];
+
+	for (c = 0; c < nChannels; ++c)
+		planes[c] = (const S *)((const UInt8 *)src + c * nFrames * kSrcBytes);
+	kEntry(planes, (D *)dest, nChannels, nFrames);
+}
+
+template <typename S, typename D, unsigned int kDestBytes, void (*kEntry)( const S *, D * const [], unsigned int, unsigned int )>
+static void Deinterleave( const void *src, void *dest, unsigned int count )
+{
+	unsigned int nChannels = InterleavedChannels(count), nFrames = count / nChannels, c;
+	D *planes[9];
+
+	for (c = 0; c < nChannels; ++c)
+		planes[c] = (D *)((UInt8 *)dest + c * nFrames * kDestBytes);
+	kEntry((const S *)src, planes, nChannels, nFrames);
+}
+
+// up to 20 channels, more than the 16 the backends keep a repeating table of gains for
+static const Float32 sChannelGains[] = {
+	0.5f, 1.0f, 0.0f, 2.0f, -1.0f, 0.25f, 1.5f, 0.70710678f, 0.1f, -0.3f,
+	1e-3f, 0.99999994f, 1.00000012f, -0.5f, 3.0f, 0.0625f, 0.8f, -2.0f, 0.33333334f, 1e-6f
+};
+
+static unsigned int GainChannels( unsigned int count )
+{
+	return 1 + count % (sizeof(sChannelGains) / sizeof(sChannelGains[0]));
+}
+
+// a * b rounded toward minus infinity, as the converters multiply in their rounding mode (see vMulDown)
+static inline Float32 MulDown( Float32 a, Float32 b )
+{
+	double p = (double)a * b;
+	Float32 r = (Float32)p;
+
+	return ((double)r > p) ? nextafterf(r, -INFINITY) : r;
+}
+
+template <typename D, unsigned int kDestBytes, void (*kPortable)( const Float32 *, D *, unsigned int )>
+static void WithGainReference( const void *src, void *dest, unsigned int count )
+{
+	unsigned int nChannels = GainChannels(count), i;
+
+	for (i = 0; i < count; ++i) {
+		Float32 f = MulDown(((const Float32 *)src)[i], sChannelGains[i % nChannels]);
+		kPortable(&f, (D *)((UInt8 *)dest + i * kDestBytes), 1);
+	}
+}
+
+template <typename D, void (*kEntry)( const Float32 *, D *, unsigned int, const Float32 *, unsigned int )>
+static void WithGain( const void *src, void *dest, unsigned int count )
+{
+	kEntry((const Float32 *)src, (D *)dest, count, sChannelGains, GainChannels(count));
+}
+
+// Ramps whose every gain is exact in float -- linear steps of 2^-20 and -2^-18, halving, and no
+// ramp at all -- so that the result doesn't depend on how a backend groups the frames. A frame
+// too wide for IOAF_Float32ToNativeInt16WithGainRamp and the like to buffer comes in the long runs.
+static void RampLayout( unsigned int count, unsigned int *nChannels, Float32 *gain, Float32 *step, bool *exponential )
+{
+	*nChannels = (count > 4096) ? 520 : 1 + (count / 4) % 6;
+	*exponential = false;
+	switch ((count / 2) % 4) {
+		case 0:		*gain = 0.25f;	*step = 1.0f / 1048576.0f;		break;
+		case 1:		*gain = 1.0f;	*step = -1.0f / 262144.0f;		break;
+		case 2:		*gain = 1.0f;	*step = 0.5f;	*exponential = true;	break;
+		default:	*gain = 0.75f;	*step = 0.0f;					break;
+	}
+}
+
+template <typename D, unsigned int kDestBytes, void (*kPortable)( const Float32 *, D *, unsigned int )>
+static void GainRampReference( const void *src, void *dest, unsigned int count )
+{
+	unsigned int nChannels, frame, c;
+	Float32 gain, step, g;
+	bool exponential;
+
+	RampLayout(count, &nChannels, &gain, &step, &exponential);
+	g = gain;
+	for (frame = 0; frame < count / nChannels; ++frame) {
+		if (!exponential)
+			g = gain + (Float32)frame * step;
+		for (c = 0; c < nChannels; ++c) {
+			unsigned int i = frame * nChannels + c;
+			Float32 f = ((const Float32 *)src)[i] * g;
+			kPortable(&f, (D *)((UInt8 *)dest + i * kDestBytes), 1);
+		}
+		if (exponential)
+			g *= step;
+	}
+}
+
+// in two calls, the second starting from the gain the first returns
+template <typename D, unsigned int kDestBytes, Float32 (*kEntry)( const Float32 *, D *, unsigned int, unsigned int, Float32, Float32, bool )>
+static void GainRamp( const void *src, void *dest, unsigned int count )
+{
+	unsigned int nChannels, nFrames, first;
+	Float32 gain, step;
+	bool exponential;
+
+	RampLayout(count, &nChannels, &gain, &step, &exponential);
+	nFrames = count / nChannels;
+	first = nFrames / 3;
+	gain = kEntry((const Float32 *)src, (D *)dest, nChannels, first, gain, step, exponential);
+	kEntry((const Float32 *)src + first * nChannels, (D *)((UInt8 *)dest + first * nChannels * kDestBytes), nChannels, nFrames - first, gain, step, exponential);
+}
+
+// Justified samples: the depths 16, 12, 8 in 16-bit containers, 24, 20, 16 in 24-bit ones and
+// 32, 28, 24, 20 in 32-bit ones, each high and low aligned. A full-width sample goes to the
+// regular converters.
+static void JustifiedLayout( unsigned int count, unsigned int bitWidth, unsigned int *bitDepth, bool *highAligned )
+{
+	unsigned int nDepths = (bitWidth == 32) ? 4 : 3;
+
+	*bitDepth = bitWidth - 4 * (count % nDepths);
+	*highAligned = ((count / nDepths) & 1) != 0;
+}
+
+template <class T, unsigned int kBitWidth>
+static void Float32ToIntJustifiedReference( const void *src, void *dest, unsigned int count )
+{
+	typename T::value_type *d = (typename T::value_type *)dest;
+	unsigned int bitDepth, i;
+	bool highAligned;
+
+	JustifiedLayout(count, kBitWidth, &bitDepth, &highAligned);
+
+	// floor(x * 2^(bitDepth-1) + 0.5), clipped; above 24 bits the largest value is limited by the float's precision
+	double scale = (double)(1U << (bitDepth - 1));
+	double maxValue = scale - ((bitDepth <= 24) ? 1.0 : (double)(1U << (bitDepth - 25)));
+
+	for (i = 0; i < count; ++i) {
+		double v = ((const Float32 *)src)[i] * scale + 0.5;
+		SInt32 n;
+
+		if (!(v > -scale))
+			n = (SInt32)-scale;
+		else if (v >= maxValue)
+			n = (SInt32)maxValue;
+		else
+			n = (SInt32)floor(v);
+		T::store(d + i, highAligned ? (SInt32)((UInt32)n << (kBitWidth - bitDepth)) : n);
+	}
+}
+
+template <class T, unsigned int kBitWidth>
+static void IntJustifiedToFloat32Reference( const void *src, void *dest, unsigned int count )
+{
+	const typename T::value_type *s = (const typename T::value_type *)src;
+	unsigned int bitDepth, i;
+	bool highAligned;
+
+	JustifiedLayout(count, kBitWidth, &bitDepth, &highAligned);
+	for (i = 0; i < count; ++i) {
+		UInt32 lane = (UInt32)(SInt32)T::load(s + i) << (32 - kBitWidth);
+
+		lane = highAligned ? lane & (0xFFFFFFFFU << (32 - bitDepth)) : lane << (kBitWidth - bitDepth);
+		((Float32 *)dest)[i] = (Float32)(SInt32)lane * (1.0f / 2147483648.0f);
+	}
+}
+
+template <unsigned int kBitWidth, void (*kEntry)( const Float32 *, void *, unsigned int, unsigned int, unsigned int, bool )>
+static void Float32ToIntJustified( const void *src, void *dest, unsigned int count )
+{
+	unsigned int bitDepth;
+	bool highAligned;
+
+	JustifiedLayout(count, kBitWidth, &bitDepth, &highAligned);
+	kEntry((const Float32 *)src, dest, count, bitDepth, kBitWidth, highAligned);
+}
+
+template <unsigned int kBitWidth, void (*kEntry)( const void *, Float32 *, unsigned int, unsigned int, unsigned int, bool )>
+static void IntJustifiedToFloat32( const void *src, void *dest, unsigned int count )
+{
+	unsigned int bitDepth;
+	bool highAligned;
+
+	JustifiedLayout(count, kBitWidth, &bitDepth, &highAligned);
+	kEntry(src, (Float32 *)dest, count, bitDepth, kBitWidth, highAligned);
+}
+
+// Channel subsets: frames of 1 to 13 channels, of which a run from firstChannel is used
+static void ChannelLayout( unsigned int count, unsigned int *frameStride, unsigned int *firstChannel, unsigned int *nChannels )
+{
+	*frameStride = 1 + count % 13;
+	*nChannels = 1 + (count / 13) % *frameStride;
+	*firstChannel = (count / 7) % (*frameStride - *nChannels + 1);
+}
+
+template <typename D, unsigned int kDestBytes, void (*kPortable)( const Float32 *, D *, unsigned int )>
+static void ChannelsReference( const void *src, void *dest, unsigned int count )
+{
+	unsigned int frameStride, firstChannel, nChannels, frame, c;
+
+	ChannelLayout(count, &frameStride, &firstChannel, &nChannels);
+	for (frame = 0; frame < count / frameStride; ++frame) {
+		for (c = firstChannel; c < firstChannel + nChannels; ++c) {
+			unsigned int i = frame * frameStride + c;
+			kPortable((const Float32 *)src + i, (D *)((UInt8 *)dest + i * kDestBytes), 1);
+		}
+	}
+}
+
+template <typename D, void (*kEntry)( const Float32 *, D *, unsigned int, unsigned int, unsigned int, unsigned int )>
+static void Channels( const void *src, void *dest, unsigned int count )
+{
+	unsigned int frameStride, firstChannel, nChannels;
+
+	ChannelLayout(count, &frameStride, &firstChannel, &nChannels);
+	kEntry((const Float32 *)src, (D *)dest, count / frameStride, frameStride, firstChannel, nChannels);
+}
+
+static void MixFloat32Add( const Float32 *src, Float32 *dest, unsigned int count )
+{
+	while (count--)
+		*dest++ += *src++;
+}
+
+// Which NaN a sum of two NaNs keeps is up to the compiler (see MatchMixNaNs), and short runs of
+// channels are mixed in scalar code while long ones go through the table's mix, so any NaN will
+// do in a mixed channel where the reference has one.
+static void QuietMixedNaNs( void *dest, unsigned int count )
+{
+	const UInt32 quietNaN = 0x7FC00000;
+	unsigned int frameStride, firstChannel, nChannels, frame, c;
+
+	ChannelLayout(count, &frameStride, &firstChannel, &nChannels);
+	for (frame = 0; frame < count / frameStride; ++frame) {
+		for (c = firstChannel; c < firstChannel + nChannels; ++c) {
+			Float32 *f = (Float32 *)dest + frame * frameStride + c;
+			if (*f != *f)
+				memcpy(f, &quietNaN, 4);
+		}
+	}
+}
+
+static void MixFloat32ChannelsReference( const void *src, void *dest, unsigned int count )
+{
+	ChannelsReference<Float32, 4, MixFloat32Add>(src, dest, count);
+	QuietMixedNaNs(dest, count);
+}
+
+static void MixFloat32Channels( const void *src, void *dest, unsigned int count )
+{
+	Channels<Float32, IOAF_MixFloat32Channels>(src, dest, count);
+	QuietMixedNaNs(dest, count);
+}
+
+// FindActiveChannels starts from the run ChannelLayout gives, or from none at all for every
+// third count; the widened run goes in the first two words of dest
+static void ActiveChannelLayout( unsigned int count, unsigned int *frameStride, unsigned int *firstChannel, unsigned int *nChannels )
+{
+	ChannelLayout(count, frameStride, firstChannel, nChannels);
+	if (count % 3 == 0)
+		*nChannels = 0;
+}
+
+static void FindActiveChannelsReference( const void *src, void *dest, unsigned int count )
+{
+	const UInt32 *sample = (const UInt32 *)src;
+	unsigned int frameStride, firstChannel, nChannels, first, end, i;
+
+	ActiveChannelLayout(count, &frameStride, &firstChannel, &nChannels);
+	first = nChannels ? firstChannel : frameStride;
+	end = nChannels ? firstChannel + nChannels : 0;
+	for (i = 0; i < count / frameStride * frameStride; ++i) {
+		if (sample[i] << 1) {		// not +/-0
+			if (i % frameStride < first)
+				first = i % frameStride;
+			if (i % frameStride >= end)
+				end = i % frameStride + 1;
+		}
+	}
+	if (first < end) {
+		firstChannel = first;
+		nChannels = end - first;
+	}
+	if (count >= 2) {
+		((UInt32 *)dest)[0] = firstChannel;
+		((UInt32 *)dest)[1] = nChannels;
+	}
+}
+
+static void FindActiveChannels( const void *src, void *dest, unsigned int count )
+{
+	unsigned int frameStride, firstChannel, nChannels;
+
+	ActiveChannelLayout(count, &frameStride, &firstChannel, &nChannels);
+	IOAF_Float32FindActiveChannels((const Float32 *)src, count / frameStride, frameStride, &firstChannel, &nChannels);
+	if (count >= 2) {
+		((UInt32 *)dest)[0] = firstChannel;
+		((UInt32 *)dest)[1] = nChannels;
+	}
+}
+
+// Batches of 1 to 4 jobs of growing length, each native or swapped as bit j of count / 4 says
+static unsigned int BatchJobs( const void *src, void *dest, unsigned int count, IOAF_IntFormat nativeFormat, unsigned int destBytes, IOAF_ConversionJob jobs[4] )
+{
+	unsigned int nJobs = 1 + count % 4, j;
+
+	for (j = 0; j < nJobs; ++j) {
+		unsigned int start = count * j * j / (nJobs * nJobs), end = count * (j + 1) * (j + 1) / (nJobs * nJobs);
+
+		jobs[j].src = (const Float32 *)src + start;
+		jobs[j].dest = (UInt8 *)dest + start * destBytes;
+		jobs[j].count = end - start;
+		jobs[j].format = (IOAF_IntFormat)(nativeFormat + (((count / 4) >> j) & 1));
+	}
+	return nJobs;
+}
+
+template <typename D, IOAF_IntFormat kNativeFormat, unsigned int kDestBytes, void (*kNative)( const Float32 *, D *, unsigned int ), void (*kSwap)( const Float32 *, D *, unsigned int )>
+static void Float32ToIntBatchReference( const void *src, void *dest, unsigned int count )
+{
+	IOAF_ConversionJob jobs[4];
+	unsigned int nJobs = BatchJobs(src, dest, count, kNativeFormat, kDestBytes, jobs), j;
+
+	for (j = 0; j < nJobs; ++j)
+		((jobs[j].format == kNativeFormat) ? kNative : kSwap)(jobs[j].src, (D *)jobs[j].dest, jobs[j].count);
+}
+
+template <IOAF_IntFormat kNativeFormat, unsigned int kDestBytes>
+static void Float32ToIntBatch( const void *src, void *dest, unsigned int count )
+{
+	IOAF_ConversionJob jobs[4];
+	unsigned int nJobs = BatchJobs(src, dest, count, kNativeFormat, kDestBytes, jobs);
+
+	IOAF_Float32ToIntBatch(jobs, nJobs);
+}
+
+// The converters without a table entry are called directly by their IOAF_ entry points, or through
+// the adapters above; these are checked against their portable versions.
+#define DIRECT(name)	#name, 0
+#define INT_TO_INT_ENTRY(s, sw, d, dw)	{ DIRECT(s##Int##sw##To##d##Int##dw), kIntSource, sw / 8, dw / 8 }
+#define INT_TO_INT_PROCS(s, sw, d, dw)	{ (const void *)IntToIntReference<PCMSInt##sw##s, PCMSInt##dw##d>, (const void *)IntToInt<kIOAF_##s##Int##sw, kIOAF_##d##Int##dw> }
+
+static const TableEntry sDirectEntries[] = {
+	{ DIRECT(Float32ToFloat64), kFloatSource, 4, 8 },
+	{ DIRECT(Float64ToFloat32), kDoubleSource, 8, 4 },
+	{ DIRECT(Float32ToSInt8), kFloatSource, 4, 1 },
+	{ DIRECT(Float32ToUInt8), kFloatSource, 4, 1 },
+	{ DIRECT(SInt8ToFloat32), kIntSource, 1, 4 },
+	{ DIRECT(UInt8ToFloat32), kIntSource, 1, 4 },
+	{ DIRECT(Float32ToALaw), kFloatSource, 4, 1 },
+	{ DIRECT(Float32ToMuLaw), kFloatSource, 4, 1 },
+	{ DIRECT(Float32ToNativeInt16_ToWriteCombine), kFloatSource, 4, 2 },
+	{ DIRECT(Float32ToSwapInt16_ToWriteCombine), kFloatSource, 4, 2 },
+	{ DIRECT(Float32ToNativeInt24_ToWriteCombine), kFloatSource, 4, 3 },
+	{ DIRECT(Float32ToSwapInt24_ToWriteCombine), kFloatSource, 4, 3 },
+	{ DIRECT(Float32ToNativeInt32_ToWriteCombine), kFloatSource, 4, 4 },
+	{ DIRECT(Float32ToSwapInt32_ToWriteCombine), kFloatSource, 4, 4 },
+	{ DIRECT(bcopy_WriteCombine), kCopy, 1, 1 },
+	{ DIRECT(bcopy_ToWriteCombine), kCopy, 1, 1 },
+	{ DIRECT(ByteSwapInt16), kIntSource, 2, 2 },
+	{ DIRECT(ByteSwapInt24), kIntSource, 3, 3 },
+	{ DIRECT(ByteSwapInt32), kIntSource, 4, 4 },
+	INT_TO_INT_ENTRY(Native, 16, Swap, 16),
+	INT_TO_INT_ENTRY(Native, 16, Native, 24),
+	INT_TO_INT_ENTRY(Native, 16, Swap, 24),
+	INT_TO_INT_ENTRY(Native, 16, Native, 32),
+	INT_TO_INT_ENTRY(Native, 16, Swap, 32),
+	INT_TO_INT_ENTRY(Swap, 16, Native, 16),
+	INT_TO_INT_ENTRY(Swap, 16, Native, 24),
+	INT_TO_INT_ENTRY(Swap, 16, Swap, 24),
+	INT_TO_INT_ENTRY(Swap, 16, Native, 32),
+	INT_TO_INT_ENTRY(Swap, 16, Swap, 32),
+	INT_TO_INT_ENTRY(Native, 24, Native, 16),
+	INT_TO_INT_ENTRY(Native, 24, Swap, 16),
+	INT_TO_INT_ENTRY(Native, 24, Swap, 24),
+	INT_TO_INT_ENTRY(Native, 24, Native, 32),
+	INT_TO_INT_ENTRY(Native, 24, Swap, 32),
+	INT_TO_INT_ENTRY(Swap, 24, Native, 16),
+	INT_TO_INT_ENTRY(Swap, 24, Swap, 16),
+	INT_TO_INT_ENTRY(Swap, 24, Native, 24),
+	INT_TO_INT_ENTRY(Swap, 24, Native, 32),
+	INT_TO_INT_ENTRY(Swap, 24, Swap, 32),
+	INT_TO_INT_ENTRY(Native, 32, Native, 16),
+	INT_TO_INT_ENTRY(Native, 32, Swap, 16),
+	INT_TO_INT_ENTRY(Native, 32, Native, 24),
+	INT_TO_INT_ENTRY(Native, 32, Swap, 24),
+	INT_TO_INT_ENTRY(Native, 32, Swap, 32),
+	INT_TO_INT_ENTRY(Swap, 32, Native, 16),
+	INT_TO_INT_ENTRY(Swap, 32, Swap, 16),
+	INT_TO_INT_ENTRY(Swap, 32, Native, 24),
+	INT_TO_INT_ENTRY(Swap, 32, Swap, 24),
+	INT_TO_INT_ENTRY(Swap, 32, Native, 32),
+	{ DIRECT(Interleave32), kIntSource, 4, 4 },
+	{ DIRECT(Deinterleave32), kIntSource, 4, 4 },
+	{ DIRECT(DeinterleaveFloat32ToNativeInt16), kFloatSource, 4, 2 },
+	{ DIRECT(DeinterleaveFloat32ToSwapInt16), kFloatSource, 4, 2 },
+	{ DIRECT(DeinterleaveFloat32ToNativeInt32), kFloatSource, 4, 4 },
+	{ DIRECT(DeinterleaveFloat32ToSwapInt32), kFloatSource, 4, 4 },
+	{ DIRECT(InterleaveNativeInt16ToFloat32), kIntSource, 2, 4 },
+	{ DIRECT(InterleaveSwapInt16ToFloat32), kIntSource, 2, 4 },
+	{ DIRECT(InterleaveNativeInt32ToFloat32), kIntSource, 4, 4 },
+	{ DIRECT(InterleaveSwapInt32ToFloat32), kIntSource, 4, 4 },
+	{ DIRECT(Float32ToNativeInt16WithGain), kFloatSource, 4, 2 },
+	{ DIRECT(Float32ToSwapInt16WithGain), kFloatSource, 4, 2 },
+	{ DIRECT(Float32ToNativeInt24WithGain), kFloatSource, 4, 3 },
+	{ DIRECT(Float32ToSwapInt24WithGain), kFloatSource, 4, 3 },
+	{ DIRECT(Float32ToNativeInt32WithGain), kFloatSource, 4, 4 },
+	{ DIRECT(Float32ToSwapInt32WithGain), kFloatSource, 4, 4 },
+	{ DIRECT(GainRampFloat32), kFloatSource, 4, 4 },
+	{ DIRECT(Float32ToNativeInt16WithGainRamp), kFloatSource, 4, 2 },
+	{ DIRECT(Float32ToSwapInt16WithGainRamp), kFloatSource, 4, 2 },
+	{ DIRECT(Float32ToNativeInt24WithGainRamp), kFloatSource, 4, 3 },
+	{ DIRECT(Float32ToSwapInt24WithGainRamp), kFloatSource, 4, 3 },
+	{ DIRECT(Float32ToNativeInt32WithGainRamp), kFloatSource, 4, 4 },
+	{ DIRECT(Float32ToSwapInt32WithGainRamp), kFloatSource, 4, 4 },
+	{ "Float32ToNativeIntJustified 16", 0, kFloatSource, 4, 2 },
+	{ "Float32ToSwapIntJustified 16", 0, kFloatSource, 4, 2 },
+	{ "Float32ToNativeIntJustified 24", 0, kFloatSource, 4, 3 },
+	{ "Float32ToSwapIntJustified 24", 0, kFloatSource, 4, 3 },
+	{ "Float32ToNativeIntJustified 32", 0, kFloatSource, 4, 4 },
+	{ "Float32ToSwapIntJustified 32", 0, kFloatSource, 4, 4 },
+	{ "NativeIntJustifiedToFloat32 16", 0, kIntSource, 2, 4 },
+	{ "SwapIntJustifiedToFloat32 16", 0, kIntSource, 2, 4 },
+	{ "NativeIntJustifiedToFloat32 24", 0, kIntSource, 3, 4 },
+	{ "SwapIntJustifiedToFloat32 24", 0, kIntSource, 3, 4 },
+	{ "NativeIntJustifiedToFloat32 32", 0, kIntSource, 4, 4 },
+	{ "SwapIntJustifiedToFloat32 32", 0, kIntSource, 4, 4 },
+	{ DIRECT(Float32ToNativeInt16Channels), kFloatSource, 4, 2 },
+	{ DIRECT(Float32ToSwapInt16Channels), kFloatSource, 4, 2 },
+	{ DIRECT(Float32ToNativeInt24Channels), kFloatSource, 4, 3 },
+	{ DIRECT(Float32ToSwapInt24Channels), kFloatSource, 4, 3 },
+	{ DIRECT(Float32ToNativeInt32Channels), kFloatSource, 4, 4 },
+	{ DIRECT(Float32ToSwapInt32Channels), kFloatSource, 4, 4 },
+	{ DIRECT(MixFloat32Channels), kMix, 4, 4 },
+	{ DIRECT(Float32FindActiveChannels), kSparseSource, 4, 4 },
+	{ "Float32ToIntBatch 16", 0, kFloatSource, 4, 2 },
+	{ "Float32ToIntBatch 24", 0, kFloatSource, 4, 3 },
+	{ "Float32ToIntBatch 32", 0, kFloatSource, 4, 4 }
+};
+
+static const void * const sDirectProcs[][2] = {		// reference, entry point
+	{ (const void *)Float32ToFloat64_Portable, (const void *)IOAF_Float32ToFloat64 },
+	{ (const void *)Float64ToFloat32_Portable, (const void *)IOAF_Float64ToFloat32 },
+	{ (const void *)Float32ToSInt8_Portable, (const void *)IOAF_Float32ToSInt8 },
+	{ (const void *)Float32ToUInt8_Portable, (const void *)IOAF_Float32ToUInt8 },
+	{ (const void *)SInt8ToFloat32_Portable, (const void *)IOAF_SInt8ToFloat32 },
+	{ (const void *)UInt8ToFloat32_Portable, (const void *)IOAF_UInt8ToFloat32 },
+	{ (const void *)Float32ToALaw_Portable, (const void *)IOAF_Float32ToALaw },
+	{ (const void *)Float32ToMuLaw_Portable, (const void *)IOAF_Float32ToMuLaw },
+	{ (const void *)Float32ToNativeInt16_Portable, (const void *)IOAF_Float32ToNativeInt16_ToWriteCombine },
+	{ (const void *)Float32ToSwapInt16_Portable, (const void *)IOAF_Float32ToSwapInt16_ToWriteCombine },
+	{ (const void *)Float32ToNativeInt24_Portable, (const void *)IOAF_Float32ToNativeInt24_ToWriteCombine },
+	{ (const void *)Float32ToSwapInt24_Portable, (const void *)IOAF_Float32ToSwapInt24_ToWriteCombine },
+	{ (const void *)Float32ToNativeInt32_Portable, (const void *)IOAF_Float32ToNativeInt32_ToWriteCombine },
+	{ (const void *)Float32ToSwapInt32_Portable, (const void *)IOAF_Float32ToSwapInt32_ToWriteCombine },
+	{ (const void *)bcopy_Portable, (const void *)IOAF_bcopy_WriteCombine },
+	{ (const void *)bcopy_Portable, (const void *)IOAF_bcopy_ToWriteCombine },
+	{ (const void *)IntToIntReference<PCMSInt16Native, PCMSInt16Swap>, (const void *)IOAF_ByteSwapInt16 },
+	{ (const void *)IntToIntReference<PCMSInt24Native, PCMSInt24Swap>, (const void *)IOAF_ByteSwapInt24 },
+	{ (const void *)IntToIntReference<PCMSInt32Native, PCMSInt32Swap>, (const void *)IOAF_ByteSwapInt32 },
+	INT_TO_INT_PROCS(Native, 16, Swap, 16),
+	INT_TO_INT_PROCS(Native, 16, Native, 24),
+	INT_TO_INT_PROCS(Native, 16, Swap, 24),
+	INT_TO_INT_PROCS(Native, 16, Native, 32),
+	INT_TO_INT_PROCS(Native, 16, Swap, 32),
+	INT_TO_INT_PROCS(Swap, 16, Native, 16),
+	INT_TO_INT_PROCS(Swap, 16, Native, 24),
+	INT_TO_INT_PROCS(Swap, 16, Swap, 24),
+	INT_TO_INT_PROCS(Swap, 16, Native, 32),
+	INT_TO_INT_PROCS(Swap, 16, Swap, 32),
+	INT_TO_INT_PROCS(Native, 24, Native, 16),
+	INT_TO_INT_PROCS(Native, 24, Swap, 16),
+	INT_TO_INT_PROCS(Native, 24, Swap, 24),
+	INT_TO_INT_PROCS(Native, 24, Native, 32),
+	INT_TO_INT_PROCS(Native, 24, Swap, 32),
+	INT_TO_INT_PROCS(Swap, 24, Native, 16),
+	INT_TO_INT_PROCS(Swap, 24, Swap, 16),
+	INT_TO_INT_PROCS(Swap, 24, Native, 24),
+	INT_TO_INT_PROCS(Swap, 24, Native, 32),
+	INT_TO_INT_PROCS(Swap, 24, Swap, 32),
+	INT_TO_INT_PROCS(Native, 32, Native, 16),
+	INT_TO_INT_PROCS(Native, 32, Swap, 16),
+	INT_TO_INT_PROCS(Native, 32, Native, 24),
+	INT_TO_INT_PROCS(Native, 32, Swap, 24),
+	INT_TO_INT_PROCS(Native, 32, Swap, 32),
+	INT_TO_INT_PROCS(Swap, 32, Native, 16),
+	INT_TO_INT_PROCS(Swap, 32, Swap, 16),
+	INT_TO_INT_PROCS(Swap, 32, Native, 24),
+	INT_TO_INT_PROCS(Swap, 32, Swap, 24),
+	INT_TO_INT_PROCS(Swap, 32, Native, 32),
+	{ (const void *)InterleaveReference<Float32, Float32, 4, 4, Copy32>, (const void *)Interleave<void, void, 4, IOAF_Interleave32> },
+	{ (const void *)DeinterleaveReference<Float32, Float32, 4, 4, Copy32>, (const void *)Deinterleave<void, void, 4, IOAF_Deinterleave32> },
+	{ (const void *)DeinterleaveReference<Float32, SInt16, 4, 2, Float32ToNativeInt16_Portable>, (const void *)Deinterleave<Float32, SInt16, 2, IOAF_DeinterleaveFloat32ToNativeInt16> },
+	{ (const void *)DeinterleaveReference<Float32, SInt16, 4, 2, Float32ToSwapInt16_Portable>, (const void *)Deinterleave<Float32, SInt16, 2, IOAF_DeinterleaveFloat32ToSwapInt16> },
+	{ (const void *)DeinterleaveReference<Float32, SInt32, 4, 4, Float32ToNativeInt32_Portable>, (const void *)Deinterleave<Float32, SInt32, 4, IOAF_DeinterleaveFloat32ToNativeInt32> },
+	{ (const void *)DeinterleaveReference<Float32, SInt32, 4, 4, Float32ToSwapInt32_Portable>, (const void *)Deinterleave<Float32, SInt32, 4, IOAF_DeinterleaveFloat32ToSwapInt32> },
+	{ (const void *)InterleaveReference<SInt16, Float32, 2, 4, NativeInt16ToFloat32_Portable>, (const void *)Interleave<SInt16, Float32, 2, IOAF_InterleaveNativeInt16ToFloat32> },
+	{ (const void *)InterleaveReference<SInt16, Float32, 2, 4, SwapInt16ToFloat32_Portable>, (const void *)Interleave<SInt16, Float32, 2, IOAF_InterleaveSwapInt16ToFloat32> },
+	{ (const void *)InterleaveReference<SInt32, Float32, 4, 4, NativeInt32ToFloat32_Portable>, (const void *)Interleave<SInt32, Float32, 4, IOAF_InterleaveNativeInt32ToFloat32> },
+	{ (const void *)InterleaveReference<SInt32, Float32, 4, 4, SwapInt32ToFloat32_Portable>, (const void *)Interleave<SInt32, Float32, 4, IOAF_InterleaveSwapInt32ToFloat32> },
+	{ (const void *)WithGainReference<SInt16, 2, Float32ToNativeInt16_Portable>, (const void *)WithGain<SInt16, IOAF_Float32ToNativeInt16WithGain> },
+	{ (const void *)WithGainReference<SInt16, 2, Float32ToSwapInt16_Portable>, (const void *)WithGain<SInt16, IOAF_Float32ToSwapInt16WithGain> },
+	{ (const void *)WithGainReference<UInt8, 3, Float32ToNativeInt24_Portable>, (const void *)WithGain<UInt8, IOAF_Float32ToNativeInt24WithGain> },
+	{ (const void *)WithGainReference<UInt8, 3, Float32ToSwapInt24_Portable>, (const void *)WithGain<UInt8, IOAF_Float32ToSwapInt24WithGain> },
+	{ (const void *)WithGainReference<SInt32, 4, Float32ToNativeInt32_Portable>, (const void *)WithGain<SInt32, IOAF_Float32ToNativeInt32WithGain> },
+	{ (const void *)WithGainReference<SInt32, 4, Float32ToSwapInt32_Portable>, (const void *)WithGain<SInt32, IOAF_Float32ToSwapInt32WithGain> },
+	{ (const void *)GainRampReference<Float32, 4, Copy32>, (const void *)GainRamp<Float32, 4, IOAF_GainRampFloat32> },
+	{ (const void *)GainRampReference<SInt16, 2, Float32ToNativeInt16_Portable>, (const void *)GainRamp<SInt16, 2, IOAF_Float32ToNativeInt16WithGainRamp> },
+	{ (const void *)GainRampReference<SInt16, 2, Float32ToSwapInt16_Portable>, (const void *)GainRamp<SInt16, 2, IOAF_Float32ToSwapInt16WithGainRamp> },
+	{ (const void *)GainRampReference<UInt8, 3, Float32ToNativeInt24_Portable>, (const void *)GainRamp<UInt8, 3, IOAF_Float32ToNativeInt24WithGainRamp> },
+	{ (const void *)GainRampReference<UInt8, 3, Float32ToSwapInt24_Portable>, (const void *)GainRamp<UInt8, 3, IOAF_Float32ToSwapInt24WithGainRamp> },
+	{ (const void *)GainRampReference<SInt32, 4, Float32ToNativeInt32_Portable>, (const void *)GainRamp<SInt32, 4, IOAF_Float32ToNativeInt32WithGainRamp> },
+	{ (const void *)GainRampReference<SInt32, 4, Float32ToSwapInt32_Portable>, (const void *)GainRamp<SInt32, 4, IOAF_Float32ToSwapInt32WithGainRamp> },
+	{ (const void *)Float32ToIntJustifiedReference<PCMSInt16Native, 16>, (const void *)Float32ToIntJustified<16, IOAF_Float32ToNativeIntJustified> },
+	{ (const void *)Float32ToIntJustifiedReference<PCMSInt16Swap, 16>, (const void *)Float32ToIntJustified<16, IOAF_Float32ToSwapIntJustified> },
+	{ (const void *)Float32ToIntJustifiedReference<PCMSInt24Native, 24>, (const void *)Float32ToIntJustified<24, IOAF_Float32ToNativeIntJustified> },
+	{ (const void *)Float32ToIntJustifiedReference<PCMSInt24Swap, 24>, (const void *)Float32ToIntJustified<24, IOAF_Float32ToSwapIntJustified> },
+	{ (const void *)Float32ToIntJustifiedReference<PCMSInt32Native, 32>, (const void *)Float32ToIntJustified<32, IOAF_Float32ToNativeIntJustified> },
+	{ (const void *)Float32ToIntJustifiedReference<PCMSInt32Swap, 32>, (const void *)Float32ToIntJustified<32, IOAF_Float32ToSwapIntJustified> },
+	{ (const void *)IntJustifiedToFloat32Reference<PCMSInt16Native, 16>, (const void *)IntJustifiedToFloat32<16, IOAF_NativeIntJustifiedToFloat32> },
+	{ (const void *)IntJustifiedToFloat32Reference<PCMSInt16Swap, 16>, (const void *)IntJustifiedToFloat32<16, IOAF_SwapIntJustifiedToFloat32> },
+	{ (const void *)IntJustifiedToFloat32Reference<PCMSInt24Native, 24>, (const void *)IntJustifiedToFloat32<24, IOAF_NativeIntJustifiedToFloat32> },
+	{ (const void *)IntJustifiedToFloat32Reference<PCMSInt24Swap, 24>, (const void *)IntJustifiedToFloat32<24, IOAF_SwapIntJustifiedToFloat32> },
+	{ (const void *)IntJustifiedToFloat32Reference<PCMSInt32Native, 32>, (const void *)IntJustifiedToFloat32<32, IOAF_NativeIntJustifiedToFloat32> },
+	{ (const void *)IntJustifiedToFloat32Reference<PCMSInt32Swap, 32>, (const void *)IntJustifiedToFloat32<32, IOAF_SwapIntJustifiedToFloat32> },
+	{ (const void *)ChannelsReference<SInt16, 2, Float32ToNativeInt16_Portable>, (const void *)Channels<SInt16, IOAF_Float32ToNativeInt16Channels> },
+	{ (const void *)ChannelsReference<SInt16, 2, Float32ToSwapInt16_Portable>, (const void *)Channels<SInt16, IOAF_Float32ToSwapInt16Channels> },
+	{ (const void *)ChannelsReference<UInt8, 3, Float32ToNativeInt24_Portable>, (const void *)Channels<UInt8, IOAF_Float32ToNativeInt24Channels> },
+	{ (const void *)ChannelsReference<UInt8, 3, Float32ToSwapInt24_Portable>, (const void *)Channels<UInt8, IOAF_Float32ToSwapInt24Channels> },
+	{ (const void *)ChannelsReference<SInt32, 4, Float32ToNativeInt32_Portable>, (const void *)Channels<SInt32, IOAF_Float32ToNativeInt32Channels> },
+	{ (const void *)ChannelsReference<SInt32, 4, Float32ToSwapInt32_Portable>, (const void *)Channels<SInt32, IOAF_Float32ToSwapInt32Channels> },
+	{ (const void *)MixFloat32ChannelsReference, (const void *)MixFloat32Channels },
+	{ (const void *)FindActiveChannelsReference, (const void *)FindActiveChannels },
+	{ (const void *)Float32ToIntBatchReference<SInt16, kIOAF_NativeInt16, 2, Float32ToNativeInt16_Portable, Float32ToSwapInt16_Portable>, (const void *)Float32ToIntBatch<kIOAF_NativeInt16, 2> },
+	{ (const void *)Float32ToIntBatchReference<UInt8, kIOAF_NativeInt24, 3, Float32ToNativeInt24_Portable, Float32ToSwapInt24_Portable>, (const void *)Float32ToIntBatch<kIOAF_NativeInt24, 3> },
+	{ (const void *)Float32ToIntBatchReference<SInt32, kIOAF_NativeInt32, 4, Float32ToNativeInt32_Portable, Float32ToSwapInt32_Portable>, (const void *)Float32ToIntBatch<kIOAF_NativeInt32, 4> }
+};
+
+#define kNumDirectEntries	(sizeof(sDirectEntries) / sizeof(sDirectEntries[0]))
+
+static const void *TableProc( const IOAF_ConverterTable *table, const TableEntry *entry )
+{
+	const void *proc;
+
+	memcpy(&proc, (const UInt8 *)table + entry->offset, sizeof(proc));
+	return proc;
+}
+
+// 16-bit and wider samples must be aligned to their size (at most 4); 24-bit and 8-bit ones need not be
+static unsigned int Alignment( unsigned int bytesPerSample )
+{
+	return (bytesPerSample == 2 || bytesPerSample == 4) ? bytesPerSample : (bytesPerSample > 4 ? 4 : 1);
+}
+
+static inline UInt32 Random( UInt32 &seed )
+{
+	seed = seed * 1664525 + 1013904223;
+	return seed;
+}
+
+static inline Float32 FloatFromBits( UInt32 bits )
+{
+	Float32 f;
+
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+// ____________________________________________________________________________________
+// Input
+
+static UInt8 *	sSource;		// kBufferBytes, 64-byte aligned
+static UInt8 *	sMixDest;		// the starting contents of a mix destination
+static UInt8 *	sRefBuffer;
+static UInt8 *	sTestBuffer;
+static UInt8 *	sSourceCopy;
+
+// float test values: specials, rounding boundaries and random samples in and beyond full scale
+static Float32 TestFloat( unsigned int i, UInt32 &seed )
+{
+	static const UInt32 specials[] = {
+		0x3F800000, 0xBF800000,		// +/-1.0
+		0x3F7FFFFF, 0xBF7FFFFF,		// just inside
+		0x3F800001, 0xBF800001,		// just outside
+		0x3FC00000, 0xC0400000,		// 1.5, -3.0
+		0x00000000, 0x80000000,		// +/-0
+		0x00000001, 0x80000001,		// smallest denormals
+		0x007FFFFF, 0x807FFFFF,		// largest denormals
+		0x7F800000, 0xFF800000,		// +/-inf
+		0x7FC00000, 0xFFC00000,		// quiet NaNs
+		0x7F800001, 0x7F7FFFFF		// signalling NaN, biggest float
+	};
+	static const Float32 lsb[] = { 1.0f / 32768.0f, 1.0f / 8388608.0f, 1.0f / 2147483648.0f, 1.0f / 128.0f };
+	UInt32 r = Random(seed);
+
+	switch (i % 8) {
+		case 0:
+			return FloatFromBits(specials[(r >> 8) % (sizeof(specials) / sizeof(specials[0]))]);
+		case 1: {
+			// exactly half an LSB above or below a step, at one of the output widths
+			Float32 step = lsb[(r >> 4) & 3];
+			SInt32 k = (SInt32)((r >> 8) & 0xFFFF) - 32768;
+			return ((Float32)k + ((r & 1) ? 0.5f : -0.5f)) * step;
+		}
+		case 2:
+			return ((SInt32)r) * (2.0f / 2147483648.0f);		// +/-2
+		default:
+			return ((SInt32)r) * (1.0f / 2147483648.0f);		// +/-1
+	}
+}
+
+static void FillSources( UInt32 seed )
+{
+	unsigned int i;
+
+	for (i = 0; i < kBufferBytes / 4; ++i) {
+		Float32 f = TestFloat(i, seed);
+		memcpy(sSource + 4 * i, &f, 4);
+		f = TestFloat(i + 3, seed);
+		memcpy(sMixDest + 4 * i, &f, 4);
+	}
+}
+
+// ordinary signal for timing: special values (denormals especially) take slow paths in the FPU
+static void FillBenchSources( UInt32 seed )
+{
+	unsigned int i;
+
+	for (i = 0; i < kBufferBytes / 4; ++i) {
+		Float32 f = ((SInt32)Random(seed)) * (1.0f / 2147483648.0f);
+		memcpy(sSource + 4 * i, &f, 4);
+		f = ((SInt32)Random(seed)) * (1.0f / 2147483648.0f);
+		memcpy(sMixDest + 4 * i, &f, 4);
+	}
+}
+
+// doubles: the float test values, some of them nudged off the float grid, and a few beyond the float range
+static void FillDoubleSource( UInt32 seed, bool bench )
+{
+	unsigned int i;
+
+	for (i = 0; i < kBufferBytes / 8; ++i) {
+		UInt32 r = Random(seed);
+		Float64 d;
+
+		if (bench)
+			d = ((SInt32)r) * (1.0 / 2147483648.0);
+		else if (i % 16 == 5)
+			d = (r & 1) ? 1e300 * ((r & 2) ? -1.0 : 1.0) : 1e-310;
+		else {
+			d = TestFloat(i, seed);
+			if (i % 4 == 3)
+				d += d * ((r & 1) ? (1.0 / 16777216.0) : ((SInt32)r) * (1.0 / 36028797018963968.0));
+		}
+		memcpy(sSource + 8 * i, &d, 8);
+	}
+}
+
+static void FillIntSource( UInt32 seed )
+{
+	unsigned int i;
+
+	for (i = 0; i < kBufferBytes; ++i)
+		sSource[i] = (UInt8)(Random(seed) >> 24);
+}
+
+// +/-0 with one test value in 64, for finding the channels that aren't silent
+static void FillSparseSource( UInt32 seed )
+{
+	unsigned int i;
+
+	for (i = 0; i < kBufferBytes / 4; ++i) {
+		UInt32 r = Random(seed);
+		Float32 f = ((r >> 8) & 63) ? FloatFromBits(r & 0x80000000) : TestFloat(i, seed);
+		memcpy(sSource + 4 * i, &f, 4);
+	}
+}
+
+// ____________________________________________________________________________________
+// Verification
+
+static unsigned int sFailures;
+
+static void Run( const TableEntry *entry, const void *proc, const UInt8 *src, UInt8 *dest, unsigned int count, unsigned int srcStride )
+{
+	if (entry->kind == kMixMulti) {
+		const Float32 *sources[kMaxMixSources];
+		unsigned int nSources = 1 + count % kMaxMixSources, s;
+
+		for (s = 0; s < nSources; ++s)
+			sources[s] = (const Float32 *)(src + s * srcStride);
+		((IOAF_MixFloat32MultiProc)proc)(sources, nSources, (Float32 *)dest, count);
+	} else {
+		((TestProc)proc)(src, dest, count);
+	}
+}
+
+static void PrepareDest( const TableEntry *entry, UInt8 *buffer, unsigned int destOffset, unsigned int count )
+{
+	memset(buffer, kGuardByte, kGuardBytes + destOffset + count * entry->destBytes + kGuardBytes);
+	if (entry->kind == kMix || entry->kind == kMixMulti)
+		memcpy(buffer + kGuardBytes + destOffset, sMixDest + kGuardBytes + destOffset, count * entry->destBytes);
+}
+
+#if !PCMBLIT_X86
+// Which NaN a sum of two NaNs keeps depends on the order the compiler puts the operands in, and some
+// CPUs always give their default NaN, so the generic backend's mixes need only give some NaN where the
+// reference does.
+static void MatchMixNaNs( const TableEntry *entry, unsigned int count, unsigned int destOffset )
+{
+	UInt8 *ref = sRefBuffer + kGuardBytes + destOffset, *test = sTestBuffer + kGuardBytes + destOffset;
+	unsigned int i;
+
+	if (entry->kind != kMix && entry->kind != kMixMulti)
+		return;
+	for (i = 0; i < count; ++i) {
+		Float32 r, t;
+
+		memcpy(&r, ref + 4 * i, 4);
+		memcpy(&t, test + 4 * i, 4);
+		if (r != r && t != t)
+			memcpy(test + 4 * i, &r, 4);
+	}
+}
+#endif
+
+static bool Compare( const char *table, const TableEntry *entry, unsigned int count, unsigned int srcOffset, unsigned int destOffset )
+{
+	unsigned int size = kGuardBytes + destOffset + count * entry->destBytes + kGuardBytes;
+	unsigned int i;
+
+#if !PCMBLIT_X86
+	MatchMixNaNs(entry, count, destOffset);
+#endif
+	if (memcmp(sRefBuffer, sTestBuffer, size) == 0)
+		return true;
+	for (i = 0; sRefBuffer[i] == sTestBuffer[i]; ++i)
+		;
+	if (sFailures++ < kMaxReportedErrors * kNumTableEntries) {
+		long byte = (long)i - kGuardBytes - destOffset;
+		printf("FAIL %s %s: count %u, source offset %u, dest offset %u: byte %ld (sample %ld) is 0x%02X, not 0x%02X\n",
+			   table, entry->name, count, srcOffset, destOffset, byte, byte / (long)entry->destBytes, sTestBuffer[i], sRefBuffer[i]);
+	}
+	return false;
+}
+
+static bool VerifyEntry( const char *table, const TableEntry *entry, const void *ref, const void *test )
+{
+	static const unsigned int longCounts[] = { 47, 63, 64, 65, 95, 127, 128, 129, 255, 257, 1023, 1031, 4099 };
+	unsigned int srcAlign = Alignment(entry->srcBytes), destAlign = Alignment(entry->destBytes);
+	unsigned int srcStride = (kMaxSamples / kMaxMixSources) * 4;
+	unsigned int srcOffset, destOffset, c, count, i;
+
+	for (srcOffset = 0; srcOffset < 16; srcOffset += srcAlign) {
+		for (destOffset = 0; destOffset < 16; destOffset += destAlign) {
+			for (c = 0; c < 41 + sizeof(longCounts) / sizeof(longCounts[0]); ++c) {
+				const UInt8 *src = sSource + kGuardBytes + srcOffset;
+
+				count = (c <= 40) ? c : longCounts[c - 41];
+				PrepareDest(entry, sRefBuffer, destOffset, count);
+				PrepareDest(entry, sTestBuffer, destOffset, count);
+				Run(entry, ref, src, sRefBuffer + kGuardBytes + destOffset, count, srcStride);
+				Run(entry, test, src, sTestBuffer + kGuardBytes + destOffset, count, srcStride);
+				if (!Compare(table, entry, count, srcOffset, destOffset))
+					return false;
+				for (i = 0; i < kGuardBytes; ++i) {
+					if (sRefBuffer[i] != kGuardByte || sRefBuffer[kGuardBytes + destOffset + count * entry->destBytes + i] != kGuardByte) {
+						printf("FAIL Portable %s writes outside its destination (count %u)\n", entry->name, count);
+						++sFailures;
+						return false;
+					}
+				}
+			}
+		}
+	}
+
+	// one long run, unaligned both sides
+	count = kMaxSamples - 64 - 5;
+	if (entry->kind == kMixMulti)
+		count = srcStride / 4 - 64 - 3;
+	PrepareDest(entry, sRefBuffer, 3 * destAlign, count);
+	PrepareDest(entry, sTestBuffer, 3 * destAlign, count);
+	Run(entry, ref, sSource + kGuardBytes + srcAlign, sRefBuffer + kGuardBytes + 3 * destAlign, count, srcStride);
+	Run(entry, test, sSource + kGuardBytes + srcAlign, sTestBuffer + kGuardBytes + 3 * destAlign, count, srcStride);
+	if (!Compare(table, entry, count, srcAlign, 3 * destAlign))
+		return false;
+
+	if (memcmp(sSource, sSourceCopy, kBufferBytes) != 0) {
+		printf("FAIL %s %s writes to its source\n", table, entry->name);
+		memcpy(sSource, sSourceCopy, kBufferBytes);
+		++sFailures;
+		return false;
+	}
+	return true;
+}
+
+static void VerifyTables( const IOAF_ConverterTable *tables[], const char *names[], unsigned int nTables, UInt32 seed )
+{
+	unsigned int t, e;
+
+	for (t = 1; t < nTables; ++t) {
+		unsigned int passed = 0, shared = 0;
+
+		for (e = 0; e < kNumTableEntries; ++e) {
+			const TableEntry *entry = &sTableEntries[e];
+			const void *ref = TableProc(tables[0], entry), *test = TableProc(tables[t], entry);
+
+			if (entry->kind == kIntSource || entry->kind == kCopy)
+				FillIntSource(seed + e);
+			else
+				FillSources(seed + e);
+			memcpy(sSourceCopy, sSource, kBufferBytes);
+
+			if (test == ref)
+				++shared;
+			else if (VerifyEntry(names[t], entry, ref, test))
+				++passed;
+		}
+		printf("%-8s %u of %u entries match the portable references (%u are the references)\n", names[t], passed + shared, (unsigned int)kNumTableEntries, shared);
+	}
+}
+
+static void VerifyDirect( UInt32 seed )
+{
+	unsigned int passed = 0, e;
+
+	for (e = 0; e < kNumDirectEntries; ++e) {
+		const TableEntry *entry = &sDirectEntries[e];
+
+		if (entry->kind == kIntSource || entry->kind == kCopy)
+			FillIntSource(seed + e);
+		else if (entry->kind == kSparseSource)
+			FillSparseSource(seed + e);
+		else if (entry->kind == kDoubleSource)
+			FillDoubleSource(seed + e, false);
+		else
+			FillSources(seed + e);
+		memcpy(sSourceCopy, sSource, kBufferBytes);
+		if (VerifyEntry("IOAF", entry, sDirectProcs[e][0], sDirectProcs[e][1]))
+			++passed;
+	}
+	printf("%-8s %u of %u entry points match the portable references\n", "IOAF", passed, (unsigned int)kNumDirectEntries);
+}
+
+// ____________________________________________________________________________________
+// Dither
+//
+// Dithered output can't match a reference bit for bit, but TPDF dither of +/-1 LSB can only move
+// a sample one step from where the undithered converter puts it. Every table's dithered entries,
+// the _Portable ones included, are held to that against the portable undithered converter, and
+// have to move some samples.
+
+typedef void (*DitheredProc)( const Float32 *src, void *dest, unsigned int count, unsigned int nChannels, UInt32 seed[], Float32 *shapingError );
+
+template <class T>
+static SInt32 LoadSample( const UInt8 *p )
+{
+	return (SInt32)T::load((const typename T::value_type *)p);
+}
+
+typedef struct {
+	TableEntry		dithered;
+	TableEntry		undithered;
+	SInt32			(*load)( const UInt8 *p );
+} DitherEntry;
+
+static const DitherEntry sDitherEntries[] = {
+	{ { ENTRY(float32ToNativeInt16Dithered), kFloatSource, 4, 2 }, { ENTRY(float32ToNativeInt16), kFloatSource, 4, 2 }, LoadSample<PCMSInt16Native> },
+	{ { ENTRY(float32ToSwapInt16Dithered), kFloatSource, 4, 2 }, { ENTRY(float32ToSwapInt16), kFloatSource, 4, 2 }, LoadSample<PCMSInt16Swap> },
+	{ { ENTRY(float32ToNativeInt24Dithered), kFloatSource, 4, 3 }, { ENTRY(float32ToNativeInt24), kFloatSource, 4, 3 }, LoadSample<PCMSInt24Native> },
+	{ { ENTRY(float32ToSwapInt24Dithered), kFloatSource, 4, 3 }, { ENTRY(float32ToSwapInt24), kFloatSource, 4, 3 }, LoadSample<PCMSInt24Swap> }
+};
+
+#define kNumDitherEntries	(sizeof(sDitherEntries) / sizeof(sDitherEntries[0]))
+
+static bool VerifyDitherEntry( const char *table, const DitherEntry *entry, DitheredProc dithered, TestProc undithered )
+{
+	static const unsigned int counts[] = { 1, 2, 7, 16, 33, 64, 255, 1024, kMaxSamples - 64 - 5 };
+	unsigned int bytes = entry->dithered.destBytes, moved = 0, c, i;
+	IOAF_DitherState state;
+
+	IOAF_DitherStateInit(&state, 1);
+	for (c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+		const UInt8 *src = sSource + kGuardBytes + 4 * (c & 1);
+		UInt8 *ref = sRefBuffer + kGuardBytes, *test = sTestBuffer + kGuardBytes;
+		unsigned int count = counts[c];
+
+		undithered(src, ref, count);
+		dithered((const Float32 *)src, test, count, 2, state.seed, NULL);
+		for (i = 0; i < count; ++i) {
+			SInt32 d = entry->load(test + i * bytes) - entry->load(ref + i * bytes);
+
+			if (d < -1 || d > 1) {
+				if (sFailures++ < kMaxReportedErrors * kNumTableEntries)
+					printf("FAIL %s %s: count %u: sample %u is %d, %d LSB from the undithered %d\n",
+						   table, entry->dithered.name, count, i, entry->load(test + i * bytes), d, entry->load(ref + i * bytes));
+				return false;
+			}
+			if (d != 0)
+				++moved;
+		}
+	}
+	if (moved == 0) {
+		printf("FAIL %s %s doesn't dither\n", table, entry->dithered.name);
+		++sFailures;
+		return false;
+	}
+	return true;
+}
+
+static void VerifyDither( const IOAF_ConverterTable *tables[], const char *names[], unsigned int nTables, UInt32 seed )
+{
+	unsigned int t, e;
+
+	for (t = 0; t < nTables; ++t) {
+		unsigned int passed = 0;
+
+		for (e = 0; e < kNumDitherEntries; ++e) {
+			const DitherEntry *entry = &sDitherEntries[e];
+
+			FillSources(seed + e);
+			if (VerifyDitherEntry(names[t], entry, (DitheredProc)TableProc(tables[t], &entry->dithered), (TestProc)TableProc(tables[0], &entry->undithered)))
+				++passed;
+		}
+		printf("%-8s %u of %u dithered entries are within 1 LSB of the undithered output\n", names[t], passed, (unsigned int)kNumDitherEntries);
+	}
+}
+
+static void SetFormat( IOAudioStreamFormat *format, UInt32 numericRepresentation, UInt8 bitDepth, UInt8 bitWidth )
+{
+	memset(format, 0, sizeof(*format));
+	format->fNumChannels = 1;
+	format->fSampleFormat = kIOAudioStreamSampleFormatLinearPCM;
+	format->fNumericRepresentation = numericRepresentation;
+	format->fBitDepth = bitDepth;
+	format->fBitWidth = bitWidth;
+	format->fAlignment = kIOAudioStreamAlignmentHighByte;
+	format->fByteOrder = kIOAudioStreamByteOrderLittleEndian;
+}
+
+// IOAF_GetPCMConverter: a NaN through the generic float -> int loop gives 0, and a sample narrower
+// than its container is refused rather than converted at full width
+static void VerifyPCMConverters()
+{
+	IOAudioStreamFormat floatFormat, intFormat;
+	IOAF_PCMConverterProc proc;
+	Float64 src[2] = { 0.0, 0.0 };
+	SInt32 dest[2] = { 1, 1 };
+	UInt64 nanBits = 0x7FF8000000000000ULL;
+
+	memcpy(&src[0], &nanBits, sizeof(src[0]));
+	src[1] = -src[0];
+	SetFormat(&floatFormat, kIOAudioStreamNumericRepresentationIEEE754Float, 64, 64);
+	SetFormat(&intFormat, kIOAudioStreamNumericRepresentationSignedInt, 32, 32);
+	proc = IOAF_GetPCMConverter(&floatFormat, &intFormat);
+	if (proc == NULL) {
+		printf("FAIL IOAF_GetPCMConverter Float64 -> SInt32: no converter\n");
+		++sFailures;
+	} else {
+		proc(src, dest, 2);
+		if (dest[0] != 0 || dest[1] != 0) {
+			printf("FAIL IOAF_GetPCMConverter Float64 -> SInt32: NaN gave %d %d, expected 0\n", dest[0], dest[1]);
+			++sFailures;
+		}
+	}
+
+	SetFormat(&intFormat, kIOAudioStreamNumericRepresentationSignedInt, 20, 24);
+	SetFormat(&floatFormat, kIOAudioStreamNumericRepresentationIEEE754Float, 32, 32);
+	if (IOAF_GetPCMConverter(&floatFormat, &intFormat) != NULL || IOAF_GetPCMConverter(&intFormat, &floatFormat) != NULL) {
+		printf("FAIL IOAF_GetPCMConverter accepted 20 bits in 24\n");
+		++sFailures;
+	}
+}
+
+static int Verify( const IOAF_ConverterTable *tables[], const char *names[], unsigned int nTables )
+{
+	UInt32 savedState;
+
+	VerifyTables(tables, names, nTables, 0x12345678);
+	VerifyDirect(0x2545F491);
+	VerifyDither(tables, names, nTables, 0x85EBCA6B);
+	VerifyPCMConverters();
+
+	savedState = IOAF_DisableDenormals();
+	printf("with denormals flushed:\n");
+	VerifyTables(tables, names, nTables, 0x9E3779B9);
+	VerifyDirect(0x6C8E9CF5);
+	IOAF_RestoreDenormals(savedState);
+
+	if (sFailures) {
+		printf("%u failures\n", sFailures);
+		return 1;
+	}
+	printf("all converters match\n");
+	return 0;
+}
+
+// ____________________________________________________________________________________
+// Benchmark
+
+static double Now()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// best of three runs of at least a millisecond each; returns seconds per call
+static double TimeEntry( const TableEntry *entry, const void *proc, const UInt8 *src, UInt8 *dest, unsigned int count, unsigned int srcStride )
+{
+	double best = 1e9;
+	unsigned int iterations = 1 + (1 << 18) / (count + 16), run, i;
+
+	Run(entry, proc, src, dest, count, srcStride);		// warm up
+	for (run = 0; run < 3; ++run) {
+		double start = Now(), elapsed;
+
+		for (i = 0; i < iterations; ++i)
+			Run(entry, proc, src, dest, count, srcStride);
+		elapsed = Now() - start;
+		if (elapsed < 1e-3) {
+			iterations *= 2;
+			--run;
+			continue;
+		}
+		if (elapsed / iterations < best)
+			best = elapsed / iterations;
+	}
+	return best;
+}
+
+static void BenchEntry( const char *table, const TableEntry *entry, const void *proc, bool allOffsets )
+{
+	static const unsigned int counts[] = { 1, 7, 16, 64, 256, 1024, 4096, 16384, 65536 };
+	unsigned int srcAlign = Alignment(entry->srcBytes), destAlign = Alignment(entry->destBytes);
+	unsigned int srcStride = (kMaxSamples / kMaxMixSources) * 4;
+	unsigned int srcOffset, destOffset, c;
+
+	for (c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+		unsigned int count = counts[c];
+
+		if (entry->kind == kMixMulti && count + 16 > srcStride / 4)
+			continue;
+		for (srcOffset = 0; srcOffset < 16; srcOffset += srcAlign) {
+			for (destOffset = 0; destOffset < 16; destOffset += destAlign) {
+				// without -a, just aligned and one misaligned combination
+				if (!allOffsets && !(srcOffset == 0 && destOffset == 0) && !(srcOffset == srcAlign && destOffset == 3 * destAlign))
+					continue;
+
+				UInt8 *dest = sTestBuffer + kGuardBytes + destOffset;
+				unsigned int bytes = entry->srcBytes + entry->destBytes;
+				double seconds;
+
+				if (entry->kind == kMixMulti)
+					bytes = (1 + count % kMaxMixSources) * entry->srcBytes + 2 * entry->destBytes;
+				else if (entry->kind == kMix)
+					bytes += entry->destBytes;
+				PrepareDest(entry, sTestBuffer, destOffset, count);
+				seconds = TimeEntry(entry, proc, sSource + kGuardBytes + srcOffset, dest, count, srcStride);
+				printf("%-8s %-22s %6u  src+%-2u dst+%-2u  %8.3f ns/sample  %7.2f GB/s\n", table, entry->name, count, srcOffset, destOffset,
+					   seconds * 1e9 / count, (double)bytes * count / seconds * 1e-9);
+			}
+		}
+	}
+}
+
+static int Bench( const IOAF_ConverterTable *tables[], const char *names[], unsigned int nTables, bool allOffsets )
+{
+	unsigned int t, e;
+
+	FillBenchSources(0x12345678);
+	for (e = 0; e < kNumTableEntries; ++e) {
+		for (t = 0; t < nTables; ++t) {
+			const TableEntry *entry = &sTableEntries[e];
+
+			// entries that are the portable reference were timed with it
+			if (t > 0 && TableProc(tables[t], entry) == TableProc(tables[0], entry))
+				continue;
+			BenchEntry(names[t], entry, TableProc(tables[t], entry), allOffsets);
+		}
+	}
+	for (e = 0; e < kNumDirectEntries; ++e) {
+		if (sDirectEntries[e].kind == kDoubleSource)
+			FillDoubleSource(0x12345678, true);
+		else
+			FillBenchSources(0x12345678);
+		BenchEntry(names[0], &sDirectEntries[e], sDirectProcs[e][0], allOffsets);
+		BenchEntry("IOAF", &sDirectEntries[e], sDirectProcs[e][1], allOffsets);
+	}
+	return 0;
+}
+
+// ____________________________________________________________________________________
+// Dither cost
+//
+// The dithered converters against the undithered ones, both as IOAudioStream reaches them: through
+// the dispatch layer, so on the widest table this CPU can run. Interleaved stereo. Plain TPDF has to
+// keep at least 80% of the undithered throughput from 256 samples up, or this fails.
+
+static IOAF_DitherState sDitherState;
+
+static void NativeInt16Plain( const void *src, void *dest, unsigned int count )
+{
+	IOAF_Float32ToNativeInt16((const Float32 *)src, (SInt16 *)dest, count);
+}
+
+static void NativeInt24Plain( const void *src, void *dest, unsigned int count )
+{
+	IOAF_Float32ToNativeInt24((const Float32 *)src, (UInt8 *)dest, count);
+}
+
+static void NativeInt16TPDF( const void *src, void *dest, unsigned int count )
+{
+	IOAF_Float32ToNativeInt16Dithered((const Float32 *)src, (SInt16 *)dest, count, 2, false, &sDitherState);
+}
+
+static void NativeInt16Shaped( const void *src, void *dest, unsigned int count )
+{
+	IOAF_Float32ToNativeInt16Dithered((const Float32 *)src, (SInt16 *)dest, count, 2, true, &sDitherState);
+}
+
+static void NativeInt24TPDF( const void *src, void *dest, unsigned int count )
+{
+	IOAF_Float32ToNativeInt24Dithered((const Float32 *)src, (UInt8 *)dest, count, 2, false, &sDitherState);
+}
+
+static void NativeInt24Shaped( const void *src, void *dest, unsigned int count )
+{
+	IOAF_Float32ToNativeInt24Dithered((const Float32 *)src, (UInt8 *)dest, count, 2, true, &sDitherState);
+}
+
+static inline double Min( double a, double b )
+{
+	return (a < b) ? a : b;
+}
+
+static int BenchDither()
+{
+	static const TableEntry entries[] = {
+		{ ENTRY(float32ToNativeInt16), kFloatSource, 4, 2 },
+		{ ENTRY(float32ToNativeInt24), kFloatSource, 4, 3 }
+	};
+	static const void * const procs[][3] = {		// undithered, TPDF, noise shaped
+		{ (const void *)NativeInt16Plain, (const void *)NativeInt16TPDF, (const void *)NativeInt16Shaped },
+		{ (const void *)NativeInt24Plain, (const void *)NativeInt24TPDF, (const void *)NativeInt24Shaped }
+	};
+	static const unsigned int counts[] = { 64, 256, 1024, 4096, 16384 };
+	unsigned int e, c;
+	bool slow = false;
+
+	FillBenchSources(0x12345678);
+	IOAF_DitherStateInit(&sDitherState, 1);
+	for (e = 0; e < sizeof(entries) / sizeof(entries[0]); ++e) {
+		for (c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c) {
+			const UInt8 *src = sSource + kGuardBytes;
+			UInt8 *dest = sTestBuffer + kGuardBytes;
+			unsigned int count = counts[c];
+			double plain = 1e9, tpdf = 1e9, shaped = 1e9;
+			unsigned int round;
+
+			// in turns, so that a busy spell on the machine doesn't fall on just one of them
+			for (round = 0; round < 9; ++round) {
+				plain = Min(plain, TimeEntry(&entries[e], procs[e][0], src, dest, count, 0));
+				tpdf = Min(tpdf, TimeEntry(&entries[e], procs[e][1], src, dest, count, 0));
+				shaped = Min(shaped, TimeEntry(&entries[e], procs[e][2], src, dest, count, 0));
+			}
+
+			printf("%-22s %6u  %7.3f ns/sample  TPDF %7.3f (%3.0f%%)  shaped %7.3f (%3.0f%%)\n", entries[e].name, count,
+				   plain * 1e9 / count, tpdf * 1e9 / count, 100.0 * plain / tpdf, shaped * 1e9 / count, 100.0 * plain / shaped);
+			if (count >= 256 && plain / tpdf < 0.8)
+				slow = true;
+		}
+	}
+	if (slow) {
+		printf("TPDF dither is below 80%% of the undithered throughput\n");
+		return 1;
+	}
+	return 0;
+}
+
+// ____________________________________________________________________________________
+
+static UInt8 *AllocBuffer()
+{
+	void *p = NULL;
+
+	if (posix_memalign(&p, 64, kBufferBytes) != 0) {
+		fprintf(stderr, "out of memory\n");
+		exit(2);
+	}
+	return (UInt8 *)p;
+}
+
+int main( int argc, char *argv[] )
+{
+	const IOAF_ConverterTable *tables[kMaxTables];
+	const char *names[kMaxTables];
+	unsigned int nTables = IOAF_GetConverterTables(tables, names, kMaxTables), t;
+
+	sSource = AllocBuffer();
+	sMixDest = AllocBuffer();
+	sRefBuffer = AllocBuffer();
+	sTestBuffer = AllocBuffer();
+	sSourceCopy = AllocBuffer();
+
+	printf("tables:");
+	for (t = 0; t < nTables; ++t)
+		printf(" %s", names[t]);
+	printf("\n");
+
+	if (argc >= 2 && strcmp(argv[1], "verify") == 0)
+		return Verify(tables, names, nTables);
+	if (argc >= 2 && strcmp(argv[1], "bench") == 0)
+		return Bench(tables, names, nTables, argc >= 3 && strcmp(argv[2], "-a") == 0);
+	if (argc >= 2 && strcmp(argv[1], "dither") == 0)
+		return BenchDither();
+
+	fprintf(stderr, "usage: %s verify | bench [-a] | dither\n", argv[0]);
+	return 2;
+}